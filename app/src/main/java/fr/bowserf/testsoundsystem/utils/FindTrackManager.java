@@ -7,7 +7,7 @@ import android.provider.MediaStore;
 import android.support.annotation.NonNull;
 
 /**
- * Use to get, one by one, information on available music files on the device.
+ * Use to get, one by one or all at once, information on available music files on the device.
  */
 public class FindTrackManager {
 
@@ -50,4 +50,33 @@ public class FindTrackManager {
                 musicCursorExtern.getString(3),
                 musicCursorExtern.getString(4));
     }
+
+    /**
+     * Get paths of all music files on the device, for example to scan the whole library with
+     * {@link fr.bowserf.soundsystem.SoundSystem#scanLibrary(String[], String)}.
+     */
+    public static String[] getAllTrackPaths(@NonNull final Context context) {
+        String[] projMusics = {MediaStore.Audio.Media.DATA};
+
+        String whereArgs[] = new String[2];
+        whereArgs[0] = "0";
+        whereArgs[1] = "10000";
+
+        final CursorLoader cursorLoaderMusicExter = new CursorLoader(
+                context,
+                MediaStore.Audio.Media.EXTERNAL_CONTENT_URI,
+                projMusics,
+                MediaStore.Audio.Media.IS_MUSIC + "!= ? AND " + MediaStore.Audio.Media.DURATION + " > ? ",
+                whereArgs,
+                MediaStore.Audio.Media.TITLE_KEY + " ASC");
+        final Cursor musicCursorExtern = cursorLoaderMusicExter.loadInBackground();
+
+        final String[] paths = new String[musicCursorExtern.getCount()];
+        int i = 0;
+        while (musicCursorExtern.moveToNext()) {
+            paths[i++] = musicCursorExtern.getString(0);
+        }
+        musicCursorExtern.close();
+        return paths;
+    }
 }
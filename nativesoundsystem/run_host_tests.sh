@@ -0,0 +1,41 @@
+#!/bin/sh
+# Build and run the host tests of the native library : the *Test.cpp files next to the code they
+# check, each one in the 16 bits and in the float player configuration. They don't need Android,
+# android_debug.h logs to stderr on other hosts. Tests run from the root of the repository.
+#
+# Tests write their output files to $HOST_TEST_DIR, the build directory.
+# A test links the sources listed in its "// host test sources :" lines, paths from src/main/jni.
+#
+# usage : nativesoundsystem/run_host_tests.sh [build directory]
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+JNI="$ROOT/nativesoundsystem/src/main/jni"
+BUILD=${1:-"$ROOT/nativesoundsystem/build/host-tests"}
+CXX=${CXX:-g++}
+
+mkdir -p "$BUILD" || exit 1
+# tests write their files there
+export HOST_TEST_DIR="$BUILD"
+failed=0
+for test in $(cd "$JNI" && find . -name '*Test.cpp' | sort); do
+    sources=$(sed -n 's|^// host test sources : ||p' "$JNI/$test")
+    name=$(basename "$test" .cpp)
+    for config in short float; do
+        flags=""
+        if [ "$config" = float ]; then
+            flags="-DFLOAT_PLAYER"
+        fi
+        binary="$BUILD/$name-$config"
+        if ! (cd "$JNI" && $CXX -std=c++11 -O2 -Wall $flags -I. -o "$binary" "$test" $sources \
+                -pthread -lm); then
+            echo "FAIL $name ($config) : build"
+            failed=1
+        elif (cd "$ROOT" && "$binary"); then
+            echo "PASS $name ($config)"
+        else
+            echo "FAIL $name ($config)"
+            failed=1
+        fi
+    done
+done
+exit $failed
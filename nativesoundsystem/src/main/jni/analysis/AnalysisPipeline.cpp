@@ -0,0 +1,217 @@
+#include "AnalysisPipeline.h"
+
+#include <string.h>
+#include <time.h>
+
+#include <utils/android_debug.h>
+#include <utils/Tracer.h>
+
+static double now_ms(void) {
+    struct timespec res;
+    clock_gettime(CLOCK_MONOTONIC, &res);
+    return 1000.0 * res.tv_sec + (double) res.tv_nsec / 1e6;
+}
+
+AnalysisPipeline::AnalysisPipeline(SoundSystem *soundSystem, SoundSystemCallback *callback,
+                                   ThreadPool *threadPool) :
+        _soundSystem(soundSystem),
+        _soundSystemCallback(callback),
+        _threadPool(threadPool),
+        _pages(nullptr),
+        _numberFrames(0),
+        _isComplete(false),
+        _isTaskPosted(false) {
+    pthread_mutex_init(&_mutex, nullptr);
+    memset(_analyzers, 0, sizeof(_analyzers));
+    memset(&_analysis, 0, sizeof(_analysis));
+    _analysis.key = -1;
+    _soundSystem->addTrackListener(trackListener, this);
+}
+
+AnalysisPipeline::~AnalysisPipeline() {
+    _soundSystem->removeTrackListener(trackListener, this);
+    stop();
+    for (int type = 0; type < kAnalyzerCount; type++) {
+        delete _analyzers[type];
+    }
+    pthread_mutex_destroy(&_mutex);
+}
+
+bool AnalysisPipeline::addAnalyzer(TrackAnalyzer *analyzer) {
+    const int type = analyzer->getType();
+    if (type < 0 || type >= kAnalyzerCount || _analyzers[type] != nullptr) {
+        LOGE("Analyzer of type %d already added", type);
+        return false;
+    }
+    _analyzers[type] = analyzer;
+    return true;
+}
+
+void AnalysisPipeline::trackListener(void *context, int event, const PcmPages *pages) {
+    AnalysisPipeline *self = static_cast<AnalysisPipeline *>(context);
+    switch (event) {
+        case kTrackFramesAppended:
+            self->onFramesExtracted(pages, false);
+            break;
+        case kTrackCompleted:
+            self->onFramesExtracted(pages, true);
+            break;
+        case kTrackReleased:
+            self->stop();
+            break;
+        default:
+            break;
+    }
+}
+
+void AnalysisPipeline::onFramesExtracted(const PcmPages *pages, bool isComplete) {
+    if (pages == nullptr) {
+        return;
+    }
+    pthread_mutex_lock(&_mutex);
+    if (!_analysis.isComplete) {
+        _pages = pages;
+        _numberFrames = pages->getNumberFrames();
+        _isComplete = _isComplete || isComplete;
+        if (!_isTaskPosted && hasFramesToAnalyze()) {
+            _isTaskPosted = true;
+            _threadPool->post(analyzeTask, this, kTaskPriorityBackground, this);
+        }
+    }
+    pthread_mutex_unlock(&_mutex);
+}
+
+void AnalysisPipeline::stop() {
+    pthread_mutex_lock(&_mutex);
+    _pages = nullptr;
+    pthread_mutex_unlock(&_mutex);
+
+    // the running task reads the pages of the track
+    _threadPool->cancel(this);
+    _threadPool->waitIdle(this);
+
+    pthread_mutex_lock(&_mutex);
+    for (int type = 0; type < kAnalyzerCount; type++) {
+        if (_analyzers[type] != nullptr) {
+            _analyzers[type]->reset();
+        }
+    }
+    memset(&_analysis, 0, sizeof(_analysis));
+    _analysis.key = -1;
+    _numberFrames = 0;
+    _isComplete = false;
+    _isTaskPosted = false;
+    pthread_mutex_unlock(&_mutex);
+}
+
+void AnalysisPipeline::getAnalysis(TrackAnalysis *analysis) {
+    pthread_mutex_lock(&_mutex);
+    *analysis = _analysis;
+    pthread_mutex_unlock(&_mutex);
+}
+
+unsigned int AnalysisPipeline::getCurve(int type, float *values, unsigned int maxValues) {
+    if (type < 0 || type >= kAnalyzerCount) {
+        return 0;
+    }
+    unsigned int numberValues = 0;
+    pthread_mutex_lock(&_mutex);
+    if (_analysis.isComplete && _analyzers[type] != nullptr) {
+        const float *curve;
+        numberValues = _analyzers[type]->getCurve(&curve);
+        numberValues = numberValues < maxValues ? numberValues : maxValues;
+        memcpy(values, curve, numberValues * sizeof(float));
+    }
+    pthread_mutex_unlock(&_mutex);
+    return numberValues;
+}
+
+bool AnalysisPipeline::hasFramesToAnalyze() const {
+    // frames are analysed by blocks while the track is extracted
+    return _isComplete || _numberFrames - _analysis.numberFrames >= ANALYSIS_BLOCK_FRAMES;
+}
+
+void AnalysisPipeline::analyzeTask(void *data) {
+    static_cast<AnalysisPipeline *>(data)->analyze();
+}
+
+void AnalysisPipeline::analyze() {
+    TRACE_SCOPE("trackAnalysis");
+    pthread_mutex_lock(&_mutex);
+    const PcmPages *pages = _pages;
+    const unsigned int startFrame = _analysis.numberFrames;
+    unsigned int endFrame = _numberFrames;
+    pthread_mutex_unlock(&_mutex);
+    if (pages == nullptr) {
+        return;
+    }
+
+    const double startTime = now_ms();
+    if (endFrame - startFrame > ANALYSIS_TASK_FRAMES) {
+        endFrame = startFrame + ANALYSIS_TASK_FRAMES;
+    }
+    double analyzerMs[kAnalyzerCount] = {};
+    unsigned int position = startFrame;
+    while (position < endFrame) {
+        unsigned int count;
+        const AUDIO_HARDWARE_SAMPLE_TYPE *frames = pages->getFrames(position, &count);
+        if (frames == nullptr) {
+            break;
+        }
+        if (count > endFrame - position) {
+            count = endFrame - position;
+        }
+        if (count > ANALYSIS_BLOCK_FRAMES) {
+            count = ANALYSIS_BLOCK_FRAMES;
+        }
+        for (int type = 0; type < kAnalyzerCount; type++) {
+            if (_analyzers[type] != nullptr) {
+                const double analyzerStartTime = now_ms();
+                _analyzers[type]->process(frames, count);
+                analyzerMs[type] += now_ms() - analyzerStartTime;
+            }
+        }
+        position += count;
+    }
+
+    bool isFinished = false;
+    pthread_mutex_lock(&_mutex);
+    // the track may have been released while the frames were analysed
+    if (_pages != pages) {
+        pthread_mutex_unlock(&_mutex);
+        return;
+    }
+    _analysis.numberFrames = position;
+    _analysis.numberTasks++;
+
+    if (position < endFrame) {
+        LOGE("Frame %u of the analysed track is not readable", position);
+        _isTaskPosted = false;
+    } else if (_isComplete && position >= _numberFrames) {
+        for (int type = 0; type < kAnalyzerCount; type++) {
+            if (_analyzers[type] != nullptr) {
+                const double analyzerStartTime = now_ms();
+                _analyzers[type]->finish(&_analysis);
+                analyzerMs[type] += now_ms() - analyzerStartTime;
+            }
+        }
+        _analysis.isComplete = true;
+        _isTaskPosted = false;
+        isFinished = true;
+    } else if (hasFramesToAnalyze()) {
+        // the next frames are analysed by another task, after the tasks posted meanwhile
+        _threadPool->post(analyzeTask, this, kTaskPriorityBackground, this);
+    } else {
+        _isTaskPosted = false;
+    }
+
+    for (int type = 0; type < kAnalyzerCount; type++) {
+        _analysis.analyzerMs[type] += analyzerMs[type];
+    }
+    _analysis.totalMs += now_ms() - startTime;
+    pthread_mutex_unlock(&_mutex);
+
+    if (isFinished) {
+        _soundSystemCallback->notifyTrackAnalysisCompleted();
+    }
+}
@@ -0,0 +1,89 @@
+//
+// Created by Frederic on 16/06/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_ANALYSISPIPELINE_H
+#define MINI_SOUND_SYSTEM_ANALYSISPIPELINE_H
+
+#include <pthread.h>
+
+#include "TrackAnalyzer.h"
+#include "audio/PcmPages.h"
+#include "audio/SoundSystem.h"
+#include "listener/SoundSystemCallback.h"
+#include "utils/ThreadPool.h"
+
+// frames analysed by a task before it lets the other tasks of the pool run
+#define ANALYSIS_TASK_FRAMES (64 * ANALYSIS_BLOCK_FRAMES)
+
+/**
+ * Analysis of the loaded track in a single pass over its frames, while it is extracted.
+ *
+ * Frames appended by the extraction are read once by a task of the thread pool, block after block :
+ * every analyzer processes a block before the next one is read, so that the block stays in the data
+ * cache. Tasks of the pass run one after the other, never on the thread of the extraction. Once
+ * every frame has been analysed, the results of all analyzers are sent with a single notification.
+ */
+class AnalysisPipeline {
+public:
+    /**
+     * Follow the tracks loaded by soundSystem from now on.
+     */
+    AnalysisPipeline(SoundSystem *soundSystem, SoundSystemCallback *callback,
+                     ThreadPool *threadPool);
+    AnalysisPipeline& operator=(const AnalysisPipeline& ) = delete;
+    AnalysisPipeline(AnalysisPipeline&) = delete;
+    ~AnalysisPipeline();
+
+    /**
+     * Add an analyzer, deleted with the pipeline. Called before a track is loaded.
+     * @return false if an analyzer of the same type has already been added.
+     */
+    bool addAnalyzer(TrackAnalyzer *analyzer);
+
+    // results of the frames analysed so far, complete once the notification has been sent
+    void getAnalysis(TrackAnalysis *analysis);
+
+    /**
+     * Copy the curve of the analyzer of a TrackAnalyzerType, once the analysis is complete.
+     * @return number of values copied.
+     */
+    unsigned int getCurve(int type, float *values, unsigned int maxValues);
+
+private:
+
+    static void trackListener(void *context, int event, const PcmPages *pages);
+
+    void onFramesExtracted(const PcmPages *pages, bool isComplete);
+
+    // drop the task and the results of the track, which is about to be released
+    void stop();
+
+    static void analyzeTask(void *data);
+
+    void analyze();
+
+    // called with the mutex locked
+    bool hasFramesToAnalyze() const;
+
+    SoundSystem *_soundSystem;
+    SoundSystemCallback *_soundSystemCallback;
+    ThreadPool *_threadPool;
+
+    // by type, null if not added. Only used by the task of the pass, or while no task is posted
+    TrackAnalyzer *_analyzers[kAnalyzerCount];
+
+    pthread_mutex_t _mutex;
+
+    // track followed, null while no frame has been extracted
+    const PcmPages *_pages;
+    unsigned int _numberFrames;
+    bool _isComplete;
+
+    // a single task of the pass is posted or running at a time
+    bool _isTaskPosted;
+
+    TrackAnalysis _analysis;
+};
+
+#endif //MINI_SOUND_SYSTEM_ANALYSISPIPELINE_H
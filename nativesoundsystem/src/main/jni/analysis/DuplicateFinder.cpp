@@ -0,0 +1,272 @@
+#include "DuplicateFinder.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <audio/DecoderFactory.h>
+#include <utils/android_debug.h>
+
+#include "FeatureIndex.h"
+#include "Fingerprinter.h"
+
+// maximum number of matches checked for one query
+#define MAX_MATCHES 32
+
+struct FingerprintJob {
+    DuplicateFinder *finder;
+    char *filePath;
+};
+
+typedef struct {
+    AudioDecoder *decoder;
+    Fingerprinter *fingerprinter;
+} FingerprintContext;
+
+static double now_ms(void) {
+    struct timespec res;
+    clock_gettime(CLOCK_REALTIME, &res);
+    return 1000.0 * res.tv_sec + (double) res.tv_nsec / 1e6;
+}
+
+static void fingerprintTrackTask(void *data) {
+    FingerprintJob *job = (FingerprintJob *) data;
+    job->finder->fingerprintTrack(job->filePath);
+}
+
+static bool decodedBlockCallback(const short *samples, unsigned int numberSamples, void *context) {
+    FingerprintContext *fingerprintContext = (FingerprintContext *) context;
+    // channel count is only known once the decoder has started
+    if (fingerprintContext->fingerprinter == nullptr) {
+        fingerprintContext->fingerprinter = new Fingerprinter(
+                fingerprintContext->decoder->getFileSampleRate(),
+                fingerprintContext->decoder->getNumberChannels(),
+                FINGERPRINT_DEFAULT_DURATION_S);
+    }
+    // stop decoding once the start of the track is fingerprinted
+    return fingerprintContext->fingerprinter->process(samples, numberSamples);
+}
+
+DuplicateFinder::DuplicateFinder(SoundSystemCallback *callback, ThreadPool *threadPool,
+                                 SLEngineItf engine, int sampleRate, int bufferSize) :
+        _soundSystemCallback(callback),
+        _threadPool(threadPool),
+        _engine(engine),
+        _sampleRate(sampleRate),
+        _bufferSize(bufferSize),
+        _trackPaths(nullptr),
+        _trackPathHashes(nullptr),
+        _trackPathsCapacity(0),
+        _isRunning(false),
+        _cancelled(false),
+        _jobs(nullptr),
+        _numberJobs(0),
+        _numberPendingJobs(0) {
+    pthread_mutex_init(&_mutex, NULL);
+}
+
+DuplicateFinder::~DuplicateFinder() {
+    cancel();
+    _threadPool->waitIdle(this);
+    clear();
+    pthread_mutex_destroy(&_mutex);
+}
+
+bool DuplicateFinder::fingerprintTracks(char **filePaths, int numberFiles) {
+    pthread_mutex_lock(&_mutex);
+    if (_isRunning) {
+        pthread_mutex_unlock(&_mutex);
+        LOGE("Fingerprinting is already running");
+        return false;
+    }
+
+    _jobs = (FingerprintJob *) calloc(numberFiles > 0 ? numberFiles : 1, sizeof(FingerprintJob));
+    _numberJobs = 0;
+    for (int i = 0; i < numberFiles; i++) {
+        if (findTrackId(hashFeaturePath(filePaths[i])) >= 0) {
+            continue;
+        }
+        _jobs[_numberJobs].finder = this;
+        _jobs[_numberJobs].filePath = strdup(filePaths[i]);
+        _numberJobs++;
+    }
+    _numberPendingJobs = _numberJobs;
+    _cancelled = false;
+    _isRunning = true;
+    int numberJobs = _numberJobs;
+    FingerprintJob *jobs = _jobs;
+    pthread_mutex_unlock(&_mutex);
+
+    if (numberJobs == 0) {
+        finishFingerprinting();
+        return true;
+    }
+
+    for (int i = 0; i < numberJobs; i++) {
+        // a track cancelled before its decoding is only counted as fingerprinted
+        _threadPool->post(fingerprintTrackTask, &jobs[i], kTaskPriorityBackground, this,
+                          fingerprintTrackTask);
+    }
+    return true;
+}
+
+void DuplicateFinder::cancel() {
+    _cancelled = true;
+    // tracks not decoded yet are dropped right away
+    _threadPool->cancel(this);
+}
+
+void DuplicateFinder::fingerprintTrack(const char *filePath) {
+    if (!_cancelled) {
+        AudioDecoder *decoder = createAudioDecoder(filePath, _engine, _sampleRate, _bufferSize);
+        FingerprintContext context = {decoder, nullptr};
+
+        bool decoded = decoder->decode(filePath, decodedBlockCallback, &context, &_cancelled);
+        if (decoded && context.fingerprinter != nullptr && context.fingerprinter->finish() > 0) {
+            pthread_mutex_lock(&_mutex);
+            int trackId = _index.addTrack(context.fingerprinter->getFingerprint(),
+                                          context.fingerprinter->getFingerprintLength());
+            if (trackId >= _trackPathsCapacity) {
+                _trackPathsCapacity = _trackPathsCapacity == 0 ? 256 : _trackPathsCapacity * 2;
+                _trackPaths = (char **) realloc(_trackPaths, _trackPathsCapacity * sizeof(char *));
+                _trackPathHashes = (uint64_t *) realloc(_trackPathHashes,
+                                                        _trackPathsCapacity * sizeof(uint64_t));
+            }
+            _trackPaths[trackId] = strdup(filePath);
+            _trackPathHashes[trackId] = hashFeaturePath(filePath);
+            pthread_mutex_unlock(&_mutex);
+        } else if (!_cancelled) {
+            LOGW("Unable to fingerprint %s", filePath);
+        } else {
+            DecodeStats stats;
+            decoder->getDecodeStats(&stats);
+            _threadPool->reportCancelledJob(kTaskPriorityBackground, stats.decodeMs);
+        }
+        delete context.fingerprinter;
+        delete decoder;
+    }
+
+    onTrackFingerprinted();
+}
+
+void DuplicateFinder::onTrackFingerprinted() {
+    pthread_mutex_lock(&_mutex);
+    bool isLastTrack = --_numberPendingJobs == 0;
+    pthread_mutex_unlock(&_mutex);
+
+    if (isLastTrack) {
+        finishFingerprinting();
+    }
+}
+
+void DuplicateFinder::finishFingerprinting() {
+    pthread_mutex_lock(&_mutex);
+    bool cancelled = _cancelled;
+    for (int i = 0; i < _numberJobs; i++) {
+        free(_jobs[i].filePath);
+    }
+    free(_jobs);
+    _jobs = nullptr;
+    _numberJobs = 0;
+    _isRunning = false;
+    pthread_mutex_unlock(&_mutex);
+
+    _soundSystemCallback->notifyFingerprintCompleted(_index.getNumberTracks(), cancelled);
+}
+
+int DuplicateFinder::findDuplicates(const char *filePath, char **duplicatePaths,
+                                    int maxDuplicates) {
+    const double startTime = now_ms();
+
+    pthread_mutex_lock(&_mutex);
+    int trackId = findTrackId(hashFeaturePath(filePath));
+    pthread_mutex_unlock(&_mutex);
+    if (trackId < 0) {
+        return 0;
+    }
+
+    FingerprintMatch matches[MAX_MATCHES];
+    int numberMatches = _index.findMatches(trackId, matches,
+                                           maxDuplicates < MAX_MATCHES ? maxDuplicates
+                                                                       : MAX_MATCHES);
+    LOGI("Duplicates search duration %f", now_ms() - startTime);
+    return copyMatchingPaths(matches, numberMatches, duplicatePaths);
+}
+
+int DuplicateFinder::findDuplicates(const short *samples, unsigned int numberSamples,
+                                    int sampleRate, int numberChannels, char **duplicatePaths,
+                                    int maxDuplicates) {
+    return findSamplesDuplicates(samples, numberSamples, sampleRate, numberChannels,
+                                 duplicatePaths, maxDuplicates);
+}
+
+int DuplicateFinder::findDuplicates(const float *samples, unsigned int numberSamples,
+                                    int sampleRate, int numberChannels, char **duplicatePaths,
+                                    int maxDuplicates) {
+    return findSamplesDuplicates(samples, numberSamples, sampleRate, numberChannels,
+                                 duplicatePaths, maxDuplicates);
+}
+
+template<typename T>
+int DuplicateFinder::findSamplesDuplicates(const T *samples, unsigned int numberSamples,
+                                           int sampleRate, int numberChannels,
+                                           char **duplicatePaths, int maxDuplicates) {
+    const double startTime = now_ms();
+
+    Fingerprinter fingerprinter(sampleRate, numberChannels, FINGERPRINT_DEFAULT_DURATION_S);
+    fingerprinter.process(samples, numberSamples);
+    if (fingerprinter.finish() == 0) {
+        return 0;
+    }
+
+    FingerprintMatch matches[MAX_MATCHES];
+    int numberMatches = _index.findMatches(fingerprinter.getFingerprint(),
+                                           fingerprinter.getFingerprintLength(), -1, matches,
+                                           maxDuplicates < MAX_MATCHES ? maxDuplicates
+                                                                       : MAX_MATCHES);
+    LOGI("Duplicates search duration %f", now_ms() - startTime);
+    return copyMatchingPaths(matches, numberMatches, duplicatePaths);
+}
+
+int DuplicateFinder::copyMatchingPaths(FingerprintMatch *matches, int numberMatches,
+                                       char **duplicatePaths) {
+    pthread_mutex_lock(&_mutex);
+    int numberPaths = 0;
+    for (int i = 0; i < numberMatches; i++) {
+        LOGV("Duplicate %s, bit error rate %f", _trackPaths[matches[i].trackId],
+             matches[i].bitErrorRate);
+        duplicatePaths[numberPaths++] = strdup(_trackPaths[matches[i].trackId]);
+    }
+    pthread_mutex_unlock(&_mutex);
+    return numberPaths;
+}
+
+int DuplicateFinder::findTrackId(uint64_t pathHash) {
+    int numberTracks = _index.getNumberTracks();
+    for (int i = 0; i < numberTracks; i++) {
+        if (_trackPathHashes[i] == pathHash) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void DuplicateFinder::clear() {
+    pthread_mutex_lock(&_mutex);
+    if (_isRunning) {
+        pthread_mutex_unlock(&_mutex);
+        LOGE("Fingerprints can't be cleared while fingerprinting");
+        return;
+    }
+    int numberTracks = _index.getNumberTracks();
+    for (int i = 0; i < numberTracks; i++) {
+        free(_trackPaths[i]);
+    }
+    free(_trackPaths);
+    free(_trackPathHashes);
+    _trackPaths = nullptr;
+    _trackPathHashes = nullptr;
+    _trackPathsCapacity = 0;
+    _index.clear();
+    pthread_mutex_unlock(&_mutex);
+}
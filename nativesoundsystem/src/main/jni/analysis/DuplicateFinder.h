@@ -0,0 +1,99 @@
+//
+// Created by Frederic on 09/05/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_DUPLICATEFINDER_H
+#define MINI_SOUND_SYSTEM_DUPLICATEFINDER_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include <SLES/OpenSLES.h>
+
+#include "FingerprintIndex.h"
+#include "listener/SoundSystemCallback.h"
+#include "utils/ThreadPool.h"
+
+struct FingerprintJob;
+
+/**
+ * Fingerprint audio files in parallel on the thread pool and find tracks sharing the same audio
+ * content, whatever their encoding. Only the start of each track is decoded.
+ */
+class DuplicateFinder {
+public:
+    DuplicateFinder(SoundSystemCallback *callback, ThreadPool *threadPool, SLEngineItf engine,
+                    int sampleRate, int bufferSize);
+    ~DuplicateFinder();
+
+    /**
+     * Start fingerprinting files in background, end is notified through the callback.
+     * Files already fingerprinted are skipped.
+     * @return false if files are already being fingerprinted.
+     */
+    bool fingerprintTracks(char **filePaths, int numberFiles);
+
+    void cancel();
+
+    /**
+     * Find tracks with the same audio content as a fingerprinted file.
+     * @param duplicatePaths filled with copies of paths, to free by the caller.
+     * @return number of paths written.
+     */
+    int findDuplicates(const char *filePath, char **duplicatePaths, int maxDuplicates);
+
+    /**
+     * Find fingerprinted tracks with the same audio content as the given samples.
+     */
+    int findDuplicates(const short *samples, unsigned int numberSamples, int sampleRate,
+                       int numberChannels, char **duplicatePaths, int maxDuplicates);
+
+    int findDuplicates(const float *samples, unsigned int numberSamples, int sampleRate,
+                       int numberChannels, char **duplicatePaths, int maxDuplicates);
+
+    /**
+     * Remove all fingerprints, not possible while fingerprinting.
+     */
+    void clear();
+
+    //-------------------------
+    // - Workers, internal -
+    //-------------------------
+    void fingerprintTrack(const char *filePath);
+
+private:
+
+    template<typename T>
+    int findSamplesDuplicates(const T *samples, unsigned int numberSamples, int sampleRate,
+                              int numberChannels, char **duplicatePaths, int maxDuplicates);
+
+    int copyMatchingPaths(FingerprintMatch *matches, int numberMatches, char **duplicatePaths);
+
+    int findTrackId(uint64_t pathHash);
+
+    void onTrackFingerprinted();
+
+    void finishFingerprinting();
+
+    SoundSystemCallback *_soundSystemCallback;
+    ThreadPool *_threadPool;
+    SLEngineItf _engine;
+    int _sampleRate;
+    int _bufferSize;
+
+    FingerprintIndex _index;
+
+    // path of each track id of the index, protected by the mutex
+    pthread_mutex_t _mutex;
+    char **_trackPaths;
+    uint64_t *_trackPathHashes;
+    int _trackPathsCapacity;
+
+    bool _isRunning;
+    volatile bool _cancelled;
+    FingerprintJob *_jobs;
+    int _numberJobs;
+    int _numberPendingJobs;
+};
+
+#endif //MINI_SOUND_SYSTEM_DUPLICATEFINDER_H
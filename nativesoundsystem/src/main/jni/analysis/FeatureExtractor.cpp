@@ -0,0 +1,171 @@
+#include "FeatureExtractor.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// number of frames reduced to one peak before building the overview
+#define CHUNK_SIZE 1024
+
+// gating of the loudness, see ITU-R BS.1770
+#define LOUDNESS_ABSOLUTE_GATE -70.0
+#define LOUDNESS_RELATIVE_GATE -10.0
+#define SUB_BLOCKS_PER_GATING_BLOCK 4
+
+static inline double meanSquareToLoudness(double meanSquare) {
+    return -0.691 + 10.0 * log10(meanSquare);
+}
+
+FeatureExtractor::FeatureExtractor(int sampleRate, int numberChannels) :
+        _sampleRate(sampleRate > 0 ? sampleRate : 44100),
+        _numberChannels(numberChannels > 0 ? numberChannels : 1),
+        _numberFrames(0),
+        _currentChannel(0),
+        _peak(0),
+        _sumSquares(0),
+        _chunkPeaks(nullptr),
+        _numberChunks(0),
+        _chunkPeaksCapacity(0),
+        _currentChunkPeak(0),
+        _currentChunkFrames(0),
+        _subBlocks(nullptr),
+        _numberSubBlocks(0),
+        _subBlocksCapacity(0),
+        _currentSubBlockSum(0),
+        _currentSubBlockFrames(0) {
+    _subBlockSize = (unsigned int) (_sampleRate / 10);
+}
+
+FeatureExtractor::~FeatureExtractor() {
+    free(_chunkPeaks);
+    free(_subBlocks);
+}
+
+void FeatureExtractor::process(const short *samples, unsigned int numberSamples) {
+    const double normalization = 1.0 / (32768.0 * 32768.0);
+
+    for (unsigned int i = 0; i < numberSamples; i++) {
+        short sample = samples[i];
+        short magnitude = (short) (sample < 0 ? (sample == -32768 ? 32767 : -sample) : sample);
+        if (magnitude > _currentChunkPeak) {
+            _currentChunkPeak = magnitude;
+        }
+        _currentSubBlockSum += (double) sample * sample * normalization;
+
+        if (++_currentChannel < _numberChannels) {
+            continue;
+        }
+
+        // end of a frame
+        _currentChannel = 0;
+        _numberFrames++;
+
+        if (++_currentChunkFrames == CHUNK_SIZE) {
+            endOverviewChunk();
+        }
+        if (++_currentSubBlockFrames == _subBlockSize) {
+            endLoudnessSubBlock();
+        }
+    }
+}
+
+void FeatureExtractor::endOverviewChunk() {
+    if (_numberChunks == _chunkPeaksCapacity) {
+        _chunkPeaksCapacity = _chunkPeaksCapacity == 0 ? 1024 : _chunkPeaksCapacity * 2;
+        _chunkPeaks = (short *) realloc(_chunkPeaks, _chunkPeaksCapacity * sizeof(short));
+    }
+    _chunkPeaks[_numberChunks++] = _currentChunkPeak;
+    if (_currentChunkPeak > _peak) {
+        _peak = _currentChunkPeak;
+    }
+    _currentChunkPeak = 0;
+    _currentChunkFrames = 0;
+}
+
+void FeatureExtractor::endLoudnessSubBlock() {
+    if (_numberSubBlocks == _subBlocksCapacity) {
+        _subBlocksCapacity = _subBlocksCapacity == 0 ? 1024 : _subBlocksCapacity * 2;
+        _subBlocks = (float *) realloc(_subBlocks, _subBlocksCapacity * sizeof(float));
+    }
+    // channels are summed, as BS.1770 does for front channels
+    _subBlocks[_numberSubBlocks++] = (float) (_currentSubBlockSum / _currentSubBlockFrames);
+    _sumSquares += _currentSubBlockSum;
+    _currentSubBlockSum = 0;
+    _currentSubBlockFrames = 0;
+}
+
+void FeatureExtractor::finish(FeatureRecord *record) {
+    if (_currentChunkFrames > 0) {
+        endOverviewChunk();
+    }
+    if (_currentSubBlockFrames > 0) {
+        _sumSquares += _currentSubBlockSum;
+        _currentSubBlockSum = 0;
+        _currentSubBlockFrames = 0;
+    }
+
+    memset(record, 0, sizeof(FeatureRecord));
+    record->status = kFeatureStatusOk;
+    record->sampleRate = (uint32_t) _sampleRate;
+    record->numberChannels = (uint32_t) _numberChannels;
+    record->durationMs = (uint32_t) (_numberFrames * 1000 / _sampleRate);
+    record->peak = _peak / 32767.0f;
+    record->rms = _numberFrames == 0 ? 0.f :
+                  (float) sqrt(_sumSquares / ((double) _numberFrames * _numberChannels));
+
+    // gated loudness over overlapping 400ms blocks
+    double sumAboveAbsoluteGate = 0;
+    unsigned int numberAboveAbsoluteGate = 0;
+    unsigned int numberBlocks = _numberSubBlocks >= SUB_BLOCKS_PER_GATING_BLOCK ?
+                                _numberSubBlocks - SUB_BLOCKS_PER_GATING_BLOCK + 1 : 0;
+    float *blocks = (float *) malloc((numberBlocks > 0 ? numberBlocks : 1) * sizeof(float));
+    for (unsigned int i = 0; i < numberBlocks; i++) {
+        double meanSquare = 0;
+        for (int j = 0; j < SUB_BLOCKS_PER_GATING_BLOCK; j++) {
+            meanSquare += _subBlocks[i + j];
+        }
+        meanSquare /= SUB_BLOCKS_PER_GATING_BLOCK;
+        blocks[i] = (float) meanSquare;
+        if (meanSquare > 0 && meanSquareToLoudness(meanSquare) > LOUDNESS_ABSOLUTE_GATE) {
+            sumAboveAbsoluteGate += meanSquare;
+            numberAboveAbsoluteGate++;
+        }
+    }
+
+    record->loudness = (float) LOUDNESS_ABSOLUTE_GATE;
+    if (numberAboveAbsoluteGate > 0) {
+        double relativeGate = meanSquareToLoudness(sumAboveAbsoluteGate / numberAboveAbsoluteGate)
+                              + LOUDNESS_RELATIVE_GATE;
+        double sumGated = 0;
+        unsigned int numberGated = 0;
+        for (unsigned int i = 0; i < numberBlocks; i++) {
+            if (blocks[i] > 0) {
+                double loudness = meanSquareToLoudness(blocks[i]);
+                if (loudness > LOUDNESS_ABSOLUTE_GATE && loudness > relativeGate) {
+                    sumGated += blocks[i];
+                    numberGated++;
+                }
+            }
+        }
+        if (numberGated > 0) {
+            record->loudness = (float) meanSquareToLoudness(sumGated / numberGated);
+        }
+    }
+    free(blocks);
+
+    // reduce chunk peaks to the overview size
+    for (unsigned int i = 0; i < FEATURE_OVERVIEW_SIZE && _numberChunks > 0; i++) {
+        unsigned int start = (unsigned int) ((unsigned long) i * _numberChunks / FEATURE_OVERVIEW_SIZE);
+        unsigned int end = (unsigned int) ((unsigned long) (i + 1) * _numberChunks / FEATURE_OVERVIEW_SIZE);
+        if (end == start) {
+            end = start + 1;
+        }
+        short peak = 0;
+        for (unsigned int j = start; j < end && j < _numberChunks; j++) {
+            if (_chunkPeaks[j] > peak) {
+                peak = _chunkPeaks[j];
+            }
+        }
+        record->overview[i] = (uint8_t) (peak * 255 / 32767);
+    }
+}
@@ -0,0 +1,60 @@
+//
+// Created by Frederic on 02/05/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_FEATUREEXTRACTOR_H
+#define MINI_SOUND_SYSTEM_FEATUREEXTRACTOR_H
+
+#include "FeatureIndex.h"
+
+/**
+ * Compute track features from consecutive blocks of decoded samples, without keeping the samples.
+ */
+class FeatureExtractor {
+public:
+    FeatureExtractor(int sampleRate, int numberChannels);
+    ~FeatureExtractor();
+
+    /**
+     * @param samples       interleaved 16 bits samples.
+     * @param numberSamples number of samples, all channels included.
+     */
+    void process(const short *samples, unsigned int numberSamples);
+
+    /**
+     * Fill the record with features of all processed blocks.
+     */
+    void finish(FeatureRecord *record);
+
+private:
+
+    void endOverviewChunk();
+
+    void endLoudnessSubBlock();
+
+    int _sampleRate;
+    int _numberChannels;
+
+    unsigned long _numberFrames;
+    int _currentChannel;
+
+    short _peak;
+    double _sumSquares;
+
+    // peak of each chunk of frames, reduced to the overview at the end
+    short *_chunkPeaks;
+    unsigned int _numberChunks;
+    unsigned int _chunkPeaksCapacity;
+    short _currentChunkPeak;
+    unsigned int _currentChunkFrames;
+
+    // mean square of 100ms sub-blocks, gating blocks are made of 4 consecutive sub-blocks
+    float *_subBlocks;
+    unsigned int _numberSubBlocks;
+    unsigned int _subBlocksCapacity;
+    double _currentSubBlockSum;
+    unsigned int _currentSubBlockFrames;
+    unsigned int _subBlockSize;
+};
+
+#endif //MINI_SOUND_SYSTEM_FEATUREEXTRACTOR_H
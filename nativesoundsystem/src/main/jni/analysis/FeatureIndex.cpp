@@ -0,0 +1,248 @@
+#include "FeatureIndex.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <utils/android_debug.h>
+
+static int compareRecords(const void *a, const void *b) {
+    uint64_t hashA = ((const FeatureRecord *) a)->pathHash;
+    uint64_t hashB = ((const FeatureRecord *) b)->pathHash;
+    return hashA < hashB ? -1 : (hashA > hashB ? 1 : 0);
+}
+
+static int compareHashes(const void *a, const void *b) {
+    uint64_t hashA = *(const uint64_t *) a;
+    uint64_t hashB = *(const uint64_t *) b;
+    return hashA < hashB ? -1 : (hashA > hashB ? 1 : 0);
+}
+
+FeatureIndex::FeatureIndex() :
+        _fd(-1),
+        _writable(false),
+        _mapping(nullptr),
+        _mappingSize(0),
+        _flags(0),
+        _records(nullptr),
+        _numberRecords(0) {
+}
+
+FeatureIndex::~FeatureIndex() {
+    close();
+}
+
+bool FeatureIndex::openForRead(const char *indexPath) {
+    close();
+
+    _fd = open(indexPath, O_RDONLY);
+    if (_fd < 0) {
+        return false;
+    }
+
+    FeatureIndexHeader header;
+    if (pread(_fd, &header, sizeof(header), 0) != sizeof(header)
+        || header.magic != FEATURE_INDEX_MAGIC
+        || header.version != FEATURE_INDEX_VERSION
+        || header.recordSize != sizeof(FeatureRecord)) {
+        LOGE("Invalid feature index %s", indexPath);
+        close();
+        return false;
+    }
+    _flags = header.flags;
+    _writable = false;
+
+    if (!mapRecords(false)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool FeatureIndex::openForAppend(const char *indexPath) {
+    close();
+
+    _fd = open(indexPath, O_RDWR | O_CREAT, 0644);
+    if (_fd < 0) {
+        LOGE("Unable to open feature index %s", indexPath);
+        return false;
+    }
+    _writable = true;
+
+    FeatureIndexHeader header;
+    if (pread(_fd, &header, sizeof(header), 0) != sizeof(header)
+        || header.magic != FEATURE_INDEX_MAGIC
+        || header.version != FEATURE_INDEX_VERSION
+        || header.recordSize != sizeof(FeatureRecord)) {
+        // new or unreadable index, start from scratch
+        if (ftruncate(_fd, 0) != 0 || !writeHeader(0)) {
+            close();
+            return false;
+        }
+    } else {
+        _flags = header.flags;
+    }
+
+    // drop a record partially written when the previous scan has been interrupted
+    struct stat fileStat;
+    fstat(_fd, &fileStat);
+    size_t recordsSize = (size_t) fileStat.st_size - sizeof(FeatureIndexHeader);
+    if (recordsSize % sizeof(FeatureRecord) != 0) {
+        ftruncate(_fd, sizeof(FeatureIndexHeader)
+                       + recordsSize / sizeof(FeatureRecord) * sizeof(FeatureRecord));
+    }
+
+    if (!mapRecords(false)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void FeatureIndex::close() {
+    unmapRecords();
+    if (_fd >= 0) {
+        if (_writable) {
+            fdatasync(_fd);
+        }
+        ::close(_fd);
+        _fd = -1;
+    }
+    _flags = 0;
+    _numberRecords = 0;
+    _writable = false;
+}
+
+bool FeatureIndex::append(const FeatureRecord *record) {
+    if (_fd < 0 || !_writable) {
+        return false;
+    }
+
+    // the mapping doesn't follow the file size, it's only used before the first append
+    unmapRecords();
+
+    if (_flags & FEATURE_INDEX_FLAG_SORTED) {
+        writeHeader(_flags & ~FEATURE_INDEX_FLAG_SORTED);
+    }
+
+    off_t offset = sizeof(FeatureIndexHeader) + (off_t) _numberRecords * sizeof(FeatureRecord);
+    if (pwrite(_fd, record, sizeof(FeatureRecord), offset) != sizeof(FeatureRecord)) {
+        LOGE("Unable to write feature record");
+        return false;
+    }
+    _numberRecords++;
+    return true;
+}
+
+bool FeatureIndex::sort() {
+    if (_fd < 0 || !_writable) {
+        return false;
+    }
+
+    unmapRecords();
+    if (!mapRecords(true)) {
+        return false;
+    }
+    qsort((void *) _records, _numberRecords, sizeof(FeatureRecord), compareRecords);
+    msync(_mapping, _mappingSize, MS_SYNC);
+    unmapRecords();
+
+    return writeHeader(_flags | FEATURE_INDEX_FLAG_SORTED);
+}
+
+const FeatureRecord *FeatureIndex::find(uint64_t pathHash) {
+    if (_records == nullptr) {
+        return nullptr;
+    }
+
+    if (_flags & FEATURE_INDEX_FLAG_SORTED) {
+        unsigned int low = 0;
+        unsigned int high = _numberRecords;
+        while (low < high) {
+            unsigned int middle = low + (high - low) / 2;
+            if (_records[middle].pathHash < pathHash) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        if (low < _numberRecords && _records[low].pathHash == pathHash) {
+            return &_records[low];
+        }
+        return nullptr;
+    }
+
+    for (unsigned int i = 0; i < _numberRecords; i++) {
+        if (_records[i].pathHash == pathHash) {
+            return &_records[i];
+        }
+    }
+    return nullptr;
+}
+
+uint64_t *FeatureIndex::copySortedHashes(unsigned int *numberHashes) {
+    *numberHashes = 0;
+    if (_records == nullptr || _numberRecords == 0) {
+        return nullptr;
+    }
+
+    uint64_t *hashes = (uint64_t *) malloc(_numberRecords * sizeof(uint64_t));
+    for (unsigned int i = 0; i < _numberRecords; i++) {
+        hashes[i] = _records[i].pathHash;
+    }
+    if (!(_flags & FEATURE_INDEX_FLAG_SORTED)) {
+        qsort(hashes, _numberRecords, sizeof(uint64_t), compareHashes);
+    }
+    *numberHashes = _numberRecords;
+    return hashes;
+}
+
+bool FeatureIndex::mapRecords(bool writable) {
+    struct stat fileStat;
+    if (fstat(_fd, &fileStat) != 0) {
+        return false;
+    }
+
+    _numberRecords = (unsigned int) (((size_t) fileStat.st_size - sizeof(FeatureIndexHeader))
+                                     / sizeof(FeatureRecord));
+    if (_numberRecords == 0) {
+        return true;
+    }
+
+    _mappingSize = (size_t) fileStat.st_size;
+    _mapping = mmap(nullptr, _mappingSize, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                    MAP_SHARED, _fd, 0);
+    if (_mapping == MAP_FAILED) {
+        LOGE("Unable to map feature index");
+        _mapping = nullptr;
+        _mappingSize = 0;
+        return false;
+    }
+    _records = (const FeatureRecord *) ((const uint8_t *) _mapping + sizeof(FeatureIndexHeader));
+    return true;
+}
+
+void FeatureIndex::unmapRecords() {
+    if (_mapping != nullptr) {
+        munmap(_mapping, _mappingSize);
+        _mapping = nullptr;
+        _mappingSize = 0;
+    }
+    _records = nullptr;
+}
+
+bool FeatureIndex::writeHeader(uint32_t flags) {
+    FeatureIndexHeader header;
+    header.magic = FEATURE_INDEX_MAGIC;
+    header.version = FEATURE_INDEX_VERSION;
+    header.recordSize = sizeof(FeatureRecord);
+    header.flags = flags;
+    if (pwrite(_fd, &header, sizeof(header), 0) != sizeof(header)) {
+        LOGE("Unable to write feature index header");
+        return false;
+    }
+    _flags = flags;
+    return true;
+}
@@ -0,0 +1,133 @@
+//
+// Created by Frederic on 02/05/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_FEATUREINDEX_H
+#define MINI_SOUND_SYSTEM_FEATUREINDEX_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define FEATURE_INDEX_MAGIC 0x4953534D // "MSSI"
+#define FEATURE_INDEX_VERSION 1
+
+// number of points of the peak overview stored for each track
+#define FEATURE_OVERVIEW_SIZE 128
+
+// records are sorted by path hash, lookups can use a binary search
+#define FEATURE_INDEX_FLAG_SORTED 0x1
+
+enum {
+    kFeatureStatusOk = 0,
+    kFeatureStatusFailed = 1,
+};
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t flags;
+} FeatureIndexHeader;
+
+/**
+ * Features of one track. Fixed size so the file is an array of records after the header and
+ * can be read directly from the mapping.
+ */
+typedef struct {
+    uint64_t pathHash;
+    uint32_t status;
+    uint32_t sampleRate;
+    uint32_t numberChannels;
+    uint32_t durationMs;
+    float peak;
+    float rms;
+    // gated loudness in dB full scale, without K-weighting
+    float loudness;
+    uint32_t reserved;
+    // peak of each part of the track, 0 to 255
+    uint8_t overview[FEATURE_OVERVIEW_SIZE];
+} FeatureRecord;
+
+/**
+ * 64 bits FNV-1a hash of the file path, used as key in the index.
+ */
+static inline uint64_t hashFeaturePath(const char *path) {
+    uint64_t hash = 14695981039346656037ULL;
+    while (*path) {
+        hash ^= (uint8_t) *path++;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * Binary index file of track features.
+ *
+ * Records are appended while a scan is running, so an interrupted scan keeps every finished
+ * track. Once a scan is complete, records are sorted by hash in place.
+ */
+class FeatureIndex {
+public:
+    FeatureIndex();
+    ~FeatureIndex();
+
+    /**
+     * Open the index for reading through a read only mapping.
+     */
+    bool openForRead(const char *indexPath);
+
+    /**
+     * Open or create the index to append new records. An invalid file is recreated and a
+     * truncated trailing record is dropped.
+     */
+    bool openForAppend(const char *indexPath);
+
+    void close();
+
+    bool append(const FeatureRecord *record);
+
+    /**
+     * Sort records of the file opened for append and mark the index as sorted.
+     */
+    bool sort();
+
+    const FeatureRecord *find(uint64_t pathHash);
+
+    inline const FeatureRecord *find(const char *path) {
+        return find(hashFeaturePath(path));
+    }
+
+    inline unsigned int getNumberRecords() {
+        return _numberRecords;
+    }
+
+    inline const FeatureRecord *getRecord(unsigned int index) {
+        return &_records[index];
+    }
+
+    /**
+     * Copy hashes of all records, sorted, into a malloc'd array. Used to skip tracks already
+     * scanned when a scan is resumed.
+     */
+    uint64_t *copySortedHashes(unsigned int *numberHashes);
+
+private:
+
+    bool mapRecords(bool writable);
+
+    void unmapRecords();
+
+    bool writeHeader(uint32_t flags);
+
+    int _fd;
+    bool _writable;
+
+    void *_mapping;
+    size_t _mappingSize;
+
+    uint32_t _flags;
+    const FeatureRecord *_records;
+    unsigned int _numberRecords;
+};
+
+#endif //MINI_SOUND_SYSTEM_FEATUREINDEX_H
@@ -0,0 +1,274 @@
+#include "FingerprintIndex.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// only one sub-fingerprint out of FINGERPRINT_INDEX_STRIDE is indexed, queries use all of them
+#define FINGERPRINT_INDEX_STRIDE 2
+
+// maximum length of an indexed fingerprint, positions are stored on 12 bits
+#define FINGERPRINT_MAX_LENGTH 4096
+
+// sub-fingerprints shared by too many tracks (silence...) don't help to find candidates
+#define FINGERPRINT_MAX_POSTINGS_PER_VALUE 64
+
+// number of best voted candidates checked with the bit error rate
+#define FINGERPRINT_MAX_CANDIDATES 16
+
+// minimum number of aligned sub-fingerprints to compute a meaningful bit error rate
+#define FINGERPRINT_MIN_OVERLAP 64
+
+typedef struct {
+    int trackId;
+    int offset;
+    int votes;
+} FingerprintCandidate;
+
+static int comparePostings(const void *a, const void *b) {
+    const FingerprintPosting *postingA = (const FingerprintPosting *) a;
+    const FingerprintPosting *postingB = (const FingerprintPosting *) b;
+    if (postingA->subFingerprint != postingB->subFingerprint) {
+        return postingA->subFingerprint < postingB->subFingerprint ? -1 : 1;
+    }
+    return postingA->location < postingB->location ? -1 :
+           (postingA->location > postingB->location ? 1 : 0);
+}
+
+static int compareKeys(const void *a, const void *b) {
+    uint64_t keyA = *(const uint64_t *) a;
+    uint64_t keyB = *(const uint64_t *) b;
+    return keyA < keyB ? -1 : (keyA > keyB ? 1 : 0);
+}
+
+static int compareCandidates(const void *a, const void *b) {
+    return ((const FingerprintCandidate *) b)->votes - ((const FingerprintCandidate *) a)->votes;
+}
+
+static int compareMatches(const void *a, const void *b) {
+    float berA = ((const FingerprintMatch *) a)->bitErrorRate;
+    float berB = ((const FingerprintMatch *) b)->bitErrorRate;
+    return berA < berB ? -1 : (berA > berB ? 1 : 0);
+}
+
+FingerprintIndex::FingerprintIndex() :
+        _tracks(nullptr),
+        _numberTracks(0),
+        _tracksCapacity(0),
+        _postings(nullptr),
+        _numberPostings(0),
+        _postingsCapacity(0),
+        _isSorted(true) {
+    pthread_mutex_init(&_mutex, NULL);
+}
+
+FingerprintIndex::~FingerprintIndex() {
+    clear();
+    pthread_mutex_destroy(&_mutex);
+}
+
+int FingerprintIndex::addTrack(const uint32_t *fingerprint, unsigned int length) {
+    if (length == 0) {
+        return -1;
+    }
+    if (length > FINGERPRINT_MAX_LENGTH) {
+        length = FINGERPRINT_MAX_LENGTH;
+    }
+
+    pthread_mutex_lock(&_mutex);
+    if (_numberTracks == _tracksCapacity) {
+        _tracksCapacity = _tracksCapacity == 0 ? 256 : _tracksCapacity * 2;
+        _tracks = (FingerprintTrack *) realloc(_tracks, _tracksCapacity * sizeof(FingerprintTrack));
+    }
+    int trackId = _numberTracks++;
+    FingerprintTrack *track = &_tracks[trackId];
+    track->fingerprint = (uint32_t *) malloc(length * sizeof(uint32_t));
+    memcpy(track->fingerprint, fingerprint, length * sizeof(uint32_t));
+    track->length = length;
+
+    unsigned int numberNewPostings = (length + FINGERPRINT_INDEX_STRIDE - 1) / FINGERPRINT_INDEX_STRIDE;
+    if (_numberPostings + numberNewPostings > _postingsCapacity) {
+        while (_numberPostings + numberNewPostings > _postingsCapacity) {
+            _postingsCapacity = _postingsCapacity == 0 ? 65536 : _postingsCapacity * 2;
+        }
+        _postings = (FingerprintPosting *) realloc(_postings,
+                                                   _postingsCapacity * sizeof(FingerprintPosting));
+    }
+    for (unsigned int i = 0; i < length; i += FINGERPRINT_INDEX_STRIDE) {
+        uint32_t subFingerprint = fingerprint[i];
+        // constant parts of the signal give meaningless values
+        if (subFingerprint == 0 || subFingerprint == 0xFFFFFFFF) {
+            continue;
+        }
+        FingerprintPosting *posting = &_postings[_numberPostings++];
+        posting->subFingerprint = subFingerprint;
+        posting->location = ((uint32_t) trackId << 12) | i;
+    }
+    _isSorted = false;
+    pthread_mutex_unlock(&_mutex);
+
+    return trackId;
+}
+
+int FingerprintIndex::findMatches(int trackId, FingerprintMatch *matches, int maxMatches) {
+    pthread_mutex_lock(&_mutex);
+    if (trackId < 0 || trackId >= _numberTracks) {
+        pthread_mutex_unlock(&_mutex);
+        return 0;
+    }
+    unsigned int length = _tracks[trackId].length;
+    uint32_t *fingerprint = (uint32_t *) malloc(length * sizeof(uint32_t));
+    memcpy(fingerprint, _tracks[trackId].fingerprint, length * sizeof(uint32_t));
+    pthread_mutex_unlock(&_mutex);
+
+    int numberMatches = findMatches(fingerprint, length, trackId, matches, maxMatches);
+    free(fingerprint);
+    return numberMatches;
+}
+
+int FingerprintIndex::findMatches(const uint32_t *fingerprint, unsigned int length,
+                                  int excludedTrackId, FingerprintMatch *matches, int maxMatches) {
+    pthread_mutex_lock(&_mutex);
+    sortPostings();
+
+    // vote for (track, alignment) pairs sharing exact sub-fingerprints
+    unsigned int numberKeys = 0;
+    unsigned int keysCapacity = length * 4 + 1;
+    uint64_t *keys = (uint64_t *) malloc(keysCapacity * sizeof(uint64_t));
+    for (unsigned int i = 0; i < length; i++) {
+        uint32_t subFingerprint = fingerprint[i];
+        if (subFingerprint == 0 || subFingerprint == 0xFFFFFFFF) {
+            continue;
+        }
+
+        unsigned int low = 0;
+        unsigned int high = _numberPostings;
+        while (low < high) {
+            unsigned int middle = low + (high - low) / 2;
+            if (_postings[middle].subFingerprint < subFingerprint) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        unsigned int end = low;
+        while (end < _numberPostings && _postings[end].subFingerprint == subFingerprint) {
+            end++;
+        }
+        if (end - low > FINGERPRINT_MAX_POSTINGS_PER_VALUE) {
+            continue;
+        }
+
+        for (unsigned int j = low; j < end; j++) {
+            int trackId = (int) (_postings[j].location >> 12);
+            if (trackId == excludedTrackId) {
+                continue;
+            }
+            int offset = (int) (_postings[j].location & 0xFFF) - (int) i;
+            if (numberKeys == keysCapacity) {
+                keysCapacity *= 2;
+                keys = (uint64_t *) realloc(keys, keysCapacity * sizeof(uint64_t));
+            }
+            keys[numberKeys++] = ((uint64_t) trackId << 32) | (uint32_t) (offset + 0x8000);
+        }
+    }
+    qsort(keys, numberKeys, sizeof(uint64_t), compareKeys);
+
+    // best voted alignment of each track
+    FingerprintCandidate *candidates = (FingerprintCandidate *) malloc(
+            (numberKeys > 0 ? numberKeys : 1) * sizeof(FingerprintCandidate));
+    int numberCandidates = 0;
+    for (unsigned int start = 0; start < numberKeys;) {
+        unsigned int end = start;
+        while (end < numberKeys && keys[end] == keys[start]) {
+            end++;
+        }
+        int trackId = (int) (keys[start] >> 32);
+        int offset = (int) (keys[start] & 0xFFFFFFFF) - 0x8000;
+        int votes = (int) (end - start);
+        if (numberCandidates > 0 && candidates[numberCandidates - 1].trackId == trackId) {
+            if (votes > candidates[numberCandidates - 1].votes) {
+                candidates[numberCandidates - 1].offset = offset;
+                candidates[numberCandidates - 1].votes = votes;
+            }
+        } else {
+            candidates[numberCandidates].trackId = trackId;
+            candidates[numberCandidates].offset = offset;
+            candidates[numberCandidates].votes = votes;
+            numberCandidates++;
+        }
+        start = end;
+    }
+    free(keys);
+    qsort(candidates, numberCandidates, sizeof(FingerprintCandidate), compareCandidates);
+
+    FingerprintMatch verifiedMatches[FINGERPRINT_MAX_CANDIDATES];
+    int numberVerifiedMatches = 0;
+    for (int i = 0; i < numberCandidates && i < FINGERPRINT_MAX_CANDIDATES; i++) {
+        float ber = bitErrorRate(fingerprint, length, candidates[i].trackId, candidates[i].offset);
+        if (ber < FINGERPRINT_MATCH_MAX_BIT_ERROR_RATE) {
+            FingerprintMatch *match = &verifiedMatches[numberVerifiedMatches++];
+            match->trackId = candidates[i].trackId;
+            match->bitErrorRate = ber;
+            match->offset = candidates[i].offset;
+        }
+    }
+    free(candidates);
+    pthread_mutex_unlock(&_mutex);
+
+    qsort(verifiedMatches, numberVerifiedMatches, sizeof(FingerprintMatch), compareMatches);
+    int numberMatches = numberVerifiedMatches < maxMatches ? numberVerifiedMatches : maxMatches;
+    memcpy(matches, verifiedMatches, numberMatches * sizeof(FingerprintMatch));
+    return numberMatches;
+}
+
+float FingerprintIndex::bitErrorRate(const uint32_t *fingerprint, unsigned int length,
+                                     int trackId, int offset) {
+    const FingerprintTrack *track = &_tracks[trackId];
+    // query position i is aligned with track position i + offset
+    int start = offset < 0 ? -offset : 0;
+    int end = (int) length;
+    if ((int) track->length - offset < end) {
+        end = (int) track->length - offset;
+    }
+    if (end - start < FINGERPRINT_MIN_OVERLAP) {
+        return 1.f;
+    }
+
+    unsigned int differentBits = 0;
+    for (int i = start; i < end; i++) {
+        differentBits += __builtin_popcount(fingerprint[i] ^ track->fingerprint[i + offset]);
+    }
+    return differentBits / (32.f * (end - start));
+}
+
+void FingerprintIndex::sortPostings() {
+    if (!_isSorted) {
+        qsort(_postings, _numberPostings, sizeof(FingerprintPosting), comparePostings);
+        _isSorted = true;
+    }
+}
+
+void FingerprintIndex::clear() {
+    pthread_mutex_lock(&_mutex);
+    for (int i = 0; i < _numberTracks; i++) {
+        free(_tracks[i].fingerprint);
+    }
+    free(_tracks);
+    _tracks = nullptr;
+    _numberTracks = 0;
+    _tracksCapacity = 0;
+
+    free(_postings);
+    _postings = nullptr;
+    _numberPostings = 0;
+    _postingsCapacity = 0;
+    _isSorted = true;
+    pthread_mutex_unlock(&_mutex);
+}
+
+int FingerprintIndex::getNumberTracks() {
+    pthread_mutex_lock(&_mutex);
+    int numberTracks = _numberTracks;
+    pthread_mutex_unlock(&_mutex);
+    return numberTracks;
+}
@@ -0,0 +1,87 @@
+//
+// Created by Frederic on 09/05/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_FINGERPRINTINDEX_H
+#define MINI_SOUND_SYSTEM_FINGERPRINTINDEX_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+// two fingerprints match when less than this ratio of their bits differ
+#define FINGERPRINT_MATCH_MAX_BIT_ERROR_RATE 0.35f
+
+typedef struct {
+    int trackId;
+    // ratio of different bits between the aligned fingerprints
+    float bitErrorRate;
+    // offset of the track compared to the query, in sub-fingerprints
+    int offset;
+} FingerprintMatch;
+
+typedef struct {
+    uint32_t subFingerprint;
+    // track id in the 20 high bits, position in the fingerprint in the 12 low bits
+    uint32_t location;
+} FingerprintPosting;
+
+typedef struct {
+    uint32_t *fingerprint;
+    unsigned int length;
+} FingerprintTrack;
+
+/**
+ * In memory inverted index from sub-fingerprint values to positions in the indexed tracks.
+ *
+ * Candidates sharing exact sub-fingerprints with the query are voted by alignment, then the best
+ * ones are confirmed by the bit error rate of the whole aligned fingerprints.
+ */
+class FingerprintIndex {
+public:
+    FingerprintIndex();
+    FingerprintIndex& operator=(const FingerprintIndex& ) = delete;
+    FingerprintIndex(FingerprintIndex&) = delete;
+    ~FingerprintIndex();
+
+    /**
+     * Copy the fingerprint into the index.
+     * @return id of the track, -1 if the fingerprint is empty.
+     */
+    int addTrack(const uint32_t *fingerprint, unsigned int length);
+
+    /**
+     * Find indexed tracks matching the fingerprint, best match first.
+     * @param excludedTrackId id of a track not returned, used to query an indexed track.
+     * @return number of matches written.
+     */
+    int findMatches(const uint32_t *fingerprint, unsigned int length, int excludedTrackId,
+                    FingerprintMatch *matches, int maxMatches);
+
+    /**
+     * Find tracks matching an indexed track.
+     */
+    int findMatches(int trackId, FingerprintMatch *matches, int maxMatches);
+
+    void clear();
+
+    int getNumberTracks();
+
+private:
+
+    void sortPostings();
+
+    float bitErrorRate(const uint32_t *fingerprint, unsigned int length, int trackId, int offset);
+
+    pthread_mutex_t _mutex;
+
+    FingerprintTrack *_tracks;
+    int _numberTracks;
+    int _tracksCapacity;
+
+    FingerprintPosting *_postings;
+    unsigned int _numberPostings;
+    unsigned int _postingsCapacity;
+    bool _isSorted;
+};
+
+#endif //MINI_SOUND_SYSTEM_FINGERPRINTINDEX_H
@@ -0,0 +1,136 @@
+#include "Fingerprinter.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#define FINGERPRINT_SAMPLE_RATE 5512.5f
+#define FINGERPRINT_FRAME_SIZE 2048
+#define FINGERPRINT_HOP_S 0.0232f
+
+// 33 bands give the 32 bits of a sub-fingerprint
+#define FINGERPRINT_NUMBER_BANDS 33
+#define FINGERPRINT_MIN_FREQUENCY 300.0
+#define FINGERPRINT_MAX_FREQUENCY 2000.0
+
+Fingerprinter::Fingerprinter(int sampleRate, int numberChannels, float durationSeconds) :
+        _numberChannels(numberChannels > 0 ? numberChannels : 1),
+        _signalLength(0),
+        _accumulator(0),
+        _accumulated(0),
+        _currentChannel(0),
+        _fingerprint(nullptr),
+        _fingerprintLength(0) {
+    _decimation = (int) lroundf(sampleRate / FINGERPRINT_SAMPLE_RATE);
+    if (_decimation < 1) {
+        _decimation = 1;
+    }
+    _decimatedSampleRate = (float) sampleRate / _decimation;
+    _signalCapacity = (unsigned int) (durationSeconds * _decimatedSampleRate);
+    _signal = (float *) malloc(_signalCapacity * sizeof(float));
+}
+
+Fingerprinter::~Fingerprinter() {
+    free(_signal);
+    free(_fingerprint);
+}
+
+inline bool Fingerprinter::pushSample(float sample) {
+    _accumulator += sample;
+    if (++_currentChannel < _numberChannels) {
+        return true;
+    }
+    _currentChannel = 0;
+
+    // channels are averaged and a box filter is applied before decimation
+    if (++_accumulated == _decimation) {
+        _signal[_signalLength++] = _accumulator / (_decimation * _numberChannels);
+        _accumulator = 0;
+        _accumulated = 0;
+    }
+    return _signalLength < _signalCapacity;
+}
+
+bool Fingerprinter::process(const short *samples, unsigned int numberSamples) {
+    if (_signalLength >= _signalCapacity) {
+        return false;
+    }
+    for (unsigned int i = 0; i < numberSamples; i++) {
+        if (!pushSample(samples[i] * (1.f / 32768.f))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Fingerprinter::process(const float *samples, unsigned int numberSamples) {
+    if (_signalLength >= _signalCapacity) {
+        return false;
+    }
+    for (unsigned int i = 0; i < numberSamples; i++) {
+        if (!pushSample(samples[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+unsigned int Fingerprinter::finish() {
+    free(_fingerprint);
+    _fingerprint = nullptr;
+    _fingerprintLength = 0;
+
+    const float hop = FINGERPRINT_HOP_S * _decimatedSampleRate;
+    if (_signalLength < FINGERPRINT_FRAME_SIZE) {
+        return 0;
+    }
+    // the first frame is only used as reference of the second one
+    unsigned int numberFrames = (unsigned int) ((_signalLength - FINGERPRINT_FRAME_SIZE) / hop) + 1;
+    if (numberFrames < 2) {
+        return 0;
+    }
+
+    // bins of band edges, bands are logarithmically spaced
+    int bandEdges[FINGERPRINT_NUMBER_BANDS + 1];
+    for (int i = 0; i <= FINGERPRINT_NUMBER_BANDS; i++) {
+        double frequency = FINGERPRINT_MIN_FREQUENCY
+                           * pow(FINGERPRINT_MAX_FREQUENCY / FINGERPRINT_MIN_FREQUENCY,
+                                 (double) i / FINGERPRINT_NUMBER_BANDS);
+        bandEdges[i] = (int) (frequency * FINGERPRINT_FRAME_SIZE / _decimatedSampleRate);
+    }
+
+    FFT fft(FINGERPRINT_FRAME_SIZE);
+    float power[FINGERPRINT_FRAME_SIZE / 2 + 1];
+    float energies[FINGERPRINT_NUMBER_BANDS];
+    float previousEnergies[FINGERPRINT_NUMBER_BANDS];
+
+    _fingerprint = (uint32_t *) malloc((numberFrames - 1) * sizeof(uint32_t));
+    for (unsigned int frame = 0; frame < numberFrames; frame++) {
+        unsigned int start = (unsigned int) (frame * hop);
+        fft.powerSpectrum(_signal + start, power);
+
+        for (int band = 0; band < FINGERPRINT_NUMBER_BANDS; band++) {
+            float energy = 0;
+            for (int bin = bandEdges[band]; bin < bandEdges[band + 1]; bin++) {
+                energy += power[bin];
+            }
+            energies[band] = energy;
+        }
+
+        if (frame > 0) {
+            uint32_t subFingerprint = 0;
+            for (int band = 0; band < FINGERPRINT_NUMBER_BANDS - 1; band++) {
+                float difference = (energies[band] - energies[band + 1])
+                                   - (previousEnergies[band] - previousEnergies[band + 1]);
+                if (difference > 0) {
+                    subFingerprint |= 1u << band;
+                }
+            }
+            _fingerprint[_fingerprintLength++] = subFingerprint;
+        }
+
+        for (int band = 0; band < FINGERPRINT_NUMBER_BANDS; band++) {
+            previousEnergies[band] = energies[band];
+        }
+    }
+    return _fingerprintLength;
+}
@@ -0,0 +1,73 @@
+//
+// Created by Frederic on 09/05/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_FINGERPRINTER_H
+#define MINI_SOUND_SYSTEM_FINGERPRINTER_H
+
+#include <stdint.h>
+
+#include <dsp/FFT.h>
+
+// duration at the start of the track used to compute the fingerprint
+#define FINGERPRINT_DEFAULT_DURATION_S 15.f
+
+/**
+ * Compute a fingerprint of the start of a track : one 32 bits sub-fingerprint every 23ms, each bit
+ * being the sign of the energy difference between two adjacent frequency bands, compared to the
+ * previous frame (Haitsma & Kalker). It's robust to encoding and bitrate changes, so two encodings
+ * of the same track have few different bits.
+ */
+class Fingerprinter {
+public:
+    Fingerprinter(int sampleRate, int numberChannels, float durationSeconds);
+    ~Fingerprinter();
+
+    /**
+     * @param samples       interleaved 16 bits samples.
+     * @param numberSamples number of samples, all channels included.
+     * @return false when enough samples have been received, next samples are ignored.
+     */
+    bool process(const short *samples, unsigned int numberSamples);
+
+    /**
+     * Same as above with samples in the player format, between -1 and 1.
+     */
+    bool process(const float *samples, unsigned int numberSamples);
+
+    /**
+     * Compute sub-fingerprints of all received samples.
+     * @return number of sub-fingerprints, available with getFingerprint.
+     */
+    unsigned int finish();
+
+    inline const uint32_t *getFingerprint(){
+        return _fingerprint;
+    }
+
+    inline unsigned int getFingerprintLength(){
+        return _fingerprintLength;
+    }
+
+private:
+
+    inline bool pushSample(float sample);
+
+    int _numberChannels;
+    int _decimation;
+    float _decimatedSampleRate;
+
+    // mono signal, decimated to ~5.5kHz
+    float *_signal;
+    unsigned int _signalLength;
+    unsigned int _signalCapacity;
+
+    float _accumulator;
+    int _accumulated;
+    int _currentChannel;
+
+    uint32_t *_fingerprint;
+    unsigned int _fingerprintLength;
+};
+
+#endif //MINI_SOUND_SYSTEM_FINGERPRINTER_H
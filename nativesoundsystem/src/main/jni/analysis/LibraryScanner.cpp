@@ -0,0 +1,229 @@
+#include "LibraryScanner.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <audio/DecoderFactory.h>
+#include <utils/android_debug.h>
+
+#include "FeatureExtractor.h"
+
+struct ScanJob {
+    LibraryScanner *scanner;
+    const char *filePath;
+};
+
+typedef struct {
+    AudioDecoder *decoder;
+    FeatureExtractor *extractor;
+} ScanContext;
+
+static double now_ms(void) {
+    struct timespec res;
+    clock_gettime(CLOCK_REALTIME, &res);
+    return 1000.0 * res.tv_sec + (double) res.tv_nsec / 1e6;
+}
+
+static int compareHashes(const void *a, const void *b) {
+    uint64_t hashA = *(const uint64_t *) a;
+    uint64_t hashB = *(const uint64_t *) b;
+    return hashA < hashB ? -1 : (hashA > hashB ? 1 : 0);
+}
+
+static void scanTrackTask(void *data) {
+    ScanJob *job = (ScanJob *) data;
+    job->scanner->scanTrack(job->filePath);
+}
+
+static bool decodedBlockCallback(const short *samples, unsigned int numberSamples, void *context) {
+    ScanContext *scanContext = (ScanContext *) context;
+    // channel count is only known once the decoder has started
+    if (scanContext->extractor == nullptr) {
+        scanContext->extractor = new FeatureExtractor(scanContext->decoder->getFileSampleRate(),
+                                                      scanContext->decoder->getNumberChannels());
+    }
+    scanContext->extractor->process(samples, numberSamples);
+    return true;
+}
+
+LibraryScanner::LibraryScanner(SoundSystemCallback *callback, ThreadPool *threadPool,
+                               SLEngineItf engine, int sampleRate, int bufferSize) :
+        _soundSystemCallback(callback),
+        _threadPool(threadPool),
+        _engine(engine),
+        _sampleRate(sampleRate),
+        _bufferSize(bufferSize),
+        _isScanning(false),
+        _cancelled(false),
+        _filePaths(nullptr),
+        _jobs(nullptr),
+        _numberFilesToScan(0),
+        _numberFilesScanned(0),
+        _numberFilesTotal(0),
+        _scanStartTime(0) {
+    pthread_mutex_init(&_mutex, NULL);
+    memset(&_decodeStats, 0, sizeof(_decodeStats));
+}
+
+LibraryScanner::~LibraryScanner() {
+    cancel();
+    // cancelled jobs end quickly, the last one closes the index
+    _threadPool->waitIdle(this);
+    pthread_mutex_destroy(&_mutex);
+}
+
+bool LibraryScanner::scan(char **filePaths, int numberFiles, const char *indexPath) {
+    pthread_mutex_lock(&_mutex);
+    if (_isScanning) {
+        pthread_mutex_unlock(&_mutex);
+        LOGE("A library scan is already running");
+        return false;
+    }
+    if (!_index.openForAppend(indexPath)) {
+        pthread_mutex_unlock(&_mutex);
+        return false;
+    }
+
+    // skip tracks scanned by a previous run
+    unsigned int numberScannedHashes;
+    uint64_t *scannedHashes = _index.copySortedHashes(&numberScannedHashes);
+
+    _filePaths = (char **) calloc(numberFiles > 0 ? numberFiles : 1, sizeof(char *));
+    _numberFilesToScan = 0;
+    for (int i = 0; i < numberFiles; i++) {
+        uint64_t hash = hashFeaturePath(filePaths[i]);
+        if (scannedHashes != nullptr
+            && bsearch(&hash, scannedHashes, numberScannedHashes, sizeof(uint64_t),
+                       compareHashes) != nullptr) {
+            continue;
+        }
+        _filePaths[_numberFilesToScan++] = strdup(filePaths[i]);
+    }
+    free(scannedHashes);
+
+    _numberFilesTotal = numberFiles;
+    _numberFilesScanned = numberFiles - _numberFilesToScan;
+    _cancelled = false;
+    _isScanning = true;
+    _scanStartTime = now_ms();
+    memset(&_decodeStats, 0, sizeof(_decodeStats));
+
+    _jobs = (ScanJob *) calloc(_numberFilesToScan > 0 ? _numberFilesToScan : 1, sizeof(ScanJob));
+    int numberFilesToScan = _numberFilesToScan;
+    pthread_mutex_unlock(&_mutex);
+
+    LOGI("Library scan : %d tracks, %d already in the index", numberFiles,
+         numberFiles - numberFilesToScan);
+
+    _soundSystemCallback->notifyScanProgress(numberFiles - numberFilesToScan, numberFiles);
+
+    if (numberFilesToScan == 0) {
+        finishScan();
+        return true;
+    }
+
+    ScanJob *jobs = _jobs;
+    for (int i = 0; i < numberFilesToScan; i++) {
+        jobs[i].scanner = this;
+        jobs[i].filePath = _filePaths[i];
+        // a track cancelled before its decoding is only counted as scanned
+        _threadPool->post(scanTrackTask, &jobs[i], kTaskPriorityBackground, this, scanTrackTask);
+    }
+    return true;
+}
+
+void LibraryScanner::cancel() {
+    _cancelled = true;
+    // tracks not decoded yet are dropped right away
+    _threadPool->cancel(this);
+}
+
+bool LibraryScanner::isScanning() {
+    pthread_mutex_lock(&_mutex);
+    bool isScanning = _isScanning;
+    pthread_mutex_unlock(&_mutex);
+    return isScanning;
+}
+
+void LibraryScanner::scanTrack(const char *filePath) {
+    if (!_cancelled) {
+        AudioDecoder *decoder = createAudioDecoder(filePath, _engine, _sampleRate, _bufferSize);
+        ScanContext scanContext = {decoder, nullptr};
+
+        bool decoded = decoder->decode(filePath, decodedBlockCallback, &scanContext, &_cancelled);
+        DecodeStats stats;
+        decoder->getDecodeStats(&stats);
+
+        // a cancelled track is not written, it will be scanned again when the scan is resumed
+        if (!_cancelled) {
+            FeatureRecord record;
+            if (decoded && scanContext.extractor != nullptr) {
+                scanContext.extractor->finish(&record);
+            } else {
+                memset(&record, 0, sizeof(FeatureRecord));
+                record.status = kFeatureStatusFailed;
+                LOGW("Unable to scan %s", filePath);
+            }
+            record.pathHash = hashFeaturePath(filePath);
+
+            pthread_mutex_lock(&_mutex);
+            _index.append(&record);
+            _decodeStats.decodeMs += stats.decodeMs;
+            _decodeStats.ioWaitMs += stats.ioWaitMs;
+            _decodeStats.numberBytesRead += stats.numberBytesRead;
+            pthread_mutex_unlock(&_mutex);
+        } else {
+            _threadPool->reportCancelledJob(kTaskPriorityBackground, stats.decodeMs);
+        }
+        delete scanContext.extractor;
+        delete decoder;
+    }
+
+    onTrackScanned();
+}
+
+void LibraryScanner::onTrackScanned() {
+    pthread_mutex_lock(&_mutex);
+    _numberFilesScanned++;
+    int numberFilesScanned = _numberFilesScanned;
+    int numberFilesTotal = _numberFilesTotal;
+    bool isLastTrack = --_numberFilesToScan == 0;
+    pthread_mutex_unlock(&_mutex);
+
+    if (!_cancelled) {
+        _soundSystemCallback->notifyScanProgress(numberFilesScanned, numberFilesTotal);
+    }
+
+    if (isLastTrack) {
+        finishScan();
+    }
+}
+
+void LibraryScanner::finishScan() {
+    pthread_mutex_lock(&_mutex);
+    bool cancelled = _cancelled;
+    if (!cancelled) {
+        _index.sort();
+    }
+    LOGI("Library scan %s in %f ms, %u tracks in the index", cancelled ? "cancelled" : "ended",
+         now_ms() - _scanStartTime, _index.getNumberRecords());
+    // durations are summed over the workers
+    LOGI("Library scan decoding %f ms including %f ms of I/O wait, %llu bytes read by software "
+         "decoders",
+         _decodeStats.decodeMs, _decodeStats.ioWaitMs,
+         (unsigned long long) _decodeStats.numberBytesRead);
+    _index.close();
+
+    for (int i = 0; i < _numberFilesTotal && _filePaths != nullptr; i++) {
+        free(_filePaths[i]);
+    }
+    free(_filePaths);
+    _filePaths = nullptr;
+    free(_jobs);
+    _jobs = nullptr;
+    _isScanning = false;
+    pthread_mutex_unlock(&_mutex);
+
+    _soundSystemCallback->notifyScanCompleted(cancelled);
+}
@@ -0,0 +1,81 @@
+//
+// Created by Frederic on 02/05/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_LIBRARYSCANNER_H
+#define MINI_SOUND_SYSTEM_LIBRARYSCANNER_H
+
+#include <pthread.h>
+
+#include <SLES/OpenSLES.h>
+
+#include "FeatureIndex.h"
+#include "audio/AudioDecoder.h"
+#include "listener/SoundSystemCallback.h"
+#include "utils/ThreadPool.h"
+
+struct ScanJob;
+
+/**
+ * Decode and analyse a list of audio files in parallel on the thread pool, results are written in
+ * a FeatureIndex.
+ *
+ * Tracks already present in the index are skipped, so a cancelled or interrupted scan is resumed
+ * by scanning the same list again with the same index file.
+ */
+class LibraryScanner {
+public:
+    LibraryScanner(SoundSystemCallback *callback, ThreadPool *threadPool, SLEngineItf engine,
+                   int sampleRate, int bufferSize);
+    ~LibraryScanner();
+
+    /**
+     * Start scanning files in background. Progress and end of the scan are notified through the
+     * callback.
+     * @return false if a scan is already running or the index can't be opened.
+     */
+    bool scan(char **filePaths, int numberFiles, const char *indexPath);
+
+    /**
+     * Ask the running scan to stop as soon as possible. Tracks being decoded are not written.
+     */
+    void cancel();
+
+    bool isScanning();
+
+    //-------------------------
+    // - Workers, internal -
+    //-------------------------
+    void scanTrack(const char *filePath);
+
+private:
+
+    void onTrackScanned();
+
+    void finishScan();
+
+    SoundSystemCallback *_soundSystemCallback;
+    ThreadPool *_threadPool;
+    SLEngineItf _engine;
+    int _sampleRate;
+    int _bufferSize;
+
+    // protect the index and the scan state
+    pthread_mutex_t _mutex;
+    FeatureIndex _index;
+    bool _isScanning;
+    volatile bool _cancelled;
+
+    char **_filePaths;
+    ScanJob *_jobs;
+    int _numberFilesToScan;
+    int _numberFilesScanned;
+    int _numberFilesTotal;
+
+    double _scanStartTime;
+
+    // decode stats of the scanned tracks, to tell slow storage from slow decoding
+    DecodeStats _decodeStats;
+};
+
+#endif //MINI_SOUND_SYSTEM_LIBRARYSCANNER_H
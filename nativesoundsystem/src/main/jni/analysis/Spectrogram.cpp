@@ -0,0 +1,446 @@
+#include "Spectrogram.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <utils/android_debug.h>
+#include <utils/Tracer.h>
+
+#ifdef FLOAT_PLAYER
+#define SAMPLE_SCALE 0.5f
+#else
+#define SAMPLE_SCALE (0.5f / 32768.f)
+#endif
+
+// power of a full scale sine in its bin, with the gain of the Hann window
+#define FULL_SCALE_POWER ((SPECTROGRAM_FFT_SIZE / 4.f) * (SPECTROGRAM_FFT_SIZE / 4.f))
+
+#define ALL_LEVELS ((1u << SPECTROGRAM_NUMBER_LEVELS) - 1)
+
+// bytes of a tile in the budget, columns are allocated with it
+#define TILE_BYTES (sizeof(SpectrogramTile) + SPECTROGRAM_TILE_SIZE)
+
+typedef struct {
+    Spectrogram *spectrogram;
+    unsigned int chunk;
+} SpectrogramJob;
+
+static double now_ms(void) {
+    struct timespec res;
+    clock_gettime(CLOCK_MONOTONIC, &res);
+    return 1000.0 * res.tv_sec + (double) res.tv_nsec / 1e6;
+}
+
+static inline unsigned int getNumberTiles(int level) {
+    return (SPECTROGRAM_MAX_CHUNKS + (1u << level) - 1) >> level;
+}
+
+Spectrogram::Spectrogram(SoundSystem *soundSystem, ThreadPool *threadPool, size_t budgetBytes) :
+        _soundSystem(soundSystem),
+        _threadPool(threadPool),
+        _pages(nullptr),
+        _numberFrames(0),
+        _isComplete(false),
+        _numberChunks(0),
+        _numberReadyChunks(0),
+        _head(nullptr),
+        _tail(nullptr),
+        _budgetBytes(budgetBytes),
+        _usedBytes(0),
+        _numberTiles(0),
+        _computedChunks(0),
+        _computeMs(0),
+        _hits(0),
+        _misses(0),
+        _evictions(0) {
+    pthread_mutex_init(&_mutex, nullptr);
+    _pendingLevels = (uint8_t *) calloc(SPECTROGRAM_MAX_CHUNKS, sizeof(uint8_t));
+    for (int level = 0; level < SPECTROGRAM_NUMBER_LEVELS; level++) {
+        _tiles[level] = (SpectrogramTile **) calloc(getNumberTiles(level),
+                                                    sizeof(SpectrogramTile *));
+    }
+
+    // low bands are one bin wide until the logarithmic spacing is wider than a bin
+    const int numberBins = SPECTROGRAM_FFT_SIZE / 2 + 1;
+    const float binFrequency = (float) soundSystem->getSampleRate() / SPECTROGRAM_FFT_SIZE;
+    const float nyquistFrequency = soundSystem->getSampleRate() * 0.5f;
+    const int firstBin = (int) (SPECTROGRAM_MIN_FREQUENCY / binFrequency + 0.5f);
+    _bandBins[0] = firstBin > 0 ? firstBin : 1;
+    for (int band = 1; band <= SPECTROGRAM_NUMBER_BANDS; band++) {
+        const float ratio = (float) band / SPECTROGRAM_NUMBER_BANDS;
+        const float frequency = SPECTROGRAM_MIN_FREQUENCY
+                                * powf(nyquistFrequency / SPECTROGRAM_MIN_FREQUENCY, ratio);
+        int bin = (int) (frequency / binFrequency + 0.5f);
+        if (bin <= _bandBins[band - 1]) {
+            bin = _bandBins[band - 1] + 1;
+        }
+        _bandBins[band] = bin < numberBins ? bin : numberBins;
+    }
+    _bandBins[SPECTROGRAM_NUMBER_BANDS] = numberBins;
+
+    _soundSystem->addTrackListener(trackListener, this);
+}
+
+Spectrogram::~Spectrogram() {
+    _soundSystem->removeTrackListener(trackListener, this);
+    stop();
+    for (int level = 0; level < SPECTROGRAM_NUMBER_LEVELS; level++) {
+        free(_tiles[level]);
+    }
+    free(_pendingLevels);
+    pthread_mutex_destroy(&_mutex);
+}
+
+void Spectrogram::trackListener(void *context, int event, const PcmPages *pages) {
+    Spectrogram *self = static_cast<Spectrogram *>(context);
+    switch (event) {
+        case kTrackFramesAppended:
+            self->onFramesExtracted(pages, false);
+            break;
+        case kTrackCompleted:
+            self->onFramesExtracted(pages, true);
+            break;
+        case kTrackReleased:
+            self->stop();
+            break;
+        default:
+            break;
+    }
+}
+
+void Spectrogram::onFramesExtracted(const PcmPages *pages, bool isComplete) {
+    if (pages == nullptr) {
+        return;
+    }
+    pthread_mutex_lock(&_mutex);
+    _pages = pages;
+    _numberFrames = pages->getNumberFrames();
+    if (isComplete && !_isComplete) {
+        _isComplete = true;
+        const unsigned int numberColumns =
+                (_numberFrames + SPECTROGRAM_HOP_FRAMES - 1) / SPECTROGRAM_HOP_FRAMES;
+        _numberChunks = (numberColumns + SPECTROGRAM_TILE_COLUMNS - 1) / SPECTROGRAM_TILE_COLUMNS;
+    }
+    postReadyChunks();
+    pthread_mutex_unlock(&_mutex);
+}
+
+void Spectrogram::stop() {
+    pthread_mutex_lock(&_mutex);
+    _pages = nullptr;
+    pthread_mutex_unlock(&_mutex);
+
+    // running tasks read the pages of the track
+    _threadPool->cancel(this);
+    _threadPool->waitIdle(this);
+
+    pthread_mutex_lock(&_mutex);
+    clear();
+    pthread_mutex_unlock(&_mutex);
+}
+
+int Spectrogram::getTile(int level, unsigned int index, uint8_t *columns) {
+    if (level < 0 || level >= SPECTROGRAM_NUMBER_LEVELS || index >= getNumberTiles(level)) {
+        return kSpectrogramTileMissing;
+    }
+
+    int state = kSpectrogramTileMissing;
+    pthread_mutex_lock(&_mutex);
+    if (_pages != nullptr) {
+        SpectrogramTile *tile = _tiles[level][index];
+        if (tile != nullptr) {
+            memcpy(columns, tile->columns, SPECTROGRAM_TILE_SIZE);
+            unlink(tile);
+            pushFront(tile);
+            _hits++;
+            state = isTileComplete(tile) ? kSpectrogramTileComplete : kSpectrogramTilePartial;
+        } else {
+            _misses++;
+        }
+
+        // chunks not extracted yet are computed for every level once they are
+        if (state != kSpectrogramTileComplete) {
+            const unsigned int firstChunk = index << level;
+            const unsigned int endChunk = firstChunk + (1u << level) < _numberReadyChunks
+                                          ? firstChunk + (1u << level) : _numberReadyChunks;
+            for (unsigned int chunk = firstChunk; chunk < endChunk; chunk++) {
+                const unsigned int position = chunk - firstChunk;
+                if (tile == nullptr
+                    || (tile->writtenChunks[position >> 5] & (1u << (position & 31))) == 0) {
+                    requestChunk(chunk, 1u << level);
+                }
+            }
+        }
+    }
+    pthread_mutex_unlock(&_mutex);
+    return state;
+}
+
+unsigned int Spectrogram::getNumberColumns() {
+    pthread_mutex_lock(&_mutex);
+    const unsigned int numberColumns = _isComplete
+            ? (_numberFrames + SPECTROGRAM_HOP_FRAMES - 1) / SPECTROGRAM_HOP_FRAMES
+            : _numberFrames / SPECTROGRAM_HOP_FRAMES;
+    pthread_mutex_unlock(&_mutex);
+    return numberColumns;
+}
+
+void Spectrogram::setBudget(size_t budgetBytes) {
+    pthread_mutex_lock(&_mutex);
+    _budgetBytes = budgetBytes;
+    evictDownTo(_budgetBytes);
+    pthread_mutex_unlock(&_mutex);
+}
+
+void Spectrogram::getStats(SpectrogramStats *stats) {
+    pthread_mutex_lock(&_mutex);
+    stats->computedChunks = _computedChunks;
+    stats->computeMs = _computeMs;
+    stats->hits = _hits;
+    stats->misses = _misses;
+    stats->evictions = _evictions;
+    stats->numberTiles = _numberTiles;
+    stats->usedBytes = _usedBytes;
+    stats->budgetBytes = _budgetBytes;
+    pthread_mutex_unlock(&_mutex);
+}
+
+void Spectrogram::chunkTask(void *data) {
+    SpectrogramJob *job = (SpectrogramJob *) data;
+    job->spectrogram->computeChunk(job->chunk);
+    free(job);
+}
+
+void Spectrogram::cancelChunkTask(void *data) {
+    free(data);
+}
+
+void Spectrogram::computeChunk(unsigned int chunk) {
+    TRACE_SCOPE("spectrogramChunk");
+    pthread_mutex_lock(&_mutex);
+    const PcmPages *pages = _pages;
+    pthread_mutex_unlock(&_mutex);
+    if (pages == nullptr) {
+        return;
+    }
+
+    const double startTime = now_ms();
+    FFT fft(SPECTROGRAM_FFT_SIZE);
+    AUDIO_HARDWARE_SAMPLE_TYPE *frames = (AUDIO_HARDWARE_SAMPLE_TYPE *) malloc(
+            SPECTROGRAM_FFT_SIZE * 2 * sizeof(AUDIO_HARDWARE_SAMPLE_TYPE));
+    float *signal = (float *) malloc(SPECTROGRAM_FFT_SIZE * sizeof(float));
+    float *power = (float *) malloc((SPECTROGRAM_FFT_SIZE / 2 + 1) * sizeof(float));
+    uint8_t *columns = (uint8_t *) malloc(SPECTROGRAM_TILE_SIZE);
+
+    const bool isAllocated = frames != nullptr && signal != nullptr && power != nullptr
+                             && columns != nullptr;
+    if (isAllocated) {
+        const unsigned int firstFrame = chunk * SPECTROGRAM_CHUNK_FRAMES;
+        for (int column = 0; column < SPECTROGRAM_TILE_COLUMNS; column++) {
+            computeColumn(pages, firstFrame + column * SPECTROGRAM_HOP_FRAMES, &fft, frames, signal,
+                          power, columns + column * SPECTROGRAM_NUMBER_BANDS);
+        }
+    } else {
+        LOGE("Unable to allocate the spectrogram of chunk %u", chunk);
+    }
+
+    pthread_mutex_lock(&_mutex);
+    // the track may have been released while the chunk was computed
+    if (isAllocated && _pages == pages) {
+        writeChunk(chunk, _pendingLevels[chunk], columns);
+        _computedChunks++;
+        _computeMs += now_ms() - startTime;
+    }
+    _pendingLevels[chunk] = 0;
+    pthread_mutex_unlock(&_mutex);
+
+    free(frames);
+    free(signal);
+    free(power);
+    free(columns);
+}
+
+void Spectrogram::computeColumn(const PcmPages *pages, unsigned int startFrame, FFT *fft,
+                                AUDIO_HARDWARE_SAMPLE_TYPE *frames, float *signal, float *power,
+                                uint8_t *column) {
+    // frames after the end of the track are silent
+    if (pages->read(startFrame, frames, SPECTROGRAM_FFT_SIZE) == 0) {
+        memset(column, 0, SPECTROGRAM_NUMBER_BANDS);
+        return;
+    }
+    for (int i = 0; i < SPECTROGRAM_FFT_SIZE; i++) {
+        signal[i] = ((float) frames[i * 2] + (float) frames[i * 2 + 1]) * SAMPLE_SCALE;
+    }
+    fft->powerSpectrum(signal, power);
+
+    for (int band = 0; band < SPECTROGRAM_NUMBER_BANDS; band++) {
+        float bandPower = 0.f;
+        for (int bin = _bandBins[band]; bin < _bandBins[band + 1]; bin++) {
+            bandPower = power[bin] > bandPower ? power[bin] : bandPower;
+        }
+        const float levelDb = 10.f * log10f(bandPower * (1.f / FULL_SCALE_POWER) + 1e-20f);
+        const float level = 255.f * (1.f + levelDb / SPECTROGRAM_RANGE_DB);
+        column[band] = (uint8_t) (level <= 0.f ? 0.f : (level >= 255.f ? 255.f : level + 0.5f));
+    }
+}
+
+bool Spectrogram::isChunkReady(unsigned int chunk) const {
+    if (_isComplete) {
+        return chunk < _numberChunks;
+    }
+    // the last column of the chunk reads a whole transform
+    const uint64_t endFrame = (uint64_t) (chunk + 1) * SPECTROGRAM_CHUNK_FRAMES
+                              - SPECTROGRAM_HOP_FRAMES + SPECTROGRAM_FFT_SIZE;
+    return endFrame <= _numberFrames;
+}
+
+void Spectrogram::postReadyChunks() {
+    while (_numberReadyChunks < SPECTROGRAM_MAX_CHUNKS && isChunkReady(_numberReadyChunks)) {
+        requestChunk(_numberReadyChunks, ALL_LEVELS);
+        _numberReadyChunks++;
+    }
+}
+
+void Spectrogram::requestChunk(unsigned int chunk, unsigned int levels) {
+    if (_pendingLevels[chunk] == 0) {
+        SpectrogramJob *job = (SpectrogramJob *) malloc(sizeof(SpectrogramJob));
+        if (job == nullptr) {
+            return;
+        }
+        job->spectrogram = this;
+        job->chunk = chunk;
+        // the overview comes after the extraction of the decks
+        _threadPool->post(chunkTask, job, kTaskPriorityBackground, this, cancelChunkTask);
+    }
+    _pendingLevels[chunk] |= levels;
+}
+
+void Spectrogram::writeChunk(unsigned int chunk, unsigned int levels, const uint8_t *columns) {
+    for (int level = 0; level < SPECTROGRAM_NUMBER_LEVELS; level++) {
+        if ((levels & (1u << level)) == 0) {
+            continue;
+        }
+        SpectrogramTile *tile = acquireTile(level, chunk >> level);
+        if (tile == nullptr) {
+            continue;
+        }
+
+        // the chunk is reduced to a part of the tile
+        const unsigned int position = chunk & ((1u << level) - 1);
+        const int numberColumns = SPECTROGRAM_TILE_COLUMNS >> level;
+        uint8_t *dst = tile->columns + position * numberColumns * SPECTROGRAM_NUMBER_BANDS;
+        for (int column = 0; column < numberColumns; column++) {
+            const uint8_t *src = columns + (column << level) * SPECTROGRAM_NUMBER_BANDS;
+            memcpy(dst, src, SPECTROGRAM_NUMBER_BANDS);
+            for (int i = 1; i < (1 << level); i++) {
+                src += SPECTROGRAM_NUMBER_BANDS;
+                for (int band = 0; band < SPECTROGRAM_NUMBER_BANDS; band++) {
+                    dst[band] = src[band] > dst[band] ? src[band] : dst[band];
+                }
+            }
+            dst += SPECTROGRAM_NUMBER_BANDS;
+        }
+        tile->writtenChunks[position >> 5] |= 1u << (position & 31);
+    }
+}
+
+bool Spectrogram::isTileComplete(const SpectrogramTile *tile) const {
+    if (!_isComplete) {
+        return false;
+    }
+    const unsigned int firstChunk = tile->index << tile->level;
+    const unsigned int endChunk = firstChunk + (1u << tile->level) < _numberChunks
+                                  ? firstChunk + (1u << tile->level) : _numberChunks;
+    for (unsigned int chunk = firstChunk; chunk < endChunk; chunk++) {
+        const unsigned int position = chunk - firstChunk;
+        if ((tile->writtenChunks[position >> 5] & (1u << (position & 31))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+SpectrogramTile* Spectrogram::acquireTile(int level, unsigned int index) {
+    SpectrogramTile *tile = _tiles[level][index];
+    if (tile != nullptr) {
+        unlink(tile);
+        pushFront(tile);
+        return tile;
+    }
+
+    if (TILE_BYTES > _budgetBytes) {
+        return nullptr;
+    }
+    evictDownTo(_budgetBytes - TILE_BYTES);
+    tile = (SpectrogramTile *) calloc(1, TILE_BYTES);
+    if (tile == nullptr) {
+        return nullptr;
+    }
+    tile->level = level;
+    tile->index = index;
+    tile->columns = (uint8_t *) (tile + 1);
+    _tiles[level][index] = tile;
+    pushFront(tile);
+    _usedBytes += TILE_BYTES;
+    _numberTiles++;
+    return tile;
+}
+
+void Spectrogram::unlink(SpectrogramTile *tile) {
+    if (tile->previous != nullptr) {
+        tile->previous->next = tile->next;
+    } else {
+        _head = tile->next;
+    }
+    if (tile->next != nullptr) {
+        tile->next->previous = tile->previous;
+    } else {
+        _tail = tile->previous;
+    }
+    tile->previous = nullptr;
+    tile->next = nullptr;
+}
+
+void Spectrogram::pushFront(SpectrogramTile *tile) {
+    tile->previous = nullptr;
+    tile->next = _head;
+    if (_head != nullptr) {
+        _head->previous = tile;
+    } else {
+        _tail = tile;
+    }
+    _head = tile;
+}
+
+void Spectrogram::evict(SpectrogramTile *tile) {
+    unlink(tile);
+    _tiles[tile->level][tile->index] = nullptr;
+    _usedBytes -= TILE_BYTES;
+    _numberTiles--;
+    _evictions++;
+    free(tile);
+}
+
+void Spectrogram::evictDownTo(size_t budgetBytes) {
+    while (_tail != nullptr && _usedBytes > budgetBytes) {
+        evict(_tail);
+    }
+}
+
+void Spectrogram::clear() {
+    while (_head != nullptr) {
+        SpectrogramTile *tile = _head;
+        unlink(tile);
+        _tiles[tile->level][tile->index] = nullptr;
+        free(tile);
+    }
+    _usedBytes = 0;
+    _numberTiles = 0;
+    memset(_pendingLevels, 0, SPECTROGRAM_MAX_CHUNKS * sizeof(uint8_t));
+    _numberFrames = 0;
+    _isComplete = false;
+    _numberChunks = 0;
+    _numberReadyChunks = 0;
+}
@@ -0,0 +1,190 @@
+//
+// Created by Frederic on 15/06/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_SPECTROGRAM_H
+#define MINI_SOUND_SYSTEM_SPECTROGRAM_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "audio/PcmPages.h"
+#include "audio/SoundSystem.h"
+#include "dsp/FFT.h"
+#include "utils/ThreadPool.h"
+
+// frames of each transform, and between the first frames of two columns
+#define SPECTROGRAM_FFT_SIZE 1024
+#define SPECTROGRAM_HOP_FRAMES 512
+
+// bands of a column, spaced logarithmically from SPECTROGRAM_MIN_FREQUENCY to the Nyquist frequency
+#define SPECTROGRAM_NUMBER_BANDS 128
+#define SPECTROGRAM_MIN_FREQUENCY 30.0f
+
+// a band is quantized from 255 for a full scale sine down to 0 at -SPECTROGRAM_RANGE_DB
+#define SPECTROGRAM_RANGE_DB 96.0f
+
+// columns of a tile. A column of level n is the maximum of 2^n columns of level 0
+#define SPECTROGRAM_TILE_COLUMNS 256
+#define SPECTROGRAM_NUMBER_LEVELS 8
+#define SPECTROGRAM_TILE_SIZE (SPECTROGRAM_TILE_COLUMNS * SPECTROGRAM_NUMBER_BANDS)
+
+// a chunk is the part of the track of a tile of level 0, computed by one task
+#define SPECTROGRAM_CHUNK_FRAMES (SPECTROGRAM_TILE_COLUMNS * SPECTROGRAM_HOP_FRAMES)
+#define SPECTROGRAM_MAX_CHUNKS ((PCM_MAX_PAGES * PCM_PAGE_FRAMES) / SPECTROGRAM_CHUNK_FRAMES)
+
+// default memory budget of the tiles
+#define SPECTROGRAM_DEFAULT_BUDGET_BYTES (16 * 1024 * 1024)
+
+// state of a tile copied by getTile
+enum SpectrogramTileState {
+    // not computed yet, or evicted : it is computed again
+    kSpectrogramTileMissing = 0,
+    // columns not computed yet are 0
+    kSpectrogramTilePartial,
+    kSpectrogramTileComplete,
+};
+
+typedef struct SpectrogramTile {
+    int level;
+    unsigned int index;
+    // SPECTROGRAM_TILE_COLUMNS columns of SPECTROGRAM_NUMBER_BANDS bands, lowest band first
+    uint8_t *columns;
+    // chunks written to the tile, one bit per chunk from the first chunk of the tile
+    uint32_t writtenChunks[((1 << (SPECTROGRAM_NUMBER_LEVELS - 1)) + 31) / 32];
+    // least recently used list, most recent first
+    SpectrogramTile *previous;
+    SpectrogramTile *next;
+} SpectrogramTile;
+
+typedef struct {
+    uint32_t computedChunks;
+    double computeMs;
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions;
+    uint32_t numberTiles;
+    uint64_t usedBytes;
+    uint64_t budgetBytes;
+} SpectrogramStats;
+
+/**
+ * Spectrogram of the loaded track for its overview, computed while the track is extracted.
+ *
+ * Each chunk of the track is transformed by a task of the thread pool, so that chunks are computed
+ * in parallel as soon as their frames are extracted. Columns are quantized to 8 bits log magnitudes
+ * in tiles of several zoom levels. Tiles are evicted, least recently used first, to stay within the
+ * memory budget, and computed again when they are requested.
+ */
+class Spectrogram {
+public:
+    /**
+     * Follow the tracks loaded by soundSystem from now on.
+     */
+    Spectrogram(SoundSystem *soundSystem, ThreadPool *threadPool, size_t budgetBytes);
+    Spectrogram& operator=(const Spectrogram& ) = delete;
+    Spectrogram(Spectrogram&) = delete;
+    ~Spectrogram();
+
+    /**
+     * Copy a tile, and compute again the part of it which is missing.
+     * @param columns SPECTROGRAM_TILE_SIZE bytes, not written if the tile is missing.
+     * @return a SpectrogramTileState.
+     */
+    int getTile(int level, unsigned int index, uint8_t *columns);
+
+    /**
+     * Columns of level 0 of the loaded track, growing while it is extracted.
+     */
+    unsigned int getNumberColumns();
+
+    // tiles are evicted if they don't fit anymore
+    void setBudget(size_t budgetBytes);
+
+    void getStats(SpectrogramStats *stats);
+
+private:
+
+    static void trackListener(void *context, int event, const PcmPages *pages);
+
+    void onFramesExtracted(const PcmPages *pages, bool isComplete);
+
+    // drop the tasks and the tiles of the track, which is about to be released
+    void stop();
+
+    static void chunkTask(void *data);
+
+    static void cancelChunkTask(void *data);
+
+    void computeChunk(unsigned int chunk);
+
+    // spectrum of the frames from startFrame, quantized to column
+    void computeColumn(const PcmPages *pages, unsigned int startFrame, FFT *fft,
+                       AUDIO_HARDWARE_SAMPLE_TYPE *frames, float *signal, float *power,
+                       uint8_t *column);
+
+    // the following methods are called with the mutex locked
+
+    bool isChunkReady(unsigned int chunk) const;
+
+    // post tasks of the chunks whose frames have been extracted since the last call
+    void postReadyChunks();
+
+    // compute chunk for the tiles of levels, a mask of one bit per level
+    void requestChunk(unsigned int chunk, unsigned int levels);
+
+    // reduce the columns of a chunk to the tiles of levels
+    void writeChunk(unsigned int chunk, unsigned int levels, const uint8_t *columns);
+
+    bool isTileComplete(const SpectrogramTile *tile) const;
+
+    // create the tile if it fits in the budget
+    SpectrogramTile* acquireTile(int level, unsigned int index);
+
+    void unlink(SpectrogramTile *tile);
+
+    void pushFront(SpectrogramTile *tile);
+
+    void evict(SpectrogramTile *tile);
+
+    void evictDownTo(size_t budgetBytes);
+
+    void clear();
+
+    SoundSystem *_soundSystem;
+    ThreadPool *_threadPool;
+
+    // first FFT bin of each band, and end of the last band
+    int _bandBins[SPECTROGRAM_NUMBER_BANDS + 1];
+
+    pthread_mutex_t _mutex;
+
+    // track followed, null while no frame has been extracted
+    const PcmPages *_pages;
+    unsigned int _numberFrames;
+    bool _isComplete;
+    // known when the track is complete
+    unsigned int _numberChunks;
+    // chunks before this one have been posted once
+    unsigned int _numberReadyChunks;
+    // levels requested for each chunk and not written yet, a task is posted while not 0
+    uint8_t *_pendingLevels;
+
+    // tiles of each level by index
+    SpectrogramTile **_tiles[SPECTROGRAM_NUMBER_LEVELS];
+    SpectrogramTile *_head;
+    SpectrogramTile *_tail;
+
+    size_t _budgetBytes;
+    size_t _usedBytes;
+    uint32_t _numberTiles;
+
+    uint32_t _computedChunks;
+    double _computeMs;
+    uint32_t _hits;
+    uint32_t _misses;
+    uint32_t _evictions;
+};
+
+#endif //MINI_SOUND_SYSTEM_SPECTROGRAM_H
@@ -0,0 +1,81 @@
+//
+// Created by Frederic on 16/06/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_TRACKANALYZER_H
+#define MINI_SOUND_SYSTEM_TRACKANALYZER_H
+
+#include <stdint.h>
+
+#include "audio/SampleType.h"
+
+// frames given at once to every analyzer, small enough to stay in the data cache between analyzers
+#define ANALYSIS_BLOCK_FRAMES 1024
+
+// analyzers of the loaded track, one of each type at most
+enum TrackAnalyzerType {
+    kAnalyzerPeak = 0,
+    kAnalyzerRms,
+    kAnalyzerSilence,
+    kAnalyzerLoudness,
+    kAnalyzerOnset,
+    kAnalyzerKey,
+    kAnalyzerCount,
+};
+
+// results of the analyzers on the stored frames of the loaded track
+typedef struct {
+    // frames analysed, every stored frame once complete
+    uint32_t numberFrames;
+    bool isComplete;
+    // 1 is full scale
+    float peak;
+    float rms;
+    // in stored frames
+    uint32_t firstAudibleFrame;
+    uint32_t lastAudibleFrame;
+    // integrated loudness in LUFS, see ITU-R BS.1770
+    float loudness;
+    uint32_t numberOnsets;
+    // 0 to 11 for the major keys from C, 12 to 23 for the minor keys from C, -1 if unknown
+    int32_t key;
+    // correlation of the chroma of the track with the profile of the key, from -1 to 1
+    float keyStrength;
+    // time spent in each analyzer, and in the whole pass including the reading of the pages
+    double analyzerMs[kAnalyzerCount];
+    double totalMs;
+    // tasks run by the thread pool for the pass
+    uint32_t numberTasks;
+} TrackAnalysis;
+
+/**
+ * Analysis of a track fed with consecutive blocks of stored frames, while the track is extracted.
+ * An analyzer is only called by one thread at a time, and never keeps the frames.
+ */
+class TrackAnalyzer {
+public:
+    virtual ~TrackAnalyzer() {}
+
+    // a TrackAnalyzerType
+    virtual int getType() = 0;
+
+    // forget the previous track
+    virtual void reset() = 0;
+
+    // interleaved stereo frames, at most ANALYSIS_BLOCK_FRAMES
+    virtual void process(const AUDIO_HARDWARE_SAMPLE_TYPE *frames, unsigned int numberFrames) = 0;
+
+    // write the results of the whole track, called once after the last frame
+    virtual void finish(TrackAnalysis *analysis) = 0;
+
+    /**
+     * Values computed along the track, valid from finish until reset.
+     * @return number of values, 0 if the analyzer has no curve.
+     */
+    virtual unsigned int getCurve(const float **values) {
+        *values = nullptr;
+        return 0;
+    }
+};
+
+#endif //MINI_SOUND_SYSTEM_TRACKANALYZER_H
@@ -0,0 +1,689 @@
+#include "TrackAnalyzers.h"
+
+#include <climits>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <utils/android_debug.h>
+#include <utils/Tracer.h>
+
+#include "dsp/FFT.h"
+
+#ifdef FLOAT_PLAYER
+#define FULL_SCALE 1.f
+#else
+#define FULL_SCALE ((float) SHRT_MAX)
+#endif
+
+// gating of the loudness, see ITU-R BS.1770
+#define LOUDNESS_ABSOLUTE_GATE -70.0
+#define LOUDNESS_RELATIVE_GATE -10.0
+#define SUB_BLOCKS_PER_GATING_BLOCK 4
+
+// energy of a hop under which the onset envelope doesn't rise, so that noise after silence is not
+// an onset
+#define ONSET_ENERGY_FLOOR 1e-7f
+
+// frames of the decimated signal of a chunk, the last transforms of two chunks overlap
+#define KEY_CHUNK_CAPACITY ((ANALYSIS_KEY_CHUNK_TRANSFORMS - 1) * ANALYSIS_KEY_HOP_FRAMES \
+                            + ANALYSIS_KEY_FFT_SIZE)
+#define KEY_MAX_DECIMATION 16
+
+// range of the notes of the chroma, C2 to C7
+#define KEY_MIN_FREQUENCY 65.41f
+#define KEY_MAX_FREQUENCY 2093.f
+#define KEY_C0_FREQUENCY 16.3516f
+
+// transforms whose highest pitch class is 60 dB under a full scale sine are silent
+#define KEY_SILENCE_MAGNITUDE (ANALYSIS_KEY_FFT_SIZE / 4 * 1e-3f)
+
+// probe tone ratings of the degrees of major and minor keys, from Krumhansl and Kessler
+static const float MAJOR_PROFILE[12] = {6.35f, 2.23f, 3.48f, 2.33f, 4.38f, 4.09f,
+                                        2.52f, 5.19f, 2.39f, 3.66f, 2.29f, 2.88f};
+static const float MINOR_PROFILE[12] = {6.33f, 2.68f, 3.52f, 5.38f, 2.60f, 3.53f,
+                                        2.54f, 4.75f, 3.98f, 2.69f, 3.34f, 3.17f};
+
+typedef struct KeyChunk {
+    unsigned int numberFrames;
+    // KEY_CHUNK_CAPACITY frames allocated with the chunk
+    float *frames;
+    KeyChunk *next;
+} KeyChunk;
+
+static double now_ms(void) {
+    struct timespec res;
+    clock_gettime(CLOCK_MONOTONIC, &res);
+    return 1000.0 * res.tv_sec + (double) res.tv_nsec / 1e6;
+}
+
+static KeyChunk* createKeyChunk() {
+    KeyChunk *chunk = (KeyChunk *) malloc(sizeof(KeyChunk) + KEY_CHUNK_CAPACITY * sizeof(float));
+    if (chunk == nullptr) {
+        return nullptr;
+    }
+    chunk->numberFrames = 0;
+    chunk->frames = (float *) (chunk + 1);
+    chunk->next = nullptr;
+    return chunk;
+}
+
+// Pearson correlation of a chroma with the profile moved to a tonic
+static float correlate(const float *chroma, const float *profile, int tonic) {
+    float chromaMean = 0.f;
+    float profileMean = 0.f;
+    for (int i = 0; i < 12; i++) {
+        chromaMean += chroma[i];
+        profileMean += profile[i];
+    }
+    chromaMean /= 12.f;
+    profileMean /= 12.f;
+
+    float product = 0.f;
+    float chromaSquares = 0.f;
+    float profileSquares = 0.f;
+    for (int pitchClass = 0; pitchClass < 12; pitchClass++) {
+        const float x = chroma[pitchClass] - chromaMean;
+        const float y = profile[(pitchClass - tonic + 12) % 12] - profileMean;
+        product += x * y;
+        chromaSquares += x * x;
+        profileSquares += y * y;
+    }
+    const float norm = sqrtf(chromaSquares * profileSquares);
+    return norm > 0.f ? product / norm : 0.f;
+}
+
+static inline double meanSquareToLoudness(double meanSquare) {
+    return -0.691 + 10.0 * log10(meanSquare);
+}
+
+static inline double filter(const double *coefficients, double *state, double input) {
+    const double output = coefficients[0] * input + coefficients[1] * state[0]
+                          + coefficients[2] * state[1] - coefficients[3] * state[2]
+                          - coefficients[4] * state[3];
+    state[1] = state[0];
+    state[0] = input;
+    state[3] = state[2];
+    state[2] = output;
+    return output;
+}
+
+PeakAnalyzer::PeakAnalyzer() {
+    reset();
+}
+
+int PeakAnalyzer::getType() {
+    return kAnalyzerPeak;
+}
+
+void PeakAnalyzer::reset() {
+    _peak = 0.f;
+}
+
+void PeakAnalyzer::process(const AUDIO_HARDWARE_SAMPLE_TYPE *frames, unsigned int numberFrames) {
+    const float peak = SilenceDetector::computePeak(frames, numberFrames * 2);
+    _peak = peak > _peak ? peak : _peak;
+}
+
+void PeakAnalyzer::finish(TrackAnalysis *analysis) {
+    analysis->peak = _peak / FULL_SCALE;
+}
+
+RmsAnalyzer::RmsAnalyzer() {
+    reset();
+}
+
+int RmsAnalyzer::getType() {
+    return kAnalyzerRms;
+}
+
+void RmsAnalyzer::reset() {
+    _sumSquares = 0;
+    _numberSamples = 0;
+}
+
+void RmsAnalyzer::process(const AUDIO_HARDWARE_SAMPLE_TYPE *frames, unsigned int numberFrames) {
+    // independent sums, so that the additions don't wait for each other
+    float sums[4] = {0.f, 0.f, 0.f, 0.f};
+    const unsigned int numberSamples = numberFrames * 2;
+    unsigned int i = 0;
+    for (; i + 4 <= numberSamples; i += 4) {
+        for (int lane = 0; lane < 4; lane++) {
+            const float sample = (float) frames[i + lane];
+            sums[lane] += sample * sample;
+        }
+    }
+    for (; i < numberSamples; i++) {
+        sums[0] += (float) frames[i] * (float) frames[i];
+    }
+    _sumSquares += (double) sums[0] + sums[1] + sums[2] + sums[3];
+    _numberSamples += numberSamples;
+}
+
+void RmsAnalyzer::finish(TrackAnalysis *analysis) {
+    analysis->rms = _numberSamples == 0 ? 0.f
+                                        : (float) sqrt(_sumSquares / _numberSamples) / FULL_SCALE;
+}
+
+SilenceAnalyzer::SilenceAnalyzer(int sampleRate) :
+        _silenceDetector(sampleRate) {
+}
+
+int SilenceAnalyzer::getType() {
+    return kAnalyzerSilence;
+}
+
+void SilenceAnalyzer::reset() {
+    _silenceDetector.reset();
+}
+
+void SilenceAnalyzer::process(const AUDIO_HARDWARE_SAMPLE_TYPE *frames,
+                              unsigned int numberFrames) {
+    _silenceDetector.process(frames, numberFrames);
+}
+
+void SilenceAnalyzer::finish(TrackAnalysis *analysis) {
+    analysis->firstAudibleFrame = _silenceDetector.getFirstAudibleFrame();
+    analysis->lastAudibleFrame = _silenceDetector.getLastAudibleFrame();
+}
+
+LoudnessAnalyzer::LoudnessAnalyzer(int sampleRate) :
+        _subBlocks(nullptr),
+        _subBlocksCapacity(0) {
+    const double rate = sampleRate > 0 ? sampleRate : 44100;
+    _subBlockSize = (unsigned int) (rate / 10);
+
+    // filters of the K-weighting computed for the sample rate, see ITU-R BS.1770
+    double k = tan(M_PI * 1681.974450955533 / rate);
+    const double quality = 0.7071752369554196;
+    const double highGain = pow(10.0, 3.999843853973347 / 20.0);
+    const double bandGain = pow(highGain, 0.4996667741545416);
+    double a0 = 1.0 + k / quality + k * k;
+    _shelf[0] = (highGain + bandGain * k / quality + k * k) / a0;
+    _shelf[1] = 2.0 * (k * k - highGain) / a0;
+    _shelf[2] = (highGain - bandGain * k / quality + k * k) / a0;
+    _shelf[3] = 2.0 * (k * k - 1.0) / a0;
+    _shelf[4] = (1.0 - k / quality + k * k) / a0;
+
+    k = tan(M_PI * 38.13547087602444 / rate);
+    const double highPassQuality = 0.5003270373238773;
+    a0 = 1.0 + k / highPassQuality + k * k;
+    _highPass[0] = 1.0;
+    _highPass[1] = -2.0;
+    _highPass[2] = 1.0;
+    _highPass[3] = 2.0 * (k * k - 1.0) / a0;
+    _highPass[4] = (1.0 - k / highPassQuality + k * k) / a0;
+
+    reset();
+}
+
+LoudnessAnalyzer::~LoudnessAnalyzer() {
+    free(_subBlocks);
+}
+
+int LoudnessAnalyzer::getType() {
+    return kAnalyzerLoudness;
+}
+
+void LoudnessAnalyzer::reset() {
+    memset(_shelfState, 0, sizeof(_shelfState));
+    memset(_highPassState, 0, sizeof(_highPassState));
+    _numberSubBlocks = 0;
+    _currentSubBlockSum = 0;
+    _currentSubBlockFrames = 0;
+}
+
+void LoudnessAnalyzer::process(const AUDIO_HARDWARE_SAMPLE_TYPE *frames,
+                               unsigned int numberFrames) {
+    const double scale = 1.0 / FULL_SCALE;
+    for (unsigned int i = 0; i < numberFrames; i++) {
+        for (int channel = 0; channel < 2; channel++) {
+            const double input = frames[i * 2 + channel] * scale;
+            const double output = filter(_highPass, _highPassState[channel],
+                                         filter(_shelf, _shelfState[channel], input));
+            // channels are summed, as BS.1770 does for front channels
+            _currentSubBlockSum += output * output;
+        }
+        if (++_currentSubBlockFrames == _subBlockSize) {
+            endSubBlock();
+        }
+    }
+}
+
+void LoudnessAnalyzer::endSubBlock() {
+    if (_numberSubBlocks == _subBlocksCapacity) {
+        const unsigned int capacity = _subBlocksCapacity == 0 ? 1024 : _subBlocksCapacity * 2;
+        float *subBlocks = (float *) realloc(_subBlocks, capacity * sizeof(float));
+        if (subBlocks == nullptr) {
+            _currentSubBlockSum = 0;
+            _currentSubBlockFrames = 0;
+            return;
+        }
+        _subBlocks = subBlocks;
+        _subBlocksCapacity = capacity;
+    }
+    _subBlocks[_numberSubBlocks++] = (float) (_currentSubBlockSum / _currentSubBlockFrames);
+    _currentSubBlockSum = 0;
+    _currentSubBlockFrames = 0;
+}
+
+void LoudnessAnalyzer::finish(TrackAnalysis *analysis) {
+    // gated loudness over overlapping 400ms blocks, computed again for each gate
+    double sumAboveAbsoluteGate = 0;
+    unsigned int numberAboveAbsoluteGate = 0;
+    const unsigned int numberBlocks = _numberSubBlocks >= SUB_BLOCKS_PER_GATING_BLOCK
+                                      ? _numberSubBlocks - SUB_BLOCKS_PER_GATING_BLOCK + 1 : 0;
+    for (unsigned int i = 0; i < numberBlocks; i++) {
+        double meanSquare = 0;
+        for (int j = 0; j < SUB_BLOCKS_PER_GATING_BLOCK; j++) {
+            meanSquare += _subBlocks[i + j];
+        }
+        meanSquare /= SUB_BLOCKS_PER_GATING_BLOCK;
+        if (meanSquare > 0 && meanSquareToLoudness(meanSquare) > LOUDNESS_ABSOLUTE_GATE) {
+            sumAboveAbsoluteGate += meanSquare;
+            numberAboveAbsoluteGate++;
+        }
+    }
+
+    analysis->loudness = (float) LOUDNESS_ABSOLUTE_GATE;
+    if (numberAboveAbsoluteGate == 0) {
+        return;
+    }
+    const double relativeGate = meanSquareToLoudness(sumAboveAbsoluteGate / numberAboveAbsoluteGate)
+                                + LOUDNESS_RELATIVE_GATE;
+    double sumGated = 0;
+    unsigned int numberGated = 0;
+    for (unsigned int i = 0; i < numberBlocks; i++) {
+        double meanSquare = 0;
+        for (int j = 0; j < SUB_BLOCKS_PER_GATING_BLOCK; j++) {
+            meanSquare += _subBlocks[i + j];
+        }
+        meanSquare /= SUB_BLOCKS_PER_GATING_BLOCK;
+        if (meanSquare > 0) {
+            const double loudness = meanSquareToLoudness(meanSquare);
+            if (loudness > LOUDNESS_ABSOLUTE_GATE && loudness > relativeGate) {
+                sumGated += meanSquare;
+                numberGated++;
+            }
+        }
+    }
+    if (numberGated > 0) {
+        analysis->loudness = (float) meanSquareToLoudness(sumGated / numberGated);
+    }
+}
+
+OnsetAnalyzer::OnsetAnalyzer() :
+        _envelope(nullptr),
+        _envelopeCapacity(0) {
+    reset();
+}
+
+OnsetAnalyzer::~OnsetAnalyzer() {
+    free(_envelope);
+}
+
+int OnsetAnalyzer::getType() {
+    return kAnalyzerOnset;
+}
+
+void OnsetAnalyzer::reset() {
+    _envelopeLength = 0;
+    _previousEnergy = ONSET_ENERGY_FLOOR;
+    _currentHopSum = 0;
+    _currentHopFrames = 0;
+}
+
+void OnsetAnalyzer::process(const AUDIO_HARDWARE_SAMPLE_TYPE *frames, unsigned int numberFrames) {
+    while (numberFrames > 0) {
+        const unsigned int remainingFrames = ANALYSIS_ONSET_HOP_FRAMES - _currentHopFrames;
+        const unsigned int count = numberFrames < remainingFrames ? numberFrames : remainingFrames;
+        // energy of the mono signal
+        float sum = 0.f;
+        for (unsigned int i = 0; i < count; i++) {
+            const float sample = (float) frames[i * 2] + (float) frames[i * 2 + 1];
+            sum += sample * sample;
+        }
+        _currentHopSum += sum;
+        _currentHopFrames += count;
+        if (_currentHopFrames == ANALYSIS_ONSET_HOP_FRAMES) {
+            endHop();
+        }
+        frames += count * 2;
+        numberFrames -= count;
+    }
+}
+
+void OnsetAnalyzer::endHop() {
+    if (_envelopeLength == _envelopeCapacity) {
+        const unsigned int capacity = _envelopeCapacity == 0 ? 4096 : _envelopeCapacity * 2;
+        float *envelope = (float *) realloc(_envelope, capacity * sizeof(float));
+        if (envelope == nullptr) {
+            _currentHopSum = 0;
+            _currentHopFrames = 0;
+            return;
+        }
+        _envelope = envelope;
+        _envelopeCapacity = capacity;
+    }
+
+    const float scale = 1.f / (2.f * FULL_SCALE);
+    float energy = (float) (_currentHopSum / _currentHopFrames) * scale * scale;
+    energy = energy > ONSET_ENERGY_FLOOR ? energy : ONSET_ENERGY_FLOOR;
+    const float rise = 10.f * log10f(energy / _previousEnergy);
+    _envelope[_envelopeLength++] = rise > 0.f ? rise : 0.f;
+    _previousEnergy = energy;
+    _currentHopSum = 0;
+    _currentHopFrames = 0;
+}
+
+void OnsetAnalyzer::finish(TrackAnalysis *analysis) {
+    if (_currentHopFrames > 0) {
+        endHop();
+    }
+    uint32_t numberOnsets = 0;
+    for (unsigned int i = 0; i < _envelopeLength; i++) {
+        const float value = _envelope[i];
+        if (value >= ANALYSIS_ONSET_THRESHOLD_DB
+            && (i == 0 || value > _envelope[i - 1])
+            && (i + 1 == _envelopeLength || value >= _envelope[i + 1])) {
+            numberOnsets++;
+        }
+    }
+    analysis->numberOnsets = numberOnsets;
+}
+
+unsigned int OnsetAnalyzer::getCurve(const float **values) {
+    *values = _envelope;
+    return _envelopeLength;
+}
+
+KeyAnalyzer::KeyAnalyzer(int sampleRate, ThreadPool *threadPool) :
+        _threadPool(threadPool),
+        _chunk(nullptr),
+        _pendingHead(nullptr),
+        _pendingTail(nullptr),
+        _numberRunningChunks(0) {
+    pthread_mutex_init(&_mutex, nullptr);
+    pthread_cond_init(&_chunksDone, nullptr);
+
+    const int rate = sampleRate > 0 ? sampleRate : 44100;
+    _decimation = (rate + ANALYSIS_KEY_SAMPLE_RATE / 2) / ANALYSIS_KEY_SAMPLE_RATE;
+    _decimation = _decimation < 1 ? 1 : (_decimation > KEY_MAX_DECIMATION ? KEY_MAX_DECIMATION
+                                                                          : _decimation);
+    const float binFrequency = (float) rate / _decimation / ANALYSIS_KEY_FFT_SIZE;
+    for (int bin = 0; bin <= ANALYSIS_KEY_FFT_SIZE / 2; bin++) {
+        const float frequency = bin * binFrequency;
+        if (frequency < KEY_MIN_FREQUENCY || frequency > KEY_MAX_FREQUENCY) {
+            _binPitchClasses[bin] = -1;
+        } else {
+            const int note = (int) lroundf(12.f * log2f(frequency / KEY_C0_FREQUENCY));
+            _binPitchClasses[bin] = (int8_t) (note % 12);
+        }
+    }
+
+    _firstSum = 0;
+    _secondSum = 0;
+    memset(_firstHistory, 0, sizeof(_firstHistory));
+    memset(_secondHistory, 0, sizeof(_secondHistory));
+    _historyPosition = 0;
+    _decimationPhase = 0;
+    memset(_chroma, 0, sizeof(_chroma));
+    _workerMs = 0;
+}
+
+KeyAnalyzer::~KeyAnalyzer() {
+    reset();
+    // tasks finding no chunk may still be returning
+    _threadPool->waitIdle(this);
+    pthread_cond_destroy(&_chunksDone);
+    pthread_mutex_destroy(&_mutex);
+}
+
+int KeyAnalyzer::getType() {
+    return kAnalyzerKey;
+}
+
+void KeyAnalyzer::reset() {
+    pthread_mutex_lock(&_mutex);
+    while (_pendingHead != nullptr) {
+        KeyChunk *chunk = _pendingHead;
+        _pendingHead = chunk->next;
+        free(chunk);
+    }
+    _pendingTail = nullptr;
+    pthread_mutex_unlock(&_mutex);
+
+    _threadPool->cancel(this);
+
+    pthread_mutex_lock(&_mutex);
+    while (_numberRunningChunks > 0) {
+        pthread_cond_wait(&_chunksDone, &_mutex);
+    }
+    memset(_chroma, 0, sizeof(_chroma));
+    _workerMs = 0;
+    pthread_mutex_unlock(&_mutex);
+
+    free(_chunk);
+    _chunk = nullptr;
+    _firstSum = 0;
+    _secondSum = 0;
+    memset(_firstHistory, 0, sizeof(_firstHistory));
+    memset(_secondHistory, 0, sizeof(_secondHistory));
+    _historyPosition = 0;
+    _decimationPhase = 0;
+}
+
+void KeyAnalyzer::process(const AUDIO_HARDWARE_SAMPLE_TYPE *frames, unsigned int numberFrames) {
+    if (_chunk == nullptr) {
+        _chunk = createKeyChunk();
+        if (_chunk == nullptr) {
+            return;
+        }
+    }
+    const float scale = 0.5f / FULL_SCALE;
+    const double normalization = 1.0 / (_decimation * _decimation);
+    for (unsigned int i = 0; i < numberFrames; i++) {
+        const float sample = ((float) frames[i * 2] + (float) frames[i * 2 + 1]) * scale;
+        _firstSum += sample - _firstHistory[_historyPosition];
+        _firstHistory[_historyPosition] = sample;
+        _secondSum += _firstSum - _secondHistory[_historyPosition];
+        _secondHistory[_historyPosition] = _firstSum;
+        _historyPosition = _historyPosition + 1 < _decimation ? _historyPosition + 1 : 0;
+
+        if (++_decimationPhase < _decimation) {
+            continue;
+        }
+        _decimationPhase = 0;
+        _chunk->frames[_chunk->numberFrames++] = (float) (_secondSum * normalization);
+        if (_chunk->numberFrames == KEY_CHUNK_CAPACITY) {
+            submitChunk();
+            if (_chunk == nullptr) {
+                return;
+            }
+        }
+    }
+}
+
+void KeyAnalyzer::submitChunk() {
+    KeyChunk *chunk = _chunk;
+    _chunk = createKeyChunk();
+    if (_chunk != nullptr) {
+        const unsigned int overlap = ANALYSIS_KEY_FFT_SIZE - ANALYSIS_KEY_HOP_FRAMES;
+        memcpy(_chunk->frames, chunk->frames + chunk->numberFrames - overlap,
+               overlap * sizeof(float));
+        _chunk->numberFrames = overlap;
+    }
+
+    pthread_mutex_lock(&_mutex);
+    if (_pendingTail != nullptr) {
+        _pendingTail->next = chunk;
+    } else {
+        _pendingHead = chunk;
+    }
+    _pendingTail = chunk;
+    pthread_mutex_unlock(&_mutex);
+    _threadPool->post(chunkTask, this, kTaskPriorityBackground, this);
+}
+
+void KeyAnalyzer::chunkTask(void *data) {
+    TRACE_SCOPE("keyChunk");
+    static_cast<KeyAnalyzer *>(data)->computePendingChunk(true);
+}
+
+bool KeyAnalyzer::computePendingChunk(bool isWorker) {
+    pthread_mutex_lock(&_mutex);
+    KeyChunk *chunk = _pendingHead;
+    if (chunk == nullptr) {
+        pthread_mutex_unlock(&_mutex);
+        return false;
+    }
+    _pendingHead = chunk->next;
+    if (_pendingHead == nullptr) {
+        _pendingTail = nullptr;
+    }
+    _numberRunningChunks++;
+    pthread_mutex_unlock(&_mutex);
+
+    const double startTime = now_ms();
+    float chroma[12] = {};
+    computeChroma(chunk, chroma);
+    free(chunk);
+
+    pthread_mutex_lock(&_mutex);
+    for (int pitchClass = 0; pitchClass < 12; pitchClass++) {
+        _chroma[pitchClass] += chroma[pitchClass];
+    }
+    if (isWorker) {
+        _workerMs += now_ms() - startTime;
+    }
+    if (--_numberRunningChunks == 0) {
+        pthread_cond_broadcast(&_chunksDone);
+    }
+    pthread_mutex_unlock(&_mutex);
+    return true;
+}
+
+void KeyAnalyzer::computeChroma(const KeyChunk *chunk, float *chroma) {
+    FFT fft(ANALYSIS_KEY_FFT_SIZE);
+    float *power = (float *) malloc((ANALYSIS_KEY_FFT_SIZE / 2 + 1) * sizeof(float));
+    if (power == nullptr) {
+        LOGE("Unable to allocate the spectrum of a key chunk");
+        return;
+    }
+    for (unsigned int start = 0; start + ANALYSIS_KEY_FFT_SIZE <= chunk->numberFrames;
+         start += ANALYSIS_KEY_HOP_FRAMES) {
+        fft.powerSpectrum(chunk->frames + start, power);
+        float transformChroma[12] = {};
+        for (int bin = 0; bin <= ANALYSIS_KEY_FFT_SIZE / 2; bin++) {
+            if (_binPitchClasses[bin] >= 0) {
+                transformChroma[_binPitchClasses[bin]] += sqrtf(power[bin]);
+            }
+        }
+
+        // each transform weighs the same, so that loud parts don't decide the key alone
+        float highest = 0.f;
+        for (int pitchClass = 0; pitchClass < 12; pitchClass++) {
+            highest = transformChroma[pitchClass] > highest ? transformChroma[pitchClass] : highest;
+        }
+        if (highest < KEY_SILENCE_MAGNITUDE) {
+            continue;
+        }
+        for (int pitchClass = 0; pitchClass < 12; pitchClass++) {
+            chroma[pitchClass] += transformChroma[pitchClass] / highest;
+        }
+    }
+    free(power);
+}
+
+void KeyAnalyzer::finish(TrackAnalysis *analysis) {
+    // the end of the track is transformed if it holds a whole transform
+    if (_chunk != nullptr && _chunk->numberFrames >= ANALYSIS_KEY_FFT_SIZE) {
+        submitChunk();
+    }
+    free(_chunk);
+    _chunk = nullptr;
+
+    // chunks no worker has started are not waited for
+    while (computePendingChunk(false)) {
+    }
+
+    pthread_mutex_lock(&_mutex);
+    while (_numberRunningChunks > 0) {
+        pthread_cond_wait(&_chunksDone, &_mutex);
+    }
+    analysis->key = -1;
+    analysis->keyStrength = 0.f;
+    float total = 0.f;
+    for (int pitchClass = 0; pitchClass < 12; pitchClass++) {
+        total += _chroma[pitchClass];
+    }
+    if (total > 0.f) {
+        for (int tonic = 0; tonic < 12; tonic++) {
+            const float major = correlate(_chroma, MAJOR_PROFILE, tonic);
+            const float minor = correlate(_chroma, MINOR_PROFILE, tonic);
+            if (analysis->key < 0 || major > analysis->keyStrength) {
+                analysis->key = tonic;
+                analysis->keyStrength = major;
+            }
+            if (minor > analysis->keyStrength) {
+                analysis->key = 12 + tonic;
+                analysis->keyStrength = minor;
+            }
+        }
+    }
+    // the work of the chunks on the other threads is part of the cost of the analyzer
+    analysis->analyzerMs[kAnalyzerKey] += _workerMs;
+    pthread_mutex_unlock(&_mutex);
+}
+
+double KeyAnalyzer::benchmark(ThreadPool *threadPool, int sampleRate, int *key) {
+    // I IV V I of D major with the root in the bass, two seconds per chord
+    static const int CHORDS[4][4] = {{38, 50, 54, 57}, {43, 55, 59, 62},
+                                     {45, 57, 61, 64}, {38, 50, 54, 57}};
+    const unsigned int chordFrames = (unsigned int) sampleRate * 2;
+    const unsigned int loopFrames = chordFrames * 4;
+    AUDIO_HARDWARE_SAMPLE_TYPE *frames = (AUDIO_HARDWARE_SAMPLE_TYPE *) malloc(
+            (size_t) loopFrames * 2 * sizeof(AUDIO_HARDWARE_SAMPLE_TYPE));
+    if (frames == nullptr) {
+        *key = -1;
+        return 0;
+    }
+    for (unsigned int i = 0; i < loopFrames; i++) {
+        const int *chord = CHORDS[i / chordFrames];
+        const float time = (float) (i % chordFrames) / sampleRate;
+        const float envelope = expf(-time);
+        float value = 0.f;
+        for (int note = 0; note < 4; note++) {
+            const float frequency = 440.f * powf(2.f, (chord[note] - 69) / 12.f);
+            for (int harmonic = 1; harmonic <= 3; harmonic++) {
+                value += 0.08f / harmonic * envelope
+                         * sinf(2.f * (float) M_PI * frequency * harmonic * time);
+            }
+        }
+        frames[i * 2] = (AUDIO_HARDWARE_SAMPLE_TYPE) (value * FULL_SCALE);
+        frames[i * 2 + 1] = frames[i * 2];
+    }
+
+    KeyAnalyzer analyzer(sampleRate, threadPool);
+    TrackAnalysis analysis;
+    memset(&analysis, 0, sizeof(analysis));
+    const unsigned int numberFrames = (unsigned int) sampleRate * ANALYSIS_KEY_BENCHMARK_SECONDS;
+
+    const double startTime = now_ms();
+    unsigned int position = 0;
+    while (position < numberFrames) {
+        const unsigned int loopPosition = position % loopFrames;
+        unsigned int count = loopFrames - loopPosition;
+        count = count < ANALYSIS_BLOCK_FRAMES ? count : ANALYSIS_BLOCK_FRAMES;
+        count = count < numberFrames - position ? count : numberFrames - position;
+        analyzer.process(frames + loopPosition * 2, count);
+        position += count;
+    }
+    analyzer.finish(&analysis);
+    const double elapsedMs = now_ms() - startTime;
+
+    free(frames);
+    *key = analysis.key;
+    return elapsedMs;
+}
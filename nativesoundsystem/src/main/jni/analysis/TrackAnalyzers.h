@@ -0,0 +1,219 @@
+//
+// Created by Frederic on 16/06/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_TRACKANALYZERS_H
+#define MINI_SOUND_SYSTEM_TRACKANALYZERS_H
+
+#include <pthread.h>
+
+#include "TrackAnalyzer.h"
+#include "dsp/SilenceDetector.h"
+#include "utils/ThreadPool.h"
+
+// frames of a value of the onset envelope
+#define ANALYSIS_ONSET_HOP_FRAMES 512
+
+// rise of energy between two hops from which a local maximum of the envelope is an onset
+#define ANALYSIS_ONSET_THRESHOLD_DB 6.f
+
+// the key is detected on a mono signal decimated to about this rate
+#define ANALYSIS_KEY_SAMPLE_RATE 11025
+
+// frames of the decimated signal of each transform, and between two transforms
+#define ANALYSIS_KEY_FFT_SIZE 4096
+#define ANALYSIS_KEY_HOP_FRAMES 2048
+
+// transforms of a chunk of the decimated signal, computed by one task
+#define ANALYSIS_KEY_CHUNK_TRANSFORMS 64
+
+// duration of the track of KeyAnalyzer::benchmark
+#define ANALYSIS_KEY_BENCHMARK_SECONDS 300
+
+// highest absolute sample
+class PeakAnalyzer : public TrackAnalyzer {
+public:
+    PeakAnalyzer();
+
+    int getType() override;
+    void reset() override;
+    void process(const AUDIO_HARDWARE_SAMPLE_TYPE *frames, unsigned int numberFrames) override;
+    void finish(TrackAnalysis *analysis) override;
+
+private:
+    // in the unit of samples
+    float _peak;
+};
+
+// root mean square of the samples of both channels
+class RmsAnalyzer : public TrackAnalyzer {
+public:
+    RmsAnalyzer();
+
+    int getType() override;
+    void reset() override;
+    void process(const AUDIO_HARDWARE_SAMPLE_TYPE *frames, unsigned int numberFrames) override;
+    void finish(TrackAnalysis *analysis) override;
+
+private:
+    // in the unit of samples
+    double _sumSquares;
+    uint64_t _numberSamples;
+};
+
+// first and last audible frames, with the default parameters of silence trimming
+class SilenceAnalyzer : public TrackAnalyzer {
+public:
+    SilenceAnalyzer(int sampleRate);
+
+    int getType() override;
+    void reset() override;
+    void process(const AUDIO_HARDWARE_SAMPLE_TYPE *frames, unsigned int numberFrames) override;
+    void finish(TrackAnalysis *analysis) override;
+
+private:
+    SilenceDetector _silenceDetector;
+};
+
+/**
+ * Integrated loudness of ITU-R BS.1770 : samples are K-weighted, then the mean square of 400ms
+ * gating blocks is gated twice. Unlike FeatureExtractor, samples are filtered, at the cost of two
+ * biquads per sample.
+ */
+class LoudnessAnalyzer : public TrackAnalyzer {
+public:
+    LoudnessAnalyzer(int sampleRate);
+    LoudnessAnalyzer& operator=(const LoudnessAnalyzer& ) = delete;
+    LoudnessAnalyzer(LoudnessAnalyzer&) = delete;
+    ~LoudnessAnalyzer();
+
+    int getType() override;
+    void reset() override;
+    void process(const AUDIO_HARDWARE_SAMPLE_TYPE *frames, unsigned int numberFrames) override;
+    void finish(TrackAnalysis *analysis) override;
+
+private:
+
+    void endSubBlock();
+
+    // high shelf then high pass, b0 b1 b2 a1 a2 of each stage
+    double _shelf[5];
+    double _highPass[5];
+    // two last inputs and outputs of each stage for each channel
+    double _shelfState[2][4];
+    double _highPassState[2][4];
+
+    // mean square of 100ms sub-blocks, gating blocks are made of 4 consecutive sub-blocks
+    float *_subBlocks;
+    unsigned int _numberSubBlocks;
+    unsigned int _subBlocksCapacity;
+    double _currentSubBlockSum;
+    unsigned int _currentSubBlockFrames;
+    unsigned int _subBlockSize;
+};
+
+/**
+ * Onset envelope : rise of the energy of each hop of ANALYSIS_ONSET_HOP_FRAMES frames from the
+ * previous one, in dB. Onsets are the local maxima of the envelope above ANALYSIS_ONSET_THRESHOLD_DB.
+ */
+class OnsetAnalyzer : public TrackAnalyzer {
+public:
+    OnsetAnalyzer();
+    OnsetAnalyzer& operator=(const OnsetAnalyzer& ) = delete;
+    OnsetAnalyzer(OnsetAnalyzer&) = delete;
+    ~OnsetAnalyzer();
+
+    int getType() override;
+    void reset() override;
+    void process(const AUDIO_HARDWARE_SAMPLE_TYPE *frames, unsigned int numberFrames) override;
+    void finish(TrackAnalysis *analysis) override;
+    unsigned int getCurve(const float **values) override;
+
+private:
+
+    void endHop();
+
+    float *_envelope;
+    unsigned int _envelopeLength;
+    unsigned int _envelopeCapacity;
+
+    // energy of the previous hop, normalized to full scale
+    float _previousEnergy;
+    double _currentHopSum;
+    unsigned int _currentHopFrames;
+};
+
+struct KeyChunk;
+
+/**
+ * Musical key : chroma of the track correlated with the key profiles of Krumhansl and Kessler.
+ *
+ * The track is mixed to mono and decimated while it is analysed. Chunks of the decimated signal are
+ * transformed by tasks of the thread pool, in parallel with the analysis of the next frames and with
+ * each other. finish computes the chunks no worker has started yet, instead of waiting for a worker.
+ */
+class KeyAnalyzer : public TrackAnalyzer {
+public:
+    KeyAnalyzer(int sampleRate, ThreadPool *threadPool);
+    KeyAnalyzer& operator=(const KeyAnalyzer& ) = delete;
+    KeyAnalyzer(KeyAnalyzer&) = delete;
+    ~KeyAnalyzer();
+
+    int getType() override;
+    void reset() override;
+    void process(const AUDIO_HARDWARE_SAMPLE_TYPE *frames, unsigned int numberFrames) override;
+    void finish(TrackAnalysis *analysis) override;
+
+    /**
+     * Detect the key of ANALYSIS_KEY_BENCHMARK_SECONDS of chords of D major.
+     * @param key set to the key detected, 2 if it is right.
+     * @return milliseconds from the first frame to the key.
+     */
+    static double benchmark(ThreadPool *threadPool, int sampleRate, int *key);
+
+private:
+
+    static void chunkTask(void *data);
+
+    // send the decimated signal to a task, the end of the last transform is kept for the next chunk
+    void submitChunk();
+
+    /**
+     * Transform the first chunk no one has started.
+     * @return false if there was none.
+     */
+    bool computePendingChunk(bool isWorker);
+
+    // add the chroma of each transform of the chunk to chroma
+    void computeChroma(const KeyChunk *chunk, float *chroma);
+
+    ThreadPool *_threadPool;
+
+    // frames mixed to each decimated frame
+    int _decimation;
+    // pitch class of each bin of the transform, -1 outside of the range of notes
+    int8_t _binPitchClasses[ANALYSIS_KEY_FFT_SIZE / 2 + 1];
+
+    // decimation by two moving averages, whose kernel is a triangle
+    double _firstSum;
+    double _secondSum;
+    float _firstHistory[16];
+    double _secondHistory[16];
+    int _historyPosition;
+    int _decimationPhase;
+
+    // decimated signal not sent to a task yet
+    KeyChunk *_chunk;
+
+    pthread_mutex_t _mutex;
+    pthread_cond_t _chunksDone;
+    // chunks waiting for a worker, first submitted first
+    KeyChunk *_pendingHead;
+    KeyChunk *_pendingTail;
+    int _numberRunningChunks;
+    float _chroma[12];
+    // time spent by workers in the chunks
+    double _workerMs;
+};
+
+#endif //MINI_SOUND_SYSTEM_TRACKANALYZERS_H
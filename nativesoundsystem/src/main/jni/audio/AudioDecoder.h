@@ -0,0 +1,54 @@
+//
+// Created by Frederic on 04/06/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_AUDIODECODER_H
+#define MINI_SOUND_SYSTEM_AUDIODECODER_H
+
+#include <stdint.h>
+
+/**
+ * Called for each block of decoded interleaved 16 bits samples.
+ * Return false to stop decoding, for example when only the start of the track is needed.
+ */
+typedef bool (*DecodedBlockCallback)(const short *samples, unsigned int numberSamples,
+                                     void *context);
+
+typedef struct {
+    // duration of the decode call
+    double decodeMs;
+    // part of decodeMs spent waiting for the file, 0 when the I/O is done by the platform
+    double ioWaitMs;
+    // bytes of the file read, 0 when the I/O is done by the platform
+    uint64_t numberBytesRead;
+} DecodeStats;
+
+/**
+ * Decode a whole audio file on the calling thread. Nothing is kept in RAM : each decoded block is
+ * given to the callback and then reused.
+ *
+ * Implemented by the decoders of the platform (TrackDecoder) and by the software decoders which
+ * do not depend on Android (Mp3Decoder).
+ */
+class AudioDecoder {
+public:
+    virtual ~AudioDecoder() {}
+
+    /**
+     * Blocking decode of the file.
+     * @param cancelled polled while decoding, decode stops as soon as it becomes true.
+     * @return true if the whole file has been decoded or if the callback stopped the decoding.
+     */
+    virtual bool decode(const char *filePath, DecodedBlockCallback callback, void *context,
+                        volatile bool *cancelled) = 0;
+
+    // valid once the first block has been given to the callback
+    virtual int getNumberChannels() = 0;
+
+    virtual int getFileSampleRate() = 0;
+
+    // stats of the last decode
+    virtual void getDecodeStats(DecodeStats *stats) = 0;
+};
+
+#endif //MINI_SOUND_SYSTEM_AUDIODECODER_H
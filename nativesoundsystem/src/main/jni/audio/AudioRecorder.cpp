@@ -0,0 +1,465 @@
+#include "AudioRecorder.h"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <audio/WavWriter.h>
+#include <utils/android_debug.h>
+#include <utils/ThreadPolicy.h>
+#include <utils/Tracer.h>
+
+// level of the tone of the synthetic source, -12 dB
+#define SYNTHETIC_AMPLITUDE (0.25f * SHRT_MAX)
+
+static int64_t now_ns(void) {
+    struct timespec res;
+    clock_gettime(CLOCK_MONOTONIC, &res);
+    return (int64_t) res.tv_sec * 1000000000 + res.tv_nsec;
+}
+
+AudioRecorder::AudioRecorder(SLEngineItf engine, int sampleRate, int blockFrames) :
+        _engine(engine),
+        _sampleRate(sampleRate),
+        _blockFrames(blockFrames),
+        _source(kCaptureSourceMicrophone),
+        _numberChannels(0),
+        _blockBytes(0),
+        _isCapturing(false),
+        _fd(-1),
+        _recorderObject(nullptr),
+        _recorderRecord(nullptr),
+        _recorderQueue(nullptr),
+        _sourceBuffer(0),
+        _isSourceStopped(true),
+        _ring(nullptr),
+        _ringTimesNs(nullptr),
+        _numberRingBlocks(0),
+        _ringHead(0),
+        _ringTail(0),
+        _isWriterStopped(true),
+        _startTimeNs(0),
+        _lastBlockTimeNs(0),
+        _capturedBlocks(0),
+        _droppedBlocks(0),
+        _lateBlocks(0),
+        _maxQueuedBlocks(0),
+        _startLatencyUs(0),
+        _hasError(false),
+        _writtenBytes(0),
+        _numberWrites(0),
+        _lastLatencyMs(0),
+        _sumLatencyMs(0),
+        _maxLatencyMs(0),
+        _numberLatencies(0) {
+    pthread_mutex_init(&_statsMutex, nullptr);
+    for (int i = 0; i < CAPTURE_NUMBER_BUFFERS; i++) {
+        _sourceBuffers[i] = nullptr;
+    }
+}
+
+AudioRecorder::~AudioRecorder() {
+    stop();
+    pthread_mutex_destroy(&_statsMutex);
+}
+
+bool AudioRecorder::start(const char *path, int source, int numberChannels) {
+    if (_isCapturing || source < 0 || source >= kCaptureSourceCount
+        || numberChannels < 1 || numberChannels > 2) {
+        return false;
+    }
+
+    _fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (_fd < 0) {
+        LOGE("Can't create capture file %s", path);
+        return false;
+    }
+    // real sizes are written when stopping
+    if (!writeWavHeader(_fd, _sampleRate, numberChannels, false, 0)
+        || lseek(_fd, WAV_HEADER_SIZE, SEEK_SET) != WAV_HEADER_SIZE) {
+        ::close(_fd);
+        _fd = -1;
+        return false;
+    }
+
+    _source = source;
+    _numberChannels = numberChannels;
+    _blockBytes = (unsigned int) (_blockFrames * numberChannels * sizeof(int16_t));
+
+    // allocated once, the source never allocates
+    const uint32_t minBlocks = (uint32_t) ((int64_t) _sampleRate * CAPTURE_RING_MS / 1000
+                                           / _blockFrames) + 1;
+    _numberRingBlocks = 1;
+    while (_numberRingBlocks < minBlocks) {
+        _numberRingBlocks *= 2;
+    }
+    _ring = (unsigned char *) malloc(_numberRingBlocks * _blockBytes);
+    _ringTimesNs = (int64_t *) malloc(_numberRingBlocks * sizeof(int64_t));
+    bool isAllocated = _ring != nullptr && _ringTimesNs != nullptr;
+    for (int i = 0; i < CAPTURE_NUMBER_BUFFERS; i++) {
+        _sourceBuffers[i] = (int16_t *) calloc(_blockBytes, 1);
+        isAllocated = isAllocated && _sourceBuffers[i] != nullptr;
+    }
+    _ringHead = 0;
+    _ringTail = 0;
+    _sourceBuffer = 0;
+
+    _startTimeNs = now_ns();
+    _lastBlockTimeNs = 0;
+    _capturedBlocks = 0;
+    _droppedBlocks = 0;
+    _lateBlocks = 0;
+    _maxQueuedBlocks = 0;
+    _startLatencyUs = 0;
+    pthread_mutex_lock(&_statsMutex);
+    _hasError = false;
+    _writtenBytes = 0;
+    _numberWrites = 0;
+    _lastLatencyMs = 0;
+    _sumLatencyMs = 0;
+    _maxLatencyMs = 0;
+    _numberLatencies = 0;
+    pthread_mutex_unlock(&_statsMutex);
+
+    _isCapturing = true;
+    if (!isAllocated) {
+        LOGE("Can't allocate the capture ring of %u blocks", _numberRingBlocks);
+        stop();
+        return false;
+    }
+
+    // the writer is ready before the first block
+    _isWriterStopped = false;
+    pthread_create(&_writerThread, nullptr, writerThread, this);
+
+    _isSourceStopped = false;
+    if (source == kCaptureSourceSynthetic) {
+        pthread_create(&_syntheticThread, nullptr, syntheticThread, this);
+    } else if (!startRecorder()) {
+        stop();
+        return false;
+    }
+    LOGI("Capture started, ring of %u blocks of %d frames", _numberRingBlocks, _blockFrames);
+    return true;
+}
+
+bool AudioRecorder::startRecorder() {
+    SLresult result;
+
+    // default input of the device
+    SLDataLocator_IODevice locDevice = {SL_DATALOCATOR_IODEVICE, SL_IODEVICE_AUDIOINPUT,
+                                        SL_DEFAULTDEVICEID_AUDIOINPUT, nullptr};
+    SLDataSource audioSrc = {&locDevice, nullptr};
+
+    SLDataLocator_AndroidSimpleBufferQueue locBufferQueue;
+    locBufferQueue.locatorType = SL_DATALOCATOR_ANDROIDSIMPLEBUFFERQUEUE;
+    locBufferQueue.numBuffers = CAPTURE_NUMBER_BUFFERS;
+
+    SLDataFormat_PCM dataFormat;
+    dataFormat.formatType = SL_DATAFORMAT_PCM;
+    dataFormat.numChannels = (SLuint32) _numberChannels;
+    dataFormat.samplesPerSec = (SLuint32) _sampleRate * 1000;
+    dataFormat.bitsPerSample = SL_PCMSAMPLEFORMAT_FIXED_16;
+    dataFormat.containerSize = SL_PCMSAMPLEFORMAT_FIXED_16;
+    dataFormat.channelMask = _numberChannels == 1 ? SL_SPEAKER_FRONT_CENTER
+                                                  : SL_SPEAKER_FRONT_LEFT | SL_SPEAKER_FRONT_RIGHT;
+    dataFormat.endianness = SL_BYTEORDER_LITTLEENDIAN;
+
+    SLDataSink audioSnk = {&locBufferQueue, &dataFormat};
+
+    const SLInterfaceID ids[] = {SL_IID_ANDROIDSIMPLEBUFFERQUEUE, SL_IID_ANDROIDCONFIGURATION};
+    const SLboolean req[] = {SL_BOOLEAN_TRUE, SL_BOOLEAN_FALSE};
+    const int numberInterface = sizeof(ids)/sizeof(ids[0]);
+
+    result = (*_engine)->CreateAudioRecorder(_engine, &_recorderObject, &audioSrc, &audioSnk,
+                                             numberInterface, ids, req);
+    if (result != SL_RESULT_SUCCESS) {
+        LOGE("Can't create the recorder, is RECORD_AUDIO granted ? %u", (unsigned int) result);
+        _recorderObject = nullptr;
+        return false;
+    }
+
+    // voice recognition skips the processing of the input, which adds latency. The configuration
+    // interface is optional and set before the recorder is realized.
+    SLAndroidConfigurationItf recorderConfiguration;
+    result = (*_recorderObject)->GetInterface(_recorderObject, SL_IID_ANDROIDCONFIGURATION,
+                                              &recorderConfiguration);
+    if (result == SL_RESULT_SUCCESS) {
+        SLuint32 preset = SL_ANDROID_RECORDING_PRESET_VOICE_RECOGNITION;
+        (*recorderConfiguration)->SetConfiguration(recorderConfiguration,
+                                                   SL_ANDROID_KEY_RECORDING_PRESET,
+                                                   &preset, sizeof(preset));
+    }
+
+    result = (*_recorderObject)->Realize(_recorderObject, SL_BOOLEAN_FALSE);
+    if (result != SL_RESULT_SUCCESS) {
+        LOGE("Can't realize the recorder %u", (unsigned int) result);
+        releaseRecorder();
+        return false;
+    }
+
+    result = (*_recorderObject)->GetInterface(_recorderObject, SL_IID_RECORD, &_recorderRecord);
+    if (result == SL_RESULT_SUCCESS) {
+        result = (*_recorderObject)->GetInterface(_recorderObject, SL_IID_ANDROIDSIMPLEBUFFERQUEUE,
+                                                  &_recorderQueue);
+    }
+    if (result == SL_RESULT_SUCCESS) {
+        result = (*_recorderQueue)->RegisterCallback(_recorderQueue, recorderCallback, this);
+    }
+    for (int i = 0; i < CAPTURE_NUMBER_BUFFERS && result == SL_RESULT_SUCCESS; i++) {
+        result = (*_recorderQueue)->Enqueue(_recorderQueue, _sourceBuffers[i], _blockBytes);
+    }
+    if (result == SL_RESULT_SUCCESS) {
+        result = (*_recorderRecord)->SetRecordState(_recorderRecord, SL_RECORDSTATE_RECORDING);
+    }
+    if (result != SL_RESULT_SUCCESS) {
+        LOGE("Can't start the recorder %u", (unsigned int) result);
+        releaseRecorder();
+        return false;
+    }
+    return true;
+}
+
+void AudioRecorder::releaseRecorder() {
+    if (_recorderObject == nullptr) {
+        return;
+    }
+    if (_recorderRecord != nullptr) {
+        (*_recorderRecord)->SetRecordState(_recorderRecord, SL_RECORDSTATE_STOPPED);
+    }
+    if (_recorderQueue != nullptr) {
+        (*_recorderQueue)->Clear(_recorderQueue);
+    }
+    // returns once no callback is running
+    (*_recorderObject)->Destroy(_recorderObject);
+    _recorderObject = nullptr;
+    _recorderRecord = nullptr;
+    _recorderQueue = nullptr;
+}
+
+bool AudioRecorder::stop() {
+    if (!_isCapturing) {
+        return false;
+    }
+
+    // no block is sent once the source is stopped
+    if (!_isSourceStopped) {
+        __atomic_store_n(&_isSourceStopped, true, __ATOMIC_RELAXED);
+        if (_source == kCaptureSourceSynthetic) {
+            pthread_join(_syntheticThread, nullptr);
+        } else {
+            releaseRecorder();
+        }
+    }
+
+    // the writer thread empties the ring before it ends
+    if (!_isWriterStopped) {
+        __atomic_store_n(&_isWriterStopped, true, __ATOMIC_RELEASE);
+        pthread_join(_writerThread, nullptr);
+    }
+
+    pthread_mutex_lock(&_statsMutex);
+    const uint64_t dataSize = _writtenBytes;
+    bool success = !_hasError;
+    pthread_mutex_unlock(&_statsMutex);
+
+    success = success && writeWavHeader(_fd, _sampleRate, _numberChannels, false,
+                                        (uint32_t) dataSize);
+    if (::close(_fd) != 0) {
+        success = false;
+    }
+    _fd = -1;
+
+    free(_ring);
+    _ring = nullptr;
+    free(_ringTimesNs);
+    _ringTimesNs = nullptr;
+    for (int i = 0; i < CAPTURE_NUMBER_BUFFERS; i++) {
+        free(_sourceBuffers[i]);
+        _sourceBuffers[i] = nullptr;
+    }
+    _isCapturing = false;
+
+    LOGI("Capture stopped, %u blocks captured, %u dropped",
+         __atomic_load_n(&_capturedBlocks, __ATOMIC_RELAXED),
+         __atomic_load_n(&_droppedBlocks, __ATOMIC_RELAXED));
+    return success;
+}
+
+void AudioRecorder::getStats(CaptureStats *stats) {
+    stats->isCapturing = _isCapturing;
+    stats->capturedBlocks = __atomic_load_n(&_capturedBlocks, __ATOMIC_RELAXED);
+    stats->droppedBlocks = __atomic_load_n(&_droppedBlocks, __ATOMIC_RELAXED);
+    stats->lateBlocks = __atomic_load_n(&_lateBlocks, __ATOMIC_RELAXED);
+    stats->maxQueuedBlocks = __atomic_load_n(&_maxQueuedBlocks, __ATOMIC_RELAXED);
+    stats->numberRingBlocks = _numberRingBlocks;
+    stats->startLatencyMs = __atomic_load_n(&_startLatencyUs, __ATOMIC_RELAXED) / 1000.f;
+
+    pthread_mutex_lock(&_statsMutex);
+    stats->hasError = _hasError;
+    stats->writtenBytes = _writtenBytes;
+    stats->numberWrites = _numberWrites;
+    stats->lastLatencyMs = (float) _lastLatencyMs;
+    stats->meanLatencyMs = _numberLatencies > 0 ? (float) (_sumLatencyMs / _numberLatencies) : 0.f;
+    stats->maxLatencyMs = (float) _maxLatencyMs;
+    pthread_mutex_unlock(&_statsMutex);
+}
+
+void AudioRecorder::recorderCallback(SLAndroidSimpleBufferQueueItf queue, void *context) {
+    AudioRecorder *self = static_cast<AudioRecorder *>(context);
+    // buffers are filled in the order they have been enqueued
+    int16_t *buffer = self->_sourceBuffers[self->_sourceBuffer];
+    self->onBlockCaptured(buffer);
+    (*queue)->Enqueue(queue, buffer, self->_blockBytes);
+    self->_sourceBuffer = (self->_sourceBuffer + 1) % CAPTURE_NUMBER_BUFFERS;
+}
+
+void AudioRecorder::onBlockCaptured(const int16_t *samples) {
+    const int64_t nowNs = now_ns();
+    const int64_t blockDurationNs = (int64_t) _blockFrames * 1000000000 / _sampleRate;
+
+    const uint32_t capturedBlocks = _capturedBlocks;
+    if (capturedBlocks == 0) {
+        __atomic_store_n(&_startLatencyUs, (uint32_t) ((nowNs - _startTimeNs) / 1000),
+                         __ATOMIC_RELAXED);
+    } else if (nowNs - _lastBlockTimeNs > blockDurationNs * CAPTURE_LATE_BLOCKS) {
+        __atomic_store_n(&_lateBlocks, _lateBlocks + 1, __ATOMIC_RELAXED);
+    }
+    _lastBlockTimeNs = nowNs;
+    __atomic_store_n(&_capturedBlocks, capturedBlocks + 1, __ATOMIC_RELAXED);
+
+    const uint32_t tail = _ringTail;
+    const uint32_t queuedBlocks = tail - __atomic_load_n(&_ringHead, __ATOMIC_ACQUIRE);
+    if (queuedBlocks == _numberRingBlocks) {
+        __atomic_store_n(&_droppedBlocks, _droppedBlocks + 1, __ATOMIC_RELAXED);
+        return;
+    }
+    const uint32_t index = tail & (_numberRingBlocks - 1);
+    memcpy(_ring + index * _blockBytes, samples, _blockBytes);
+    // the first frame of the block has been captured one block ago
+    _ringTimesNs[index] = nowNs - blockDurationNs;
+    __atomic_store_n(&_ringTail, tail + 1, __ATOMIC_RELEASE);
+
+    if (queuedBlocks + 1 > _maxQueuedBlocks) {
+        __atomic_store_n(&_maxQueuedBlocks, queuedBlocks + 1, __ATOMIC_RELAXED);
+    }
+}
+
+void* AudioRecorder::writerThread(void *data) {
+    AudioRecorder *self = static_cast<AudioRecorder *>(data);
+    self->writeBlocks();
+    return nullptr;
+}
+
+void AudioRecorder::writeBlocks() {
+    uint32_t policyGeneration = 0;
+    uint32_t minWriteBlocks = (CAPTURE_MIN_WRITE_BYTES + _blockBytes - 1) / _blockBytes;
+    // the ring of a low sample rate may not hold many writes
+    if (minWriteBlocks > _numberRingBlocks / 4) {
+        minWriteBlocks = _numberRingBlocks / 4;
+    }
+    bool hasError = false;
+
+    while (true) {
+        refreshThreadPolicy(kThreadRoleIo, &policyGeneration);
+        // blocks sent before the stop are in the ring once the stop is seen
+        const bool isStopped = __atomic_load_n(&_isWriterStopped, __ATOMIC_ACQUIRE);
+        const uint32_t head = _ringHead;
+        const uint32_t queuedBlocks = __atomic_load_n(&_ringTail, __ATOMIC_ACQUIRE) - head;
+        const uint32_t index = head & (_numberRingBlocks - 1);
+        // a write stops at the end of the ring
+        uint32_t numberBlocks = _numberRingBlocks - index;
+        if (numberBlocks > queuedBlocks) {
+            numberBlocks = queuedBlocks;
+        }
+
+        if (numberBlocks == 0 || (numberBlocks < minWriteBlocks
+                                  && index + numberBlocks < _numberRingBlocks && !isStopped)) {
+            if (isStopped) {
+                return;
+            }
+            usleep(CAPTURE_WRITER_PERIOD_MS * 1000);
+            continue;
+        }
+
+        const unsigned int numberBytes = numberBlocks * _blockBytes;
+        if (!hasError) {
+            TRACE_SCOPE("captureWrite");
+            const unsigned char *src = _ring + index * _blockBytes;
+            unsigned int written = 0;
+            while (written < numberBytes) {
+                ssize_t result = ::write(_fd, src + written, numberBytes - written);
+                if (result <= 0) {
+                    LOGE("Error while writing the capture file");
+                    hasError = true;
+                    break;
+                }
+                written += result;
+            }
+        }
+
+        const int64_t nowNs = now_ns();
+        pthread_mutex_lock(&_statsMutex);
+        if (hasError) {
+            _hasError = true;
+        } else {
+            _writtenBytes += numberBytes;
+            _numberWrites++;
+            for (uint32_t i = 0; i < numberBlocks; i++) {
+                const double latencyMs = (nowNs - _ringTimesNs[index + i]) / 1e6;
+                _sumLatencyMs += latencyMs;
+                if (latencyMs > _maxLatencyMs) {
+                    _maxLatencyMs = latencyMs;
+                }
+                _lastLatencyMs = latencyMs;
+            }
+            _numberLatencies += numberBlocks;
+        }
+        pthread_mutex_unlock(&_statsMutex);
+
+        // blocks are given back to the source once written, or dropped after an error
+        __atomic_store_n(&_ringHead, head + numberBlocks, __ATOMIC_RELEASE);
+    }
+}
+
+void* AudioRecorder::syntheticThread(void *data) {
+    AudioRecorder *self = static_cast<AudioRecorder *>(data);
+    self->synthesizeBlocks();
+    return nullptr;
+}
+
+void AudioRecorder::synthesizeBlocks() {
+    uint32_t policyGeneration = 0;
+    refreshThreadPolicy(kThreadRoleRender, &policyGeneration);
+
+    const int64_t blockDurationNs = (int64_t) _blockFrames * 1000000000 / _sampleRate;
+    const float phaseIncrement = 2.f * (float) M_PI * CAPTURE_SYNTHETIC_FREQUENCY / _sampleRate;
+    float phase = 0.f;
+    int16_t *buffer = _sourceBuffers[0];
+
+    // blocks are sent at the pace of a device, the first one is full a block after the start
+    int64_t blockTimeNs = now_ns() + blockDurationNs;
+    while (!__atomic_load_n(&_isSourceStopped, __ATOMIC_RELAXED)) {
+        struct timespec deadline;
+        deadline.tv_sec = (time_t) (blockTimeNs / 1000000000);
+        deadline.tv_nsec = (long) (blockTimeNs % 1000000000);
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr);
+
+        for (int i = 0; i < _blockFrames; i++) {
+            const int16_t sample = (int16_t) (SYNTHETIC_AMPLITUDE * sinf(phase));
+            for (int channel = 0; channel < _numberChannels; channel++) {
+                buffer[i * _numberChannels + channel] = sample;
+            }
+            phase += phaseIncrement;
+            if (phase > 2.f * (float) M_PI) {
+                phase -= 2.f * (float) M_PI;
+            }
+        }
+        onBlockCaptured(buffer);
+        blockTimeNs += blockDurationNs;
+    }
+}
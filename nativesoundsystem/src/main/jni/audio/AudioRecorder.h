@@ -0,0 +1,178 @@
+//
+// Created by Frederic on 16/06/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_AUDIORECORDER_H
+#define MINI_SOUND_SYSTEM_AUDIORECORDER_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include <SLES/OpenSLES.h>
+#include <SLES/OpenSLES_Android.h>
+
+// buffers of the recorder queue, one is filled by the device while the other is copied
+#define CAPTURE_NUMBER_BUFFERS 2
+
+// captured audio held by the ring before blocks are dropped, if the writer thread is late
+#define CAPTURE_RING_MS 2000
+
+// the writer thread waits for this many bytes before writing, except at the end of the ring and
+// when the capture stops
+#define CAPTURE_MIN_WRITE_BYTES (64 * 1024)
+
+// period at which the writer thread looks for captured blocks
+#define CAPTURE_WRITER_PERIOD_MS 10
+
+// a gap between blocks longer than this number of blocks is counted as a late block
+#define CAPTURE_LATE_BLOCKS 2
+
+// frequency of the tone of the synthetic source
+#define CAPTURE_SYNTHETIC_FREQUENCY 440.f
+
+enum CaptureSource {
+    // default input of the device through an OpenSL ES recorder, needs the RECORD_AUDIO permission
+    kCaptureSourceMicrophone = 0,
+    // tone generated by a thread at the pace of the device, for devices without input and tests
+    kCaptureSourceSynthetic,
+    kCaptureSourceCount,
+};
+
+typedef struct {
+    bool isCapturing;
+    // set when the file can't be written anymore, captured blocks are dropped then
+    bool hasError;
+    // blocks of the recorder buffer size received from the source
+    uint32_t capturedBlocks;
+    // blocks received while the ring was full, missing from the file
+    uint32_t droppedBlocks;
+    // blocks received later than CAPTURE_LATE_BLOCKS blocks after the previous one
+    uint32_t lateBlocks;
+    // highest number of blocks waiting in the ring, out of numberRingBlocks
+    uint32_t maxQueuedBlocks;
+    uint32_t numberRingBlocks;
+    uint64_t writtenBytes;
+    uint32_t numberWrites;
+    // from the start of the capture to the first block received
+    float startLatencyMs;
+    // from the capture of the first frame of a block to the end of the write of the block
+    float lastLatencyMs;
+    float meanLatencyMs;
+    float maxLatencyMs;
+} CaptureStats;
+
+/**
+ * Capture audio to a WAV file of 16 bits samples.
+ *
+ * Blocks are copied by the capture callback into a lock-free ring with a single producer and a single
+ * consumer, and never wait : a block which doesn't fit is dropped and counted. A writer thread drains
+ * the ring with large sequential writes, so the capture callback never touches the filesystem.
+ */
+class AudioRecorder {
+public:
+    /**
+     * @param engine engine of the sound system, must outlive the recorder.
+     * @param blockFrames frames of each block sent by the device.
+     */
+    AudioRecorder(SLEngineItf engine, int sampleRate, int blockFrames);
+    AudioRecorder& operator=(const AudioRecorder& ) = delete;
+    AudioRecorder(AudioRecorder&) = delete;
+    ~AudioRecorder();
+
+    /**
+     * Create the file and start the writer thread, then the source.
+     * @param numberChannels 1 or 2.
+     * @return false if a capture is running, or if the file or the source can't be created.
+     */
+    bool start(const char *path, int source, int numberChannels);
+
+    /**
+     * Stop the source, write the blocks left in the ring and complete the file. Blocking.
+     * @return false if no capture was running or if an error occurred while writing.
+     */
+    bool stop();
+
+    // counters of the current capture, or of the last one once stopped
+    void getStats(CaptureStats *stats);
+
+private:
+
+    static void recorderCallback(SLAndroidSimpleBufferQueueItf queue, void *context);
+
+    static void* writerThread(void *data);
+
+    static void* syntheticThread(void *data);
+
+    bool startRecorder();
+
+    void releaseRecorder();
+
+    // called by the thread of the source with each block, lock free
+    void onBlockCaptured(const int16_t *samples);
+
+    void writeBlocks();
+
+    void synthesizeBlocks();
+
+    SLEngineItf _engine;
+    int _sampleRate;
+    int _blockFrames;
+
+    // settings of the current capture
+    int _source;
+    int _numberChannels;
+    unsigned int _blockBytes;
+    bool _isCapturing;
+
+    int _fd;
+
+    // OpenSL ES recorder of the microphone source
+    SLObjectItf _recorderObject;
+    SLRecordItf _recorderRecord;
+    SLAndroidSimpleBufferQueueItf _recorderQueue;
+
+    // filled by the source, then copied to the ring
+    int16_t *_sourceBuffers[CAPTURE_NUMBER_BUFFERS];
+    int _sourceBuffer;
+
+    // read with atomics by the synthetic source
+    pthread_t _syntheticThread;
+    bool _isSourceStopped;
+
+    // blocks of the ring and the capture time of their first frame, _numberRingBlocks is a power
+    // of two. Consecutive blocks are contiguous, so that several are written at once.
+    unsigned char *_ring;
+    int64_t *_ringTimesNs;
+    uint32_t _numberRingBlocks;
+
+    // indexes only grow and wrap around, _ringHead is written by the writer thread and _ringTail
+    // by the source. Padding keeps them on different cache lines.
+    uint32_t _ringHead;
+    char _padding[64 - sizeof(uint32_t)];
+    uint32_t _ringTail;
+
+    // set once the source is stopped, the writer thread empties the ring then ends
+    pthread_t _writerThread;
+    bool _isWriterStopped;
+
+    // written by the thread of the source, read with atomics. _startTimeNs is set before it starts.
+    int64_t _startTimeNs;
+    int64_t _lastBlockTimeNs;
+    uint32_t _capturedBlocks;
+    uint32_t _droppedBlocks;
+    uint32_t _lateBlocks;
+    uint32_t _maxQueuedBlocks;
+    uint32_t _startLatencyUs;
+
+    // written by the writer thread, guarded by the mutex
+    pthread_mutex_t _statsMutex;
+    bool _hasError;
+    uint64_t _writtenBytes;
+    uint32_t _numberWrites;
+    double _lastLatencyMs;
+    double _sumLatencyMs;
+    double _maxLatencyMs;
+    uint32_t _numberLatencies;
+};
+
+#endif //MINI_SOUND_SYSTEM_AUDIORECORDER_H
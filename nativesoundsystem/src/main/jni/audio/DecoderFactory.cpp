@@ -0,0 +1,12 @@
+#include "DecoderFactory.h"
+
+#include "audio/TrackDecoder.h"
+#include "audio/mp3/Mp3Decoder.h"
+
+AudioDecoder *createAudioDecoder(const char *filePath, SLEngineItf engine, int sampleRate,
+                                 int bufferSize) {
+    if (Mp3Decoder::isMp3File(filePath)) {
+        return new Mp3Decoder();
+    }
+    return new TrackDecoder(engine, sampleRate, bufferSize);
+}
@@ -0,0 +1,20 @@
+//
+// Created by Frederic on 04/06/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_DECODERFACTORY_H
+#define MINI_SOUND_SYSTEM_DECODERFACTORY_H
+
+#include <SLES/OpenSLES.h>
+
+#include "audio/AudioDecoder.h"
+
+/**
+ * Decoder used by the background jobs for a file : the software decoder when it supports the file,
+ * so that results are the same on every device, the decoder of the platform otherwise.
+ * @return decoder to delete by the caller.
+ */
+AudioDecoder *createAudioDecoder(const char *filePath, SLEngineItf engine, int sampleRate,
+                                 int bufferSize);
+
+#endif //MINI_SOUND_SYSTEM_DECODERFACTORY_H
@@ -0,0 +1,55 @@
+#include "EngineStatus.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+EngineStatus::EngineStatus() {
+    _words = (uint32_t *) calloc(kStatusNumberWords, sizeof(uint32_t));
+}
+
+EngineStatus::~EngineStatus() {
+    free(_words);
+}
+
+void EngineStatus::beginWrite(int sequenceWord) {
+    const uint32_t sequence = _words[sequenceWord];
+    __atomic_store_n(&_words[sequenceWord], sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+void EngineStatus::endWrite(int sequenceWord) {
+    __atomic_store_n(&_words[sequenceWord], _words[sequenceWord] + 1, __ATOMIC_RELEASE);
+}
+
+void EngineStatus::writeFloat(int word, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    write(word, bits);
+}
+
+void EngineStatus::writeTime(int word, int64_t timeNs) {
+    write(word, (uint32_t) ((uint64_t) timeNs >> 32));
+    write(word + 1, (uint32_t) timeNs);
+}
+
+void EngineStatus::read(int sequenceWord, uint32_t *words, int numberWords) const {
+    uint32_t sequence;
+    do {
+        sequence = __atomic_load_n(&_words[sequenceWord], __ATOMIC_ACQUIRE);
+        for (int i = 0; i < numberWords; i++) {
+            words[i] = __atomic_load_n(&_words[sequenceWord + 1 + i], __ATOMIC_RELAXED);
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        // odd while the section is written
+    } while ((sequence & 1) != 0 || sequence != __atomic_load_n(&_words[sequenceWord], __ATOMIC_RELAXED));
+}
+
+float EngineStatus::toFloat(uint32_t word) {
+    float value;
+    memcpy(&value, &word, sizeof(value));
+    return value;
+}
+
+int64_t EngineStatus::toTime(uint32_t highWord, uint32_t lowWord) {
+    return (int64_t) (((uint64_t) highWord << 32) | lowWord);
+}
@@ -0,0 +1,92 @@
+//
+// Created by Frederic on 13/06/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_ENGINESTATUS_H
+#define MINI_SOUND_SYSTEM_ENGINESTATUS_H
+
+#include <stdint.h>
+
+/**
+ * Words of the status block, mirrored in SSEngineStatus. Each section starts with its sequence.
+ */
+enum EngineStatusWord {
+    // written by the audio thread, or under the command mutex while the stream is stopped
+    kStatusPlayerSequence = 0,
+    kStatusIsPlaying,
+    kStatusPositionFrames,
+    kStatusPresentedFrame,
+    kStatusPresentationTimeHigh,
+    kStatusPresentationTimeLow,
+    kStatusRate,
+    kStatusPeakLeft,
+    kStatusPeakRight,
+    kStatusStarvedBuffers,
+    kStatusLateCallbacks,
+    kStatusOutputFrameHigh,
+    kStatusOutputFrameLow,
+
+    // written by the thread loading or extracting the track
+    kStatusLoadSequence,
+    kStatusIsLoaded,
+    kStatusIsExtracting,
+    kStatusExtractedFrames,
+    kStatusTotalFrames,
+
+    kStatusNumberWords
+};
+
+#define STATUS_PLAYER_NUMBER_WORDS (kStatusLoadSequence - kStatusPlayerSequence - 1)
+#define STATUS_LOAD_NUMBER_WORDS (kStatusNumberWords - kStatusLoadSequence - 1)
+
+/**
+ * Block of 32 bits words read by any thread without locking, including Java through a direct
+ * ByteBuffer in native byte order, so that the UI never calls native code to show the engine state.
+ *
+ * Each section is a seqlock with a single writer at a time : the sequence is odd while the section
+ * is written, readers copy the section again when the sequence changed. Writers never wait for
+ * readers. 64 bits values are split in two words, they can't be stored atomically on all devices.
+ */
+class EngineStatus {
+public:
+    EngineStatus();
+    EngineStatus& operator=(const EngineStatus& ) = delete;
+    EngineStatus(EngineStatus&) = delete;
+    ~EngineStatus();
+
+    void beginWrite(int sequenceWord);
+
+    void endWrite(int sequenceWord);
+
+    inline void write(int word, uint32_t value) {
+        __atomic_store_n(&_words[word], value, __ATOMIC_RELAXED);
+    }
+
+    void writeFloat(int word, float value);
+
+    // stored in word and word + 1
+    void writeTime(int word, int64_t timeNs);
+
+    /**
+     * Copy the numberWords words following sequenceWord as written by a single write.
+     */
+    void read(int sequenceWord, uint32_t *words, int numberWords) const;
+
+    static float toFloat(uint32_t word);
+
+    static int64_t toTime(uint32_t highWord, uint32_t lowWord);
+
+    inline void *getBuffer() {
+        return _words;
+    }
+
+    inline int getSize() const {
+        return kStatusNumberWords * sizeof(uint32_t);
+    }
+
+private:
+
+    uint32_t *_words;
+};
+
+#endif //MINI_SOUND_SYSTEM_ENGINESTATUS_H
@@ -0,0 +1,134 @@
+#include "EventScheduler.h"
+
+#include <stdlib.h>
+
+EventScheduler::EventScheduler() :
+        _nextOrder(0),
+        _generation(0),
+        _numberHeapEvents(0),
+        _heapGeneration(0),
+        _scheduledEvents(0),
+        _rejectedEvents(0),
+        _appliedEvents(0),
+        _lateEvents(0),
+        _maxLateFrames(0),
+        _cancelledEvents(0),
+        _pendingEvents(0) {
+    _heap = (ScheduledEvent *) calloc(SCHEDULER_MAX_EVENTS, sizeof(ScheduledEvent));
+}
+
+EventScheduler::~EventScheduler() {
+    free(_heap);
+}
+
+bool EventScheduler::schedule(const ScheduledEvent &event) {
+    ScheduledEvent scheduled = event;
+    scheduled.order = __atomic_fetch_add(&_nextOrder, 1, __ATOMIC_RELAXED);
+    scheduled.generation = __atomic_load_n(&_generation, __ATOMIC_ACQUIRE);
+    if (!_queue.push(scheduled)) {
+        __atomic_fetch_add(&_rejectedEvents, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    __atomic_fetch_add(&_scheduledEvents, 1, __ATOMIC_RELAXED);
+    return true;
+}
+
+void EventScheduler::cancelAll() {
+    __atomic_fetch_add(&_generation, 1, __ATOMIC_RELEASE);
+}
+
+void EventScheduler::collect() {
+    uint32_t cancelledEvents = 0;
+    const uint32_t generation = __atomic_load_n(&_generation, __ATOMIC_ACQUIRE);
+    if (generation != _heapGeneration) {
+        cancelledEvents += _numberHeapEvents;
+        _numberHeapEvents = 0;
+        _heapGeneration = generation;
+    }
+
+    // events which don't fit in the heap wait in the queue for the next blocks
+    ScheduledEvent event;
+    while (_numberHeapEvents < SCHEDULER_MAX_EVENTS && _queue.pop(&event)) {
+        const int32_t age = (int32_t) (_heapGeneration - event.generation);
+        if (age > 0) {
+            cancelledEvents++;
+            continue;
+        }
+        if (age < 0) {
+            // sent after a cancel which happened once the generation was read
+            cancelledEvents += _numberHeapEvents;
+            _numberHeapEvents = 0;
+            _heapGeneration = event.generation;
+        }
+        pushHeap(event);
+    }
+
+    if (cancelledEvents > 0) {
+        __atomic_store_n(&_cancelledEvents, _cancelledEvents + cancelledEvents, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&_pendingEvents, (uint32_t) _numberHeapEvents, __ATOMIC_RELAXED);
+}
+
+bool EventScheduler::popDue(uint64_t startFrame, uint64_t endFrame, ScheduledEvent *event) {
+    if (_numberHeapEvents == 0 || _heap[0].frame >= endFrame) {
+        return false;
+    }
+    *event = _heap[0];
+    popHeap();
+
+    if (event->frame < startFrame) {
+        const uint64_t lateFrames = startFrame - event->frame;
+        __atomic_store_n(&_lateEvents, _lateEvents + 1, __ATOMIC_RELAXED);
+        if (lateFrames > _maxLateFrames) {
+            __atomic_store_n(&_maxLateFrames,
+                             lateFrames > UINT32_MAX ? UINT32_MAX : (uint32_t) lateFrames,
+                             __ATOMIC_RELAXED);
+        }
+    }
+    __atomic_store_n(&_appliedEvents, _appliedEvents + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&_pendingEvents, (uint32_t) _numberHeapEvents, __ATOMIC_RELAXED);
+    return true;
+}
+
+void EventScheduler::getStats(SchedulerStats *stats) {
+    stats->scheduledEvents = __atomic_load_n(&_scheduledEvents, __ATOMIC_RELAXED);
+    stats->appliedEvents = __atomic_load_n(&_appliedEvents, __ATOMIC_RELAXED);
+    stats->lateEvents = __atomic_load_n(&_lateEvents, __ATOMIC_RELAXED);
+    stats->maxLateFrames = __atomic_load_n(&_maxLateFrames, __ATOMIC_RELAXED);
+    stats->cancelledEvents = __atomic_load_n(&_cancelledEvents, __ATOMIC_RELAXED);
+    stats->rejectedEvents = __atomic_load_n(&_rejectedEvents, __ATOMIC_RELAXED);
+    stats->pendingEvents = __atomic_load_n(&_pendingEvents, __ATOMIC_RELAXED);
+}
+
+void EventScheduler::pushHeap(const ScheduledEvent &event) {
+    int index = _numberHeapEvents++;
+    while (index > 0) {
+        const int parent = (index - 1) / 2;
+        if (!isBefore(event, _heap[parent])) {
+            break;
+        }
+        _heap[index] = _heap[parent];
+        index = parent;
+    }
+    _heap[index] = event;
+}
+
+void EventScheduler::popHeap() {
+    const ScheduledEvent last = _heap[--_numberHeapEvents];
+    int index = 0;
+    for (;;) {
+        int child = index * 2 + 1;
+        if (child >= _numberHeapEvents) {
+            break;
+        }
+        if (child + 1 < _numberHeapEvents && isBefore(_heap[child + 1], _heap[child])) {
+            child++;
+        }
+        if (!isBefore(_heap[child], last)) {
+            break;
+        }
+        _heap[index] = _heap[child];
+        index = child;
+    }
+    _heap[index] = last;
+}
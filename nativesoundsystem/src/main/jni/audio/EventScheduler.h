@@ -0,0 +1,129 @@
+//
+// Created by Frederic on 16/06/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_EVENTSCHEDULER_H
+#define MINI_SOUND_SYSTEM_EVENTSCHEDULER_H
+
+#include <stdint.h>
+
+#include "utils/MpscQueue.h"
+
+// events sent and not collected by the audio thread yet
+#define SCHEDULER_QUEUE_CAPACITY 256
+
+// events collected by the audio thread and waiting for their frame
+#define SCHEDULER_MAX_EVENTS 256
+
+enum ScheduledEventType {
+    kScheduledEventStart = 0,
+    kScheduledEventStop,
+    kScheduledEventSeek,
+    kScheduledEventGain,
+    kScheduledEventCount,
+};
+
+/**
+ * Transport change applied by the audio thread at a frame of the output clock.
+ */
+typedef struct {
+    int type;
+
+    // frame of the output clock, counted from the first frame rendered by the player
+    uint64_t frame;
+
+    // frame of the track to play from, for a seek
+    unsigned int position;
+
+    // linear gain of the track reached in rampFrames frames, for a gain change
+    float gain;
+    int rampFrames;
+
+    // set by the scheduler : events of the same frame are applied in the order they were sent
+    uint32_t order;
+    uint32_t generation;
+} ScheduledEvent;
+
+typedef struct {
+    uint32_t scheduledEvents;
+    uint32_t appliedEvents;
+    // applied after their frame, at the start of the next block rendered
+    uint32_t lateEvents;
+    uint32_t maxLateFrames;
+    uint32_t cancelledEvents;
+    // sent while the queue was full
+    uint32_t rejectedEvents;
+    // collected and waiting for their frame after the last block
+    uint32_t pendingEvents;
+} SchedulerStats;
+
+/**
+ * Events sent by any thread without locking and applied by the audio thread at their frame.
+ *
+ * Sent events go through a lock-free queue with several producers. The audio thread moves them to
+ * a binary heap ordered by frame at the start of each block, then pops the events of the block in
+ * order : the cost of a block is proportional to its events, with the logarithm of the events
+ * waiting. Nothing is allocated by the audio thread.
+ */
+class EventScheduler {
+public:
+    EventScheduler();
+    EventScheduler& operator=(const EventScheduler& ) = delete;
+    EventScheduler(EventScheduler&) = delete;
+    ~EventScheduler();
+
+    /**
+     * Called by any thread but the audio thread.
+     * @return false if too many events wait for the audio thread, the event is dropped.
+     */
+    bool schedule(const ScheduledEvent &event);
+
+    // drop the events sent before, called by any thread but the audio thread
+    void cancelAll();
+
+    // move the sent events to the heap, called by the audio thread at the start of each block
+    void collect();
+
+    /**
+     * Pop the next event of the block [startFrame, endFrame[, or an event of a previous block,
+     * which is late. Called by the audio thread.
+     * @return false if no event is due before endFrame.
+     */
+    bool popDue(uint64_t startFrame, uint64_t endFrame, ScheduledEvent *event);
+
+    void getStats(SchedulerStats *stats);
+
+private:
+
+    // true if a must be applied before b
+    static inline bool isBefore(const ScheduledEvent &a, const ScheduledEvent &b) {
+        return a.frame < b.frame || (a.frame == b.frame && (int32_t) (a.order - b.order) < 0);
+    }
+
+    void pushHeap(const ScheduledEvent &event);
+
+    void popHeap();
+
+    MpscQueue<ScheduledEvent, SCHEDULER_QUEUE_CAPACITY> _queue;
+    uint32_t _nextOrder;
+    // incremented by cancelAll, events of a previous generation are dropped
+    uint32_t _generation;
+
+    // owned by the audio thread, _heap[0] is the next event
+    ScheduledEvent *_heap;
+    int _numberHeapEvents;
+    uint32_t _heapGeneration;
+
+    // incremented with atomics
+    uint32_t _scheduledEvents;
+    uint32_t _rejectedEvents;
+
+    // written by the audio thread, read with atomics
+    uint32_t _appliedEvents;
+    uint32_t _lateEvents;
+    uint32_t _maxLateFrames;
+    uint32_t _cancelledEvents;
+    uint32_t _pendingEvents;
+};
+
+#endif //MINI_SOUND_SYSTEM_EVENTSCHEDULER_H
@@ -0,0 +1,71 @@
+#include "OfflineRenderer.h"
+
+#include <stdlib.h>
+#include <time.h>
+
+#include <utils/android_debug.h>
+
+static double now_ms(void) {
+    struct timespec res;
+    clock_gettime(CLOCK_MONOTONIC, &res);
+    return 1000.0 * res.tv_sec + (double) res.tv_nsec / 1e6;
+}
+
+OfflineRenderer::OfflineRenderer(int sampleRate, int blockFrames) :
+        _sampleRate(sampleRate),
+        _blockFrames(blockFrames) {
+    _trackRenderer = new TrackRenderer(sampleRate, blockFrames);
+    _block = (AUDIO_HARDWARE_SAMPLE_TYPE *) calloc((size_t) blockFrames * 2,
+                                                   sizeof(AUDIO_HARDWARE_SAMPLE_TYPE));
+}
+
+OfflineRenderer::~OfflineRenderer() {
+    free(_block);
+    delete _trackRenderer;
+}
+
+bool OfflineRenderer::render(const PcmPages *track, unsigned int startFrame,
+                             unsigned int totalFrames, const char *wavPath, OfflineRenderStats *stats) {
+#ifdef FLOAT_PLAYER
+    const bool isFloat = true;
+#else
+    const bool isFloat = false;
+#endif
+    if (!_wavWriter.open(wavPath, _sampleRate, 2, isFloat)) {
+        return false;
+    }
+
+    const double startTime = now_ms();
+
+    _trackRenderer->setPosition(startFrame);
+    bool success = true;
+    unsigned int numberFrames = 0;
+    const unsigned int numberFramesToRender = totalFrames > startFrame ? totalFrames - startFrame : 0;
+    while (success && numberFrames < numberFramesToRender) {
+        int numberFramesRead = _trackRenderer->render(track, totalFrames, _block, _blockFrames);
+        if (numberFramesRead <= 0) {
+            // the read head doesn't move anymore
+            break;
+        }
+        numberFrames += numberFramesRead;
+        // the last block isn't padded with silence
+        success = _wavWriter.write(_block, numberFramesRead * 2 * sizeof(AUDIO_HARDWARE_SAMPLE_TYPE));
+    }
+
+    if (!_wavWriter.close()) {
+        success = false;
+    }
+
+    const double durationMs = now_ms() - startTime;
+    const double audioDurationMs = 1000.0 * numberFrames / _sampleRate;
+    const double realTimeFactor = durationMs > 0 ? audioDurationMs / durationMs : 0;
+    LOGI("Offline render of %u frames : %f ms, %fx real time", numberFrames, durationMs,
+         realTimeFactor);
+
+    if (stats != nullptr) {
+        stats->numberFrames = numberFrames;
+        stats->durationMs = durationMs;
+        stats->realTimeFactor = realTimeFactor;
+    }
+    return success;
+}
@@ -0,0 +1,62 @@
+//
+// Created by Frederic on 27/05/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_OFFLINERENDERER_H
+#define MINI_SOUND_SYSTEM_OFFLINERENDERER_H
+
+#include "audio/SampleType.h"
+#include "audio/TrackRenderer.h"
+#include "audio/WavWriter.h"
+
+typedef struct {
+    unsigned int numberFrames;
+    double durationMs;
+
+    // duration of the rendered audio divided by the time spent to render it
+    double realTimeFactor;
+} OfflineRenderStats;
+
+/**
+ * Render a track to a WAV file as fast as possible, with the processing chain of the player.
+ * Blocks have the size of the player buffers so the output is the same as what the player plays.
+ * Doesn't use any audio device.
+ */
+class OfflineRenderer {
+public:
+    /**
+     * @param blockFrames number of frames rendered at once, buffer size of the player.
+     */
+    OfflineRenderer(int sampleRate, int blockFrames);
+    OfflineRenderer& operator=(const OfflineRenderer& ) = delete;
+    OfflineRenderer(OfflineRenderer&) = delete;
+    ~OfflineRenderer();
+
+    /**
+     * Render the track from startFrame to its end. Blocking.
+     * @param stats can be null.
+     * @return false if the file can't be written.
+     */
+    bool render(const PcmPages *track, unsigned int startFrame, unsigned int totalFrames,
+                const char *wavPath, OfflineRenderStats *stats);
+
+    /**
+     * Equalizer applied on rendered frames, to configure before rendering.
+     */
+    inline Equalizer* getEqualizer(){
+        return _trackRenderer->getEqualizer();
+    }
+
+private:
+
+    int _sampleRate;
+    int _blockFrames;
+
+    TrackRenderer *_trackRenderer;
+
+    AUDIO_HARDWARE_SAMPLE_TYPE *_block;
+
+    WavWriter _wavWriter;
+};
+
+#endif //MINI_SOUND_SYSTEM_OFFLINERENDERER_H
@@ -0,0 +1,144 @@
+// Host test of the offline render, run by nativesoundsystem/run_host_tests.sh. Also renders a file
+// on the host : OfflineRendererTest <input wav or aiff> <output wav> [low mid high gains in dB]
+// host test sources : audio/OfflineRenderer.cpp audio/TrackRenderer.cpp audio/ReadHead.cpp
+// host test sources : audio/PcmPages.cpp audio/PcmFile.cpp audio/WavWriter.cpp
+// host test sources : dsp/ChannelMapper.cpp dsp/Equalizer.cpp utils/ThreadPolicy.cpp utils/Tracer.cpp
+
+#include "OfflineRenderer.h"
+#include "PcmFile.h"
+
+#include <climits>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// rendered by the 16 bits configuration, from the root of the repository. After an intended
+// change of the processing chain, copy the file rendered by the test over it.
+#define TEST_GOLDEN_PATH "nativesoundsystem/src/test/data/offline_render_golden.wav"
+#define TEST_OUTPUT_NAME "offline_render.wav"
+
+#define TEST_SAMPLE_RATE 48000
+// not a multiple of the block, so the last block is partial
+#define TEST_NUMBER_FRAMES 12007
+#define TEST_BLOCK_FRAMES 192
+
+// float rendering and 16 bits rendering round at different steps
+#define TEST_TOLERANCE 3
+
+// tones in the three bands of the equalizer, the left and right channels differ
+static void generateInput(AUDIO_HARDWARE_SAMPLE_TYPE *frames, unsigned int numberFrames) {
+    for (unsigned int i = 0; i < numberFrames; i++) {
+        const double time = (double) i / TEST_SAMPLE_RATE;
+        const double low = sin(2. * M_PI * 80. * time);
+        const double mid = sin(2. * M_PI * 1000. * time);
+        const double high = sin(2. * M_PI * 9000. * time);
+        const short left = (short) lrint(8000. * (low + mid + high));
+        const short right = (short) lrint(8000. * (low - mid) + 4000. * high);
+#ifdef FLOAT_PLAYER
+        frames[i * 2] = left / ((float) SHRT_MAX);
+        frames[i * 2 + 1] = right / ((float) SHRT_MAX);
+#else
+        frames[i * 2] = left;
+        frames[i * 2 + 1] = right;
+#endif
+    }
+}
+
+static float toShortScale(AUDIO_HARDWARE_SAMPLE_TYPE sample) {
+#ifdef FLOAT_PLAYER
+    // PcmFile converts 16 bits samples with this scale
+    return sample * 32768.f;
+#else
+    return sample;
+#endif
+}
+
+static bool render(const AUDIO_HARDWARE_SAMPLE_TYPE *frames, unsigned int numberFrames,
+                   int sampleRate, const float gainsDb[3], const char *outputPath) {
+    PcmPages *track = PcmPages::wrap(frames, numberFrames);
+    if (track == nullptr) {
+        fprintf(stderr, "Too many frames to render\n");
+        return false;
+    }
+    OfflineRenderer renderer(sampleRate, TEST_BLOCK_FRAMES);
+    renderer.getEqualizer()->setThreeBandGains(gainsDb[0], gainsDb[1], gainsDb[2]);
+    OfflineRenderStats stats;
+    const bool success = renderer.render(track, 0, numberFrames, outputPath, &stats);
+    if (success) {
+        printf("Rendered %u frames to %s, %.0fx real time\n", stats.numberFrames, outputPath,
+               stats.realTimeFactor);
+    } else {
+        fprintf(stderr, "Can't render to %s\n", outputPath);
+    }
+    delete track;
+    return success;
+}
+
+static int renderFile(const char *inputPath, const char *outputPath, const float gainsDb[3]) {
+    PcmFile input;
+    if (!input.open(inputPath)) {
+        fprintf(stderr, "Can't open %s\n", inputPath);
+        return 1;
+    }
+    return render(input.getPlayerData(), input.getNumberFrames(), input.getSampleRate(), gainsDb,
+                  outputPath) ? 0 : 1;
+}
+
+static int checkGolden(const char *outputPath) {
+    AUDIO_HARDWARE_SAMPLE_TYPE *frames = (AUDIO_HARDWARE_SAMPLE_TYPE *) malloc(
+            TEST_NUMBER_FRAMES * 2 * sizeof(AUDIO_HARDWARE_SAMPLE_TYPE));
+    generateInput(frames, TEST_NUMBER_FRAMES);
+    const float gainsDb[3] = {6.f, -12.f, 3.f};
+    const bool isRendered = render(frames, TEST_NUMBER_FRAMES, TEST_SAMPLE_RATE, gainsDb,
+                                   outputPath);
+    free(frames);
+    if (!isRendered) {
+        return 1;
+    }
+
+    PcmFile output;
+    PcmFile golden;
+    if (!output.open(outputPath) || !golden.open(TEST_GOLDEN_PATH)) {
+        fprintf(stderr, "Can't read %s or %s\n", outputPath, TEST_GOLDEN_PATH);
+        return 1;
+    }
+    if (output.getNumberFrames() != golden.getNumberFrames()
+        || output.getSampleRate() != golden.getSampleRate()
+        || output.getNumberChannels() != 2) {
+        fprintf(stderr, "Rendered %u frames at %d Hz, golden has %u frames at %d Hz\n",
+                output.getNumberFrames(), output.getSampleRate(), golden.getNumberFrames(),
+                golden.getSampleRate());
+        return 1;
+    }
+
+    const AUDIO_HARDWARE_SAMPLE_TYPE *outputFrames = output.getPlayerData();
+    const AUDIO_HARDWARE_SAMPLE_TYPE *goldenFrames = golden.getPlayerData();
+    float maxDifference = 0.f;
+    for (unsigned int i = 0; i < golden.getNumberFrames() * 2; i++) {
+        const float difference = fabsf(toShortScale(outputFrames[i])
+                                       - toShortScale(goldenFrames[i]));
+        if (difference > maxDifference) {
+            maxDifference = difference;
+        }
+    }
+    printf("Offline render : %.2f LSB from the golden file\n", maxDifference);
+    return maxDifference <= TEST_TOLERANCE ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+    if (argc >= 3) {
+        float gainsDb[3] = {0.f, 0.f, 0.f};
+        for (int i = 0; i < 3 && i + 3 < argc; i++) {
+            gainsDb[i] = (float) atof(argv[i + 3]);
+        }
+        return renderFile(argv[1], argv[2], gainsDb);
+    }
+
+    // the runner gives its build directory
+    const char *directory = getenv("HOST_TEST_DIR");
+    char outputPath[1024];
+    snprintf(outputPath, sizeof(outputPath), "%s/%s", directory != nullptr ? directory : ".",
+             TEST_OUTPUT_NAME);
+    return checkGolden(outputPath);
+}
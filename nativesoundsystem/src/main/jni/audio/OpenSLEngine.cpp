@@ -0,0 +1,88 @@
+#include "OpenSLEngine.h"
+
+#include <pthread.h>
+
+#include <utils/android_debug.h>
+
+static pthread_mutex_t engineMutex = PTHREAD_MUTEX_INITIALIZER;
+static int numberUsers = 0;
+
+static SLObjectItf engineObj = nullptr;
+static SLEngineItf engineItf = nullptr;
+static SLObjectItf outputMixObj = nullptr;
+
+static void destroyEngine() {
+    if (outputMixObj != nullptr) {
+        (*outputMixObj)->Destroy(outputMixObj);
+        outputMixObj = nullptr;
+    }
+    if (engineObj != nullptr) {
+        (*engineObj)->Destroy(engineObj);
+        engineObj = nullptr;
+        engineItf = nullptr;
+    }
+}
+
+static bool createEngine() {
+    const SLuint32 engineIIDCount = 1;
+    const SLInterfaceID engineIIDs[] = {SL_IID_ENGINE};
+    const SLboolean engineReqs[] = {SL_BOOLEAN_TRUE};
+
+    SLresult result = slCreateEngine(&engineObj, 0, nullptr, engineIIDCount, engineIIDs,
+                                     engineReqs);
+    if (result != SL_RESULT_SUCCESS) {
+        LOGE("Unable to create the OpenSL engine : %d", (int) result);
+        engineObj = nullptr;
+        return false;
+    }
+
+    // 2nd parameter : True if it's asynchronous and false to be synchronous
+    result = (*engineObj)->Realize(engineObj, SL_BOOLEAN_FALSE);
+    if (result == SL_RESULT_SUCCESS) {
+        result = (*engineObj)->GetInterface(engineObj, SL_IID_ENGINE, &engineItf);
+    }
+
+    if (result == SL_RESULT_SUCCESS) {
+        const SLuint32 outputMixIIDCount = 0;
+        const SLInterfaceID outputMixIIDs[] = {};
+        const SLboolean outputMixReqs[] = {};
+        result = (*engineItf)->CreateOutputMix(engineItf, &outputMixObj, outputMixIIDCount,
+                                               outputMixIIDs, outputMixReqs);
+        if (result != SL_RESULT_SUCCESS) {
+            outputMixObj = nullptr;
+        }
+    }
+    if (result == SL_RESULT_SUCCESS) {
+        result = (*outputMixObj)->Realize(outputMixObj, SL_BOOLEAN_FALSE);
+    }
+
+    if (result != SL_RESULT_SUCCESS) {
+        LOGE("Unable to realize the OpenSL engine : %d", (int) result);
+        destroyEngine();
+        return false;
+    }
+    return true;
+}
+
+bool acquireOpenSLEngine(SLEngineItf *engine, SLObjectItf *outputMix) {
+    pthread_mutex_lock(&engineMutex);
+    bool isCreated = numberUsers > 0 || createEngine();
+    if (isCreated) {
+        numberUsers++;
+        *engine = engineItf;
+        *outputMix = outputMixObj;
+    }
+    pthread_mutex_unlock(&engineMutex);
+    return isCreated;
+}
+
+void releaseOpenSLEngine() {
+    pthread_mutex_lock(&engineMutex);
+    if (numberUsers > 0) {
+        numberUsers--;
+        if (numberUsers == 0) {
+            destroyEngine();
+        }
+    }
+    pthread_mutex_unlock(&engineMutex);
+}
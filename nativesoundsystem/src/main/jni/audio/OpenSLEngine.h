@@ -0,0 +1,21 @@
+//
+// Created by Frederic on 14/06/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_OPENSLENGINE_H
+#define MINI_SOUND_SYSTEM_OPENSLENGINE_H
+
+#include <SLES/OpenSLES.h>
+
+/**
+ * OpenSL ES engine and output mix shared by all sound systems of the process : android supports a
+ * single engine per application, the players of every sound system are mixed in the same output.
+ *
+ * The first acquire creates them, the last release destroys them.
+ * @return false if the engine can't be created, nothing has to be released then.
+ */
+bool acquireOpenSLEngine(SLEngineItf *engine, SLObjectItf *outputMix);
+
+void releaseOpenSLEngine();
+
+#endif //MINI_SOUND_SYSTEM_OPENSLENGINE_H
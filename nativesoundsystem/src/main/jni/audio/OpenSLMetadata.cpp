@@ -0,0 +1,55 @@
+#include "OpenSLMetadata.h"
+
+#include <SLES/OpenSLES_Android.h>
+#include <SLES/OpenSLES_AndroidMetadata.h>
+#include <stdlib.h>
+#include <string.h>
+
+int readDecodedNumberChannels(SLMetadataExtractionItf metadata, int defaultNumberChannels) {
+    if (metadata == nullptr) {
+        return defaultNumberChannels;
+    }
+    SLuint32 numberItems = 0;
+    if ((*metadata)->GetItemCount(metadata, &numberItems) != SL_RESULT_SUCCESS) {
+        return defaultNumberChannels;
+    }
+
+    int numberChannels = defaultNumberChannels;
+    for (SLuint32 i = 0; i < numberItems; i++) {
+        SLuint32 keySize = 0;
+        if ((*metadata)->GetKeySize(metadata, i, &keySize) != SL_RESULT_SUCCESS) {
+            continue;
+        }
+        SLMetadataInfo *key = (SLMetadataInfo *) malloc(keySize);
+        if (key == nullptr) {
+            break;
+        }
+        bool isNumberChannels = (*metadata)->GetKey(metadata, i, keySize, key) == SL_RESULT_SUCCESS
+                                && strcmp((const char *) key->data,
+                                          ANDROID_KEY_PCMFORMAT_NUMCHANNELS) == 0;
+        free(key);
+        if (!isNumberChannels) {
+            continue;
+        }
+
+        SLuint32 valueSize = 0;
+        if ((*metadata)->GetValueSize(metadata, i, &valueSize) != SL_RESULT_SUCCESS) {
+            break;
+        }
+        SLMetadataInfo *value = (SLMetadataInfo *) malloc(valueSize);
+        if (value == nullptr) {
+            break;
+        }
+        if ((*metadata)->GetValue(metadata, i, valueSize, value) == SL_RESULT_SUCCESS
+            && value->size >= sizeof(SLuint32)) {
+            SLuint32 decodedNumberChannels;
+            memcpy(&decodedNumberChannels, value->data, sizeof(decodedNumberChannels));
+            if (decodedNumberChannels > 0) {
+                numberChannels = (int) decodedNumberChannels;
+            }
+        }
+        free(value);
+        break;
+    }
+    return numberChannels;
+}
@@ -0,0 +1,17 @@
+//
+// Created by Frederic on 11/06/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_OPENSLMETADATA_H
+#define MINI_SOUND_SYSTEM_OPENSLMETADATA_H
+
+#include <SLES/OpenSLES.h>
+
+/**
+ * Number of channels of the PCM frames output by an OpenSL decoder. The decoder keeps the channels
+ * of the file whatever the format of its sink, they are only known once it has started decoding.
+ * @return defaultNumberChannels if the metadata is not available.
+ */
+int readDecodedNumberChannels(SLMetadataExtractionItf metadata, int defaultNumberChannels);
+
+#endif //MINI_SOUND_SYSTEM_OPENSLMETADATA_H
@@ -0,0 +1,401 @@
+#include "PcmFile.h"
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <utils/android_debug.h>
+
+#include "dsp/ChannelMapper.h"
+
+#define WAV_FORMAT_PCM 1
+#define WAV_FORMAT_IEEE_FLOAT 3
+#define WAV_FORMAT_EXTENSIBLE 0xFFFE
+
+// frames of files with more than 2 channels converted at once to 16 bits before their downmix
+#define PCM_FILE_DOWNMIX_FRAMES 1024
+
+static uint16_t readUint16LE(const uint8_t *src) {
+    return (uint16_t) (src[0] | (src[1] << 8));
+}
+
+static uint32_t readUint32LE(const uint8_t *src) {
+    return (uint32_t) src[0] | ((uint32_t) src[1] << 8) | ((uint32_t) src[2] << 16)
+           | ((uint32_t) src[3] << 24);
+}
+
+static uint16_t readUint16BE(const uint8_t *src) {
+    return (uint16_t) ((src[0] << 8) | src[1]);
+}
+
+static uint32_t readUint32BE(const uint8_t *src) {
+    return ((uint32_t) src[0] << 24) | ((uint32_t) src[1] << 16) | ((uint32_t) src[2] << 8)
+           | (uint32_t) src[3];
+}
+
+// sample rate of AIFF files is an 80 bits IEEE 754 extended precision float
+static double readExtendedBE(const uint8_t *src) {
+    const int exponent = ((src[0] & 0x7F) << 8) | src[1];
+    uint64_t mantissa = 0;
+    for (int i = 0; i < 8; i++) {
+        mantissa = (mantissa << 8) | src[2 + i];
+    }
+    if (exponent == 0 && mantissa == 0) {
+        return 0;
+    }
+    const double value = ldexp((double) mantissa, exponent - 16383 - 63);
+    return (src[0] & 0x80) ? -value : value;
+}
+
+// read a sample of any supported format as a float in [-1, 1]
+static float readSample(const uint8_t *src, int format, bool isBigEndian) {
+    switch (format) {
+        case kPcmFormatUnsigned8:
+            return (src[0] - 128) * (1.f / 128.f);
+        case kPcmFormatSigned16:
+            return (int16_t) (isBigEndian ? readUint16BE(src) : readUint16LE(src))
+                   * (1.f / 32768.f);
+        case kPcmFormatSigned24: {
+            int32_t value = isBigEndian ? (src[0] << 16) | (src[1] << 8) | src[2]
+                                        : (src[2] << 16) | (src[1] << 8) | src[0];
+            // sign extension of the 24 bits value
+            value = (value ^ 0x800000) - 0x800000;
+            return value * (1.f / 8388608.f);
+        }
+        case kPcmFormatSigned32:
+            return (int32_t) (isBigEndian ? readUint32BE(src) : readUint32LE(src))
+                   * (1.f / 2147483648.f);
+        case kPcmFormatFloat32:
+        default: {
+            uint32_t bits = isBigEndian ? readUint32BE(src) : readUint32LE(src);
+            float value;
+            memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+    }
+}
+
+PcmFile::PcmFile() :
+        _fd(-1),
+        _mapping(nullptr),
+        _mappingSize(0),
+        _data(nullptr),
+        _sampleFormat(kPcmFormatSigned16),
+        _isBigEndian(false),
+        _bytesPerSample(2),
+        _sampleRate(0),
+        _numberChannels(0),
+        _numberFrames(0),
+        _convertedData(nullptr) {
+}
+
+PcmFile::~PcmFile() {
+    close();
+}
+
+bool PcmFile::isPcmFile(const char *path) {
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    uint8_t header[12];
+    bool isPcm = false;
+    if (pread(fd, header, sizeof(header), 0) == sizeof(header)) {
+        isPcm = (memcmp(header, "RIFF", 4) == 0 && memcmp(header + 8, "WAVE", 4) == 0)
+                || (memcmp(header, "FORM", 4) == 0
+                    && (memcmp(header + 8, "AIFF", 4) == 0 || memcmp(header + 8, "AIFC", 4) == 0));
+    }
+    ::close(fd);
+    return isPcm;
+}
+
+bool PcmFile::open(const char *path) {
+    close();
+
+    _fd = ::open(path, O_RDONLY);
+    if (_fd < 0) {
+        LOGE("Can't open %s", path);
+        return false;
+    }
+
+    struct stat fileStat;
+    if (fstat(_fd, &fileStat) != 0 || fileStat.st_size < 12) {
+        close();
+        return false;
+    }
+
+    _mappingSize = (size_t) fileStat.st_size;
+    _mapping = mmap(nullptr, _mappingSize, PROT_READ, MAP_PRIVATE, _fd, 0);
+    if (_mapping == MAP_FAILED) {
+        LOGE("Can't map %s", path);
+        _mapping = nullptr;
+        close();
+        return false;
+    }
+
+    const uint8_t *file = (const uint8_t *) _mapping;
+    bool isValid = memcmp(file, "RIFF", 4) == 0 ? parseWav(file, _mappingSize)
+                                                : parseAiff(file, _mappingSize);
+    if (!isValid || _numberChannels <= 0 || _numberFrames == 0) {
+        LOGE("Unsupported pcm file %s", path);
+        close();
+        return false;
+    }
+
+    // the player reads the file from the start, let the kernel read ahead
+    madvise(_mapping, _mappingSize, MADV_SEQUENTIAL);
+    madvise(_mapping, _mappingSize, MADV_WILLNEED);
+    return true;
+}
+
+void PcmFile::close() {
+    if (_mapping != nullptr) {
+        munmap(_mapping, _mappingSize);
+        _mapping = nullptr;
+        _mappingSize = 0;
+    }
+    if (_fd >= 0) {
+        ::close(_fd);
+        _fd = -1;
+    }
+    if (_convertedData != nullptr) {
+        free(_convertedData);
+        _convertedData = nullptr;
+    }
+    _data = nullptr;
+    _numberFrames = 0;
+}
+
+bool PcmFile::parseWav(const uint8_t *file, size_t fileSize) {
+    if (memcmp(file + 8, "WAVE", 4) != 0) {
+        return false;
+    }
+
+    bool hasFormat = false;
+    size_t position = 12;
+    while (position + 8 <= fileSize) {
+        const uint8_t *chunk = file + position;
+        uint32_t chunkSize = readUint32LE(chunk + 4);
+        const size_t available = fileSize - position - 8;
+
+        if (memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16 && chunkSize <= available) {
+            int audioFormat = readUint16LE(chunk + 8);
+            _numberChannels = readUint16LE(chunk + 10);
+            _sampleRate = readUint32LE(chunk + 12);
+            const int bitsPerSample = readUint16LE(chunk + 22);
+            // the data chunk is divided by the frame size
+            if (_numberChannels == 0 || _sampleRate == 0) {
+                LOGE("Invalid wav format, %d channels at %d Hz", _numberChannels, _sampleRate);
+                return false;
+            }
+            if (audioFormat == WAV_FORMAT_EXTENSIBLE && chunkSize >= 26) {
+                // first bytes of the sub format GUID are the format code
+                audioFormat = readUint16LE(chunk + 32);
+            }
+
+            if (audioFormat == WAV_FORMAT_PCM && bitsPerSample == 8) {
+                _sampleFormat = kPcmFormatUnsigned8;
+            } else if (audioFormat == WAV_FORMAT_PCM && bitsPerSample == 16) {
+                _sampleFormat = kPcmFormatSigned16;
+            } else if (audioFormat == WAV_FORMAT_PCM && bitsPerSample == 24) {
+                _sampleFormat = kPcmFormatSigned24;
+            } else if (audioFormat == WAV_FORMAT_PCM && bitsPerSample == 32) {
+                _sampleFormat = kPcmFormatSigned32;
+            } else if (audioFormat == WAV_FORMAT_IEEE_FLOAT && bitsPerSample == 32) {
+                _sampleFormat = kPcmFormatFloat32;
+            } else {
+                LOGE("Unsupported wav format %d, %d bits", audioFormat, bitsPerSample);
+                return false;
+            }
+            _bytesPerSample = bitsPerSample / 8;
+            _isBigEndian = false;
+            hasFormat = true;
+        } else if (memcmp(chunk, "data", 4) == 0 && hasFormat) {
+            // size of streamed or truncated files is wrong
+            if (chunkSize > available) {
+                chunkSize = (uint32_t) available;
+            }
+            _data = chunk + 8;
+            _numberFrames = chunkSize / (_bytesPerSample * _numberChannels);
+            return true;
+        }
+
+        // chunks are word aligned
+        position += 8 + (size_t) chunkSize + (chunkSize & 1);
+    }
+    return false;
+}
+
+bool PcmFile::parseAiff(const uint8_t *file, size_t fileSize) {
+    const bool isAifc = memcmp(file + 8, "AIFC", 4) == 0;
+    if (memcmp(file, "FORM", 4) != 0 || (!isAifc && memcmp(file + 8, "AIFF", 4) != 0)) {
+        return false;
+    }
+
+    bool hasFormat = false;
+    unsigned int numberFrames = 0;
+    size_t position = 12;
+    while (position + 8 <= fileSize) {
+        const uint8_t *chunk = file + position;
+        uint32_t chunkSize = readUint32BE(chunk + 4);
+        const size_t available = fileSize - position - 8;
+
+        if (memcmp(chunk, "COMM", 4) == 0 && chunkSize >= 18 && chunkSize <= available) {
+            _numberChannels = readUint16BE(chunk + 8);
+            numberFrames = readUint32BE(chunk + 10);
+            const int bitsPerSample = readUint16BE(chunk + 14);
+            _sampleRate = (int) lround(readExtendedBE(chunk + 16));
+            if (_numberChannels == 0 || _sampleRate <= 0) {
+                LOGE("Invalid aiff format, %d channels at %d Hz", _numberChannels, _sampleRate);
+                return false;
+            }
+
+            _isBigEndian = true;
+            bool isFloat = false;
+            if (isAifc && chunkSize >= 22) {
+                const uint8_t *compression = chunk + 26;
+                if (memcmp(compression, "sowt", 4) == 0) {
+                    _isBigEndian = false;
+                } else if (memcmp(compression, "fl32", 4) == 0
+                           || memcmp(compression, "FL32", 4) == 0) {
+                    isFloat = true;
+                } else if (memcmp(compression, "NONE", 4) != 0) {
+                    LOGE("Compressed aiff files are not supported");
+                    return false;
+                }
+            }
+
+            if (isFloat) {
+                _sampleFormat = kPcmFormatFloat32;
+                _bytesPerSample = 4;
+            } else if (bitsPerSample <= 8) {
+                LOGE("8 bits aiff files are not supported");
+                return false;
+            } else if (bitsPerSample <= 16) {
+                _sampleFormat = kPcmFormatSigned16;
+                _bytesPerSample = 2;
+            } else if (bitsPerSample <= 24) {
+                _sampleFormat = kPcmFormatSigned24;
+                _bytesPerSample = 3;
+            } else if (bitsPerSample <= 32) {
+                _sampleFormat = kPcmFormatSigned32;
+                _bytesPerSample = 4;
+            } else {
+                return false;
+            }
+            hasFormat = true;
+        } else if (memcmp(chunk, "SSND", 4) == 0 && hasFormat && chunkSize >= 8) {
+            if (chunkSize > available) {
+                chunkSize = (uint32_t) available;
+            }
+            const uint32_t offset = readUint32BE(chunk + 8);
+            if (offset > chunkSize - 8) {
+                return false;
+            }
+            _data = chunk + 16 + offset;
+            const unsigned int availableFrames =
+                    (chunkSize - 8 - offset) / (_bytesPerSample * _numberChannels);
+            _numberFrames = numberFrames < availableFrames ? numberFrames : availableFrames;
+            return true;
+        }
+
+        position += 8 + (size_t) chunkSize + (chunkSize & 1);
+    }
+    return false;
+}
+
+bool PcmFile::isPlayerFormat() {
+#ifdef FLOAT_PLAYER
+    const int playerFormat = kPcmFormatFloat32;
+#else
+    const int playerFormat = kPcmFormatSigned16;
+#endif
+    // samples are read in place, they must be aligned. Other layouts are downmixed.
+    return _data != nullptr && _numberChannels == 2 && _sampleFormat == playerFormat
+           && !_isBigEndian && ((uintptr_t) _data % sizeof(AUDIO_HARDWARE_SAMPLE_TYPE)) == 0;
+}
+
+const AUDIO_HARDWARE_SAMPLE_TYPE* PcmFile::getPlayerData() {
+    if (_convertedData != nullptr) {
+        return _convertedData;
+    }
+    if (_data == nullptr) {
+        return nullptr;
+    }
+    if (isPlayerFormat()) {
+        return (const AUDIO_HARDWARE_SAMPLE_TYPE *) _data;
+    }
+    convertToPlayerFormat();
+    return _convertedData;
+}
+
+void PcmFile::convertToPlayerFormat() {
+    _convertedData = (AUDIO_HARDWARE_SAMPLE_TYPE *) malloc(
+            (size_t) _numberFrames * 2 * sizeof(AUDIO_HARDWARE_SAMPLE_TYPE));
+    if (_convertedData == nullptr) {
+        LOGE("Not enough memory to convert %u frames", _numberFrames);
+        return;
+    }
+
+    if (_numberChannels > 2) {
+        downmixToPlayerFormat();
+    } else {
+        const int frameSize = _bytesPerSample * _numberChannels;
+        // mono files are played on both channels
+        const int rightChannelOffset = _numberChannels > 1 ? _bytesPerSample : 0;
+        for (unsigned int i = 0; i < _numberFrames; i++) {
+            const uint8_t *frame = _data + (size_t) i * frameSize;
+            for (int channel = 0; channel < 2; channel++) {
+                float sample = readSample(frame + channel * rightChannelOffset, _sampleFormat,
+                                          _isBigEndian);
+#ifdef FLOAT_PLAYER
+                _convertedData[i * 2 + channel] = sample;
+#else
+                sample *= 32768.f;
+                _convertedData[i * 2 + channel] = (short) (sample > 32767.f ? 32767 :
+                                                           (sample < -32768.f ? -32768
+                                                                              : lrintf(sample)));
+#endif
+            }
+        }
+    }
+
+    // samples won't be read again from the file
+    munmap(_mapping, _mappingSize);
+    _mapping = nullptr;
+    _mappingSize = 0;
+    _data = nullptr;
+}
+
+void PcmFile::downmixToPlayerFormat() {
+    // same downmix as decoded tracks, from 16 bits samples
+    ChannelMapper mapper;
+    mapper.setNumberChannels(_numberChannels);
+    short *samples = (short *) malloc(
+            (size_t) PCM_FILE_DOWNMIX_FRAMES * _numberChannels * sizeof(short));
+    if (samples == nullptr) {
+        LOGE("Not enough memory to downmix %d channels", _numberChannels);
+        free(_convertedData);
+        _convertedData = nullptr;
+        return;
+    }
+
+    const int frameSize = _bytesPerSample * _numberChannels;
+    for (unsigned int start = 0; start < _numberFrames; start += PCM_FILE_DOWNMIX_FRAMES) {
+        const unsigned int numberFrames = _numberFrames - start < PCM_FILE_DOWNMIX_FRAMES
+                                          ? _numberFrames - start : PCM_FILE_DOWNMIX_FRAMES;
+        const uint8_t *frames = _data + (size_t) start * frameSize;
+        for (unsigned int i = 0; i < numberFrames * _numberChannels; i++) {
+            const float sample = readSample(frames + (size_t) i * _bytesPerSample, _sampleFormat,
+                                            _isBigEndian) * 32768.f;
+            samples[i] = (short) (sample > 32767.f ? 32767 :
+                                  (sample < -32768.f ? -32768 : lrintf(sample)));
+        }
+        mapper.map(samples, _convertedData + (size_t) start * 2, numberFrames);
+    }
+    free(samples);
+}
@@ -0,0 +1,99 @@
+//
+// Created by Frederic on 31/05/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_PCMFILE_H
+#define MINI_SOUND_SYSTEM_PCMFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "audio/SampleType.h"
+
+enum PcmSampleFormat {
+    kPcmFormatUnsigned8 = 0,
+    kPcmFormatSigned16,
+    kPcmFormatSigned24,
+    kPcmFormatSigned32,
+    kPcmFormatFloat32,
+};
+
+/**
+ * Uncompressed WAV or AIFF file mapped in memory.
+ *
+ * When samples on disk are interleaved stereo in the format of the player, the player reads them
+ * directly from the mapping and nothing is copied. Otherwise they are converted once to a buffer
+ * in the format of the player by getPlayerData, whose duration grows with the file length. Files
+ * with more than 2 channels are downmixed by ChannelMapper, like decoded tracks.
+ */
+class PcmFile {
+public:
+    PcmFile();
+    PcmFile& operator=(const PcmFile& ) = delete;
+    PcmFile(PcmFile&) = delete;
+    ~PcmFile();
+
+    /**
+     * Check the first bytes of a file.
+     * @return true if it is a WAV or an AIFF file.
+     */
+    static bool isPcmFile(const char *path);
+
+    /**
+     * Parse the header and map the file.
+     * @return false if the file is not an uncompressed WAV or AIFF file.
+     */
+    bool open(const char *path);
+
+    void close();
+
+    /**
+     * Interleaved stereo frames in the format of the player, mapped or converted.
+     * @return nullptr if the file is not open.
+     */
+    const AUDIO_HARDWARE_SAMPLE_TYPE* getPlayerData();
+
+    // true if getPlayerData returns the mapping
+    bool isPlayerFormat();
+
+    inline int getSampleRate(){
+        return _sampleRate;
+    }
+
+    inline int getNumberChannels(){
+        return _numberChannels;
+    }
+
+    inline unsigned int getNumberFrames(){
+        return _numberFrames;
+    }
+
+private:
+
+    bool parseWav(const uint8_t *file, size_t fileSize);
+
+    bool parseAiff(const uint8_t *file, size_t fileSize);
+
+    void convertToPlayerFormat();
+
+    // convert files with more than 2 channels with the downmix of ChannelMapper
+    void downmixToPlayerFormat();
+
+    int _fd;
+    void *_mapping;
+    size_t _mappingSize;
+
+    // samples in the mapping
+    const uint8_t *_data;
+    int _sampleFormat;
+    bool _isBigEndian;
+    int _bytesPerSample;
+
+    int _sampleRate;
+    int _numberChannels;
+    unsigned int _numberFrames;
+
+    AUDIO_HARDWARE_SAMPLE_TYPE *_convertedData;
+};
+
+#endif //MINI_SOUND_SYSTEM_PCMFILE_H
@@ -0,0 +1,156 @@
+#include "PcmPages.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <utils/android_debug.h>
+
+#define PAGE_FRAMES_MASK (PCM_PAGE_FRAMES - 1)
+#define PAGE_BYTES (PCM_PAGE_FRAMES * 2 * sizeof(AUDIO_HARDWARE_SAMPLE_TYPE))
+
+PcmPages::PcmPages() :
+        _maxPages(PCM_MAX_PAGES),
+        _numberPages(0),
+        _numberAllocatedPages(0),
+        _numberFrames(0),
+        _ownsPages(true) {
+    _pages = (AUDIO_HARDWARE_SAMPLE_TYPE **) calloc(_maxPages, sizeof(AUDIO_HARDWARE_SAMPLE_TYPE *));
+    if (_pages == nullptr) {
+        _maxPages = 0;
+    }
+}
+
+PcmPages::~PcmPages() {
+    if (_ownsPages) {
+        for (unsigned int i = 0; i < _numberPages; i++) {
+            free(_pages[i]);
+        }
+    }
+    free(_pages);
+}
+
+PcmPages* PcmPages::wrap(const AUDIO_HARDWARE_SAMPLE_TYPE *frames, unsigned int numberFrames) {
+    const unsigned int numberPages = (numberFrames + PAGE_FRAMES_MASK) >> PCM_PAGE_FRAMES_SHIFT;
+    if (numberPages > PCM_MAX_PAGES) {
+        LOGE("Track of %u frames is too long", numberFrames);
+        return nullptr;
+    }
+
+    PcmPages *pages = new PcmPages();
+    if (pages->_maxPages == 0) {
+        delete pages;
+        return nullptr;
+    }
+    pages->_ownsPages = false;
+    for (unsigned int i = 0; i < numberPages; i++) {
+        pages->_pages[i] = (AUDIO_HARDWARE_SAMPLE_TYPE *) frames + (size_t) i * PCM_PAGE_FRAMES * 2;
+    }
+    pages->_numberPages = numberPages;
+    pages->_numberFrames = numberFrames;
+    return pages;
+}
+
+AUDIO_HARDWARE_SAMPLE_TYPE* PcmPages::getWritePointer(unsigned int *numberFrames) {
+    *numberFrames = 0;
+    if (!_ownsPages) {
+        return nullptr;
+    }
+
+    const unsigned int page = _numberFrames >> PCM_PAGE_FRAMES_SHIFT;
+    if (page >= _numberPages) {
+        if (page >= _maxPages) {
+            LOGE("Track is too long, %u frames kept", _numberFrames);
+            return nullptr;
+        }
+        AUDIO_HARDWARE_SAMPLE_TYPE *frames = (AUDIO_HARDWARE_SAMPLE_TYPE *) malloc(PAGE_BYTES);
+        if (frames == nullptr) {
+            LOGE("No memory for a new page, %u frames kept", _numberFrames);
+            return nullptr;
+        }
+        // readers only look at pages of published frames
+        __atomic_store_n(&_pages[page], frames, __ATOMIC_RELAXED);
+        _numberPages = page + 1;
+        _numberAllocatedPages++;
+    }
+
+    const unsigned int offset = _numberFrames & PAGE_FRAMES_MASK;
+    *numberFrames = PCM_PAGE_FRAMES - offset;
+    return _pages[page] + offset * 2;
+}
+
+void PcmPages::commitFrames(unsigned int numberFrames) {
+    __atomic_store_n(&_numberFrames, _numberFrames + numberFrames, __ATOMIC_RELEASE);
+}
+
+unsigned int PcmPages::append(const AUDIO_HARDWARE_SAMPLE_TYPE *frames,
+                              unsigned int numberFrames) {
+    unsigned int numberFramesAppended = 0;
+    while (numberFramesAppended < numberFrames) {
+        unsigned int writableFrames;
+        AUDIO_HARDWARE_SAMPLE_TYPE *dst = getWritePointer(&writableFrames);
+        if (dst == nullptr) {
+            break;
+        }
+        const unsigned int remainingFrames = numberFrames - numberFramesAppended;
+        const unsigned int count = remainingFrames < writableFrames ? remainingFrames
+                                                                    : writableFrames;
+        memcpy(dst, frames + numberFramesAppended * 2,
+               count * 2 * sizeof(AUDIO_HARDWARE_SAMPLE_TYPE));
+        commitFrames(count);
+        numberFramesAppended += count;
+    }
+    return numberFramesAppended;
+}
+
+const AUDIO_HARDWARE_SAMPLE_TYPE* PcmPages::getFrames(unsigned int position,
+                                                      unsigned int *numberFrames) const {
+    const unsigned int totalFrames = getNumberFrames();
+    if (position >= totalFrames) {
+        *numberFrames = 0;
+        return nullptr;
+    }
+
+    const unsigned int offset = position & PAGE_FRAMES_MASK;
+    const unsigned int pageFrames = PCM_PAGE_FRAMES - offset;
+    const unsigned int remainingFrames = totalFrames - position;
+    *numberFrames = remainingFrames < pageFrames ? remainingFrames : pageFrames;
+
+    const AUDIO_HARDWARE_SAMPLE_TYPE *page = __atomic_load_n(
+            &_pages[position >> PCM_PAGE_FRAMES_SHIFT], __ATOMIC_RELAXED);
+    return page != nullptr ? page + offset * 2 : nullptr;
+}
+
+unsigned int PcmPages::read(unsigned int position, AUDIO_HARDWARE_SAMPLE_TYPE *frames,
+                            unsigned int numberFrames) const {
+    unsigned int numberFramesRead = 0;
+    unsigned int numberFramesCopied = 0;
+    while (numberFramesCopied < numberFrames) {
+        unsigned int contiguousFrames;
+        const AUDIO_HARDWARE_SAMPLE_TYPE *src = getFrames(position + numberFramesCopied,
+                                                          &contiguousFrames);
+        const unsigned int remainingFrames = numberFrames - numberFramesCopied;
+        if (contiguousFrames == 0) {
+            // after the written frames
+            memset(frames + numberFramesCopied * 2, 0,
+                   remainingFrames * 2 * sizeof(AUDIO_HARDWARE_SAMPLE_TYPE));
+            break;
+        }
+
+        const unsigned int count = remainingFrames < contiguousFrames ? remainingFrames
+                                                                      : contiguousFrames;
+        if (src != nullptr) {
+            memcpy(frames + numberFramesCopied * 2, src,
+                   count * 2 * sizeof(AUDIO_HARDWARE_SAMPLE_TYPE));
+            numberFramesRead += count;
+        } else {
+            memset(frames + numberFramesCopied * 2, 0,
+                   count * 2 * sizeof(AUDIO_HARDWARE_SAMPLE_TYPE));
+        }
+        numberFramesCopied += count;
+    }
+    return numberFramesRead;
+}
+
+size_t PcmPages::getSizeBytes() const {
+    return _ownsPages ? (size_t) _numberAllocatedPages * PAGE_BYTES : 0;
+}
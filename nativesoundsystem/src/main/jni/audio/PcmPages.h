@@ -0,0 +1,93 @@
+//
+// Created by Frederic on 08/06/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_PCMPAGES_H
+#define MINI_SOUND_SYSTEM_PCMPAGES_H
+
+#include <stddef.h>
+
+#include "audio/SampleType.h"
+
+// frames of a page, a power of 2 so that a position is split with a shift and a mask
+#define PCM_PAGE_FRAMES_SHIFT 15
+#define PCM_PAGE_FRAMES (1u << PCM_PAGE_FRAMES_SHIFT)
+
+// pages of a track, about 3 hours at 48000 Hz
+#define PCM_MAX_PAGES 16384
+
+/**
+ * Interleaved stereo frames of a track in the format of the player, stored in fixed size pages
+ * allocated while the track is written. The length of the track doesn't have to be known before
+ * decoding, and memory grows with the decoded frames.
+ *
+ * A single thread writes at the end while other threads read frames already written : the number
+ * of frames is published after the frames, and the index of pages never moves.
+ */
+class PcmPages {
+public:
+    PcmPages();
+    PcmPages& operator=(const PcmPages& ) = delete;
+    PcmPages(PcmPages&) = delete;
+    ~PcmPages();
+
+    /**
+     * Pages pointing to contiguous frames owned by someone else, like a file mapping. Nothing can
+     * be written to them.
+     * @return nullptr if the frames don't fit in PCM_MAX_PAGES.
+     */
+    static PcmPages* wrap(const AUDIO_HARDWARE_SAMPLE_TYPE *frames, unsigned int numberFrames);
+
+    /**
+     * End of the written frames, allocating a new page when the last one is full.
+     * @param numberFrames set to the number of frames which can be written to the pointer.
+     * @return nullptr if no page can be allocated.
+     */
+    AUDIO_HARDWARE_SAMPLE_TYPE* getWritePointer(unsigned int *numberFrames);
+
+    // publish frames written to the pointer of getWritePointer
+    void commitFrames(unsigned int numberFrames);
+
+    /**
+     * Copy frames at the end of the pages.
+     * @return number of frames appended, less than numberFrames if memory is exhausted.
+     */
+    unsigned int append(const AUDIO_HARDWARE_SAMPLE_TYPE *frames, unsigned int numberFrames);
+
+    inline unsigned int getNumberFrames() const {
+        return __atomic_load_n(&_numberFrames, __ATOMIC_ACQUIRE);
+    }
+
+    /**
+     * Frames contiguous in memory from position, up to the end of its page.
+     * @param numberFrames set to the number of frames readable from the pointer.
+     * @return nullptr if the frame has not been written.
+     */
+    const AUDIO_HARDWARE_SAMPLE_TYPE* getFrames(unsigned int position,
+                                                unsigned int *numberFrames) const;
+
+    /**
+     * Copy frames across pages. Frames not written are copied as silence.
+     * @return number of frames read from pages, the others are silent.
+     */
+    unsigned int read(unsigned int position, AUDIO_HARDWARE_SAMPLE_TYPE *frames,
+                      unsigned int numberFrames) const;
+
+    // heap memory used by pages, 0 for wrapped frames
+    size_t getSizeBytes() const;
+
+private:
+
+    AUDIO_HARDWARE_SAMPLE_TYPE **_pages;
+    unsigned int _maxPages;
+    unsigned int _numberPages;
+    unsigned int _numberAllocatedPages;
+
+    // written by the writer only, read by every thread
+    unsigned int _numberFrames;
+
+    // false if pages point to frames owned by someone else
+    bool _ownsPages;
+};
+
+#endif //MINI_SOUND_SYSTEM_PCMPAGES_H
@@ -0,0 +1,55 @@
+//
+// Created by Frederic on 23/05/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_PLAYERCOMMAND_H
+#define MINI_SOUND_SYSTEM_PLAYERCOMMAND_H
+
+#include <stdint.h>
+
+// maximum number of commands waiting for the next player callback
+#define PLAYER_COMMAND_QUEUE_CAPACITY 64
+
+enum PlayerCommandType {
+    kPlayerCommandPlay = 0,
+    kPlayerCommandPause,
+    kPlayerCommandStop,
+    kPlayerCommandSetEqualizerSection,
+    kPlayerCommandSetThreeBandGains,
+    kPlayerCommandResetEqualizer,
+    kPlayerCommandSetRate,
+};
+
+/**
+ * Change of the player state sent from JNI threads to the audio thread.
+ */
+typedef struct {
+    int type;
+
+    // index and type of an equalizer section
+    int index;
+    int sectionType;
+
+    // frequency, gain and q of a section, the three band gains, or the rate and its ramp in ms
+    float values[3];
+} PlayerCommand;
+
+/**
+ * State of the player published by the audio thread at the end of each callback.
+ */
+typedef struct {
+    bool isPlaying;
+    unsigned int positionFrames;
+
+    // clock of the last callback : presentedFrame is heard at presentationTimeNs, then the position
+    // moves by rate frames of the track per frame of the output, 0 when no track is playing
+    unsigned int presentedFrame;
+    int64_t presentationTimeNs;
+    float rate;
+
+    // frame of the output clock heard at presentationTimeNs, the clock of scheduled events. It
+    // counts the frames rendered by the player and doesn't move while the stream is stopped.
+    uint64_t outputFrame;
+} PlayerState;
+
+#endif //MINI_SOUND_SYSTEM_PLAYERCOMMAND_H
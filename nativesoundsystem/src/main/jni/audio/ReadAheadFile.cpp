@@ -0,0 +1,173 @@
+#include "ReadAheadFile.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <utils/android_debug.h>
+#include <utils/ThreadPolicy.h>
+
+static double now_ms(void) {
+    struct timespec res;
+    clock_gettime(CLOCK_MONOTONIC, &res);
+    return 1000.0 * res.tv_sec + (double) res.tv_nsec / 1e6;
+}
+
+ReadAheadFile::ReadAheadFile() :
+        _fd(-1),
+        _offset(0),
+        _isOpen(false),
+        _isStopped(false),
+        _currentBlock(0),
+        _blockOffset(0),
+        _hasBlock(false),
+        _isEndOfFile(false),
+        _ioWaitMs(0),
+        _numberBytesRead(0) {
+    for (int i = 0; i < READ_AHEAD_NUMBER_BLOCKS; i++) {
+        _blocks[i] = (unsigned char *) malloc(READ_AHEAD_BLOCK_SIZE);
+        _blockSizes[i] = 0;
+    }
+}
+
+ReadAheadFile::~ReadAheadFile() {
+    close();
+    for (int i = 0; i < READ_AHEAD_NUMBER_BLOCKS; i++) {
+        free(_blocks[i]);
+    }
+}
+
+bool ReadAheadFile::open(const char *path, off_t offset) {
+    if (_isOpen) {
+        return false;
+    }
+
+    _fd = ::open(path, O_RDONLY);
+    if (_fd < 0) {
+        LOGE("Unable to open %s", path);
+        return false;
+    }
+    // larger read ahead of the kernel, pages are dropped sooner once read
+    posix_fadvise(_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    _offset = offset;
+    _isStopped = false;
+    _currentBlock = 0;
+    _blockOffset = 0;
+    _hasBlock = false;
+    _isEndOfFile = false;
+    _ioWaitMs = 0;
+    _numberBytesRead = 0;
+    sem_init(&_freeBlocks, 0, READ_AHEAD_NUMBER_BLOCKS);
+    sem_init(&_filledBlocks, 0, 0);
+    pthread_create(&_thread, nullptr, readerThread, this);
+    _isOpen = true;
+    return true;
+}
+
+unsigned int ReadAheadFile::read(void *data, unsigned int numberBytes) {
+    unsigned char *dst = (unsigned char *) data;
+    unsigned int numberCopied = 0;
+    while (_isOpen && numberCopied < numberBytes) {
+        if (!_hasBlock) {
+            if (_isEndOfFile) {
+                break;
+            }
+            acquireBlock();
+        }
+
+        const unsigned int blockSize = _blockSizes[_currentBlock];
+        unsigned int size = blockSize - _blockOffset;
+        if (size > numberBytes - numberCopied) {
+            size = numberBytes - numberCopied;
+        }
+        memcpy(dst + numberCopied, _blocks[_currentBlock] + _blockOffset, size);
+        _blockOffset += size;
+        numberCopied += size;
+
+        if (_blockOffset == blockSize) {
+            // the reader thread stops after a short block
+            _isEndOfFile = blockSize < READ_AHEAD_BLOCK_SIZE;
+            _hasBlock = false;
+            _currentBlock = (_currentBlock + 1) % READ_AHEAD_NUMBER_BLOCKS;
+            sem_post(&_freeBlocks);
+        }
+    }
+    _numberBytesRead += numberCopied;
+    return numberCopied;
+}
+
+void ReadAheadFile::acquireBlock() {
+    // only a block not read yet is counted as I/O wait
+    if (sem_trywait(&_filledBlocks) != 0) {
+        const double startTime = now_ms();
+        sem_wait(&_filledBlocks);
+        _ioWaitMs += now_ms() - startTime;
+    }
+    _blockOffset = 0;
+    _hasBlock = true;
+}
+
+void ReadAheadFile::close() {
+    if (!_isOpen) {
+        return;
+    }
+
+    _isStopped = true;
+    // wake up the reader thread if all blocks are filled
+    sem_post(&_freeBlocks);
+    pthread_join(_thread, nullptr);
+
+    sem_destroy(&_freeBlocks);
+    sem_destroy(&_filledBlocks);
+    ::close(_fd);
+    _fd = -1;
+    _isOpen = false;
+}
+
+void* ReadAheadFile::readerThread(void *data) {
+    ReadAheadFile *self = static_cast<ReadAheadFile *>(data);
+    self->readBlocks();
+    return nullptr;
+}
+
+void ReadAheadFile::readBlocks() {
+    uint32_t policyGeneration = 0;
+    refreshThreadPolicy(kThreadRoleIo, &policyGeneration);
+
+    off_t offset = _offset;
+    int block = 0;
+    while (true) {
+        sem_wait(&_freeBlocks);
+        if (_isStopped) {
+            return;
+        }
+
+        // the kernel reads the next block while this one is copied
+        posix_fadvise(_fd, offset + READ_AHEAD_BLOCK_SIZE, READ_AHEAD_BLOCK_SIZE,
+                      POSIX_FADV_WILLNEED);
+
+        unsigned int blockSize = 0;
+        while (blockSize < READ_AHEAD_BLOCK_SIZE) {
+            ssize_t result = pread(_fd, _blocks[block] + blockSize,
+                                   READ_AHEAD_BLOCK_SIZE - blockSize, offset + blockSize);
+            if (result < 0) {
+                LOGE("Error while reading file");
+                break;
+            } else if (result == 0) {
+                break;
+            }
+            blockSize += result;
+        }
+        _blockSizes[block] = blockSize;
+        offset += blockSize;
+        sem_post(&_filledBlocks);
+
+        if (blockSize < READ_AHEAD_BLOCK_SIZE) {
+            return;
+        }
+        block = (block + 1) % READ_AHEAD_NUMBER_BLOCKS;
+    }
+}
@@ -0,0 +1,95 @@
+//
+// Created by Frederic on 13/06/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_READAHEADFILE_H
+#define MINI_SOUND_SYSTEM_READAHEADFILE_H
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+// blocks read ahead by the reader thread
+#define READ_AHEAD_NUMBER_BLOCKS 4
+#define READ_AHEAD_BLOCK_SIZE (128 * 1024)
+
+/**
+ * Read a file sequentially with a dedicated thread, so that the thread decoding it only waits for
+ * the storage when all blocks read ahead have been consumed.
+ *
+ * Blocks are read with large reads, the kernel is told that the file is read sequentially and the
+ * block following the one being read is requested in advance. Time spent waiting for blocks is
+ * measured, to tell slow storage from slow decoding.
+ */
+class ReadAheadFile {
+public:
+    ReadAheadFile();
+    ReadAheadFile& operator=(const ReadAheadFile& ) = delete;
+    ReadAheadFile(ReadAheadFile&) = delete;
+    ~ReadAheadFile();
+
+    /**
+     * Open the file and start the reader thread.
+     * @param offset first byte read.
+     */
+    bool open(const char *path, off_t offset);
+
+    /**
+     * Copy the next bytes of the file.
+     * @return number of bytes copied, less than numberBytes at the end of the file or after an
+     * error.
+     */
+    unsigned int read(void *data, unsigned int numberBytes);
+
+    /**
+     * Stop the reader thread and close the file.
+     */
+    void close();
+
+    // time spent by read waiting for the reader thread since open
+    inline double getIoWaitMs() {
+        return _ioWaitMs;
+    }
+
+    // bytes given by read since open
+    inline uint64_t getNumberBytesRead() {
+        return _numberBytesRead;
+    }
+
+private:
+
+    static void* readerThread(void *data);
+
+    void readBlocks();
+
+    // wait for the next block read by the reader thread
+    void acquireBlock();
+
+    int _fd;
+    off_t _offset;
+
+    pthread_t _thread;
+    bool _isOpen;
+
+    // set by close, checked by the reader thread before each block
+    volatile bool _isStopped;
+
+    unsigned char *_blocks[READ_AHEAD_NUMBER_BLOCKS];
+    // a block shorter than READ_AHEAD_BLOCK_SIZE is the last one
+    unsigned int _blockSizes[READ_AHEAD_NUMBER_BLOCKS];
+
+    // block consumed by read, owned by the consumer until released
+    int _currentBlock;
+    unsigned int _blockOffset;
+    bool _hasBlock;
+    bool _isEndOfFile;
+
+    sem_t _freeBlocks;
+    sem_t _filledBlocks;
+
+    double _ioWaitMs;
+    uint64_t _numberBytesRead;
+};
+
+#endif //MINI_SOUND_SYSTEM_READAHEADFILE_H
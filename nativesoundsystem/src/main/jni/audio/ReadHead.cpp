@@ -0,0 +1,286 @@
+#include "ReadHead.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// frames read before and after the position by the interpolation
+#define READ_HEAD_TAPS_BEFORE 1
+#define READ_HEAD_TAPS_AFTER 2
+
+// frames interpolated at once
+#define VECTOR_FRAMES 4
+
+// frames of the track read by the benchmark, played around its middle
+#define READ_HEAD_BENCHMARK_TRACK_FRAMES (1 << 20)
+
+typedef float float4 __attribute__((vector_size(16)));
+typedef int32_t int4 __attribute__((vector_size(16)));
+
+static inline float4 splat(float value) {
+    return (float4) {value, value, value, value};
+}
+
+static inline float4 blend(int4 mask, float4 ifTrue, float4 ifFalse) {
+    return (float4) (((int4) ifTrue & mask) | ((int4) ifFalse & ~mask));
+}
+
+static inline AUDIO_HARDWARE_SAMPLE_TYPE toPlayerSample(float sample) {
+#ifdef FLOAT_PLAYER
+    return sample;
+#else
+    sample += sample < 0.f ? -0.5f : 0.5f;
+    return (short) (sample > 32767.f ? 32767.f : (sample < -32768.f ? -32768.f : sample));
+#endif
+}
+
+// interleave VECTOR_FRAMES frames, cubic interpolation can overshoot the range of 16 bits samples
+static inline void storeFrames(float4 left, float4 right, AUDIO_HARDWARE_SAMPLE_TYPE *frames) {
+#ifndef FLOAT_PLAYER
+    const float4 zero = splat(0.f);
+    const float4 half = splat(0.5f);
+    const float4 highest = splat(32767.f);
+    const float4 lowest = splat(-32768.f);
+    left += blend(left < zero, -half, half);
+    right += blend(right < zero, -half, half);
+    left = blend(left > highest, highest, blend(left < lowest, lowest, left));
+    right = blend(right > highest, highest, blend(right < lowest, lowest, right));
+#endif
+    for (int i = 0; i < VECTOR_FRAMES; i++) {
+        frames[i * 2] = (AUDIO_HARDWARE_SAMPLE_TYPE) left[i];
+        frames[i * 2 + 1] = (AUDIO_HARDWARE_SAMPLE_TYPE) right[i];
+    }
+}
+
+ReadHead::ReadHead(int maxFrames) :
+        _maxFrames(maxFrames),
+        _position(0),
+        _rate(1.f),
+        _targetRate(1.f),
+        _rateStep(0.f),
+        _windowFirstFrame(0) {
+    _indexes = (int *) calloc((size_t) maxFrames, sizeof(int));
+    _fractions = (float *) calloc((size_t) maxFrames, sizeof(float));
+    // a block at the highest rate, and the frames around its first and last positions
+    _maxWindowFrames = (int) ceilf(maxFrames * READ_HEAD_MAX_RATE)
+                       + READ_HEAD_TAPS_BEFORE + READ_HEAD_TAPS_AFTER + 1;
+    _window = (AUDIO_HARDWARE_SAMPLE_TYPE *) calloc((size_t) _maxWindowFrames * 2,
+                                                    sizeof(AUDIO_HARDWARE_SAMPLE_TYPE));
+}
+
+ReadHead::~ReadHead() {
+    free(_indexes);
+    free(_fractions);
+    free(_window);
+}
+
+void ReadHead::setPosition(unsigned int position) {
+    _position = position;
+}
+
+void ReadHead::setRate(float rate, int rampFrames) {
+    if (rate > READ_HEAD_MAX_RATE) {
+        rate = READ_HEAD_MAX_RATE;
+    } else if (rate < -READ_HEAD_MAX_RATE) {
+        rate = -READ_HEAD_MAX_RATE;
+    }
+    _targetRate = rate;
+    if (rampFrames <= 0) {
+        _rate = rate;
+        _rateStep = 0.f;
+    } else {
+        _rateStep = (rate - _rate) / rampFrames;
+    }
+}
+
+int ReadHead::read(const PcmPages *track, unsigned int totalFrames,
+                   AUDIO_HARDWARE_SAMPLE_TYPE *frames, int numberFrames) {
+    if (numberFrames > _maxFrames) {
+        numberFrames = _maxFrames;
+    }
+    const unsigned int blockFrames = (unsigned int) numberFrames;
+
+    if (_rate == 1.f && _targetRate == 1.f && _position == floor(_position)) {
+        const unsigned int position = (unsigned int) _position;
+        int numberFramesRead = 0;
+        if (position < totalFrames) {
+            unsigned int remainingFrames = totalFrames - position;
+            numberFramesRead = (int) (remainingFrames < blockFrames ? remainingFrames : blockFrames);
+        }
+        track->read(position, frames, numberFramesRead);
+        memset(frames + numberFramesRead * 2, 0,
+               (numberFrames - numberFramesRead) * 2 * sizeof(AUDIO_HARDWARE_SAMPLE_TYPE));
+        _position += numberFramesRead;
+        return numberFramesRead;
+    }
+
+    advance(totalFrames, numberFrames);
+
+    int firstIndex = _indexes[0];
+    int lastIndex = _indexes[0];
+    int numberFramesRead = 0;
+    for (int i = 0; i < numberFrames; i++) {
+        if (_indexes[i] < firstIndex) {
+            firstIndex = _indexes[i];
+        } else if (_indexes[i] > lastIndex) {
+            lastIndex = _indexes[i];
+        }
+        if ((unsigned int) _indexes[i] < totalFrames) {
+            numberFramesRead++;
+        }
+    }
+    const int firstFrame = firstIndex - READ_HEAD_TAPS_BEFORE;
+    fetchWindow(track, totalFrames, firstFrame,
+                lastIndex + READ_HEAD_TAPS_AFTER + 1 - firstFrame);
+    interpolate(frames, numberFrames);
+    return numberFramesRead;
+}
+
+void ReadHead::advance(unsigned int totalFrames, int numberFrames) {
+    double position = _position;
+    float rate = _rate;
+    for (int i = 0; i < numberFrames; i++) {
+        const double index = floor(position);
+        _indexes[i] = (int) index;
+        _fractions[i] = (float) (position - index);
+
+        if (rate != _targetRate) {
+            rate += _rateStep;
+            if ((_rateStep > 0.f && rate >= _targetRate) || (_rateStep < 0.f && rate <= _targetRate)
+                || _rateStep == 0.f) {
+                rate = _targetRate;
+            }
+        }
+        position += rate;
+        // the head stops at the ends of the track
+        if (position < 0.) {
+            position = 0.;
+        } else if (position > totalFrames) {
+            position = totalFrames;
+        }
+    }
+    _position = position;
+    _rate = rate;
+}
+
+void ReadHead::fetchWindow(const PcmPages *track, unsigned int totalFrames, int firstFrame,
+                           int numberWindowFrames) {
+    if (numberWindowFrames > _maxWindowFrames) {
+        numberWindowFrames = _maxWindowFrames;
+    }
+    _windowFirstFrame = firstFrame;
+
+    // frames outside of the track are silent
+    int frame = firstFrame;
+    const int endFrame = firstFrame + numberWindowFrames;
+    const int trackEndFrame = endFrame < (long) totalFrames ? endFrame : (int) totalFrames;
+    AUDIO_HARDWARE_SAMPLE_TYPE *dst = _window;
+    if (frame < 0) {
+        const int numberSilentFrames = (endFrame < 0 ? endFrame : 0) - frame;
+        memset(dst, 0, numberSilentFrames * 2 * sizeof(AUDIO_HARDWARE_SAMPLE_TYPE));
+        dst += numberSilentFrames * 2;
+        frame += numberSilentFrames;
+    }
+    if (frame < trackEndFrame) {
+        track->read((unsigned int) frame, dst, (unsigned int) (trackEndFrame - frame));
+        dst += (trackEndFrame - frame) * 2;
+        frame = trackEndFrame;
+    }
+    if (frame < endFrame) {
+        memset(dst, 0, (endFrame - frame) * 2 * sizeof(AUDIO_HARDWARE_SAMPLE_TYPE));
+    }
+}
+
+void ReadHead::interpolate(AUDIO_HARDWARE_SAMPLE_TYPE *frames, int numberFrames) {
+    const float4 half = splat(0.5f);
+    const float4 two = splat(2.f);
+    const float4 three = splat(3.f);
+    const float4 four = splat(4.f);
+    const float4 five = splat(5.f);
+
+    int i = 0;
+    for (; i + VECTOR_FRAMES <= numberFrames; i += VECTOR_FRAMES) {
+        float4 t;
+        memcpy(&t, _fractions + i, sizeof(t));
+        const float4 t2 = t * t;
+        const float4 t3 = t2 * t;
+        // Catmull-Rom weights of the frames before, at, after and two after the position
+        const float4 weightBefore = (two * t2 - t3 - t) * half;
+        const float4 weightCurrent = (three * t3 - five * t2 + two) * half;
+        const float4 weightNext = (four * t2 + t - three * t3) * half;
+        const float4 weightAfter = (t3 - t2) * half;
+
+        float4 channels[2];
+        for (int channel = 0; channel < 2; channel++) {
+            float4 before, current, next, after;
+            for (int lane = 0; lane < VECTOR_FRAMES; lane++) {
+                const AUDIO_HARDWARE_SAMPLE_TYPE *tap =
+                        _window + (_indexes[i + lane] - _windowFirstFrame) * 2 + channel;
+                before[lane] = tap[-2];
+                current[lane] = tap[0];
+                next[lane] = tap[2];
+                after[lane] = tap[4];
+            }
+            channels[channel] = weightBefore * before + weightCurrent * current
+                                + weightNext * next + weightAfter * after;
+        }
+        storeFrames(channels[0], channels[1], frames + i * 2);
+    }
+
+    for (; i < numberFrames; i++) {
+        const float t = _fractions[i];
+        const float t2 = t * t;
+        const float t3 = t2 * t;
+        const float weightBefore = (2.f * t2 - t3 - t) * 0.5f;
+        const float weightCurrent = (3.f * t3 - 5.f * t2 + 2.f) * 0.5f;
+        const float weightNext = (4.f * t2 + t - 3.f * t3) * 0.5f;
+        const float weightAfter = (t3 - t2) * 0.5f;
+        for (int channel = 0; channel < 2; channel++) {
+            const AUDIO_HARDWARE_SAMPLE_TYPE *tap =
+                    _window + (_indexes[i] - _windowFirstFrame) * 2 + channel;
+            frames[i * 2 + channel] = toPlayerSample(weightBefore * tap[-2] + weightCurrent * tap[0]
+                                                     + weightNext * tap[2] + weightAfter * tap[4]);
+        }
+    }
+}
+
+double ReadHead::benchmark(float rate, int numberFrames, int numberBlocks) {
+    PcmPages track;
+    unsigned int writableFrames;
+    AUDIO_HARDWARE_SAMPLE_TYPE *dst;
+    while (track.getNumberFrames() < READ_HEAD_BENCHMARK_TRACK_FRAMES
+           && (dst = track.getWritePointer(&writableFrames)) != nullptr) {
+        for (unsigned int i = 0; i < writableFrames * 2; i++) {
+#ifdef FLOAT_PLAYER
+            dst[i] = (float) (rand() % 2000 - 1000) / 1000.f;
+#else
+            dst[i] = (short) (rand() % 20000 - 10000);
+#endif
+        }
+        track.commitFrames(writableFrames);
+    }
+    const unsigned int totalFrames = track.getNumberFrames();
+
+    AUDIO_HARDWARE_SAMPLE_TYPE *frames = (AUDIO_HARDWARE_SAMPLE_TYPE *) malloc(
+            (size_t) numberFrames * 2 * sizeof(AUDIO_HARDWARE_SAMPLE_TYPE));
+    ReadHead readHead(numberFrames);
+    readHead.setRate(rate, 0);
+    readHead.setPosition(totalFrames / 2);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < numberBlocks; i++) {
+        // stay inside the track, where frames are really interpolated
+        const unsigned int position = readHead.getPosition();
+        if (position < totalFrames / 4 || position > totalFrames / 4 * 3) {
+            readHead.setPosition(totalFrames / 2);
+        }
+        readHead.read(&track, totalFrames, frames, numberFrames);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    free(frames);
+
+    double elapsedNs = (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+    return elapsedNs / numberBlocks;
+}
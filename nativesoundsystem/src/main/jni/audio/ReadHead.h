@@ -0,0 +1,91 @@
+//
+// Created by Frederic on 12/06/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_READHEAD_H
+#define MINI_SOUND_SYSTEM_READHEAD_H
+
+#include "audio/PcmPages.h"
+#include "audio/SampleType.h"
+
+// highest speed of the read head, forward or backward
+#define READ_HEAD_MAX_RATE 4.f
+
+/**
+ * Play position of a track moving at any rate, including negative rates for reverse playback and
+ * rates changing during a block for scratching and vinyl brakes.
+ *
+ * At rate 1 frames are copied. Otherwise frames are interpolated between the 4 nearest frames with
+ * a cubic Catmull-Rom spline, 4 output frames at once with vectors of 16 bytes.
+ */
+class ReadHead {
+public:
+    /**
+     * @param maxFrames maximum number of frames of a block.
+     */
+    ReadHead(int maxFrames);
+    ReadHead& operator=(const ReadHead& ) = delete;
+    ReadHead(ReadHead&) = delete;
+    ~ReadHead();
+
+    /**
+     * Read the next block and move the position. The position stays in [0, totalFrames].
+     * @param frames filled with numberFrames frames, with silence outside of the track.
+     * @return number of frames read inside the track.
+     */
+    int read(const PcmPages *track, unsigned int totalFrames, AUDIO_HARDWARE_SAMPLE_TYPE *frames,
+             int numberFrames);
+
+    inline unsigned int getPosition() {
+        return (unsigned int) _position;
+    }
+
+    // the rate is kept
+    void setPosition(unsigned int position);
+
+    /**
+     * Move the rate linearly to rate during rampFrames frames, 0 to change it immediately.
+     * @param rate clamped to [-READ_HEAD_MAX_RATE, READ_HEAD_MAX_RATE].
+     */
+    void setRate(float rate, int rampFrames);
+
+    inline float getRate() {
+        return _rate;
+    }
+
+    /**
+     * Measure the cost of a block read at a constant rate.
+     * @return nanoseconds per block of numberFrames.
+     */
+    static double benchmark(float rate, int numberFrames, int numberBlocks);
+
+private:
+
+    // compute the position of each frame of the block
+    void advance(unsigned int totalFrames, int numberFrames);
+
+    // copy the frames around the positions of the block to the window
+    void fetchWindow(const PcmPages *track, unsigned int totalFrames, int firstFrame,
+                     int numberWindowFrames);
+
+    void interpolate(AUDIO_HARDWARE_SAMPLE_TYPE *frames, int numberFrames);
+
+    int _maxFrames;
+
+    double _position;
+    float _rate;
+    float _targetRate;
+    // rate change per frame while ramping
+    float _rateStep;
+
+    // frame before each output frame and the fraction of the next frame
+    int *_indexes;
+    float *_fractions;
+
+    // frames of the track read by the block
+    AUDIO_HARDWARE_SAMPLE_TYPE *_window;
+    int _maxWindowFrames;
+    int _windowFirstFrame;
+};
+
+#endif //MINI_SOUND_SYSTEM_READHEAD_H
@@ -0,0 +1,15 @@
+//
+// Created by Frederic on 27/05/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_SAMPLETYPE_H
+#define MINI_SOUND_SYSTEM_SAMPLETYPE_H
+
+// type of samples sent to the audio hardware and kept in RAM for the loaded track
+#ifdef FLOAT_PLAYER
+#define AUDIO_HARDWARE_SAMPLE_TYPE float
+#else
+#define AUDIO_HARDWARE_SAMPLE_TYPE short
+#endif
+
+#endif //MINI_SOUND_SYSTEM_SAMPLETYPE_H
@@ -0,0 +1,405 @@
+#include "Sampler.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <audio/DecoderFactory.h>
+#include <dsp/ChannelMapper.h>
+#include <utils/android_debug.h>
+
+// frames mapped at once while a file is decoded
+#define DECODE_BLOCK_FRAMES 1024
+
+// duration of the sample of the benchmark, voices are triggered again when it ends
+#define BENCHMARK_SAMPLE_SECONDS 1
+
+typedef float float4 __attribute__((vector_size(16)));
+
+typedef struct {
+    AudioDecoder *decoder;
+    ChannelMapper *channelMapper;
+    // rate of the player, used if the decoder doesn't know the rate of the file
+    int sampleRate;
+    unsigned int maxFrames;
+    AUDIO_HARDWARE_SAMPLE_TYPE *mapped;
+    // stereo frames in the unit of the player samples
+    float *frames;
+    unsigned int numberFrames;
+    unsigned int capacity;
+    bool hasError;
+} SampleDecodeContext;
+
+static bool decodedBlockCallback(const short *samples, unsigned int numberSamples, void *context) {
+    SampleDecodeContext *decodeContext = (SampleDecodeContext *) context;
+    ChannelMapper *channelMapper = decodeContext->channelMapper;
+    // channel count is only known once the decoder has started
+    if (decodeContext->frames == nullptr) {
+        if (!channelMapper->setNumberChannels(decodeContext->decoder->getNumberChannels())) {
+            decodeContext->hasError = true;
+            return false;
+        }
+        // the rate of the file is not known before either
+        int fileSampleRate = decodeContext->decoder->getFileSampleRate();
+        if (fileSampleRate <= 0) {
+            fileSampleRate = decodeContext->sampleRate;
+        }
+        decodeContext->maxFrames = (unsigned int) fileSampleRate * SAMPLER_MAX_SAMPLE_SECONDS;
+    }
+
+    const int numberChannels = channelMapper->getNumberChannels();
+    unsigned int numberFrames = numberSamples / numberChannels;
+    if (numberFrames > decodeContext->maxFrames - decodeContext->numberFrames) {
+        numberFrames = decodeContext->maxFrames - decodeContext->numberFrames;
+    }
+    if (decodeContext->numberFrames + numberFrames > decodeContext->capacity) {
+        unsigned int capacity = decodeContext->capacity > 0 ? decodeContext->capacity * 2
+                                                            : DECODE_BLOCK_FRAMES * 16;
+        while (capacity < decodeContext->numberFrames + numberFrames) {
+            capacity *= 2;
+        }
+        float *frames = (float *) realloc(decodeContext->frames, capacity * 2 * sizeof(float));
+        if (frames == nullptr) {
+            decodeContext->hasError = true;
+            return false;
+        }
+        decodeContext->frames = frames;
+        decodeContext->capacity = capacity;
+    }
+
+    for (unsigned int first = 0; first < numberFrames; first += DECODE_BLOCK_FRAMES) {
+        const unsigned int count = numberFrames - first < DECODE_BLOCK_FRAMES
+                                   ? numberFrames - first : DECODE_BLOCK_FRAMES;
+        channelMapper->map(samples + first * numberChannels, decodeContext->mapped, count);
+        float *dst = decodeContext->frames + decodeContext->numberFrames * 2;
+        for (unsigned int i = 0; i < count * 2; i++) {
+            dst[i] = (float) decodeContext->mapped[i];
+        }
+        decodeContext->numberFrames += count;
+    }
+    return decodeContext->numberFrames < decodeContext->maxFrames;
+}
+
+static inline AUDIO_HARDWARE_SAMPLE_TYPE toPlayerSample(float sample) {
+#ifdef FLOAT_PLAYER
+    return sample;
+#else
+    sample += sample < 0.f ? -0.5f : 0.5f;
+    return (short) (sample > 32767.f ? 32767.f : (sample < -32768.f ? -32768.f : sample));
+#endif
+}
+
+// dst += src * gain on numberSamples samples, 4 at once
+static void addScaled(const float *src, float *dst, unsigned int numberSamples, float gain) {
+    const float4 gains = {gain, gain, gain, gain};
+    unsigned int i = 0;
+    for (; i + 4 <= numberSamples; i += 4) {
+        float4 source, destination;
+        memcpy(&source, src + i, sizeof(float4));
+        memcpy(&destination, dst + i, sizeof(float4));
+        destination += source * gains;
+        memcpy(dst + i, &destination, sizeof(float4));
+    }
+    for (; i < numberSamples; i++) {
+        dst[i] += src[i] * gain;
+    }
+}
+
+Sampler::Sampler(int sampleRate, int maxFrames) :
+        _sampleRate(sampleRate),
+        _maxFrames(maxFrames),
+        _numberSamples(0),
+        _nextOrder(0),
+        _numberActiveVoices(0),
+        _numberStolenVoices(0) {
+    memset(_samples, 0, sizeof(_samples));
+    memset(_voices, 0, sizeof(_voices));
+    _mix = (float *) calloc((size_t) maxFrames * 2, sizeof(float));
+    pthread_mutex_init(&_loadMutex, nullptr);
+    pthread_mutex_init(&_triggerMutex, nullptr);
+}
+
+Sampler::~Sampler() {
+    for (int i = 0; i < _numberSamples; i++) {
+        free(_samples[i].frames);
+    }
+    free(_mix);
+    pthread_mutex_destroy(&_loadMutex);
+    pthread_mutex_destroy(&_triggerMutex);
+}
+
+int Sampler::loadSample(const char *filePath, SLEngineItf engine, int bufferSize) {
+    AudioDecoder *decoder = createAudioDecoder(filePath, engine, _sampleRate, bufferSize);
+    ChannelMapper channelMapper;
+    SampleDecodeContext decodeContext;
+    memset(&decodeContext, 0, sizeof(decodeContext));
+    decodeContext.decoder = decoder;
+    decodeContext.channelMapper = &channelMapper;
+    decodeContext.sampleRate = _sampleRate;
+    decodeContext.mapped = (AUDIO_HARDWARE_SAMPLE_TYPE *) malloc(
+            DECODE_BLOCK_FRAMES * 2 * sizeof(AUDIO_HARDWARE_SAMPLE_TYPE));
+
+    volatile bool cancelled = false;
+    const bool isDecoded = decodeContext.mapped != nullptr
+                           && decoder->decode(filePath, decodedBlockCallback, &decodeContext,
+                                              &cancelled);
+    const int fileSampleRate = decoder->getFileSampleRate();
+    free(decodeContext.mapped);
+    delete decoder;
+
+    float *frames = decodeContext.frames;
+    unsigned int numberFrames = decodeContext.numberFrames;
+    if (!isDecoded || decodeContext.hasError || numberFrames == 0) {
+        LOGE("Can't decode the sample %s", filePath);
+        free(frames);
+        return -1;
+    }
+
+    // resampled once to the rate of the player, so that voices are only mixed
+    if (fileSampleRate > 0 && fileSampleRate != _sampleRate) {
+        const unsigned int resampledFrames = (unsigned int) ((uint64_t) numberFrames * _sampleRate
+                                                             / fileSampleRate);
+        float *resampled = (float *) malloc((resampledFrames > 0 ? resampledFrames : 1) * 2
+                                            * sizeof(float));
+        if (resampled == nullptr) {
+            free(frames);
+            return -1;
+        }
+        const double step = (double) fileSampleRate / _sampleRate;
+        for (unsigned int i = 0; i < resampledFrames; i++) {
+            const double position = i * step;
+            const unsigned int index = (unsigned int) position;
+            const unsigned int next = index + 1 < numberFrames ? index + 1 : index;
+            const float fraction = (float) (position - index);
+            for (int channel = 0; channel < 2; channel++) {
+                const float current = frames[index * 2 + channel];
+                resampled[i * 2 + channel] = current
+                                             + (frames[next * 2 + channel] - current) * fraction;
+            }
+        }
+        free(frames);
+        frames = resampled;
+        numberFrames = resampledFrames;
+    }
+
+    const int sample = addSample(frames, numberFrames);
+    if (sample >= 0) {
+        LOGI("Sample %d loaded, %u frames from %s", sample, numberFrames, filePath);
+    }
+    return sample;
+}
+
+int Sampler::addSample(float *frames, unsigned int numberFrames) {
+    pthread_mutex_lock(&_loadMutex);
+    const int sample = _numberSamples;
+    if (sample >= SAMPLER_MAX_SAMPLES || numberFrames == 0) {
+        pthread_mutex_unlock(&_loadMutex);
+        LOGE("Sample not added, %d samples in the bank", sample);
+        free(frames);
+        return -1;
+    }
+    _samples[sample].frames = frames;
+    _samples[sample].numberFrames = numberFrames;
+    // the audio thread reads the sample once the count includes it
+    __atomic_store_n(&_numberSamples, sample + 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&_loadMutex);
+    return sample;
+}
+
+bool Sampler::trigger(int sample, float gain, unsigned int offsetFrames) {
+    if (sample < 0 || sample >= __atomic_load_n(&_numberSamples, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+    SamplerTrigger trigger;
+    trigger.type = kSamplerTriggerStart;
+    trigger.sample = sample;
+    trigger.gain = gain;
+    trigger.offsetFrames = offsetFrames;
+
+    pthread_mutex_lock(&_triggerMutex);
+    const bool isQueued = _triggerQueue.push(trigger);
+    pthread_mutex_unlock(&_triggerMutex);
+    if (!isQueued) {
+        LOGW("Sampler trigger queue is full, sample %d dropped", sample);
+    }
+    return isQueued;
+}
+
+void Sampler::stopAll() {
+    SamplerTrigger trigger;
+    memset(&trigger, 0, sizeof(trigger));
+    trigger.type = kSamplerTriggerStopAll;
+
+    pthread_mutex_lock(&_triggerMutex);
+    const bool isQueued = _triggerQueue.push(trigger);
+    pthread_mutex_unlock(&_triggerMutex);
+    if (!isQueued) {
+        LOGW("Sampler trigger queue is full, stop dropped");
+    }
+}
+
+bool Sampler::render(AUDIO_HARDWARE_SAMPLE_TYPE *frames, unsigned int numberFrames) {
+    if (numberFrames > (unsigned int) _maxFrames) {
+        numberFrames = (unsigned int) _maxFrames;
+    }
+    memset(_mix, 0, numberFrames * 2 * sizeof(float));
+    bool hasMixed = processTriggers(numberFrames);
+
+    int numberActiveVoices = 0;
+    for (int i = 0; i < SAMPLER_MAX_VOICES; i++) {
+        Voice *voice = &_voices[i];
+        if (!voice->isActive) {
+            continue;
+        }
+        hasMixed = true;
+        if (mixVoice(voice, numberFrames)) {
+            numberActiveVoices++;
+        } else {
+            voice->isActive = false;
+        }
+    }
+    __atomic_store_n(&_numberActiveVoices, numberActiveVoices, __ATOMIC_RELAXED);
+
+    if (!hasMixed) {
+        return false;
+    }
+    for (unsigned int i = 0; i < numberFrames * 2; i++) {
+        frames[i] = toPlayerSample((float) frames[i] + _mix[i]);
+    }
+    return true;
+}
+
+bool Sampler::processTriggers(unsigned int numberFrames) {
+    const int numberSamples = __atomic_load_n(&_numberSamples, __ATOMIC_ACQUIRE);
+    bool hasFaded = false;
+    SamplerTrigger trigger;
+    while (_triggerQueue.pop(&trigger)) {
+        if (trigger.type == kSamplerTriggerStopAll) {
+            for (int i = 0; i < SAMPLER_MAX_VOICES; i++) {
+                if (_voices[i].isActive && _voices[i].delayFrames == 0) {
+                    fadeOut(&_voices[i], numberFrames);
+                    hasFaded = true;
+                }
+                _voices[i].isActive = false;
+            }
+        } else if (trigger.sample < numberSamples) {
+            hasFaded = startVoice(trigger, numberFrames) || hasFaded;
+        }
+    }
+    return hasFaded;
+}
+
+bool Sampler::startVoice(const SamplerTrigger &trigger, unsigned int numberFrames) {
+    Voice *voice = nullptr;
+    for (int i = 0; i < SAMPLER_MAX_VOICES && voice == nullptr; i++) {
+        if (!_voices[i].isActive) {
+            voice = &_voices[i];
+        }
+    }
+
+    bool hasFaded = false;
+    if (voice == nullptr) {
+        // every voice is playing, the oldest one is the least audible in most sounds
+        voice = &_voices[0];
+        for (int i = 1; i < SAMPLER_MAX_VOICES; i++) {
+            if (_voices[i].order < voice->order) {
+                voice = &_voices[i];
+            }
+        }
+        if (voice->delayFrames == 0) {
+            fadeOut(voice, numberFrames);
+            hasFaded = true;
+        }
+        __atomic_store_n(&_numberStolenVoices, _numberStolenVoices + 1, __ATOMIC_RELAXED);
+    }
+
+    const Sample &sample = _samples[trigger.sample];
+    voice->frames = sample.frames;
+    voice->numberFrames = sample.numberFrames;
+    voice->position = 0;
+    voice->delayFrames = trigger.offsetFrames;
+    voice->gain = trigger.gain;
+    voice->order = _nextOrder++;
+    voice->isActive = true;
+    return hasFaded;
+}
+
+void Sampler::fadeOut(Voice *voice, unsigned int numberFrames) {
+    // the voice is reused at once, so the fade is shorter in blocks shorter than the fade, but
+    // always reaches silence
+    const unsigned int fadeFrames = numberFrames < SAMPLER_FADE_FRAMES ? numberFrames
+                                                                       : SAMPLER_FADE_FRAMES;
+    if (fadeFrames == 0) {
+        return;
+    }
+    unsigned int count = voice->numberFrames - voice->position;
+    if (count > fadeFrames) {
+        count = fadeFrames;
+    }
+    const float *src = voice->frames + voice->position * 2;
+    const float gainStep = voice->gain / fadeFrames;
+    float gain = voice->gain;
+    for (unsigned int i = 0; i < count; i++) {
+        gain -= gainStep;
+        _mix[i * 2] += src[i * 2] * gain;
+        _mix[i * 2 + 1] += src[i * 2 + 1] * gain;
+    }
+}
+
+bool Sampler::mixVoice(Voice *voice, unsigned int numberFrames) {
+    if (voice->delayFrames >= numberFrames) {
+        voice->delayFrames -= numberFrames;
+        return true;
+    }
+    const unsigned int start = voice->delayFrames;
+    voice->delayFrames = 0;
+
+    unsigned int count = numberFrames - start;
+    if (count > voice->numberFrames - voice->position) {
+        count = voice->numberFrames - voice->position;
+    }
+    addScaled(voice->frames + voice->position * 2, _mix + start * 2, count * 2, voice->gain);
+    voice->position += count;
+    return voice->position < voice->numberFrames;
+}
+
+double Sampler::benchmark(int sampleRate, int numberFrames, int numberVoices, int numberBlocks) {
+    Sampler sampler(sampleRate, numberFrames);
+    const unsigned int sampleFrames = (unsigned int) sampleRate * BENCHMARK_SAMPLE_SECONDS;
+    float *frames = (float *) malloc(sampleFrames * 2 * sizeof(float));
+    if (frames == nullptr) {
+        return 0;
+    }
+    for (unsigned int i = 0; i < sampleFrames * 2; i++) {
+#ifdef FLOAT_PLAYER
+        frames[i] = (float) (rand() % 2000 - 1000) / 1000.f;
+#else
+        frames[i] = (float) (rand() % 20000 - 10000);
+#endif
+    }
+    const int sample = sampler.addSample(frames, sampleFrames);
+
+    AUDIO_HARDWARE_SAMPLE_TYPE *buffer = (AUDIO_HARDWARE_SAMPLE_TYPE *) malloc(
+            (size_t) numberFrames * 2 * sizeof(AUDIO_HARDWARE_SAMPLE_TYPE));
+    // voices start at different times so that they read different parts of the sample, and they
+    // are triggered again as soon as they end
+    for (int voice = 0; voice < numberVoices; voice++) {
+        sampler.trigger(sample, 1.f / numberVoices,
+                        (unsigned int) ((uint64_t) voice * sampleFrames / numberVoices));
+    }
+    double elapsedNs = 0;
+    for (int i = 0; i < numberBlocks; i++) {
+        for (int voice = sampler.getNumberActiveVoices(); voice < numberVoices; voice++) {
+            sampler.trigger(sample, 1.f / numberVoices, 0);
+        }
+        memset(buffer, 0, (size_t) numberFrames * 2 * sizeof(AUDIO_HARDWARE_SAMPLE_TYPE));
+
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        sampler.render(buffer, (unsigned int) numberFrames);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        elapsedNs += (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+    }
+    free(buffer);
+    return elapsedNs / numberBlocks;
+}
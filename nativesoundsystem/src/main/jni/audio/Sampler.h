@@ -0,0 +1,164 @@
+//
+// Created by Frederic on 16/06/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_SAMPLER_H
+#define MINI_SOUND_SYSTEM_SAMPLER_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include <SLES/OpenSLES.h>
+
+#include "audio/SampleType.h"
+#include "utils/SpscQueue.h"
+
+// samples of the bank, kept until the sampler is deleted
+#define SAMPLER_MAX_SAMPLES 64
+
+// voices mixed at the same time, the oldest one is stolen beyond
+#define SAMPLER_MAX_VOICES 128
+
+// maximum number of triggers waiting for the next callback
+#define SAMPLER_TRIGGER_QUEUE_CAPACITY 256
+
+// frames over which a stolen or stopped voice fades out instead of being cut, or the whole block
+// when it is shorter
+#define SAMPLER_FADE_FRAMES 64
+
+// longer files are truncated when they are loaded
+#define SAMPLER_MAX_SAMPLE_SECONDS 30
+
+enum SamplerTriggerType {
+    kSamplerTriggerStart = 0,
+    kSamplerTriggerStopAll,
+};
+
+// sent from JNI threads to the audio thread
+typedef struct {
+    int type;
+    int sample;
+    float gain;
+    // frames from the start of the next block rendered
+    unsigned int offsetFrames;
+} SamplerTrigger;
+
+/**
+ * One-shot samples mixed in the player callback, over the track.
+ *
+ * Samples are decoded once to float frames at the rate of the player. Triggers go through a
+ * lock-free queue to the audio thread, which starts a voice of the fixed pool at the offset of the
+ * trigger in its next block : a trigger is heard one buffer after it is sent. When every voice is
+ * playing, the oldest one is stolen. Nothing is allocated or locked by the audio thread.
+ */
+class Sampler {
+public:
+    /**
+     * @param maxFrames largest block rendered.
+     */
+    Sampler(int sampleRate, int maxFrames);
+    Sampler& operator=(const Sampler& ) = delete;
+    Sampler(Sampler&) = delete;
+    ~Sampler();
+
+    /**
+     * Decode a whole audio file into the bank. Blocking.
+     * @param bufferSize samples of the buffers of the platform decoder.
+     * @return index of the sample, -1 if the bank is full or the file can't be decoded.
+     */
+    int loadSample(const char *filePath, SLEngineItf engine, int bufferSize);
+
+    /**
+     * Add frames to the bank, interleaved stereo in the unit of the player samples.
+     * @param frames owned by the sampler from now on, allocated with malloc.
+     * @return index of the sample, -1 if the bank is full.
+     */
+    int addSample(float *frames, unsigned int numberFrames);
+
+    /**
+     * Start a voice in the next block rendered. Called by any thread but the audio thread.
+     * @param offsetFrames delay of the voice from the start of the block, in frames.
+     * @return false if the sample doesn't exist or the queue is full.
+     */
+    bool trigger(int sample, float gain, unsigned int offsetFrames);
+
+    // stop every voice at the start of the next block
+    void stopAll();
+
+    /**
+     * Mix the voices into frames, called by the audio thread.
+     * @return false if no voice was playing, frames are then unchanged.
+     */
+    bool render(AUDIO_HARDWARE_SAMPLE_TYPE *frames, unsigned int numberFrames);
+
+    // voices still playing after the last block rendered, read by any thread
+    inline int getNumberActiveVoices() {
+        return __atomic_load_n(&_numberActiveVoices, __ATOMIC_RELAXED);
+    }
+
+    // voices stolen since the creation of the sampler
+    inline uint32_t getNumberStolenVoices() {
+        return __atomic_load_n(&_numberStolenVoices, __ATOMIC_RELAXED);
+    }
+
+    /**
+     * Measure the cost of mixing numberVoices voices.
+     * @return nanoseconds per block.
+     */
+    static double benchmark(int sampleRate, int numberFrames, int numberVoices, int numberBlocks);
+
+private:
+
+    typedef struct {
+        const float *frames;
+        unsigned int numberFrames;
+        unsigned int position;
+        // frames of silence before the voice starts
+        unsigned int delayFrames;
+        float gain;
+        // the lowest order is the oldest voice
+        uint32_t order;
+        bool isActive;
+    } Voice;
+
+    typedef struct {
+        float *frames;
+        unsigned int numberFrames;
+    } Sample;
+
+    // @return true if a voice has been faded out in the mix
+    bool processTriggers(unsigned int numberFrames);
+
+    // @return true if a voice has been stolen and faded out in the mix
+    bool startVoice(const SamplerTrigger &trigger, unsigned int numberFrames);
+
+    // add the next frames of a voice which has started to the start of the mix, fading out
+    void fadeOut(Voice *voice, unsigned int numberFrames);
+
+    // add the frames of the voice in the block to the mix, @return false once it has ended
+    bool mixVoice(Voice *voice, unsigned int numberFrames);
+
+    int _sampleRate;
+    int _maxFrames;
+
+    // samples are written before _numberSamples is published, and never change afterwards
+    Sample _samples[SAMPLER_MAX_SAMPLES];
+    int _numberSamples;
+    // serializes loads, never taken by the audio thread
+    pthread_mutex_t _loadMutex;
+
+    // the audio thread only pops, the mutex serializes producers
+    SpscQueue<SamplerTrigger, SAMPLER_TRIGGER_QUEUE_CAPACITY> _triggerQueue;
+    pthread_mutex_t _triggerMutex;
+
+    // owned by the audio thread
+    Voice _voices[SAMPLER_MAX_VOICES];
+    uint32_t _nextOrder;
+    // stereo frames of the voices of the block, in the unit of the player samples
+    float *_mix;
+
+    int _numberActiveVoices;
+    uint32_t _numberStolenVoices;
+};
+
+#endif //MINI_SOUND_SYSTEM_SAMPLER_H
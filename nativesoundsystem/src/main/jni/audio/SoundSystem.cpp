@@ -1,6 +1,9 @@
 #include "SoundSystem.h"
 
-static FILE* file;
+#include <utils/Tracer.h>
+
+#include "audio/OpenSLEngine.h"
+#include "audio/OpenSLMetadata.h"
 
 static double now_ms(void) {
     struct timespec res;
@@ -15,8 +18,7 @@ static void extractionEndCallback(SLPlayItf caller, void *pContext, SLuint32 eve
         const double extractionEndTime = now_ms();
         LOGI("Extraction opensl duration %f", extractionEndTime - self->getExtractionStartTime());
 
-        self->setIsLoaded(true);
-        self->notifyExtractionEnded();
+        self->completeExtraction();
     }
 }
 
@@ -44,109 +46,273 @@ static void queuePlayerCallback(SLAndroidSimpleBufferQueueItf aSoundQueue, void
 }
 
 void SoundSystem::fillDataBuffer() {
+    TRACE_SCOPE("fillDataBuffer");
     if (_needExtractInitialisation) {
         notifyExtractionStarted();
 
         extractMetaData();
 
         _needExtractInitialisation = false;
-        _extractedData = (AUDIO_HARDWARE_SAMPLE_TYPE*) calloc(_totalFrames * 2, sizeof(AUDIO_HARDWARE_SAMPLE_TYPE));
+        // the duration is only an estimate, pages grow with the extracted frames
+        _extractedData = new PcmPages();
 
         _extractionStartTime = now_ms();
     }
 
-#ifdef FLOAT_PLAYER
-    for (int i = 0; i < _bufferSize; i++) {
-        _extractedData[_positionExtract + i] = _soundBuffer[i] * (1.0f / ((float) SHRT_MAX));
+    // the extraction buffer holds frames in the layout of the file, a frame can be split between
+    // two buffers
+    const int numberChannels = _channelMapper->getNumberChannels();
+    const short *samples = _soundBuffer;
+    unsigned int numberSamples = (unsigned int) _bufferSize;
+    const short *partialFrame = _channelMapper->completePartialFrame(&samples, &numberSamples);
+    if (partialFrame != nullptr) {
+        appendDecodedSamples(partialFrame, 1);
     }
-#else
-    int sizeBuffer = _bufferSize * sizeof(short);
-    memmove(_extractedData + _positionExtract, _soundBuffer, sizeBuffer);
-#endif
+    const unsigned int numberFrames = numberSamples / numberChannels;
+    appendDecodedSamples(samples, numberFrames);
+    _channelMapper->keepPartialFrame(samples + (size_t) numberFrames * numberChannels,
+                                     numberSamples - numberFrames * numberChannels);
+    TRACE_COUNTER("extractedFrames", _extractedData->getNumberFrames());
+}
 
-    _positionExtract += _bufferSize;
+void SoundSystem::setDecodedNumberChannels(int numberChannels) {
+    if (!_channelMapper->setNumberChannels(numberChannels)) {
+        LOGW("Invalid number of channels %d, decoded as stereo", numberChannels);
+        _channelMapper->setNumberChannels(2);
+    } else if (numberChannels > CHANNEL_MAPPER_MAX_CHANNELS) {
+        LOGW("Only the front channels of the %d channels are played", numberChannels);
+    }
+}
+
+void SoundSystem::appendDecodedSamples(const short *samples, unsigned int numberFrames) {
+    while (numberFrames > 0) {
+        unsigned int count;
+        if (!_isExtractionTrimmed || _silenceDetector->hasAudibleFrames()) {
+            // frames are mapped directly into the pages
+            unsigned int writableFrames;
+            AUDIO_HARDWARE_SAMPLE_TYPE *frames = _extractedData->getWritePointer(&writableFrames);
+            if (frames == nullptr) {
+                return;
+            }
+            count = numberFrames < writableFrames ? numberFrames : writableFrames;
+            _channelMapper->map(samples, frames, count);
+            _silenceDetector->process(frames, count);
+            _extractedData->commitFrames(count);
+        } else {
+            // the leading silence may not be stored
+            count = numberFrames < _mappingBufferFrames ? numberFrames : _mappingBufferFrames;
+            _channelMapper->map(samples, _mappingBuffer, count);
+            appendExtractedFrames(_mappingBuffer, count);
+        }
+        samples += (size_t) count * _channelMapper->getNumberChannels();
+        numberFrames -= count;
+    }
+    publishLoadState();
+    notifyTrackListeners(kTrackFramesAppended);
+}
+
+void SoundSystem::appendExtractedFrames(const AUDIO_HARDWARE_SAMPLE_TYPE *frames,
+                                        unsigned int numberFrames) {
+    const unsigned int position = _silenceDetector->getNumberFrames();
+    const bool wasAudible = _silenceDetector->hasAudibleFrames();
+    _silenceDetector->process(frames, numberFrames);
+
+    if (!_isExtractionTrimmed || wasAudible) {
+        _extractedData->append(frames, numberFrames);
+    } else if (!_silenceDetector->hasAudibleFrames()) {
+        // silent frames are kept until the silence is long enough to be trimmed
+        if (_pendingSilence != nullptr
+            && position + numberFrames <= _silenceDetector->getMinDurationFrames()) {
+            memcpy(_pendingSilence + _numberPendingFrames * 2, frames,
+                   numberFrames * 2 * sizeof(AUDIO_HARDWARE_SAMPLE_TYPE));
+            _numberPendingFrames += numberFrames;
+        } else {
+            _trackSilence.trimmedFrames = position + numberFrames;
+            _numberPendingFrames = 0;
+        }
+    } else {
+        const unsigned int firstAudibleFrame = _silenceDetector->getFirstAudibleFrame();
+        if (firstAudibleFrame == 0) {
+            // leading silence too short to be trimmed
+            _extractedData->append(_pendingSilence, _numberPendingFrames);
+            _extractedData->append(frames, numberFrames);
+        } else {
+            _trackSilence.trimmedFrames = firstAudibleFrame;
+            _extractedData->append(frames + (firstAudibleFrame - position) * 2,
+                                   position + numberFrames - firstAudibleFrame);
+            // the estimated duration included the leading silence
+            const unsigned int totalFrames = getTotalNumberFrames();
+            setTotalNumberFrames(totalFrames > firstAudibleFrame ? totalFrames - firstAudibleFrame
+                                                                 : 0);
+        }
+        _numberPendingFrames = 0;
+    }
+}
+
+void SoundSystem::setSilenceTrimming(bool trim, float thresholdDb, int minDurationMs) {
+    _isSilenceTrimmed = trim;
+    _silenceThresholdDb = thresholdDb;
+    _silenceMinDurationMs = minDurationMs > 0 ? minDurationMs : 0;
+}
+
+void SoundSystem::applySilence(unsigned int numberFrames) {
+    if (_isSilenceTrimmed && numberFrames > 0) {
+        setStartFrame(_trackSilence.firstAudibleFrame);
+        setTotalNumberFrames(_trackSilence.lastAudibleFrame + 1);
+    } else {
+        setStartFrame(0);
+        setTotalNumberFrames(numberFrames);
+    }
 }
 
 void SoundSystem::getData() {
-    if (_positionPlay > _totalFrames * 2 * sizeof(AUDIO_HARDWARE_SAMPLE_TYPE)) {
-        endTrack();
-        return;
+    TRACE_SCOPE("getData");
+    processPendingCommands();
+    _eventScheduler->collect();
+
+    const unsigned int numberFrames = (unsigned int) _bufferSize / 2;
+    const uint64_t endFrame = _outputFrame + numberFrames;
+    // events of the first frame and late events are applied before the clock is read
+    ScheduledEvent event;
+    bool hasEvent = _eventScheduler->popDue(_outputFrame, endFrame, &event);
+    while (hasEvent && event.frame <= _outputFrame) {
+        processEvent(event);
+        hasEvent = _eventScheduler->popDue(_outputFrame, endFrame, &event);
+    }
+    updateClock(true);
+
+    // the block is split at the frame of each event
+    bool hasRenderedTrack = false;
+    unsigned int renderedFrames = 0;
+    while (renderedFrames < numberFrames) {
+        const unsigned int eventFrame = hasEvent ? (unsigned int) (event.frame - _outputFrame)
+                                                 : numberFrames;
+        if (eventFrame > renderedFrames) {
+            hasRenderedTrack = renderTrack(renderedFrames, eventFrame - renderedFrames)
+                               || hasRenderedTrack;
+            renderedFrames = eventFrame;
+        }
+        if (hasEvent) {
+            processEvent(event);
+            hasEvent = _eventScheduler->popDue(_outputFrame, endFrame, &event);
+        }
+    }
+    _outputFrame = endFrame;
+
+    // samples keep playing when the track is paused or stopped
+    const bool hasVoices = _sampler->render(_playerBuffer, numberFrames);
+    if (hasRenderedTrack || hasVoices) {
+        measurePeaks();
+    } else {
+        _peakLeft = 0.f;
+        _peakRight = 0.f;
     }
 
-    int sizeBuffer = _bufferSize * sizeof(AUDIO_HARDWARE_SAMPLE_TYPE);
-    memmove(_playerBuffer, _extractedData + _positionPlay, sizeBuffer);
-    _positionPlay += _bufferSize;
+    if (hasRenderedTrack && _isPlayingTrack) {
+        const unsigned int position = _trackRenderer->getPosition();
+        TRACE_COUNTER("playPosition", position);
+        // frames not extracted yet have been played as silence
+        if (position < getTotalNumberFrames() && position > _extractedData->getNumberFrames()) {
+            _starvedBuffers++;
+        }
+    }
+    publishState();
+}
+
+bool SoundSystem::renderTrack(unsigned int offset, unsigned int numberFrames) {
+    AUDIO_HARDWARE_SAMPLE_TYPE *frames = _playerBuffer + offset * 2;
+    if (!_isPlayingTrack || _extractedData == nullptr) {
+        memset(frames, 0, numberFrames * 2 * sizeof(AUDIO_HARDWARE_SAMPLE_TYPE));
+        return false;
+    }
+
+    const unsigned int totalFrames = getTotalNumberFrames();
+    _trackRenderer->render(_extractedData, totalFrames, frames, numberFrames);
+    if (_trackRenderer->getPosition() >= totalFrames) {
+        endTrack();
+    }
+    return true;
 }
 
 SoundSystem::SoundSystem(SoundSystemCallback *callback,
                          int sampleRate,
-                         int bufSize) :
+                         int bufSize,
+                         TrackCache *trackCache) :
         _soundSystemCallback(callback),
         _needExtractInitialisation(true),
         _isLoaded(false),
-        _positionExtract(0),
-        _positionPlay(0),
         _totalFrames(0),
         _soundBuffer(nullptr),
         _playerBuffer(nullptr){
-    file = fopen("/sdcard/Music/extract", "w+");
     this->_sampleRate = sampleRate;
     this->_bufferSize = bufSize;
 
-    /*
-     * A type for standard OpenSL ES errors that all functions defined in the API return.
-     * Can have some of these values :
-     * SL_RESULT_SUCCESS
-     * SL_RESULT_PARAMETER_INVALID
-     * SL_RESULT_MEMORY_FAILURE
-     * SL_RESULT_FEATURE_UNSUPPORTED
-     * SL_RESULT_RESOURCE_ERROR
-     */
-    SLresult result;
-
-    // engine
-    const SLuint32 engineMixIIDCount = 1;
-    const SLInterfaceID engineMixIIDs[] = {SL_IID_ENGINE};
-    const SLboolean engineMixReqs[] = {SL_BOOLEAN_TRUE};
-
-    /*object : an abstraction of a set of resources, assigned for a well-defined set of tasks,
-     and the state of these resources. To allocate the resources the object must be Realized.*/
-
-    // create engine
-    result = slCreateEngine(&_engineObj, 0, nullptr, engineMixIIDCount, engineMixIIDs, engineMixReqs);
-    SLASSERT(result);
-
-    // 2nd parameter : True if it's asynchronous and false to be synchronous
-    result = (*_engineObj)->Realize(_engineObj, SL_BOOLEAN_FALSE);
-    SLASSERT(result);
-
-    // interface : an abstraction of a set of related features that a certain object provides.
-
-    // get interfaces
-    result = (*_engineObj)->GetInterface(_engineObj, SL_IID_ENGINE, &_engine);
-    SLASSERT(result);
-
-    // creation of objects used to send data to HW device
-
-    // mixed output
-    const SLuint32 outputMixIIDCount = 0;
-    const SLInterfaceID outputMixIIDs[] = {};
-    const SLboolean outputMixReqs[] = {};
-
-    result = (*_engine)->CreateOutputMix(_engine, &_outPutMixObj, outputMixIIDCount, outputMixIIDs,
-                                         outputMixReqs);
-    SLASSERT(result);
-
-    result = (*_outPutMixObj)->Realize(_outPutMixObj, SL_BOOLEAN_FALSE);
-    SLASSERT(result);
+    // player buffers are interleaved stereo
+    _trackRenderer = new TrackRenderer(sampleRate, bufSize / 2);
+    _sampler = new Sampler(sampleRate, bufSize / 2);
+    _eventScheduler = new EventScheduler();
+    _channelMapper = new ChannelMapper();
+    _mappingBufferFrames = (unsigned int) bufSize / 2;
+    _mappingBuffer = (AUDIO_HARDWARE_SAMPLE_TYPE*) calloc(_mappingBufferFrames * 2,
+                                                          sizeof(AUDIO_HARDWARE_SAMPLE_TYPE));
+    _equalizerSettings = new Equalizer(sampleRate, 0);
+    _trackCache = trackCache;
+    _silenceDetector = new SilenceDetector(sampleRate);
+    _isSilenceTrimmed = false;
+    _isExtractionTrimmed = false;
+    _silenceThresholdDb = SILENCE_DEFAULT_THRESHOLD_DB;
+    _silenceMinDurationMs = SILENCE_DEFAULT_MIN_DURATION_MS;
+    _pendingSilence = nullptr;
+    _pendingSilenceCapacity = 0;
+    _numberPendingFrames = 0;
+    setStartFrame(0);
+    memset(&_trackSilence, 0, sizeof(_trackSilence));
+
+    pthread_mutex_init(&_commandMutex, nullptr);
+    _isStreamStarted = false;
+    _isPlayingTrack = false;
+    _status = new EngineStatus();
+    _clockFrame = 0;
+    _clockTimeNs = 0;
+    _clockRate = 0.f;
+    _clockOutputFrame = 0;
+    _outputFrame = 0;
+    _deviceLatencyUs = 0;
+    _outputLatencyUs = PLAYER_DEVICE_LATENCY;
+    _lastCallbackTimeNs = 0;
+    _peakLeft = 0.f;
+    _peakRight = 0.f;
+    _starvedBuffers = 0;
+    _lateCallbacks = 0;
+    _isExtracting = false;
+
+    // the engine and the output mix are shared with the other sound systems of the process
+    _isEngineAcquired = acquireOpenSLEngine(&_engine, &_outPutMixObj);
+    assert(_isEngineAcquired);
 }
 
 SoundSystem::~SoundSystem() {
-    fclose(file);
     release();
+    releaseTrack();
+    delete _pcmFile;
+    delete _silenceDetector;
+    free(_pendingSilence);
+    free(_mappingBuffer);
+    delete _channelMapper;
+    delete _trackRenderer;
+    delete _sampler;
+    delete _eventScheduler;
+    delete _equalizerSettings;
+    delete _status;
+    pthread_mutex_destroy(&_commandMutex);
 }
 
 void SoundSystem::extractMusic(SLDataLocator_URI *fileLoc) {
+    unloadPcmFile();
+
+    // extracted data of the new track are written to new pages
+    _needExtractInitialisation = true;
+
     SLresult result;
 
     SLDataFormat_MIME format_mime;
@@ -219,7 +385,13 @@ void SoundSystem::extractMusic(SLDataLocator_URI *fileLoc) {
     SLASSERT(result);
 
     // allocate space for the buffer
-    _soundBuffer = (short*) calloc(_bufferSize, sizeof(short));
+    if (_soundBuffer == nullptr) {
+        _soundBuffer = (short*) calloc(_bufferSize, sizeof(short));
+    }
+
+    // the previous track can't be rendered anymore once the extraction thread replaces it
+    _isLoaded = false;
+    __atomic_store_n(&_isExtracting, true, __ATOMIC_RELEASE);
 
     // send two buffers
     sendSoundBufferExtract();
@@ -228,17 +400,267 @@ void SoundSystem::extractMusic(SLDataLocator_URI *fileLoc) {
     // start the extraction
     result = (*_extractPlayerPlay)->SetPlayState(_extractPlayerPlay, SL_PLAYSTATE_PLAYING);
     SLASSERT(result);
+}
 
+bool SoundSystem::loadPcmFile(const char *filePath) {
+    const double startTime = now_ms();
+
+    PcmFile *pcmFile = new PcmFile();
+    const AUDIO_HARDWARE_SAMPLE_TYPE *data = nullptr;
+    if (pcmFile->open(filePath)) {
+        data = pcmFile->getPlayerData();
+    }
+    // the mapping is read only, extracted data are only written by extractMusic
+    PcmPages *pages = data != nullptr ? PcmPages::wrap(data, pcmFile->getNumberFrames()) : nullptr;
+    if (pages == nullptr) {
+        delete pcmFile;
+        return false;
+    }
+    if (pcmFile->getSampleRate() != _sampleRate) {
+        LOGW("Pcm file at %d Hz played at %d Hz", pcmFile->getSampleRate(), _sampleRate);
+    }
+
+    // nothing must read or write the previous track anymore
+    releasePlayer();
+    releaseExtractor();
+    unloadPcmFile();
+    releaseTrack();
+
+    notifyExtractionStarted();
+
+    _pcmFile = pcmFile;
+    _extractedData = pages;
+
+    // the mapping can't be shortened, playback starts at the first audible frame instead
+    _silenceDetector->setParameters(_silenceThresholdDb, _silenceMinDurationMs);
+    _silenceDetector->processTrack(data, pcmFile->getNumberFrames());
+    _trackSilence.trimmedFrames = 0;
+    _trackSilence.firstAudibleFrame = _silenceDetector->getFirstAudibleFrame();
+    _trackSilence.lastAudibleFrame = _silenceDetector->getLastAudibleFrame();
+    _trackSilence.thresholdDb = _silenceThresholdDb;
+    _trackSilence.minDurationMs = _silenceMinDurationMs;
+    applySilence(pcmFile->getNumberFrames());
+    _isLoaded = true;
+
+    LOGI("Pcm file loaded in %f ms, %s", now_ms() - startTime,
+         pcmFile->isPlayerFormat() ? "read in place" : "converted");
+    notifyExtractionEnded();
+    return true;
+}
+
+void SoundSystem::unloadPcmFile() {
+    if (_pcmFile == nullptr) {
+        return;
+    }
+    // the player reads the mapping
+    releasePlayer();
+    notifyTrackListeners(kTrackReleased);
+    delete _extractedData;
+    _extractedData = nullptr;
+    setTotalNumberFrames(0);
+    setStartFrame(0);
     _isLoaded = false;
+    __atomic_store_n(&_isExtracting, false, __ATOMIC_RELEASE);
+    delete _pcmFile;
+    _pcmFile = nullptr;
+    publishLoadState();
+}
+
+bool SoundSystem::loadCachedTrack(const char *filePath) {
+    const double startTime = now_ms();
+
+    TrackCacheEntry *entry = _trackCache->acquire(filePath);
+    if (entry == nullptr) {
+        return false;
+    }
+    if (entry->silence.trimmedFrames > 0 && !_isSilenceTrimmed) {
+        // the leading silence has not been stored, the track is extracted again to play it
+        _trackCache->release(entry);
+        return false;
+    }
+
+    // nothing must read or write the previous track anymore
+    releasePlayer();
+    releaseExtractor();
+    unloadPcmFile();
+    releaseTrack();
+
+    notifyExtractionStarted();
+
+    _cachedTrack = entry;
+    _extractedData = entry->pages;
+    _trackSilence = entry->silence;
+    if (entry->silence.thresholdDb != _silenceThresholdDb
+        || entry->silence.minDurationMs != _silenceMinDurationMs) {
+        // trimming has been changed since the extraction, the stored frames are searched again
+        detectSilence(entry->pages);
+    }
+    applySilence(entry->numberFrames);
+    _isLoaded = true;
+
+    LOGI("Track loaded from cache in %f ms", now_ms() - startTime);
+    notifyExtractionEnded();
+    return true;
+}
+
+void SoundSystem::detectSilence(const PcmPages *pages) {
+    _silenceDetector->setParameters(_silenceThresholdDb, _silenceMinDurationMs);
+    _silenceDetector->reset();
+    const unsigned int numberFrames = pages->getNumberFrames();
+    unsigned int position = 0;
+    while (position < numberFrames) {
+        unsigned int count;
+        const AUDIO_HARDWARE_SAMPLE_TYPE *frames = pages->getFrames(position, &count);
+        if (frames == nullptr) {
+            break;
+        }
+        _silenceDetector->process(frames, count);
+        position += count;
+    }
+
+    if (_silenceDetector->hasAudibleFrames()) {
+        _trackSilence.firstAudibleFrame = _silenceDetector->getFirstAudibleFrame();
+        _trackSilence.lastAudibleFrame = _silenceDetector->getLastAudibleFrame();
+    } else {
+        _trackSilence.firstAudibleFrame = 0;
+        _trackSilence.lastAudibleFrame = numberFrames > 0 ? numberFrames - 1 : 0;
+    }
+    _trackSilence.thresholdDb = _silenceThresholdDb;
+    _trackSilence.minDurationMs = _silenceMinDurationMs;
+}
+
+void SoundSystem::prepareExtraction(const char *filePath) {
+    // nothing must read or write the previous track anymore
+    releasePlayer();
+    releaseExtractor();
+    unloadPcmFile();
+    releaseTrack();
+
+    _extractingFilePath = strdup(filePath);
+    // tracks are cached only if the file can be checked when they are loaded again
+    _hasExtractingFileVersion = TrackCache::readFileVersion(filePath, &_extractingFileVersion);
+    _isLoaded = false;
+
+    // leading silence is kept until it is long enough to be trimmed
+    _silenceDetector->setParameters(_silenceThresholdDb, _silenceMinDurationMs);
+    _silenceDetector->reset();
+    _isExtractionTrimmed = _isSilenceTrimmed;
+    const unsigned int minDurationFrames = _silenceDetector->getMinDurationFrames();
+    if (minDurationFrames > _pendingSilenceCapacity) {
+        free(_pendingSilence);
+        _pendingSilence = (AUDIO_HARDWARE_SAMPLE_TYPE*) malloc(
+                minDurationFrames * 2 * sizeof(AUDIO_HARDWARE_SAMPLE_TYPE));
+        _pendingSilenceCapacity = _pendingSilence != nullptr ? minDurationFrames : 0;
+    }
+    _numberPendingFrames = 0;
+    memset(&_trackSilence, 0, sizeof(_trackSilence));
+    _trackSilence.thresholdDb = _silenceThresholdDb;
+    _trackSilence.minDurationMs = _silenceMinDurationMs;
+}
+
+void SoundSystem::completeExtraction() {
+    if (_extractedData != nullptr) {
+        if (_silenceDetector->hasAudibleFrames()) {
+            const unsigned int trimmedFrames = _trackSilence.trimmedFrames;
+            _trackSilence.firstAudibleFrame = _silenceDetector->getFirstAudibleFrame() - trimmedFrames;
+            _trackSilence.lastAudibleFrame = _silenceDetector->getLastAudibleFrame() - trimmedFrames;
+        } else {
+            // a silence shorter than the minimum duration is kept, a longer one is not stored
+            _extractedData->append(_pendingSilence, _numberPendingFrames);
+            _numberPendingFrames = 0;
+            const unsigned int numberFrames = _extractedData->getNumberFrames();
+            _trackSilence.firstAudibleFrame = 0;
+            _trackSilence.lastAudibleFrame = numberFrames > 0 ? numberFrames - 1 : 0;
+        }
+        // the estimated duration is replaced by the number of frames actually extracted
+        applySilence(_extractedData->getNumberFrames());
+    }
+    if (_extractingFilePath != nullptr && _extractedData != nullptr && _hasExtractingFileVersion) {
+        // the cache owns extracted data from now on
+        _cachedTrack = _trackCache->insert(_extractingFilePath, _extractingFileVersion,
+                                           _extractedData, _trackSilence);
+    }
+    free(_extractingFilePath);
+    _extractingFilePath = nullptr;
+    _isLoaded = true;
+    notifyExtractionEnded();
+}
+
+bool SoundSystem::addTrackListener(TrackListener listener, void *context) {
+    if (_numberTrackListeners == SOUND_SYSTEM_MAX_TRACK_LISTENERS) {
+        LOGE("Too many track listeners");
+        return false;
+    }
+    _trackListeners[_numberTrackListeners] = listener;
+    _trackListenerContexts[_numberTrackListeners] = context;
+    _numberTrackListeners++;
+    return true;
+}
+
+void SoundSystem::removeTrackListener(TrackListener listener, void *context) {
+    for (int i = 0; i < _numberTrackListeners; i++) {
+        if (_trackListeners[i] == listener && _trackListenerContexts[i] == context) {
+            // the order of the other listeners is kept
+            for (int j = i + 1; j < _numberTrackListeners; j++) {
+                _trackListeners[j - 1] = _trackListeners[j];
+                _trackListenerContexts[j - 1] = _trackListenerContexts[j];
+            }
+            _numberTrackListeners--;
+            return;
+        }
+    }
+}
+
+void SoundSystem::notifyTrackListeners(int event) {
+    for (int i = 0; i < _numberTrackListeners; i++) {
+        _trackListeners[i](_trackListenerContexts[i], event, _extractedData);
+    }
+}
+
+void SoundSystem::releaseTrack() {
+    if (_extractedData != nullptr) {
+        notifyTrackListeners(kTrackReleased);
+    }
+    if (_cachedTrack != nullptr) {
+        _trackCache->release(_cachedTrack);
+        _cachedTrack = nullptr;
+    } else {
+        // extraction not completed, or the track could not be added to the cache
+        delete _extractedData;
+    }
+    _extractedData = nullptr;
+    setTotalNumberFrames(0);
+    setStartFrame(0);
+    _isLoaded = false;
+
+    // a previous extraction will not complete anymore
+    free(_extractingFilePath);
+    _extractingFilePath = nullptr;
+    __atomic_store_n(&_isExtracting, false, __ATOMIC_RELEASE);
+    publishLoadState();
+}
+
+void SoundSystem::releaseExtractor() {
+    if (_extractPlayerObject != nullptr) {
+        (*_extractPlayerObject)->AbortAsyncOperation(_extractPlayerObject);
+        (*_extractPlayerObject)->Destroy(_extractPlayerObject);
+        _extractPlayerObject = nullptr;
+        _extractPlayerPlay = nullptr;
+        _extractPlayerBufferQueue = nullptr;
+        _extractPlayerMetadata = nullptr;
+    }
 }
 
 void SoundSystem::initAudioPlayer() {
+    // callbacks of a previous player would still read the player buffer
+    releasePlayer();
+
     SLresult result;
 
     // configure audio source
     SLDataLocator_AndroidSimpleBufferQueue loc_bufq;
     loc_bufq.locatorType = SL_DATALOCATOR_ANDROIDSIMPLEBUFFERQUEUE;
-    loc_bufq.numBuffers = 1;
+    loc_bufq.numBuffers = PLAYER_NUMBER_BUFFERS;
 
     // format of data
 #ifdef FLOAT_PLAYER
@@ -270,8 +692,9 @@ void SoundSystem::initAudioPlayer() {
     SLDataLocator_OutputMix loc_outmix = {SL_DATALOCATOR_OUTPUTMIX, _outPutMixObj};
     SLDataSink audioSnk = {&loc_outmix, nullptr};
 
-    const SLInterfaceID ids[] = {SL_IID_VOLUME, SL_IID_ANDROIDSIMPLEBUFFERQUEUE};
-    const SLboolean req[] = {SL_BOOLEAN_TRUE, SL_BOOLEAN_TRUE};
+    const SLInterfaceID ids[] = {SL_IID_VOLUME, SL_IID_ANDROIDSIMPLEBUFFERQUEUE,
+                                 SL_IID_ANDROIDCONFIGURATION};
+    const SLboolean req[] = {SL_BOOLEAN_TRUE, SL_BOOLEAN_TRUE, SL_BOOLEAN_FALSE};
     const int numberInterface = sizeof(ids)/sizeof(ids[0]);
 
     result = (*_engine)->CreateAudioPlayer(_engine, &_playerObject, &audioSrc, &audioSnk,
@@ -295,16 +718,152 @@ void SoundSystem::initAudioPlayer() {
     result = (*_playerQueue)->RegisterCallback(_playerQueue, queuePlayerCallback, this);
     SLASSERT(result);
 
-    _playerBuffer = (AUDIO_HARDWARE_SAMPLE_TYPE*) calloc(_bufferSize,
-                                                         sizeof(AUDIO_HARDWARE_SAMPLE_TYPE));
+    // latency of the output after the player queue, the configuration interface is optional
+    SLAndroidConfigurationItf playerConfiguration;
+    result = (*_playerObject)->GetInterface(_playerObject, SL_IID_ANDROIDCONFIGURATION,
+                                            &playerConfiguration);
+    if (result == SL_RESULT_SUCCESS) {
+        SLuint32 latencyMs = 0;
+        SLuint32 valueSize = sizeof(latencyMs);
+        result = (*playerConfiguration)->GetConfiguration(playerConfiguration,
+                                                          (const SLchar *) "androidGetAudioLatency",
+                                                          &valueSize, &latencyMs);
+        if (result == SL_RESULT_SUCCESS) {
+            LOGI("Output latency reported by the device %u ms", (unsigned int) latencyMs);
+            __atomic_store_n(&_deviceLatencyUs, (uint32_t) latencyMs * 1000, __ATOMIC_RELAXED);
+        }
+    }
+
+    if (_playerBuffer == nullptr) {
+        _playerBuffer = (AUDIO_HARDWARE_SAMPLE_TYPE*) calloc(_bufferSize,
+                                                             sizeof(AUDIO_HARDWARE_SAMPLE_TYPE));
+    }
+
+    // no callback is running yet, the new track can be reset from this thread
+    pthread_mutex_lock(&_commandMutex);
+    _trackRenderer->setPosition(getStartFrame());
+    _isPlayingTrack = false;
+    updateClock(false);
+    publishState();
+    pthread_mutex_unlock(&_commandMutex);
 }
 
 bool SoundSystem::isPlaying(){
-    return getPlayerState() == SL_PLAYSTATE_PLAYING;
+    PlayerState state;
+    getState(&state);
+    return state.isPlaying;
+}
+
+void SoundSystem::getState(PlayerState *state) {
+    // indexed by the words of the status, only the words of the player are read
+    uint32_t player[kStatusNumberWords];
+    _status->read(kStatusPlayerSequence, player + kStatusPlayerSequence + 1,
+                  STATUS_PLAYER_NUMBER_WORDS);
+    state->isPlaying = player[kStatusIsPlaying] != 0;
+    state->positionFrames = player[kStatusPositionFrames];
+    state->presentedFrame = player[kStatusPresentedFrame];
+    state->presentationTimeNs = EngineStatus::toTime(player[kStatusPresentationTimeHigh],
+                                                     player[kStatusPresentationTimeLow]);
+    state->rate = EngineStatus::toFloat(player[kStatusRate]);
+    state->outputFrame = (uint64_t) EngineStatus::toTime(player[kStatusOutputFrameHigh],
+                                                         player[kStatusOutputFrameLow]);
+}
+
+void SoundSystem::publishState() {
+    _status->beginWrite(kStatusPlayerSequence);
+    _status->write(kStatusIsPlaying, (uint32_t) _isPlayingTrack);
+    _status->write(kStatusPositionFrames, _trackRenderer->getPosition());
+    _status->write(kStatusPresentedFrame, _clockFrame);
+    _status->writeTime(kStatusPresentationTimeHigh, _clockTimeNs);
+    _status->writeFloat(kStatusRate, _clockRate);
+    _status->writeFloat(kStatusPeakLeft, _peakLeft);
+    _status->writeFloat(kStatusPeakRight, _peakRight);
+    _status->write(kStatusStarvedBuffers, _starvedBuffers);
+    _status->write(kStatusLateCallbacks, _lateCallbacks);
+    // 64 bits, split like a time
+    _status->writeTime(kStatusOutputFrameHigh, (int64_t) _clockOutputFrame);
+    _status->endWrite(kStatusPlayerSequence);
+}
+
+void SoundSystem::publishLoadState() {
+    _status->beginWrite(kStatusLoadSequence);
+    _status->write(kStatusIsLoaded, (uint32_t) _isLoaded);
+    _status->write(kStatusIsExtracting,
+                   (uint32_t) __atomic_load_n(&_isExtracting, __ATOMIC_ACQUIRE));
+    _status->write(kStatusExtractedFrames,
+                   _extractedData != nullptr ? _extractedData->getNumberFrames() : 0);
+    _status->write(kStatusTotalFrames, getTotalNumberFrames());
+    _status->endWrite(kStatusLoadSequence);
+}
+
+void SoundSystem::updateClock(bool isStreamRunning) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    const int64_t nowNs = (int64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+    const int64_t bufferDurationNs = (int64_t) (_bufferSize / 2) * 1000000000 / _sampleRate;
+    if (!isStreamRunning) {
+        _lastCallbackTimeNs = 0;
+    } else {
+        // the queue is empty when a callback comes that late, the output played silence
+        if (_lastCallbackTimeNs != 0
+            && nowNs - _lastCallbackTimeNs > bufferDurationNs * PLAYER_LATE_CALLBACK_BUFFERS) {
+            _lateCallbacks++;
+        }
+        _lastCallbackTimeNs = nowNs;
+    }
+
+    uint32_t latencyUs = __atomic_load_n(&_outputLatencyUs, __ATOMIC_RELAXED);
+    if (latencyUs == PLAYER_DEVICE_LATENCY) {
+        latencyUs = __atomic_load_n(&_deviceLatencyUs, __ATOMIC_RELAXED);
+    }
+    // the buffer filled by this callback is heard after the buffers still in the queue
+    _clockTimeNs = nowNs + (PLAYER_NUMBER_BUFFERS - 1) * bufferDurationNs
+                   + (int64_t) latencyUs * 1000;
+    _clockFrame = _trackRenderer->getPosition();
+    _clockOutputFrame = _outputFrame;
+    const bool isMoving = isStreamRunning && _isPlayingTrack && _extractedData != nullptr;
+    _clockRate = isMoving ? _trackRenderer->getReadHead()->getRate() : 0.f;
+}
+
+void SoundSystem::measurePeaks() {
+#ifdef FLOAT_PLAYER
+    float left = 0.f;
+    float right = 0.f;
+#else
+    // -SHRT_MIN doesn't fit in a short
+    int left = 0;
+    int right = 0;
+#endif
+    for (int i = 0; i < _bufferSize; i += 2) {
+        const AUDIO_HARDWARE_SAMPLE_TYPE sampleLeft = _playerBuffer[i];
+        const AUDIO_HARDWARE_SAMPLE_TYPE sampleRight = _playerBuffer[i + 1];
+        if (sampleLeft > left) {
+            left = sampleLeft;
+        } else if (-sampleLeft > left) {
+            left = -sampleLeft;
+        }
+        if (sampleRight > right) {
+            right = sampleRight;
+        } else if (-sampleRight > right) {
+            right = -sampleRight;
+        }
+    }
+#ifdef FLOAT_PLAYER
+    _peakLeft = left;
+    _peakRight = right;
+#else
+    _peakLeft = left * (1.0f / SHRT_MAX);
+    _peakRight = right * (1.0f / SHRT_MAX);
+#endif
+}
+
+void SoundSystem::setOutputLatency(int latencyMs) {
+    const uint32_t latencyUs = latencyMs < 0 ? PLAYER_DEVICE_LATENCY : (uint32_t) latencyMs * 1000;
+    __atomic_store_n(&_outputLatencyUs, latencyUs, __ATOMIC_RELAXED);
 }
 
 void SoundSystem::extractAndPlayDirectly(void *sourceFile) {
-    if(_playerPlay != nullptr && isPlaying()){
+    if(_playerPlay != nullptr && getPlayerState() == SL_PLAYSTATE_PLAYING){
         return;
     }
 
@@ -346,37 +905,205 @@ void SoundSystem::extractAndPlayDirectly(void *sourceFile) {
 
 void SoundSystem::extractMetaData() {
     (*_extractPlayerPlay)->GetDuration(_extractPlayerPlay, &_musicDuration);
-    _totalFrames = (unsigned int) (((double) _musicDuration * (double) _sampleRate / 1000.0));
+    setTotalNumberFrames(
+            (unsigned int) (((double) _musicDuration * (double) _sampleRate / 1000.0)));
+
+    // the sink format asks for stereo, but the decoder outputs the channels of the file
+    setDecodedNumberChannels(readDecodedNumberChannels(_extractPlayerMetadata, 2));
 }
 
 void SoundSystem::play(bool play) {
-    SLresult result;
-    if (nullptr != _playerPlay) {
-        SLuint32 currentState;
-        (*_playerPlay)->GetPlayState(_playerPlay, &currentState);
-        if (play
-            && (currentState == SL_PLAYSTATE_PAUSED || currentState == SL_PLAYSTATE_STOPPED)) {
-            sendSoundBufferPlay();
-            result = (*_playerPlay)->SetPlayState(_playerPlay, SL_PLAYSTATE_PLAYING);
-            SLASSERT(result);
-
-            notifyPlayPause(true);
-        } else if (currentState == SL_PLAYSTATE_PLAYING) {
-            result = (*_playerPlay)->SetPlayState(_playerPlay, SL_PLAYSTATE_PAUSED);
-            SLASSERT(result);
-            result = (*_playerQueue)->Clear(_playerQueue);
-            SLASSERT(result);
-            notifyPlayPause(false);
-        }
+    if (_playerPlay == nullptr || _playerQueue == nullptr) {
+        return;
     }
+
+    PlayerCommand command;
+    command.type = play ? kPlayerCommandPlay : kPlayerCommandPause;
+    sendCommand(command);
+
+    if (play) {
+        startStream();
+    }
+
+    notifyPlayPause(play);
+}
+
+void SoundSystem::startOutput() {
+    if (_playerObject == nullptr) {
+        initAudioPlayer();
+    }
+    startStream();
+}
+
+void SoundSystem::startStream() {
+    pthread_mutex_lock(&_commandMutex);
+    if (!_isStreamStarted && _playerPlay != nullptr && _playerQueue != nullptr) {
+        // the player then runs until it is released, pause only outputs silence so that
+        // transport changes never have to touch OpenSL objects used by the audio thread
+        memset(_playerBuffer, 0, _bufferSize * sizeof(AUDIO_HARDWARE_SAMPLE_TYPE));
+        sendSoundBufferPlay();
+        SLresult result = (*_playerPlay)->SetPlayState(_playerPlay, SL_PLAYSTATE_PLAYING);
+        SLASSERT(result);
+        _isStreamStarted = true;
+    }
+    pthread_mutex_unlock(&_commandMutex);
 }
 
 void SoundSystem::stop() {
-    _positionPlay = 0;
-    (*_playerPlay)->SetPlayState(_playerPlay, SL_PLAYSTATE_STOPPED);
+    PlayerCommand command;
+    command.type = kPlayerCommandStop;
+    sendCommand(command);
     notifyStopTrack();
 };
 
+void SoundSystem::setEqualizerSection(int index, int type, float frequency, float gainDb, float q) {
+    PlayerCommand command;
+    command.type = kPlayerCommandSetEqualizerSection;
+    command.index = index;
+    command.sectionType = type;
+    command.values[0] = frequency;
+    command.values[1] = gainDb;
+    command.values[2] = q;
+    sendCommand(command);
+}
+
+void SoundSystem::setThreeBandGains(float lowGainDb, float midGainDb, float highGainDb) {
+    PlayerCommand command;
+    command.type = kPlayerCommandSetThreeBandGains;
+    command.values[0] = lowGainDb;
+    command.values[1] = midGainDb;
+    command.values[2] = highGainDb;
+    sendCommand(command);
+}
+
+void SoundSystem::setPlaybackRate(float rate, int rampMs) {
+    PlayerCommand command;
+    command.type = kPlayerCommandSetRate;
+    command.values[0] = rate;
+    command.values[1] = rampMs > 0 ? rampMs : 0;
+    sendCommand(command);
+}
+
+void SoundSystem::resetEqualizer() {
+    PlayerCommand command;
+    command.type = kPlayerCommandResetEqualizer;
+    sendCommand(command);
+}
+
+void SoundSystem::sendCommand(const PlayerCommand &command) {
+    pthread_mutex_lock(&_commandMutex);
+    applyEqualizerCommand(_equalizerSettings, command);
+    if (!_isStreamStarted) {
+        processCommand(command);
+        updateClock(false);
+        publishState();
+    } else if (!_commandQueue.push(command)) {
+        LOGW("Player command queue is full, command %d dropped", command.type);
+    }
+    pthread_mutex_unlock(&_commandMutex);
+}
+
+void SoundSystem::processPendingCommands() {
+    PlayerCommand command;
+    while (_commandQueue.pop(&command)) {
+        processCommand(command);
+    }
+}
+
+void SoundSystem::processCommand(const PlayerCommand &command) {
+    switch (command.type) {
+        case kPlayerCommandPlay:
+            _isPlayingTrack = true;
+            break;
+        case kPlayerCommandPause:
+            _isPlayingTrack = false;
+            break;
+        case kPlayerCommandStop:
+            _isPlayingTrack = false;
+            _trackRenderer->setPosition(getStartFrame());
+            break;
+        case kPlayerCommandSetRate:
+            _trackRenderer->getReadHead()->setRate(
+                    command.values[0], (int) (command.values[1] * _sampleRate / 1000.f));
+            break;
+        default:
+            applyEqualizerCommand(_trackRenderer->getEqualizer(), command);
+            break;
+    }
+}
+
+void SoundSystem::processEvent(const ScheduledEvent &event) {
+    switch (event.type) {
+        case kScheduledEventStart:
+            _isPlayingTrack = true;
+            break;
+        case kScheduledEventStop:
+            _isPlayingTrack = false;
+            _trackRenderer->setPosition(getStartFrame());
+            break;
+        case kScheduledEventSeek:
+            _trackRenderer->setPosition(event.position);
+            break;
+        case kScheduledEventGain:
+            _trackRenderer->setGain(event.gain, event.rampFrames);
+            break;
+        default:
+            break;
+    }
+}
+
+bool SoundSystem::scheduleEvent(int type, uint64_t frame, unsigned int position, float gain,
+                                int rampMs) {
+    if (type < 0 || type >= kScheduledEventCount) {
+        return false;
+    }
+    ScheduledEvent event;
+    memset(&event, 0, sizeof(event));
+    event.type = type;
+    event.frame = frame;
+    event.position = position;
+    event.gain = gain;
+    event.rampFrames = rampMs > 0 ? (int) ((int64_t) rampMs * _sampleRate / 1000) : 0;
+    return _eventScheduler->schedule(event);
+}
+
+void SoundSystem::applyEqualizerCommand(Equalizer *equalizer, const PlayerCommand &command) {
+    switch (command.type) {
+        case kPlayerCommandSetEqualizerSection:
+            equalizer->setSection(command.index, command.sectionType, command.values[0],
+                                  command.values[1], command.values[2]);
+            break;
+        case kPlayerCommandSetThreeBandGains:
+            equalizer->setThreeBandGains(command.values[0], command.values[1], command.values[2]);
+            break;
+        case kPlayerCommandResetEqualizer:
+            equalizer->reset();
+            break;
+        default:
+            break;
+    }
+}
+
+bool SoundSystem::renderToWav(const char *wavPath, OfflineRenderStats *stats) {
+    if (!_isLoaded || _extractedData == nullptr) {
+        LOGE("No extracted track to render");
+        return false;
+    }
+    // the extraction thread replaces the extracted data and the bounds of the track
+    if (__atomic_load_n(&_isExtracting, __ATOMIC_ACQUIRE)) {
+        LOGE("Can't render while a track is extracted");
+        return false;
+    }
+
+    OfflineRenderer renderer(_sampleRate, _bufferSize / 2);
+    pthread_mutex_lock(&_commandMutex);
+    renderer.getEqualizer()->copySettings(*_equalizerSettings);
+    pthread_mutex_unlock(&_commandMutex);
+
+    return renderer.render(_extractedData, getStartFrame(), getTotalNumberFrames(), wavPath,
+                           stats);
+}
+
 int SoundSystem::getPlayerState() {
     if(_playerPlay != nullptr) {
         SLuint32 currentState;
@@ -403,6 +1130,9 @@ void SoundSystem::sendSoundBufferPlay() {
 }
 
 void SoundSystem::notifyExtractionEnded() {
+    __atomic_store_n(&_isExtracting, false, __ATOMIC_RELEASE);
+    publishLoadState();
+    notifyTrackListeners(kTrackCompleted);
     _soundSystemCallback->notifyExtractionCompleted();
 }
 
@@ -415,6 +1145,8 @@ void SoundSystem::notifyEndOfTrack() {
 }
 
 void SoundSystem::notifyExtractionStarted() {
+    __atomic_store_n(&_isExtracting, true, __ATOMIC_RELEASE);
+    publishLoadState();
     _soundSystemCallback->notifyExtractionStarted();
 }
 
@@ -423,8 +1155,8 @@ void SoundSystem::notifyPlayPause(bool play) {
 }
 
 void SoundSystem::endTrack() {
-    _positionPlay = 0;
-    (*_playerPlay)->SetPlayState(_playerPlay, SL_PLAYSTATE_STOPPED);
+    _trackRenderer->setPosition(getStartFrame());
+    _isPlayingTrack = false;
     notifyEndOfTrack();
 }
 
@@ -432,14 +1164,10 @@ void SoundSystem::release() {
     // destroy sound player
     stopSoundPlayer();
 
-    if (_outPutMixObj != nullptr) {
-        (*_outPutMixObj)->Destroy(_outPutMixObj);
+    if (_isEngineAcquired) {
+        releaseOpenSLEngine();
+        _isEngineAcquired = false;
         _outPutMixObj = nullptr;
-    }
-
-    if (_engineObj != nullptr) {
-        (*_engineObj)->Destroy(_engineObj);
-        _engineObj = nullptr;
         _engine = nullptr;
     }
 }
@@ -477,20 +1205,44 @@ void SoundSystem::stopSoundPlayer() {
 }
 
 void SoundSystem::releasePlayer() {
+    pthread_mutex_lock(&_commandMutex);
     if (_playerObject != nullptr) {
         (*_playerObject)->AbortAsyncOperation(_playerObject);
         (*_playerObject)->Destroy(_playerObject);
         _playerObject = nullptr;
         _playerPlay = nullptr;
+        _playerQueue = nullptr;
+    }
+
+    // no more callback, commands not drained by the audio thread are applied here
+    if (_isStreamStarted) {
+        _isStreamStarted = false;
+        processPendingCommands();
+        _isPlayingTrack = false;
+        updateClock(false);
+        publishState();
     }
+    pthread_mutex_unlock(&_commandMutex);
 }
 
 AUDIO_HARDWARE_SAMPLE_TYPE* SoundSystem::getExtractedDataMono() {
-    unsigned int sizeDataMono = _totalFrames / 2;
+    unsigned int sizeDataMono = getTotalNumberFrames() / 2;
     AUDIO_HARDWARE_SAMPLE_TYPE* dataMono = (AUDIO_HARDWARE_SAMPLE_TYPE*) calloc(sizeof(AUDIO_HARDWARE_SAMPLE_TYPE), sizeDataMono);
 
-    for(int i = 0 ; i < sizeDataMono ; i++){
-        dataMono[i] = (_extractedData[i * 2] + _extractedData[i * 2 + 1]) / 2;
+    // frames not extracted yet stay silent
+    unsigned int i = 0;
+    while (i < sizeDataMono) {
+        unsigned int contiguousFrames;
+        const AUDIO_HARDWARE_SAMPLE_TYPE *frames = _extractedData->getFrames(i, &contiguousFrames);
+        if (contiguousFrames == 0) {
+            break;
+        }
+        const unsigned int end = sizeDataMono - i < contiguousFrames ? sizeDataMono
+                                                                     : i + contiguousFrames;
+        for (unsigned int j = 0; frames != nullptr && i + j < end; j++) {
+            dataMono[i + j] = (frames[j * 2] + frames[j * 2 + 1]) / 2;
+        }
+        i = end;
     }
     return dataMono;
 }
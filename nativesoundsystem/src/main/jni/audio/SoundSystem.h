@@ -27,13 +27,53 @@
 // Use to compute extraction duration
 #include <time.h>
 
+// Serialize producers of player commands
+#include <pthread.h>
+
 #include "listener/SoundSystemCallback.h"
 
-#ifdef FLOAT_PLAYER
-#define AUDIO_HARDWARE_SAMPLE_TYPE float
-#else
-#define AUDIO_HARDWARE_SAMPLE_TYPE short
-#endif
+#include "dsp/ChannelMapper.h"
+#include "dsp/Equalizer.h"
+#include "dsp/SilenceDetector.h"
+#include "audio/EngineStatus.h"
+#include "audio/EventScheduler.h"
+#include "audio/OfflineRenderer.h"
+#include "audio/PcmFile.h"
+#include "audio/PcmPages.h"
+#include "audio/PlayerCommand.h"
+#include "audio/SampleType.h"
+#include "audio/Sampler.h"
+#include "audio/TrackCache.h"
+#include "audio/TrackRenderer.h"
+#include "utils/SpscQueue.h"
+
+// buffers of the player queue, a buffer filled by a callback is heard after the other ones
+#define PLAYER_NUMBER_BUFFERS 1
+
+// a gap between callbacks longer than this number of buffers is counted as a late callback
+#define PLAYER_LATE_CALLBACK_BUFFERS 2
+
+// output latency not set by the application, the latency reported by the device is used
+#define PLAYER_DEVICE_LATENCY UINT32_MAX
+
+// events of the extracted data of the loaded track sent to the track listener
+enum TrackEvent {
+    // frames have been appended to the pages of the track
+    kTrackFramesAppended,
+    // the pages hold every frame of the track
+    kTrackCompleted,
+    // the pages are about to be freed or given back to the cache, they must not be read anymore
+    kTrackReleased,
+};
+
+/**
+ * Called by the thread extracting or loading the track, or releasing it. pages can be null if
+ * nothing has been extracted.
+ */
+typedef void (*TrackListener)(void *context, int event, const PcmPages *pages);
+
+// analysis following the loaded track at the same time
+#define SOUND_SYSTEM_MAX_TRACK_LISTENERS 4
 
 static void extractionEndCallback(SLPlayItf caller, void *pContext, SLuint32 event);
 static void queueExtractorCallback(SLAndroidSimpleBufferQueueItf aSoundQueue, void *aContext);
@@ -42,14 +82,80 @@ static void queuePlayerCallback(SLAndroidSimpleBufferQueueItf aSoundQueue, void
 class SoundSystem {
 
 public:
+    /**
+     * @param trackCache decoded tracks shared with the other sound systems, not owned.
+     */
     SoundSystem(SoundSystemCallback *callback,
                 int sampleRate,
-                int bufSize);
+                int bufSize,
+                TrackCache *trackCache);
 
     ~SoundSystem();
 
     void extractMusic(SLDataLocator_URI *fileLoc);
 
+    /**
+     * Load an uncompressed WAV or AIFF file without decoding : samples are read from a mapping of
+     * the file. Called instead of extractMusic, before initAudioPlayer.
+     * @return false if the file is not supported.
+     */
+    bool loadPcmFile(const char *filePath);
+
+    // release the mapping of a previous loadPcmFile before loading another track
+    void unloadPcmFile();
+
+    /**
+     * Load a track extracted recently from the cache of decoded tracks, instead of extracting it
+     * again. Called instead of extractMusic, before initAudioPlayer. The silence is searched again
+     * if the trimming parameters have changed since the extraction.
+     * @return false if the track is not in the cache, or if its leading silence has been trimmed
+     * while trimming is now disabled.
+     */
+    bool loadCachedTrack(const char *filePath);
+
+    /**
+     * Release the previous track before extracting filePath, with extractMusic or another extractor.
+     * The track is added to the cache when its extraction completes.
+     */
+    void prepareExtraction(const char *filePath);
+
+    // layout of the frames given to appendDecodedSamples, 2 by default
+    void setDecodedNumberChannels(int numberChannels);
+
+    /**
+     * Called by extractors with each block of decoded frames, in the layout set by
+     * setDecodedNumberChannels. Frames are mapped to the stereo format of the player while they are
+     * stored.
+     */
+    void appendDecodedSamples(const short *samples, unsigned int numberFrames);
+
+    // called by extractors once the whole track has been written to the extracted data
+    void completeExtraction();
+
+    /**
+     * Follow the extracted data of the loaded track, for analysis computed while it is extracted.
+     * Listeners are added and removed while no track is loaded, and told in the order they have
+     * been added.
+     * @return false if SOUND_SYSTEM_MAX_TRACK_LISTENERS listeners are already following the track.
+     */
+    bool addTrackListener(TrackListener listener, void *context);
+
+    void removeTrackListener(TrackListener listener, void *context);
+
+    /**
+     * Trim the silence at the start and at the end of the next tracks loaded : the leading silence
+     * of extracted tracks is not stored, playback starts at the first audible frame and ends after
+     * the last one.
+     * @param thresholdDb level under which a frame is silent.
+     * @param minDurationMs silence shorter than this is kept.
+     */
+    void setSilenceTrimming(bool trim, float thresholdDb, int minDurationMs);
+
+    // silence of the loaded track, computed during its extraction
+    inline const TrackSilence& getTrackSilence(){
+        return _trackSilence;
+    }
+
     void extractAndPlayDirectly(void *sourceFile);
 
     void initAudioPlayer();
@@ -62,10 +168,50 @@ public:
 
     void play(bool play);
 
+    /**
+     * Start the stream of the player without a track, so that samples can be heard. The player is
+     * created if no track has been loaded, it is created again when a track is loaded.
+     */
+    void startOutput();
+
     bool isPlaying();
 
     void stop();
 
+    // state of the player seen by the audio thread at the end of its last callback, lock free
+    void getState(PlayerState *state);
+
+    // block read by Java without native calls
+    inline EngineStatus *getStatus() {
+        return _status;
+    }
+
+    /**
+     * Latency of the output after the player queue, added to the presentation time of the played
+     * frames. Replaces the latency reported by the device, which is used if latencyMs is negative.
+     */
+    void setOutputLatency(int latencyMs);
+
+    void setEqualizerSection(int index, int type, float frequency, float gainDb, float q);
+
+    void setThreeBandGains(float lowGainDb, float midGainDb, float highGainDb);
+
+    void resetEqualizer();
+
+    /**
+     * Rate of the play position, negative to play backward. Reached linearly during rampMs, for
+     * scratches and vinyl brakes.
+     */
+    void setPlaybackRate(float rate, int rampMs);
+
+    /**
+     * Render the loaded track to a WAV file with the current settings of the player. Blocking.
+     * @param stats can be null.
+     * @return false if no track is loaded, while a track is extracted, or if the file can't be
+     * written.
+     */
+    bool renderToWav(const char *wavPath, OfflineRenderStats *stats);
+
     int getPlayerState();
 
     void fillDataBuffer();
@@ -80,20 +226,21 @@ public:
 
     AUDIO_HARDWARE_SAMPLE_TYPE* getExtractedDataMono();
 
-    inline AUDIO_HARDWARE_SAMPLE_TYPE* getExtractedData(){
+    inline PcmPages* getExtractedData(){
         return _extractedData;
     }
 
-    inline void setExtractedData(AUDIO_HARDWARE_SAMPLE_TYPE* extractedData){
+    inline void setExtractedData(PcmPages* extractedData){
         _extractedData = extractedData;
     }
 
+    // bounds of the track are changed by the extraction thread while the audio thread reads them
     inline void setTotalNumberFrames(unsigned int totalFrames){
-        _totalFrames = totalFrames;
+        __atomic_store_n(&_totalFrames, totalFrames, __ATOMIC_RELEASE);
     }
 
     inline unsigned int getTotalNumberFrames(){
-        return _totalFrames;
+        return __atomic_load_n(&_totalFrames, __ATOMIC_ACQUIRE);
     }
 
     inline bool isLoaded(){
@@ -104,10 +251,45 @@ public:
         _isLoaded = isLoaded;
     }
 
+    inline SLEngineItf getEngine(){
+        return _engine;
+    }
+
+    inline int getSampleRate(){
+        return _sampleRate;
+    }
+
+    inline int getBufferSize(){
+        return _bufferSize;
+    }
+
     inline double getExtractionStartTime(){
         return _extractionStartTime;
     }
 
+    inline TrackCache* getTrackCache(){
+        return _trackCache;
+    }
+
+    inline Sampler* getSampler(){
+        return _sampler;
+    }
+
+    inline EventScheduler* getEventScheduler(){
+        return _eventScheduler;
+    }
+
+    /**
+     * Apply a transport change at a frame of the output clock, see PlayerState::outputFrame. Lock
+     * free. Events are applied while the stream runs, at the frame where they fall in the block.
+     * @param type     ScheduledEventType.
+     * @param position frame of the track to play from, for a seek.
+     * @param gain     linear gain of the track, for a gain change.
+     * @param rampMs   duration to reach the gain.
+     * @return false if too many events wait for the audio thread.
+     */
+    bool scheduleEvent(int type, uint64_t frame, unsigned int position, float gain, int rampMs);
+
     //------------------------
     // - Extraction methods -
     //------------------------
@@ -125,14 +307,69 @@ private :
 
     void extractMetaData();
 
+    void releaseExtractor();
+
+    // drop the reference to the cached track or the partially extracted data
+    void releaseTrack();
+
+    /**
+     * Store frames in the format of the player. The leading silence is not stored if silence
+     * trimming is enabled.
+     */
+    void appendExtractedFrames(const AUDIO_HARDWARE_SAMPLE_TYPE *frames, unsigned int numberFrames);
+
+    // start and end of playback from the silence of the loaded track of numberFrames stored frames
+    void applySilence(unsigned int numberFrames);
+
+    // find the silence of stored frames with the current trimming parameters
+    void detectSilence(const PcmPages *pages);
+
+    inline void setStartFrame(unsigned int startFrame){
+        __atomic_store_n(&_startFrame, startFrame, __ATOMIC_RELEASE);
+    }
+
+    inline unsigned int getStartFrame(){
+        return __atomic_load_n(&_startFrame, __ATOMIC_ACQUIRE);
+    }
+
+    void notifyTrackListeners(int event);
+
+    void sendCommand(const PlayerCommand &command);
+
+    // send the first buffer to the player and set it playing, once per player
+    void startStream();
+
+    void processCommand(const PlayerCommand &command);
+
+    static void applyEqualizerCommand(Equalizer *equalizer, const PlayerCommand &command);
+
+    void processPendingCommands();
+
+    void processEvent(const ScheduledEvent &event);
+
+    /**
+     * Render numberFrames frames of the track from the frame offset of the player buffer, or
+     * silence if no track is playing. Called by the audio thread between scheduled events.
+     * @return false if silence was rendered.
+     */
+    bool renderTrack(unsigned int offset, unsigned int numberFrames);
+
+    void publishState();
+
+    // state of the loaded track, called by the thread loading or extracting it
+    void publishLoadState();
+
+    // highest absolute sample of each channel of the player buffer
+    void measurePeaks();
+
+    // time at which the next rendered frame is heard, called by the audio thread before rendering.
+    // The position doesn't move while the stream is not running.
+    void updateClock(bool isStreamRunning);
+
     // device features
     int _sampleRate;
     int _bufferSize;
 
-    // positions used during extraction and play of the track
-    int _positionExtract;
-    int _positionPlay;
-
     bool _isLoaded;
 
     bool _needExtractInitialisation;
@@ -146,11 +383,9 @@ private :
     // object used to notify of some events
     SoundSystemCallback *_soundSystemCallback = nullptr;
 
-    // engine
-    SLObjectItf _engineObj = nullptr;
+    // engine and output, shared by all sound systems
+    bool _isEngineAcquired = false;
     SLEngineItf _engine = nullptr;
-
-    // output
     SLObjectItf _outPutMixObj = nullptr;
 
     //extract
@@ -166,10 +401,98 @@ private :
 
     //buffer
     short*_soundBuffer = nullptr;
+
+    // decoded frames mapped to the player layout
+    ChannelMapper *_channelMapper = nullptr;
+    // frames mapped before they are stored, while looking for the end of the leading silence
+    AUDIO_HARDWARE_SAMPLE_TYPE* _mappingBuffer = nullptr;
+    unsigned int _mappingBufferFrames;
     AUDIO_HARDWARE_SAMPLE_TYPE* _playerBuffer = nullptr;
 
-    //extracted music
-    AUDIO_HARDWARE_SAMPLE_TYPE* _extractedData = nullptr;
+    //extracted music, pages filled during extraction
+    PcmPages* _extractedData = nullptr;
+
+    // owner of extracted data loaded by loadPcmFile
+    PcmFile *_pcmFile = nullptr;
+
+    // decoded tracks kept in RAM, shared by the sound systems. The loaded one is referenced by
+    // _cachedTrack.
+    TrackCache *_trackCache = nullptr;
+    TrackCacheEntry *_cachedTrack = nullptr;
+
+    // told about the extracted data of the loaded track
+    TrackListener _trackListeners[SOUND_SYSTEM_MAX_TRACK_LISTENERS] = {};
+    void *_trackListenerContexts[SOUND_SYSTEM_MAX_TRACK_LISTENERS] = {};
+    int _numberTrackListeners = 0;
+
+    // key of the track being extracted in the cache
+    char *_extractingFilePath = nullptr;
+    TrackFileVersion _extractingFileVersion;
+    bool _hasExtractingFileVersion = false;
+
+    // silence trimming, parameters are used from the next track loaded
+    SilenceDetector *_silenceDetector = nullptr;
+    bool _isSilenceTrimmed;
+    // value of _isSilenceTrimmed when the extraction started
+    bool _isExtractionTrimmed;
+    float _silenceThresholdDb;
+    int _silenceMinDurationMs;
+    TrackSilence _trackSilence;
+
+    // leading silence extracted but not stored yet
+    AUDIO_HARDWARE_SAMPLE_TYPE *_pendingSilence;
+    unsigned int _pendingSilenceCapacity;
+    unsigned int _numberPendingFrames;
+
+    // first frame played, after the leading silence. Like _totalFrames, accessed with atomics.
+    unsigned int _startFrame;
+
+    // fills each buffer sent to the player, owned by the audio thread once the stream is started
+    TrackRenderer *_trackRenderer = nullptr;
+
+    // one-shot samples mixed over the track, or over silence when no track is playing
+    Sampler *_sampler = nullptr;
+
+    // transport changes applied at a frame of _outputFrame
+    EventScheduler *_eventScheduler = nullptr;
+
+    // last equalizer settings sent to the player, guarded by the command mutex
+    Equalizer *_equalizerSettings = nullptr;
+
+    // commands are applied directly until the player callbacks start, then they are queued and
+    // drained by the audio thread. The mutex is never taken by the audio thread.
+    SpscQueue<PlayerCommand, PLAYER_COMMAND_QUEUE_CAPACITY> _commandQueue;
+    pthread_mutex_t _commandMutex;
+    bool _isStreamStarted;
+
+    // owned by the audio thread once the stream is started
+    bool _isPlayingTrack;
+
+    // state published for other threads and Java
+    EngineStatus *_status;
+
+    // clock of the last callback, owned by the audio thread once the stream is started
+    unsigned int _clockFrame;
+    int64_t _clockTimeNs;
+    float _clockRate;
+    uint64_t _clockOutputFrame;
+
+    // frames rendered by the player since its creation, owned by the audio thread
+    uint64_t _outputFrame;
+
+    // measures of the played buffers, owned by the audio thread once the stream is started
+    int64_t _lastCallbackTimeNs;
+    float _peakLeft;
+    float _peakRight;
+    uint32_t _starvedBuffers;
+    uint32_t _lateCallbacks;
+
+    // between the start and the end of the extraction of the track, written with atomics
+    bool _isExtracting;
+
+    // latency after the player queue in microseconds, read by the audio thread
+    uint32_t _deviceLatencyUs;
+    uint32_t _outputLatencyUs;
 
 };
 
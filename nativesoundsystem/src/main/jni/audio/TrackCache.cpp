@@ -0,0 +1,197 @@
+#include "TrackCache.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <utils/android_debug.h>
+
+TrackCache::TrackCache(size_t budgetBytes) :
+        _head(nullptr),
+        _tail(nullptr),
+        _budgetBytes(budgetBytes),
+        _usedBytes(0),
+        _numberTracks(0),
+        _hits(0),
+        _misses(0),
+        _evictions(0) {
+    pthread_mutex_init(&_mutex, nullptr);
+}
+
+TrackCache::~TrackCache() {
+    // references still held are dropped with the cache
+    while (_head != nullptr) {
+        TrackCacheEntry *next = _head->next;
+        delete _head->pages;
+        free(_head->filePath);
+        free(_head);
+        _head = next;
+    }
+    pthread_mutex_destroy(&_mutex);
+}
+
+bool TrackCache::readFileVersion(const char *filePath, TrackFileVersion *version) {
+    struct stat fileStat;
+    if (stat(filePath, &fileStat) != 0) {
+        return false;
+    }
+    // seconds only, st_mtim is not in the stat of every Android version
+    version->modificationTime = (int64_t) fileStat.st_mtime;
+    version->size = (int64_t) fileStat.st_size;
+    return true;
+}
+
+TrackCacheEntry* TrackCache::acquire(const char *filePath) {
+    TrackFileVersion version;
+    const bool hasVersion = readFileVersion(filePath, &version);
+
+    pthread_mutex_lock(&_mutex);
+    TrackCacheEntry *entry = find(filePath);
+    if (entry != nullptr && (!hasVersion
+                             || entry->version.modificationTime != version.modificationTime
+                             || entry->version.size != version.size)) {
+        // the file has changed, it will be decoded again
+        if (entry->references == 0) {
+            evict(entry);
+        }
+        entry = nullptr;
+    }
+    if (entry != nullptr) {
+        entry->references++;
+        unlink(entry);
+        pushFront(entry);
+        _hits++;
+    } else {
+        _misses++;
+    }
+    pthread_mutex_unlock(&_mutex);
+    return entry;
+}
+
+TrackCacheEntry* TrackCache::insert(const char *filePath, const TrackFileVersion &version,
+                                    PcmPages *pages, const TrackSilence &silence) {
+    TrackCacheEntry *entry = (TrackCacheEntry *) calloc(1, sizeof(TrackCacheEntry));
+    if (entry == nullptr) {
+        return nullptr;
+    }
+    entry->filePath = strdup(filePath);
+    if (entry->filePath == nullptr) {
+        free(entry);
+        return nullptr;
+    }
+    entry->version = version;
+    entry->pages = pages;
+    entry->numberFrames = pages->getNumberFrames();
+    entry->silence = silence;
+    entry->sizeBytes = pages->getSizeBytes();
+    entry->references = 1;
+
+    pthread_mutex_lock(&_mutex);
+    TrackCacheEntry *previousEntry = find(filePath);
+    if (previousEntry != nullptr && previousEntry->references == 0) {
+        evict(previousEntry);
+    }
+
+    // the new track is referenced, it is kept even if it does not fit
+    if (entry->sizeBytes < _budgetBytes) {
+        evictDownTo(_budgetBytes - entry->sizeBytes);
+    } else {
+        evictDownTo(0);
+    }
+    pushFront(entry);
+    _usedBytes += entry->sizeBytes;
+    _numberTracks++;
+    LOGI("Track cache : %u tracks, %zu / %zu bytes", _numberTracks, _usedBytes, _budgetBytes);
+    pthread_mutex_unlock(&_mutex);
+    return entry;
+}
+
+void TrackCache::release(TrackCacheEntry *entry) {
+    pthread_mutex_lock(&_mutex);
+    entry->references--;
+    if (entry->references == 0 && _usedBytes > _budgetBytes) {
+        evictDownTo(_budgetBytes);
+    }
+    pthread_mutex_unlock(&_mutex);
+}
+
+void TrackCache::setBudget(size_t budgetBytes) {
+    pthread_mutex_lock(&_mutex);
+    _budgetBytes = budgetBytes;
+    evictDownTo(_budgetBytes);
+    pthread_mutex_unlock(&_mutex);
+}
+
+void TrackCache::clear() {
+    pthread_mutex_lock(&_mutex);
+    evictDownTo(0);
+    pthread_mutex_unlock(&_mutex);
+}
+
+void TrackCache::getStats(TrackCacheStats *stats) {
+    pthread_mutex_lock(&_mutex);
+    stats->hits = _hits;
+    stats->misses = _misses;
+    stats->evictions = _evictions;
+    stats->numberTracks = _numberTracks;
+    stats->usedBytes = _usedBytes;
+    stats->budgetBytes = _budgetBytes;
+    pthread_mutex_unlock(&_mutex);
+}
+
+TrackCacheEntry* TrackCache::find(const char *filePath) {
+    // a few tracks at most, the most recent are checked first
+    for (TrackCacheEntry *entry = _head; entry != nullptr; entry = entry->next) {
+        if (strcmp(entry->filePath, filePath) == 0) {
+            return entry;
+        }
+    }
+    return nullptr;
+}
+
+void TrackCache::unlink(TrackCacheEntry *entry) {
+    if (entry->previous != nullptr) {
+        entry->previous->next = entry->next;
+    } else {
+        _head = entry->next;
+    }
+    if (entry->next != nullptr) {
+        entry->next->previous = entry->previous;
+    } else {
+        _tail = entry->previous;
+    }
+    entry->previous = nullptr;
+    entry->next = nullptr;
+}
+
+void TrackCache::pushFront(TrackCacheEntry *entry) {
+    entry->previous = nullptr;
+    entry->next = _head;
+    if (_head != nullptr) {
+        _head->previous = entry;
+    } else {
+        _tail = entry;
+    }
+    _head = entry;
+}
+
+void TrackCache::evict(TrackCacheEntry *entry) {
+    unlink(entry);
+    _usedBytes -= entry->sizeBytes;
+    _numberTracks--;
+    _evictions++;
+    delete entry->pages;
+    free(entry->filePath);
+    free(entry);
+}
+
+void TrackCache::evictDownTo(size_t budgetBytes) {
+    TrackCacheEntry *entry = _tail;
+    while (entry != nullptr && _usedBytes > budgetBytes) {
+        TrackCacheEntry *previous = entry->previous;
+        if (entry->references == 0) {
+            evict(entry);
+        }
+        entry = previous;
+    }
+}
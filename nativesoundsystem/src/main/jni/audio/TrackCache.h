@@ -0,0 +1,125 @@
+//
+// Created by Frederic on 07/06/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_TRACKCACHE_H
+#define MINI_SOUND_SYSTEM_TRACKCACHE_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "audio/PcmPages.h"
+#include "dsp/SilenceDetector.h"
+
+// default memory budget of the decoded tracks kept in RAM, for all sound systems
+#define TRACK_CACHE_DEFAULT_BUDGET_BYTES (256 * 1024 * 1024)
+
+// a file changed since it was decoded is decoded again
+typedef struct {
+    // seconds since the epoch
+    int64_t modificationTime;
+    int64_t size;
+} TrackFileVersion;
+
+typedef struct TrackCacheEntry {
+    char *filePath;
+    TrackFileVersion version;
+    PcmPages *pages;
+    unsigned int numberFrames;
+    // computed during extraction
+    TrackSilence silence;
+    size_t sizeBytes;
+    // an entry is never evicted while referenced
+    int references;
+    // least recently used list, most recent first
+    TrackCacheEntry *previous;
+    TrackCacheEntry *next;
+} TrackCacheEntry;
+
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions;
+    uint32_t numberTracks;
+    uint64_t usedBytes;
+    uint64_t budgetBytes;
+} TrackCacheStats;
+
+/**
+ * Decoded tracks kept in RAM by file path, so that switching back to a recently played track does
+ * not extract it again. A single cache is shared by the sound systems of the process, and the
+ * modification time and the size of the file are checked each time a track is acquired.
+ *
+ * Tracks not referenced anymore are evicted, least recently used first, when the total size goes
+ * over the budget. A referenced track is never evicted, even if it is larger than the budget.
+ * All methods are thread safe.
+ */
+class TrackCache {
+public:
+    TrackCache(size_t budgetBytes);
+    TrackCache& operator=(const TrackCache& ) = delete;
+    TrackCache(TrackCache&) = delete;
+    ~TrackCache();
+
+    /**
+     * @return false if the file can't be read, it can't be cached then.
+     */
+    static bool readFileVersion(const char *filePath, TrackFileVersion *version);
+
+    /**
+     * @return the track with a new reference, or nullptr if it is not in the cache or if the file
+     * has changed since it was decoded.
+     */
+    TrackCacheEntry* acquire(const char *filePath);
+
+    /**
+     * Keep decoded data of a track. A previous entry of the same path is evicted if not referenced,
+     * otherwise it is only hidden by the new one.
+     * @param version of the file when its decoding started.
+     * @param pages completely written, deleted by the cache from now on.
+     * @param silence found during the decoding.
+     * @return the new entry with a reference for the caller, or nullptr if it can't be allocated, in
+     * which case pages still belong to the caller.
+     */
+    TrackCacheEntry* insert(const char *filePath, const TrackFileVersion &version, PcmPages *pages,
+                            const TrackSilence &silence);
+
+    void release(TrackCacheEntry *entry);
+
+    // tracks not referenced are evicted if they don't fit anymore
+    void setBudget(size_t budgetBytes);
+
+    // evict every track not referenced
+    void clear();
+
+    void getStats(TrackCacheStats *stats);
+
+private:
+
+    TrackCacheEntry* find(const char *filePath);
+
+    void unlink(TrackCacheEntry *entry);
+
+    void pushFront(TrackCacheEntry *entry);
+
+    void evict(TrackCacheEntry *entry);
+
+    // evict least recently used tracks not referenced while more than budgetBytes are used
+    void evictDownTo(size_t budgetBytes);
+
+    pthread_mutex_t _mutex;
+
+    TrackCacheEntry *_head;
+    TrackCacheEntry *_tail;
+
+    size_t _budgetBytes;
+    size_t _usedBytes;
+    uint32_t _numberTracks;
+
+    uint32_t _hits;
+    uint32_t _misses;
+    uint32_t _evictions;
+};
+
+#endif //MINI_SOUND_SYSTEM_TRACKCACHE_H
@@ -0,0 +1,341 @@
+#include "TrackDecoder.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <utils/android_debug.h>
+
+#include "audio/OpenSLMetadata.h"
+
+#define SLASSERT(x) assert(x == SL_RESULT_SUCCESS)
+
+// time waited for the end of the decoding before checking cancellation
+#define DECODE_POLL_PERIOD_MS 100
+
+// give up when OpenSL has not decoded any buffer during this time (corrupted file...)
+#define DECODE_STALL_TIMEOUT_MS 5000
+
+// time waited by MediaCodec for an available input or output buffer
+#define CODEC_DEQUEUE_TIMEOUT_US 5000
+
+static double now_ms(void) {
+    struct timespec res;
+    clock_gettime(CLOCK_MONOTONIC, &res);
+    return 1000.0 * res.tv_sec + (double) res.tv_nsec / 1e6;
+}
+
+static void decoderBufferQueueCallback(SLAndroidSimpleBufferQueueItf aSoundQueue, void *aContext) {
+    TrackDecoder *self = static_cast<TrackDecoder *>(aContext);
+    self->onBufferDecoded();
+}
+
+static void decoderPlayCallback(SLPlayItf caller, void *pContext, SLuint32 event) {
+    if (event & SL_PLAYEVENT_HEADATEND) {
+        TrackDecoder *self = static_cast<TrackDecoder *>(pContext);
+        self->onHeadAtEnd();
+    }
+}
+
+TrackDecoder::TrackDecoder(SLEngineItf engine, int sampleRate, int bufferSize) :
+        _engine(engine),
+        _sampleRate(sampleRate),
+        _bufferSize(bufferSize),
+        _numberChannels(2),
+        _fileSampleRate(sampleRate),
+        _callback(nullptr),
+        _context(nullptr),
+        _cancelled(nullptr),
+        _bufferQueue(nullptr),
+        _metadata(nullptr),
+        _currentBuffer(0),
+        _numberDecodedBuffers(0),
+        _sawEnd(false),
+        _stoppedByCallback(false) {
+    _buffers[0] = (short *) calloc(_bufferSize, sizeof(short));
+    _buffers[1] = (short *) calloc(_bufferSize, sizeof(short));
+    sem_init(&_endSemaphore, 0, 0);
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+TrackDecoder::~TrackDecoder() {
+    sem_destroy(&_endSemaphore);
+    free(_buffers[0]);
+    free(_buffers[1]);
+}
+
+bool TrackDecoder::decode(const char *filePath, DecodedBlockCallback callback, void *context,
+                          volatile bool *cancelled) {
+    _callback = callback;
+    _context = context;
+    _cancelled = cancelled;
+    _stoppedByCallback = false;
+    memset(&_stats, 0, sizeof(_stats));
+
+    const double startTime = now_ms();
+#ifdef MEDIACODEC_EXTRACTOR
+    const bool decoded = decodeMediaCodec(filePath);
+#else
+    const bool decoded = decodeOpenSL(filePath);
+#endif
+    _stats.decodeMs = now_ms() - startTime;
+    return decoded;
+}
+
+void TrackDecoder::onBufferDecoded() {
+    // buffers are given back in the order they have been enqueued
+    short *buffer = _buffers[_currentBuffer];
+    _currentBuffer ^= 1;
+    _numberDecodedBuffers++;
+
+    if (*_cancelled || _sawEnd || _stoppedByCallback) {
+        return;
+    }
+
+    if (_numberDecodedBuffers == 1) {
+        // the sink format asks for stereo, but the decoder outputs the channels of the file
+        _numberChannels = readDecodedNumberChannels(_metadata, 2);
+    }
+
+    if (!_callback(buffer, (unsigned int) _bufferSize, _context)) {
+        _stoppedByCallback = true;
+        sem_post(&_endSemaphore);
+        return;
+    }
+
+    SLresult result = (*_bufferQueue)->Enqueue(_bufferQueue, buffer, sizeof(short) * _bufferSize);
+    SLASSERT(result);
+}
+
+void TrackDecoder::onHeadAtEnd() {
+    if (!_stoppedByCallback) {
+        _sawEnd = true;
+        sem_post(&_endSemaphore);
+    }
+}
+
+#ifndef MEDIACODEC_EXTRACTOR
+
+bool TrackDecoder::decodeOpenSL(const char *filePath) {
+    SLresult result;
+
+    SLDataLocator_URI fileLoc;
+    fileLoc.locatorType = SL_DATALOCATOR_URI;
+    fileLoc.URI = (SLchar *) filePath;
+
+    SLDataFormat_MIME format_mime;
+    format_mime.formatType = SL_DATAFORMAT_MIME;
+    format_mime.mimeType = nullptr;
+    format_mime.containerType = SL_CONTAINERTYPE_UNSPECIFIED;
+
+    SLDataSource audioSrc;
+    audioSrc.pLocator = &fileLoc;
+    audioSrc.pFormat = &format_mime;
+
+    SLDataLocator_AndroidSimpleBufferQueue dataLocatorInput;
+    dataLocatorInput.locatorType = SL_DATALOCATOR_ANDROIDSIMPLEBUFFERQUEUE;
+    dataLocatorInput.numBuffers = 2;
+
+    SLDataFormat_PCM dataFormat;
+    dataFormat.formatType = SL_DATAFORMAT_PCM;
+    dataFormat.numChannels = 2; // Stereo sound.
+    dataFormat.samplesPerSec = (SLuint32) _sampleRate * 1000;
+    dataFormat.bitsPerSample = SL_PCMSAMPLEFORMAT_FIXED_16;
+    dataFormat.containerSize = SL_PCMSAMPLEFORMAT_FIXED_16;
+    dataFormat.channelMask = SL_SPEAKER_FRONT_LEFT | SL_SPEAKER_FRONT_RIGHT;
+    dataFormat.endianness = SL_BYTEORDER_LITTLEENDIAN;
+
+    SLDataSink audioSnk = {&dataLocatorInput, &dataFormat};
+
+    const SLuint32 decoderIIDCount = 2;
+    const SLInterfaceID decoderIIDs[] = {SL_IID_ANDROIDSIMPLEBUFFERQUEUE,
+                                         SL_IID_METADATAEXTRACTION};
+    const SLboolean decoderReqs[] = {SL_BOOLEAN_TRUE, SL_BOOLEAN_TRUE};
+
+    SLObjectItf decoderObject = nullptr;
+    result = (*_engine)->CreateAudioPlayer(_engine, &decoderObject, &audioSrc, &audioSnk,
+                                           decoderIIDCount, decoderIIDs, decoderReqs);
+    if (result != SL_RESULT_SUCCESS) {
+        LOGE("Unable to create decoder for %s", filePath);
+        return false;
+    }
+
+    // an invalid file is only detected here
+    result = (*decoderObject)->Realize(decoderObject, SL_BOOLEAN_FALSE);
+    if (result != SL_RESULT_SUCCESS) {
+        LOGE("Unable to realize decoder for %s", filePath);
+        (*decoderObject)->Destroy(decoderObject);
+        return false;
+    }
+
+    SLPlayItf decoderPlay;
+    result = (*decoderObject)->GetInterface(decoderObject, SL_IID_PLAY, &decoderPlay);
+    SLASSERT(result);
+
+    result = (*decoderObject)->GetInterface(decoderObject, SL_IID_ANDROIDSIMPLEBUFFERQUEUE,
+                                            &_bufferQueue);
+    SLASSERT(result);
+
+    result = (*decoderObject)->GetInterface(decoderObject, SL_IID_METADATAEXTRACTION, &_metadata);
+    SLASSERT(result);
+
+    result = (*decoderPlay)->RegisterCallback(decoderPlay, decoderPlayCallback, this);
+    SLASSERT(result);
+    result = (*decoderPlay)->SetCallbackEventsMask(decoderPlay, SL_PLAYEVENT_HEADATEND);
+    SLASSERT(result);
+
+    result = (*_bufferQueue)->RegisterCallback(_bufferQueue, decoderBufferQueueCallback, this);
+    SLASSERT(result);
+
+    _numberChannels = 2;
+    _fileSampleRate = _sampleRate;
+    _currentBuffer = 0;
+    _numberDecodedBuffers = 0;
+    _sawEnd = false;
+    while (sem_trywait(&_endSemaphore) == 0) {
+        // semaphore posted by a previous decoding
+    }
+
+    (*_bufferQueue)->Enqueue(_bufferQueue, _buffers[0], sizeof(short) * _bufferSize);
+    (*_bufferQueue)->Enqueue(_bufferQueue, _buffers[1], sizeof(short) * _bufferSize);
+
+    result = (*decoderPlay)->SetPlayState(decoderPlay, SL_PLAYSTATE_PLAYING);
+    SLASSERT(result);
+
+    unsigned int lastNumberDecodedBuffers = 0;
+    int stalledTime = 0;
+    bool completed = false;
+    while (true) {
+        struct timespec timeout;
+        clock_gettime(CLOCK_REALTIME, &timeout);
+        timeout.tv_nsec += DECODE_POLL_PERIOD_MS * 1000000L;
+        if (timeout.tv_nsec >= 1000000000L) {
+            timeout.tv_sec++;
+            timeout.tv_nsec -= 1000000000L;
+        }
+
+        if (sem_timedwait(&_endSemaphore, &timeout) == 0) {
+            completed = true;
+            break;
+        }
+        if (*_cancelled) {
+            break;
+        }
+
+        if (_numberDecodedBuffers == lastNumberDecodedBuffers) {
+            stalledTime += DECODE_POLL_PERIOD_MS;
+            if (stalledTime >= DECODE_STALL_TIMEOUT_MS) {
+                LOGE("Decoding of %s stalled", filePath);
+                break;
+            }
+        } else {
+            lastNumberDecodedBuffers = _numberDecodedBuffers;
+            stalledTime = 0;
+        }
+    }
+
+    // prevent enqueue of new buffers, Destroy waits for the running callbacks
+    _sawEnd = true;
+    (*decoderPlay)->SetPlayState(decoderPlay, SL_PLAYSTATE_STOPPED);
+    (*_bufferQueue)->Clear(_bufferQueue);
+    (*decoderObject)->Destroy(decoderObject);
+    _bufferQueue = nullptr;
+    _metadata = nullptr;
+
+    return completed && !*_cancelled;
+}
+
+#else
+
+bool TrackDecoder::decodeMediaCodec(const char *filePath) {
+    AMediaExtractor *ex = AMediaExtractor_new();
+
+    media_status_t err = AMediaExtractor_setDataSource(ex, filePath);
+    if (err != AMEDIA_OK) {
+        LOGE("setDataSource error: %d", err);
+        AMediaExtractor_delete(ex);
+        return false;
+    }
+
+    AMediaCodec *codec = NULL;
+    int numtracks = AMediaExtractor_getTrackCount(ex);
+    for (int i = 0; i < numtracks && codec == NULL; i++) {
+        AMediaFormat *format = AMediaExtractor_getTrackFormat(ex, i);
+        const char *mime;
+        if (AMediaFormat_getString(format, AMEDIAFORMAT_KEY_MIME, &mime)
+            && strncmp(mime, "audio/", 6) == 0) {
+            int32_t numberChannels = 2;
+            int32_t fileSampleRate = _sampleRate;
+            AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_CHANNEL_COUNT, &numberChannels);
+            AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_SAMPLE_RATE, &fileSampleRate);
+            _numberChannels = numberChannels;
+            _fileSampleRate = fileSampleRate;
+
+            AMediaExtractor_selectTrack(ex, i);
+            codec = AMediaCodec_createDecoderByType(mime);
+            AMediaCodec_configure(codec, format, NULL, NULL, 0);
+            AMediaCodec_start(codec);
+        }
+        AMediaFormat_delete(format);
+    }
+
+    if (codec == NULL) {
+        LOGE("No audio track in %s", filePath);
+        AMediaExtractor_delete(ex);
+        return false;
+    }
+
+    bool sawInputEOS = false;
+    bool sawOutputEOS = false;
+    while (!sawOutputEOS && !*_cancelled) {
+        if (!sawInputEOS) {
+            ssize_t bufidx = AMediaCodec_dequeueInputBuffer(codec, CODEC_DEQUEUE_TIMEOUT_US);
+            if (bufidx >= 0) {
+                size_t bufsize;
+                auto buf = AMediaCodec_getInputBuffer(codec, bufidx, &bufsize);
+                auto sampleSize = AMediaExtractor_readSampleData(ex, buf, bufsize);
+                if (sampleSize < 0) {
+                    sampleSize = 0;
+                    sawInputEOS = true;
+                }
+                AMediaCodec_queueInputBuffer(codec, bufidx, 0, sampleSize, 0,
+                                             sawInputEOS ? AMEDIACODEC_BUFFER_FLAG_END_OF_STREAM
+                                                         : 0);
+                AMediaExtractor_advance(ex);
+            }
+        }
+
+        AMediaCodecBufferInfo info;
+        auto status = AMediaCodec_dequeueOutputBuffer(codec, &info, CODEC_DEQUEUE_TIMEOUT_US);
+        if (status >= 0) {
+            if (info.flags & AMEDIACODEC_BUFFER_FLAG_END_OF_STREAM) {
+                sawOutputEOS = true;
+            }
+            size_t bufsize;
+            uint8_t *buf = AMediaCodec_getOutputBuffer(codec, status, &bufsize);
+            if (info.size > 0
+                && !_callback(reinterpret_cast<short *>(buf + info.offset),
+                              info.size / sizeof(short), _context)) {
+                _stoppedByCallback = true;
+                sawOutputEOS = true;
+            }
+            AMediaCodec_releaseOutputBuffer(codec, status, false);
+        } else if (status == AMEDIACODEC_INFO_OUTPUT_FORMAT_CHANGED) {
+            auto format = AMediaCodec_getOutputFormat(codec);
+            int32_t numberChannels;
+            if (AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_CHANNEL_COUNT, &numberChannels)) {
+                _numberChannels = numberChannels;
+            }
+            AMediaFormat_delete(format);
+        }
+    }
+
+    AMediaCodec_stop(codec);
+    AMediaCodec_delete(codec);
+    AMediaExtractor_delete(ex);
+
+    return sawOutputEOS && !*_cancelled;
+}
+
+#endif
@@ -0,0 +1,85 @@
+//
+// Created by Frederic on 02/05/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_TRACKDECODER_H
+#define MINI_SOUND_SYSTEM_TRACKDECODER_H
+
+// Include OpenSLES
+#include <SLES/OpenSLES.h>
+#include <SLES/OpenSLES_Android.h>
+
+#include <semaphore.h>
+
+#ifdef MEDIACODEC_EXTRACTOR
+#include "media/NdkMediaCodec.h"
+#include "media/NdkMediaExtractor.h"
+#endif
+
+#include "audio/AudioDecoder.h"
+
+/**
+ * Decoder of the platform : OpenSL ES, or MediaCodec when MEDIACODEC_EXTRACTOR is defined. Files
+ * are decoded like SoundSystem::extractMusic and ExtractorNougat do, without going through the
+ * player.
+ */
+class TrackDecoder : public AudioDecoder {
+public:
+    TrackDecoder(SLEngineItf engine, int sampleRate, int bufferSize);
+    ~TrackDecoder();
+
+    bool decode(const char *filePath, DecodedBlockCallback callback, void *context,
+                volatile bool *cancelled) override;
+
+    int getNumberChannels() override {
+        return _numberChannels;
+    }
+
+    int getFileSampleRate() override {
+        return _fileSampleRate;
+    }
+
+    void getDecodeStats(DecodeStats *stats) override {
+        *stats = _stats;
+    }
+
+    //---------------------------------
+    // - OpenSL callbacks, internal -
+    //---------------------------------
+    void onBufferDecoded();
+
+    void onHeadAtEnd();
+
+private:
+
+#ifdef MEDIACODEC_EXTRACTOR
+    bool decodeMediaCodec(const char *filePath);
+#else
+    bool decodeOpenSL(const char *filePath);
+#endif
+
+    SLEngineItf _engine;
+    int _sampleRate;
+    int _bufferSize;
+
+    int _numberChannels;
+    int _fileSampleRate;
+
+    DecodeStats _stats;
+
+    DecodedBlockCallback _callback;
+    void *_context;
+    volatile bool *_cancelled;
+
+    // OpenSL decoding, two buffers are alternately enqueued
+    SLAndroidSimpleBufferQueueItf _bufferQueue;
+    SLMetadataExtractionItf _metadata;
+    short *_buffers[2];
+    int _currentBuffer;
+    volatile unsigned int _numberDecodedBuffers;
+    volatile bool _sawEnd;
+    volatile bool _stoppedByCallback;
+    sem_t _endSemaphore;
+};
+
+#endif //MINI_SOUND_SYSTEM_TRACKDECODER_H
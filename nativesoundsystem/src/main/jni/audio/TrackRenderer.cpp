@@ -0,0 +1,65 @@
+#include "TrackRenderer.h"
+
+static inline AUDIO_HARDWARE_SAMPLE_TYPE toPlayerSample(float sample) {
+#ifdef FLOAT_PLAYER
+    return sample;
+#else
+    sample += sample < 0.f ? -0.5f : 0.5f;
+    return (short) (sample > 32767.f ? 32767.f : (sample < -32768.f ? -32768.f : sample));
+#endif
+}
+
+TrackRenderer::TrackRenderer(int sampleRate, int maxFrames) :
+        _maxFrames(maxFrames),
+        _gain(1.f),
+        _targetGain(1.f),
+        _gainStep(0.f),
+        _gainRampFrames(0) {
+    _readHead = new ReadHead(maxFrames);
+    _equalizer = new Equalizer(sampleRate, maxFrames);
+}
+
+TrackRenderer::~TrackRenderer() {
+    delete _readHead;
+    delete _equalizer;
+}
+
+int TrackRenderer::render(const PcmPages *track, unsigned int totalFrames,
+                          AUDIO_HARDWARE_SAMPLE_TYPE *frames, int numberFrames) {
+    if (numberFrames > _maxFrames) {
+        numberFrames = _maxFrames;
+    }
+
+    int numberFramesRead = _readHead->read(track, totalFrames, frames, numberFrames);
+    _equalizer->process(frames, numberFrames);
+    applyGain(frames, numberFrames);
+    return numberFramesRead;
+}
+
+void TrackRenderer::setGain(float gain, int rampFrames) {
+    _targetGain = gain;
+    if (rampFrames > 0) {
+        _gainStep = (gain - _gain) / rampFrames;
+        _gainRampFrames = rampFrames;
+    } else {
+        _gain = gain;
+        _gainStep = 0.f;
+        _gainRampFrames = 0;
+    }
+}
+
+void TrackRenderer::applyGain(AUDIO_HARDWARE_SAMPLE_TYPE *frames, int numberFrames) {
+    if (_gainRampFrames == 0 && _gain == 1.f) {
+        return;
+    }
+    for (int i = 0; i < numberFrames; i++) {
+        if (_gainRampFrames > 0) {
+            _gain += _gainStep;
+            if (--_gainRampFrames == 0) {
+                _gain = _targetGain;
+            }
+        }
+        frames[i * 2] = toPlayerSample(frames[i * 2] * _gain);
+        frames[i * 2 + 1] = toPlayerSample(frames[i * 2 + 1] * _gain);
+    }
+}
@@ -0,0 +1,84 @@
+//
+// Created by Frederic on 27/05/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_TRACKRENDERER_H
+#define MINI_SOUND_SYSTEM_TRACKRENDERER_H
+
+#include "audio/PcmPages.h"
+#include "audio/ReadHead.h"
+#include "audio/SampleType.h"
+#include "dsp/Equalizer.h"
+
+/**
+ * Processing chain producing the output of the player from the decoded track : reads interleaved
+ * stereo frames at the play position, at the rate of the read head, applies the equalizer then the
+ * gain.
+ *
+ * Used by the audio thread of the player and by offline rendering, so both output the same
+ * samples. It doesn't depend on any audio API.
+ */
+class TrackRenderer {
+public:
+    /**
+     * @param maxFrames maximum number of frames of a rendered block.
+     */
+    TrackRenderer(int sampleRate, int maxFrames);
+    TrackRenderer& operator=(const TrackRenderer& ) = delete;
+    TrackRenderer(TrackRenderer&) = delete;
+    ~TrackRenderer();
+
+    /**
+     * Render the next block and move the play position.
+     * @param track       frames of the track, frames not extracted yet are silent.
+     * @param totalFrames number of frames of the track.
+     * @param frames      filled with numberFrames frames, with silence after the end of the track.
+     * @return number of frames read from the track.
+     */
+    int render(const PcmPages *track, unsigned int totalFrames,
+               AUDIO_HARDWARE_SAMPLE_TYPE *frames, int numberFrames);
+
+    inline unsigned int getPosition(){
+        return _readHead->getPosition();
+    }
+
+    inline void setPosition(unsigned int position){
+        _readHead->setPosition(position);
+    }
+
+    inline ReadHead* getReadHead(){
+        return _readHead;
+    }
+
+    inline Equalizer* getEqualizer(){
+        return _equalizer;
+    }
+
+    /**
+     * Move the gain linearly to gain during rampFrames frames, 0 to change it immediately.
+     * @param gain linear gain, 1 by default.
+     */
+    void setGain(float gain, int rampFrames);
+
+    inline float getGain(){
+        return _gain;
+    }
+
+private:
+
+    void applyGain(AUDIO_HARDWARE_SAMPLE_TYPE *frames, int numberFrames);
+
+    int _maxFrames;
+
+    // play position in frames
+    ReadHead *_readHead;
+
+    Equalizer *_equalizer;
+
+    float _gain;
+    float _targetGain;
+    float _gainStep;
+    int _gainRampFrames;
+};
+
+#endif //MINI_SOUND_SYSTEM_TRACKRENDERER_H
@@ -0,0 +1,201 @@
+#include "WavWriter.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <utils/android_debug.h>
+#include <utils/ThreadPolicy.h>
+
+#define WAV_FORMAT_PCM 1
+#define WAV_FORMAT_IEEE_FLOAT 3
+
+// a block of this size tells the writer thread to stop
+#define END_OF_STREAM_BLOCK_SIZE 0
+
+// WAV files are little endian, like all supported ABIs
+static void putUint32(unsigned char *dst, uint32_t value) {
+    memcpy(dst, &value, sizeof(value));
+}
+
+static void putUint16(unsigned char *dst, uint16_t value) {
+    memcpy(dst, &value, sizeof(value));
+}
+
+WavWriter::WavWriter() :
+        _fd(-1),
+        _sampleRate(0),
+        _numberChannels(0),
+        _isFloat(false),
+        _dataSize(0),
+        _isOpen(false),
+        _hasError(false),
+        _currentBlock(0) {
+    for (int i = 0; i < WAV_WRITER_NUMBER_BLOCKS; i++) {
+        _blocks[i] = (unsigned char *) malloc(WAV_WRITER_BLOCK_SIZE);
+        _blockSizes[i] = 0;
+    }
+}
+
+WavWriter::~WavWriter() {
+    close();
+    for (int i = 0; i < WAV_WRITER_NUMBER_BLOCKS; i++) {
+        free(_blocks[i]);
+    }
+}
+
+bool WavWriter::open(const char *path, int sampleRate, int numberChannels, bool isFloat) {
+    if (_isOpen) {
+        return false;
+    }
+
+    _fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (_fd < 0) {
+        LOGE("Can't create wav file %s", path);
+        return false;
+    }
+
+    _sampleRate = sampleRate;
+    _numberChannels = numberChannels;
+    _isFloat = isFloat;
+    _dataSize = 0;
+    _hasError = false;
+
+    // real sizes are written when closing
+    if (!writeHeader(0) || lseek(_fd, WAV_HEADER_SIZE, SEEK_SET) != WAV_HEADER_SIZE) {
+        ::close(_fd);
+        _fd = -1;
+        return false;
+    }
+
+    _currentBlock = 0;
+    _blockSizes[0] = 0;
+    sem_init(&_freeBlocks, 0, WAV_WRITER_NUMBER_BLOCKS - 1);
+    sem_init(&_filledBlocks, 0, 0);
+    pthread_create(&_thread, nullptr, writerThread, this);
+    _isOpen = true;
+    return true;
+}
+
+bool WavWriter::write(const void *data, unsigned int numberBytes) {
+    if (!_isOpen || _hasError) {
+        return false;
+    }
+
+    const unsigned char *src = (const unsigned char *) data;
+    while (numberBytes > 0) {
+        unsigned int blockSize = _blockSizes[_currentBlock];
+        unsigned int size = WAV_WRITER_BLOCK_SIZE - blockSize;
+        if (size > numberBytes) {
+            size = numberBytes;
+        }
+        memcpy(_blocks[_currentBlock] + blockSize, src, size);
+        _blockSizes[_currentBlock] = blockSize + size;
+        src += size;
+        numberBytes -= size;
+        _dataSize += size;
+
+        if (_blockSizes[_currentBlock] == WAV_WRITER_BLOCK_SIZE) {
+            submitBlock();
+        }
+    }
+    return true;
+}
+
+void WavWriter::submitBlock() {
+    sem_post(&_filledBlocks);
+    // wait for the writer thread only when it is late by all blocks
+    sem_wait(&_freeBlocks);
+    _currentBlock = (_currentBlock + 1) % WAV_WRITER_NUMBER_BLOCKS;
+    _blockSizes[_currentBlock] = 0;
+}
+
+bool WavWriter::close() {
+    if (!_isOpen) {
+        return false;
+    }
+
+    if (_blockSizes[_currentBlock] > 0) {
+        submitBlock();
+    }
+    _blockSizes[_currentBlock] = END_OF_STREAM_BLOCK_SIZE;
+    sem_post(&_filledBlocks);
+    pthread_join(_thread, nullptr);
+
+    sem_destroy(&_freeBlocks);
+    sem_destroy(&_filledBlocks);
+    _isOpen = false;
+
+    bool success = !_hasError && writeHeader(_dataSize);
+    if (::close(_fd) != 0) {
+        success = false;
+    }
+    _fd = -1;
+    return success;
+}
+
+void* WavWriter::writerThread(void *data) {
+    WavWriter *self = static_cast<WavWriter *>(data);
+    self->writeBlocks();
+    return nullptr;
+}
+
+void WavWriter::writeBlocks() {
+    uint32_t policyGeneration = 0;
+    refreshThreadPolicy(kThreadRoleIo, &policyGeneration);
+
+    int block = 0;
+    while (true) {
+        sem_wait(&_filledBlocks);
+        const unsigned int blockSize = _blockSizes[block];
+        if (blockSize == END_OF_STREAM_BLOCK_SIZE) {
+            return;
+        }
+
+        unsigned int written = 0;
+        while (!_hasError && written < blockSize) {
+            ssize_t result = ::write(_fd, _blocks[block] + written, blockSize - written);
+            if (result <= 0) {
+                LOGE("Error while writing wav file");
+                _hasError = true;
+            } else {
+                written += result;
+            }
+        }
+
+        block = (block + 1) % WAV_WRITER_NUMBER_BLOCKS;
+        sem_post(&_freeBlocks);
+    }
+}
+
+bool WavWriter::writeHeader(uint32_t dataSize) {
+    return writeWavHeader(_fd, _sampleRate, _numberChannels, _isFloat, dataSize);
+}
+
+bool writeWavHeader(int fd, int sampleRate, int numberChannels, bool isFloat, uint32_t dataSize) {
+    const uint16_t bytesPerSample = isFloat ? 4 : 2;
+    unsigned char header[WAV_HEADER_SIZE];
+
+    memcpy(header, "RIFF", 4);
+    putUint32(header + 4, WAV_HEADER_SIZE - 8 + dataSize);
+    memcpy(header + 8, "WAVE", 4);
+
+    memcpy(header + 12, "fmt ", 4);
+    putUint32(header + 16, 16);
+    putUint16(header + 20, isFloat ? WAV_FORMAT_IEEE_FLOAT : WAV_FORMAT_PCM);
+    putUint16(header + 22, (uint16_t) numberChannels);
+    putUint32(header + 24, (uint32_t) sampleRate);
+    putUint32(header + 28, (uint32_t) sampleRate * numberChannels * bytesPerSample);
+    putUint16(header + 32, (uint16_t) (numberChannels * bytesPerSample));
+    putUint16(header + 34, (uint16_t) (bytesPerSample * 8));
+
+    memcpy(header + 36, "data", 4);
+    putUint32(header + 40, dataSize);
+
+    if (pwrite(fd, header, WAV_HEADER_SIZE, 0) != WAV_HEADER_SIZE) {
+        LOGE("Can't write wav header");
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,92 @@
+//
+// Created by Frederic on 27/05/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_WAVWRITER_H
+#define MINI_SOUND_SYSTEM_WAVWRITER_H
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdint.h>
+
+// blocks of samples handed to the writer thread
+#define WAV_WRITER_NUMBER_BLOCKS 8
+#define WAV_WRITER_BLOCK_SIZE (64 * 1024)
+
+#define WAV_HEADER_SIZE 44
+
+/**
+ * Write the header of a WAV file at the start of fd, whose samples follow the header.
+ * @param isFloat true for 32 bits float samples, 16 bits integer samples otherwise.
+ */
+bool writeWavHeader(int fd, int sampleRate, int numberChannels, bool isFloat, uint32_t dataSize);
+
+/**
+ * Write a WAV file with a dedicated thread, so the thread producing samples never waits for the
+ * storage unless all blocks are full.
+ */
+class WavWriter {
+public:
+    WavWriter();
+    WavWriter& operator=(const WavWriter& ) = delete;
+    WavWriter(WavWriter&) = delete;
+    ~WavWriter();
+
+    /**
+     * Create the file and start the writer thread.
+     * @param isFloat true for 32 bits float samples, 16 bits integer samples otherwise.
+     */
+    bool open(const char *path, int sampleRate, int numberChannels, bool isFloat);
+
+    /**
+     * Copy samples to the current block, full blocks are written by the writer thread.
+     * @return false if the file is not open or if an error occurred while writing.
+     */
+    bool write(const void *data, unsigned int numberBytes);
+
+    /**
+     * Write remaining samples, stop the writer thread and complete the header.
+     * @return false if an error occurred while writing.
+     */
+    bool close();
+
+    inline uint32_t getDataSize(){
+        return _dataSize;
+    }
+
+private:
+
+    static void* writerThread(void *data);
+
+    void writeBlocks();
+
+    // hand the block being filled to the writer thread
+    void submitBlock();
+
+    bool writeHeader(uint32_t dataSize);
+
+    int _fd;
+
+    int _sampleRate;
+    int _numberChannels;
+    bool _isFloat;
+
+    uint32_t _dataSize;
+
+    pthread_t _thread;
+    bool _isOpen;
+
+    // set by the writer thread
+    volatile bool _hasError;
+
+    unsigned char *_blocks[WAV_WRITER_NUMBER_BLOCKS];
+    unsigned int _blockSizes[WAV_WRITER_NUMBER_BLOCKS];
+
+    // block filled by write, owned by the producer until submitted
+    int _currentBlock;
+
+    sem_t _freeBlocks;
+    sem_t _filledBlocks;
+};
+
+#endif //MINI_SOUND_SYSTEM_WAVWRITER_H
@@ -28,6 +28,8 @@
 
 #include "ExtractorNougat.h"
 
+#include <utils/Tracer.h>
+
 //FILE* file;
 
 static double now_ms(void) {
@@ -36,10 +38,14 @@ static double now_ms(void) {
     return 1000.0 * res.tv_sec + (double) res.tv_nsec / 1e6;
 }
 
-void doCodecWork(workerdata *d) {
+static void postCodecWork(workerdata *d);
+
+static bool doCodecWork(workerdata *d) {
+    TRACE_SCOPE("doCodecWork");
 
     ssize_t bufidx;
     if (!d->sawInputEOS) {
+        TRACE_SCOPE("codecInput");
         bufidx = AMediaCodec_dequeueInputBuffer(d->codec, 1000);
         if (bufidx >= 0) {
             size_t bufsize;
@@ -60,24 +66,21 @@ void doCodecWork(workerdata *d) {
     }
 
     if (!d->sawOutputEOS) {
+        TRACE_SCOPE("codecOutput");
         AMediaCodecBufferInfo info;
         auto status = AMediaCodec_dequeueOutputBuffer(d->codec, &info, 1000);
         if (status >= 0) {
-            if (info.flags & AMEDIACODEC_BUFFER_FLAG_END_OF_STREAM) {
-                LOGI("Extraction nougat duration : %f", now_ms() - d->extractionTimeStart);
-                d->sawOutputEOS = true;
-                d->soundSystem->notifyExtractionEnded();
-            }
-
             // get extracted data from output buffer
             if (!d->renderonce) {
-                int nbChannel = 2;
                 size_t bufsize;
                 auto *buf = AMediaCodec_getOutputBuffer(d->codec, status, &bufsize);
-                memcpy(d->extractedData + d->extractionPosition,
-                       reinterpret_cast<AUDIO_HARDWARE_SAMPLE_TYPE *>(buf),
-                       bufsize / nbChannel);
-                d->extractionPosition += bufsize / nbChannel / sizeof(AUDIO_HARDWARE_SAMPLE_TYPE);
+                // 16 bits samples in the layout of the file, only info.size bytes are decoded
+                unsigned int numberSamples = info.size / sizeof(short);
+                d->soundSystem->appendDecodedSamples(
+                        reinterpret_cast<const short *>(buf + info.offset),
+                        numberSamples / d->numberChannels);
+                d->extractionPosition += numberSamples;
+                TRACE_COUNTER("extractedFrames", d->extractedData->getNumberFrames());
 
                 /*fwrite(reinterpret_cast<AUDIO_HARDWARE_SAMPLE_TYPE *>(buf),
                             sizeof(AUDIO_HARDWARE_SAMPLE_TYPE),
@@ -86,9 +89,15 @@ void doCodecWork(workerdata *d) {
             }
 
             AMediaCodec_releaseOutputBuffer(d->codec, status, false);
+
+            // the last buffer can hold frames
+            if (info.flags & AMEDIACODEC_BUFFER_FLAG_END_OF_STREAM) {
+                LOGI("Extraction nougat duration : %f", now_ms() - d->extractionTimeStart);
+                d->sawOutputEOS = true;
+                d->soundSystem->completeExtraction();
+            }
             if (d->renderonce) {
                 d->renderonce = false;
-                return;
             }
 
         } else if (status == AMEDIACODEC_INFO_OUTPUT_BUFFERS_CHANGED) {
@@ -96,6 +105,12 @@ void doCodecWork(workerdata *d) {
         } else if (status == AMEDIACODEC_INFO_OUTPUT_FORMAT_CHANGED) {
             auto format = AMediaCodec_getOutputFormat(d->codec);
             LOGV("format changed to: %s", AMediaFormat_toString(format));
+            int32_t numberChannels;
+            if (AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_CHANNEL_COUNT, &numberChannels)
+                && numberChannels > 0) {
+                d->numberChannels = numberChannels;
+                d->soundSystem->setDecodedNumberChannels(numberChannels);
+            }
             AMediaFormat_delete(format);
         } else if (status == AMEDIACODEC_INFO_TRY_AGAIN_LATER) {
             LOGV("no output buffer right now");
@@ -104,69 +119,79 @@ void doCodecWork(workerdata *d) {
         }
     }
 
-    if (!d->sawInputEOS || !d->sawOutputEOS) {
-        mlooper->post(kMsgCodecBuffer, d);
-    }
+    return !d->sawInputEOS || !d->sawOutputEOS;
 }
 
-void MyLooper::handle(int what, void *obj) {
-    switch (what) {
-        case kMsgCodecBuffer:
-            doCodecWork((workerdata *) obj);
-            break;
-        case kMsgDecodeDone: {
-            workerdata *d = (workerdata *) obj;
-            AMediaCodec_stop(d->codec);
-            AMediaCodec_delete(d->codec);
-            AMediaExtractor_delete(d->ex);
-            d->sawInputEOS = true;
-            d->sawOutputEOS = true;
-        }
-            break;
-        case kMsgPause: {
-            workerdata *d = (workerdata *) obj;
-            if (d->isPlaying) {
-                // flush all outstanding codecbuffer messages with a no-op message
-                d->isPlaying = false;
-                post(kMsgPauseAck, NULL, true);
-            }
-        }
-            break;
-        case kMsgResume: {
-            workerdata *d = (workerdata *) obj;
-            if (!d->isPlaying) {
-                d->isPlaying = true;
-                post(kMsgCodecBuffer, d);
-            }
-        }
-            break;
+static void codecWorkTask(void *data) {
+    workerdata *d = (workerdata *) data;
+    if (d->isCancelled) {
+        return;
+    }
+    const double startTime = now_ms();
+    const bool hasWork = doCodecWork(d);
+    d->workMs += now_ms() - startTime;
+
+    // a single step of the extraction is queued at a time
+    if (hasWork && !d->isCancelled) {
+        postCodecWork(d);
     }
 }
 
-ExtractorNougat::ExtractorNougat(SoundSystem *soundSystem, const unsigned short frameRate):
-        _frameRate(frameRate){
-    data.soundSystem = soundSystem;
+static void postCodecWork(workerdata *d) {
+    // the played track is extracted before the cued ones and before the analysis of the library
+    d->priority = d->soundSystem->isPlaying() ? kTaskPriorityPlaying : kTaskPriorityCued;
+    d->threadPool->post(codecWorkTask, d, d->priority, d);
+}
+
+ExtractorNougat::ExtractorNougat(SoundSystem *soundSystem, ThreadPool *threadPool,
+                                 const unsigned short frameRate):
+        _frameRate(frameRate),
+        _isExtracting(false){
+    memset(&_data, 0, sizeof(_data));
+    _data.soundSystem = soundSystem;
+    _data.threadPool = threadPool;
     //file = fopen("/sdcard/Music/sample", "w+");
 }
 
 // shut down the native media system
 ExtractorNougat::~ExtractorNougat() {
-    if (mlooper) {
-        mlooper->post(kMsgDecodeDone, &data, true /* flush */);
-        mlooper->quit();
-        delete mlooper;
-        mlooper = NULL;
+    stop();
+}
+
+void ExtractorNougat::stop() {
+    if (!_isExtracting) {
+        return;
     }
+    workerdata *d = &_data;
+    d->isCancelled = true;
+    // the queued step is dropped, the running one ends without posting another one
+    d->threadPool->cancel(d);
+    d->threadPool->waitIdle(d);
+
+    if (!d->sawOutputEOS) {
+        LOGI("Extraction nougat cancelled after %f ms of decoding", d->workMs);
+        d->threadPool->reportCancelledJob(d->priority, d->workMs);
+    }
+    AMediaCodec_stop(d->codec);
+    AMediaCodec_delete(d->codec);
+    AMediaExtractor_delete(d->ex);
+    d->codec = nullptr;
+    d->ex = nullptr;
+    _isExtracting = false;
 }
 
 bool ExtractorNougat::extract(const char *filename) {
+    // a single extraction writes to the extracted data at a time
+    stop();
+
     AMediaExtractor *ex = AMediaExtractor_new();
 
     media_status_t err = AMediaExtractor_setDataSource(ex, filename);
-    workerdata *d = &data;
+    workerdata *d = &_data;
 
     if (err != AMEDIA_OK) {
         LOGV("setDataSource error: %d", err);
+        AMediaExtractor_delete(ex);
         return false;
     }
 
@@ -182,8 +207,7 @@ bool ExtractorNougat::extract(const char *filename) {
         const char *mime;
         if (!AMediaFormat_getString(format, AMEDIAFORMAT_KEY_MIME, &mime)) {
             LOGV("no mime type");
-            return false;
-        } else if (strncmp(mime, "audio/", 6) == 0) {
+        } else if (codec == NULL && strncmp(mime, "audio/", 6) == 0) {
             extractMetadata(format);
             // Omitting most error handling for clarity.
             // Production code should check for errors.
@@ -194,7 +218,6 @@ bool ExtractorNougat::extract(const char *filename) {
             d->codec = codec;
             d->sawInputEOS = false;
             d->sawOutputEOS = false;
-            d->isPlaying = false;
             d->renderonce = true;
             AMediaCodec_start(codec);
 
@@ -205,40 +228,40 @@ bool ExtractorNougat::extract(const char *filename) {
         AMediaFormat_delete(format);
     }
 
-    mlooper = new MyLooper();
-    mlooper->post(kMsgCodecBuffer, d);
-
-    setPlayingStreamingMediaPlayer(true);
+    if (codec == NULL) {
+        LOGE("No audio track in %s", filename);
+        AMediaExtractor_delete(ex);
+        return false;
+    }
 
+    d->isCancelled = false;
+    d->workMs = 0;
     d->extractionTimeStart = now_ms();
+    _isExtracting = true;
+    postCodecWork(d);
 
     return true;
 }
 
 void ExtractorNougat::extractMetadata(AMediaFormat *format) {
     // extract track information
+    _number_channels = 2;
     AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_CHANNEL_COUNT, &_number_channels);
+    if (_number_channels <= 0) {
+        _number_channels = 2;
+    }
+    _data.numberChannels = _number_channels;
+    _data.soundSystem->setDecodedNumberChannels(_number_channels);
     AMediaFormat_getInt64(format, AMEDIAFORMAT_KEY_DURATION, &_duration);
     AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_SAMPLE_RATE, &_file_sample_rate);
 
     // duration is in micro seconds
     _totalFrames = (unsigned int) (((double) _duration * (double) _frameRate / 1000000.0));
 
-    data.extractedData = (AUDIO_HARDWARE_SAMPLE_TYPE*) calloc(_totalFrames * _number_channels, sizeof(AUDIO_HARDWARE_SAMPLE_TYPE));
-    data.soundSystem->setExtractedData(data.extractedData);
-    data.soundSystem->setTotalNumberFrames(_totalFrames);
-}
-
-// set the playing state for the streaming media player
-void ExtractorNougat::setPlayingStreamingMediaPlayer(const bool isPlaying) {
-    LOGV("@@@ playpause: %d", isPlaying);
-    if (mlooper) {
-        if (isPlaying) {
-            mlooper->post(kMsgResume, &data);
-        } else {
-            mlooper->post(kMsgPause, &data);
-        }
-    }
+    // the duration is only an estimate, pages grow with the extracted frames
+    _data.extractedData = new PcmPages();
+    _data.soundSystem->setExtractedData(_data.extractedData);
+    _data.soundSystem->setTotalNumberFrames(_totalFrames);
 }
 
 #endif
\ No newline at end of file
@@ -13,53 +13,53 @@
 #include <unistd.h>
 
 #include <audio/SoundSystem.h>
+#include <utils/ThreadPool.h>
 
-#include "Looper.h"
 #include "media/NdkMediaCodec.h"
 #include "media/NdkMediaExtractor.h"
 
 typedef struct {
+    // decoding steps of the extraction are tasks of this pool, owned by the worker data
+    ThreadPool *threadPool;
+
     AMediaExtractor *ex;
     AMediaCodec *codec;
 
     bool sawInputEOS;
     bool sawOutputEOS;
-    bool isPlaying;
     bool renderonce;
+    // set by stop, the next decoding step is not posted anymore
+    volatile bool isCancelled;
 
     SoundSystem* soundSystem;
-    AUDIO_HARDWARE_SAMPLE_TYPE* extractedData;
+    PcmPages* extractedData;
+    // channels of the decoded frames
+    int numberChannels;
 
     double extractionTimeStart;
     bool isBufferInitialized;
     unsigned int extractionPosition;
 
-} workerdata;
-
-enum {
-    kMsgCodecBuffer,
-    kMsgPause,
-    kMsgResume,
-    kMsgPauseAck,
-    kMsgDecodeDone,
-};
-
-class MyLooper : public Looper {
-    virtual void handle(int what, void *obj);
-};
+    // time spent in the decoding steps, wasted if the extraction is stopped before its end
+    double workMs;
+    // priority of the last decoding step
+    int priority;
 
-static MyLooper *mlooper = NULL;
-static workerdata data = {NULL, NULL, false, false, false, false, NULL};
+} workerdata;
 
 class ExtractorNougat{
 public:
 
-    ExtractorNougat(SoundSystem* soundSystem, const unsigned short frameRate);
+    ExtractorNougat(SoundSystem* soundSystem, ThreadPool* threadPool,
+                    const unsigned short frameRate);
     ~ExtractorNougat();
 
-    void setPlayingStreamingMediaPlayer(const bool isPlaying);
     bool extract(const char* filename);
 
+    // stop the current extraction, its extracted data are not written anymore and its codec is
+    // released once it returns
+    void stop();
+
     void extractMetadata(AMediaFormat *format);
 
 private:
@@ -70,6 +70,9 @@ private:
     int64_t _duration;
     const unsigned short _frameRate;
 
+    // decoding steps run on the workers of the pool, several extractions run at the same time
+    bool _isExtracting;
+    workerdata _data;
 };
 
 #endif //MINI_SOUND_SYSTEM_EXTRACTORNOUGAT_H
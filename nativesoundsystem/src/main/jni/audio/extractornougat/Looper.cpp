@@ -1,121 +0,0 @@
-/*
- * Copyright (C) 2014 The Android Open Source Project
- *
- * Licensed under the Apache License, Version 2.0 (the "License");
- * you may not use this file except in compliance with the License.
- * You may obtain a copy of the License at
- *
- *      http://www.apache.org/licenses/LICENSE-2.0
- *
- * Unless required by applicable law or agreed to in writing, software
- * distributed under the License is distributed on an "AS IS" BASIS,
- * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
- * See the License for the specific language governing permissions and
- * limitations under the License.
- */
-
-#ifdef MEDIACODEC_EXTRACTOR
-
-#include "Looper.h"
-
-void* Looper::trampoline(void* p) {
-    ((Looper*)p)->loop();
-    return NULL;
-}
-
-Looper::Looper() {
-    sem_init(&headdataavailable, 0, 0);
-    sem_init(&headwriteprotect, 0, 1);
-    pthread_attr_t attr;
-    pthread_attr_init(&attr);
-
-    pthread_create(&worker, &attr, trampoline, this);
-    running = true;
-}
-
-
-Looper::~Looper() {
-    if (running) {
-        LOGV("Looper deleted while still running. Some messages will not be processed");
-        quit();
-    }
-}
-
-void Looper::post(int what, void *data, bool flush) {
-    LooperMessage *msg = new LooperMessage();
-    msg->what = what;
-    msg->obj = data;
-    msg->next = NULL;
-    msg->quit = false;
-    addmsg(msg, flush);
-}
-
-void Looper::addmsg(LooperMessage *msg, bool flush) {
-    sem_wait(&headwriteprotect);
-    LooperMessage *h = head;
-
-    if (flush) {
-        while(h) {
-            LooperMessage *next = h->next;
-            delete h;
-            h = next;
-        }
-        h = NULL;
-    }
-    if (h) {
-        while (h->next) {
-            h = h->next;
-        }
-        h->next = msg;
-    } else {
-        head = msg;
-    }
-    //LOGV("post msg %d", msg->what);
-    sem_post(&headwriteprotect);
-    sem_post(&headdataavailable);
-}
-
-void Looper::loop() {
-    while(true) {
-        // wait for available message
-        sem_wait(&headdataavailable);
-
-        // get next available message
-        sem_wait(&headwriteprotect);
-        LooperMessage *msg = head;
-        if (msg == NULL) {
-            sem_post(&headwriteprotect);
-            continue;
-        }
-        head = msg->next;
-        sem_post(&headwriteprotect);
-
-        if (msg->quit) {
-            delete msg;
-            return;
-        }
-        handle(msg->what, msg->obj);
-        delete msg;
-    }
-}
-
-void Looper::quit() {
-    LooperMessage *msg = new LooperMessage();
-    msg->what = 0;
-    msg->obj = NULL;
-    msg->next = NULL;
-    msg->quit = true;
-    addmsg(msg, false);
-    void *retval;
-    pthread_join(worker, &retval);
-    sem_destroy(&headdataavailable);
-    sem_destroy(&headwriteprotect);
-    running = false;
-}
-
-void Looper::handle(int what, void* obj) {
-    LOGV("dropping msg %d %p", what, obj);
-}
-
-#endif
-
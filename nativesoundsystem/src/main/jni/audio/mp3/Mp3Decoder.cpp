@@ -0,0 +1,992 @@
+#include "Mp3Decoder.h"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <utils/android_debug.h>
+
+#include "Mp3Tables.h"
+
+// bytes read from the file at once
+#define MP3_INPUT_BUFFER_SIZE (16 * 1024)
+
+// bits of the first lookup of Huffman codes, longer codes use a second lookup
+#define HUFFMAN_LOOKUP_BITS 8
+#define HUFFMAN_SUBTABLE_FLAG 0x80000000u
+
+// largest value of big values : 15 + 13 linbits
+#define MP3_MAX_QUANTIZED_VALUE (15 + 8191)
+
+#define MP3_MODE_JOINT_STEREO 1
+#define MP3_MODE_MONO 3
+
+#define MP3_BLOCK_SHORT 2
+
+static pthread_once_t tablesOnce = PTHREAD_ONCE_INIT;
+
+// first lookup of each Huffman table, followed by the second lookups
+static uint32_t *huffmanLookups[MP3_NUMBER_HUFFMAN_TABLES];
+
+// |x|^(4/3)
+static float powerTable[MP3_MAX_QUANTIZED_VALUE + 1];
+
+// 2^(i/4)
+static const float quarterPowers[4] = {1.f, 1.18920712f, 1.41421356f, 1.68179283f};
+
+static float imdct36[36][18];
+static float imdct12[12][6];
+
+// windows of the long block types, the short window is in the 12 first values of type 2
+static float imdctWindows[4][36];
+
+static float aliasCs[8];
+static float aliasCa[8];
+
+// gains of the left and right channels for each intensity position
+static float intensityLeft[7];
+static float intensityRight[7];
+
+static float dct32[32][32];
+static float synthesisWindow[512];
+
+static double now_ms(void) {
+    struct timespec res;
+    clock_gettime(CLOCK_REALTIME, &res);
+    return 1000.0 * res.tv_sec + (double) res.tv_nsec / 1e6;
+}
+
+/**
+ * Lookup entries are the length of the code in the low byte and the symbol in the second one,
+ * x in the high nibble and y in the low nibble for big values.
+ * Entries of the first lookup for codes longer than HUFFMAN_LOOKUP_BITS point to a second lookup
+ * indexed by the next bits : offset from the first lookup and number of bits.
+ */
+static uint32_t *buildHuffmanLookup(const Mp3HuffmanTable &table, bool isCount1) {
+    const int numberSymbols = table.size * table.size;
+    const int lookupSize = 1 << HUFFMAN_LOOKUP_BITS;
+
+    int subtableBits[lookupSize];
+    memset(subtableBits, 0, sizeof(subtableBits));
+    for (int s = 0; s < numberSymbols; s++) {
+        const int length = table.lengths[s];
+        if (length > HUFFMAN_LOOKUP_BITS) {
+            const int prefix = table.codes[s] >> (length - HUFFMAN_LOOKUP_BITS);
+            if (length - HUFFMAN_LOOKUP_BITS > subtableBits[prefix]) {
+                subtableBits[prefix] = length - HUFFMAN_LOOKUP_BITS;
+            }
+        }
+    }
+
+    int totalSize = lookupSize;
+    for (int i = 0; i < lookupSize; i++) {
+        if (subtableBits[i] > 0) {
+            totalSize += 1 << subtableBits[i];
+        }
+    }
+
+    uint32_t *lookup = (uint32_t *) calloc((size_t) totalSize, sizeof(uint32_t));
+    int offset = lookupSize;
+    for (int i = 0; i < lookupSize; i++) {
+        if (subtableBits[i] > 0) {
+            lookup[i] = HUFFMAN_SUBTABLE_FLAG | (offset << 8) | subtableBits[i];
+            offset += 1 << subtableBits[i];
+        }
+    }
+
+    for (int s = 0; s < numberSymbols; s++) {
+        const uint32_t symbol = isCount1 ? s : ((s / table.size) << 4) | (s % table.size);
+        const int length = table.lengths[s];
+        const uint32_t code = table.codes[s];
+        if (length <= HUFFMAN_LOOKUP_BITS) {
+            const int unusedBits = HUFFMAN_LOOKUP_BITS - length;
+            for (int i = 0; i < (1 << unusedBits); i++) {
+                lookup[(code << unusedBits) + i] = (symbol << 8) | length;
+            }
+        } else {
+            const int remainingBits = length - HUFFMAN_LOOKUP_BITS;
+            const uint32_t subtable = lookup[code >> remainingBits];
+            const int bits = subtable & 0xFF;
+            const int base = (subtable >> 8) & 0x7FFFFF;
+            const int unusedBits = bits - remainingBits;
+            const uint32_t suffix = code & ((1 << remainingBits) - 1);
+            for (int i = 0; i < (1 << unusedBits); i++) {
+                lookup[base + (suffix << unusedBits) + i] = (symbol << 8) | remainingBits;
+            }
+        }
+    }
+    return lookup;
+}
+
+static void initTables() {
+    for (int i = 0; i < MP3_NUMBER_HUFFMAN_TABLES; i++) {
+        const Mp3HuffmanTable &table = mp3HuffmanTables[i];
+        if (table.codes == nullptr) {
+            continue;
+        }
+        // big values tables with linbits share the codes of tables 16 and 24
+        for (int j = 0; j < i && huffmanLookups[i] == nullptr; j++) {
+            if (mp3HuffmanTables[j].codes == table.codes) {
+                huffmanLookups[i] = huffmanLookups[j];
+            }
+        }
+        if (huffmanLookups[i] == nullptr) {
+            huffmanLookups[i] = buildHuffmanLookup(table, i >= MP3_COUNT1_TABLE_A);
+        }
+    }
+
+    for (int i = 0; i <= MP3_MAX_QUANTIZED_VALUE; i++) {
+        powerTable[i] = (float) pow((double) i, 4.0 / 3.0);
+    }
+
+    for (int i = 0; i < 36; i++) {
+        for (int k = 0; k < 18; k++) {
+            imdct36[i][k] = (float) cos(M_PI / 72.0 * (2 * i + 19) * (2 * k + 1));
+        }
+    }
+    for (int i = 0; i < 12; i++) {
+        for (int k = 0; k < 6; k++) {
+            imdct12[i][k] = (float) cos(M_PI / 24.0 * (2 * i + 7) * (2 * k + 1));
+        }
+    }
+
+    for (int i = 0; i < 36; i++) {
+        const float longWindow = (float) sin(M_PI / 36.0 * (i + 0.5));
+        imdctWindows[0][i] = longWindow;
+
+        if (i < 18) {
+            imdctWindows[1][i] = longWindow;
+        } else if (i < 24) {
+            imdctWindows[1][i] = 1.f;
+        } else if (i < 30) {
+            imdctWindows[1][i] = (float) sin(M_PI / 12.0 * (i - 18 + 0.5));
+        } else {
+            imdctWindows[1][i] = 0.f;
+        }
+
+        if (i < 6) {
+            imdctWindows[3][i] = 0.f;
+        } else if (i < 12) {
+            imdctWindows[3][i] = (float) sin(M_PI / 12.0 * (i - 6 + 0.5));
+        } else if (i < 18) {
+            imdctWindows[3][i] = 1.f;
+        } else {
+            imdctWindows[3][i] = longWindow;
+        }
+
+        imdctWindows[MP3_BLOCK_SHORT][i] = i < 12 ? (float) sin(M_PI / 12.0 * (i + 0.5)) : 0.f;
+    }
+
+    static const double aliasCoefficients[8] = {-0.6, -0.535, -0.33, -0.185, -0.095, -0.041,
+                                                -0.0142, -0.0037};
+    for (int i = 0; i < 8; i++) {
+        const double norm = sqrt(1.0 + aliasCoefficients[i] * aliasCoefficients[i]);
+        aliasCs[i] = (float) (1.0 / norm);
+        aliasCa[i] = (float) (aliasCoefficients[i] / norm);
+    }
+
+    for (int i = 0; i < 7; i++) {
+        // ratio tan(i * pi / 12) written without the infinite value of i = 6
+        const double s = sin(i * M_PI / 12.0);
+        const double c = cos(i * M_PI / 12.0);
+        intensityLeft[i] = (float) (s / (s + c));
+        intensityRight[i] = (float) (c / (s + c));
+    }
+
+    for (int j = 0; j < 32; j++) {
+        for (int k = 0; k < 32; k++) {
+            dct32[j][k] = (float) cos(M_PI / 64.0 * j * (2 * k + 1));
+        }
+    }
+
+    for (int i = 0; i < 512; i++) {
+        const int32_t value = mp3SynthesisWindow[i <= 256 ? i : 512 - i];
+        synthesisWindow[i] = ((i / 64) % 2 == 0 ? 1.f : -1.f) * (float) value / 65536.f;
+    }
+}
+
+static inline unsigned int peekBits(const uint8_t *data, unsigned int position, int numberBits) {
+    const uint8_t *p = data + (position >> 3);
+    const uint32_t value = ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16)
+                           | ((uint32_t) p[2] << 8) | (uint32_t) p[3];
+    return (value << (position & 7)) >> (32 - numberBits);
+}
+
+static inline unsigned int readBits(const uint8_t *data, unsigned int *position, int numberBits) {
+    if (numberBits == 0) {
+        return 0;
+    }
+    const unsigned int value = peekBits(data, *position, numberBits);
+    *position += numberBits;
+    return value;
+}
+
+static inline unsigned int decodeSymbol(const uint32_t *lookup, const uint8_t *data,
+                                        unsigned int *position) {
+    uint32_t entry = lookup[peekBits(data, *position, HUFFMAN_LOOKUP_BITS)];
+    if (entry & HUFFMAN_SUBTABLE_FLAG) {
+        *position += HUFFMAN_LOOKUP_BITS;
+        const int bits = entry & 0xFF;
+        entry = lookup[((entry >> 8) & 0x7FFFFF) + peekBits(data, *position, bits)];
+    }
+    *position += entry & 0xFF;
+    return (entry >> 8) & 0xFF;
+}
+
+// requantized value of a big value or of a quadruple value, reading its linbits and its sign
+static inline float readValue(const uint8_t *data, unsigned int *position, unsigned int value,
+                              int linbits) {
+    if (value == 0) {
+        return 0.f;
+    }
+    if (value == 15 && linbits > 0) {
+        value += readBits(data, position, linbits);
+    }
+    return readBits(data, position, 1) ? -powerTable[value] : powerTable[value];
+}
+
+// size of the ID3v2 tag at the start of data, 0 if there is none
+static unsigned int getId3TagSize(const uint8_t *data) {
+    if (data[0] != 'I' || data[1] != 'D' || data[2] != '3') {
+        return 0;
+    }
+    const unsigned int size = ((data[6] & 0x7Fu) << 21) | ((data[7] & 0x7Fu) << 14)
+                              | ((data[8] & 0x7Fu) << 7) | (data[9] & 0x7Fu);
+    // footer flag
+    return 10 + size + ((data[5] & 0x10) ? 10 : 0);
+}
+
+Mp3Decoder::Mp3Decoder() {
+    pthread_once(&tablesOnce, initTables);
+    reset();
+}
+
+Mp3Decoder::~Mp3Decoder() {
+}
+
+void Mp3Decoder::reset() {
+    _numberChannels = 0;
+    _fileSampleRate = 0;
+    _numberDecodedFrames = 0;
+    _numberCorruptedGranules = 0;
+    memset(&_stats, 0, sizeof(_stats));
+    _sampleRateIndex = 0;
+    _mainDataBegin = 0;
+    _mainDataSize = 0;
+    memset(_overlap, 0, sizeof(_overlap));
+    memset(_synthesisBuffer, 0, sizeof(_synthesisBuffer));
+    _synthesisOffset[0] = 0;
+    _synthesisOffset[1] = 0;
+}
+
+bool Mp3Decoder::parseHeader(const uint8_t *data, Mp3FrameHeader *header) {
+    const uint32_t h = ((uint32_t) data[0] << 24) | ((uint32_t) data[1] << 16)
+                       | ((uint32_t) data[2] << 8) | (uint32_t) data[3];
+
+    // sync word, MPEG-1 and layer III
+    if ((h >> 21) != 0x7FF || ((h >> 19) & 3) != 3 || ((h >> 17) & 3) != 1) {
+        return false;
+    }
+
+    // free format bitrate is not supported
+    const int bitrateIndex = (h >> 12) & 0xF;
+    const int sampleRateIndex = (h >> 10) & 3;
+    if (bitrateIndex == 0 || bitrateIndex == 15 || sampleRateIndex == 3) {
+        return false;
+    }
+
+    header->sampleRateIndex = sampleRateIndex;
+    header->sampleRate = mp3SampleRates[sampleRateIndex];
+    header->hasCrc = ((h >> 16) & 1) == 0;
+    header->mode = (h >> 6) & 3;
+    header->modeExtension = (h >> 4) & 3;
+    header->numberChannels = header->mode == MP3_MODE_MONO ? 1 : 2;
+    header->frameSize = 144000 * mp3Bitrates[bitrateIndex] / header->sampleRate
+                        + (int) ((h >> 9) & 1);
+    return true;
+}
+
+bool Mp3Decoder::isMp3File(const char *filePath) {
+    const int fd = open(filePath, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    uint8_t data[10];
+    Mp3FrameHeader header;
+    bool isMp3 = false;
+    if (pread(fd, data, sizeof(data), 0) == sizeof(data)) {
+        const unsigned int tagSize = getId3TagSize(data);
+        isMp3 = pread(fd, data, 4, tagSize) == 4 && parseHeader(data, &header);
+    }
+    close(fd);
+    return isMp3;
+}
+
+bool Mp3Decoder::decode(const char *filePath, DecodedBlockCallback callback, void *context,
+                        volatile bool *cancelled) {
+    reset();
+    const double startTime = now_ms();
+
+    // the ID3v2 tag is not read, it can contain large pictures
+    const int fd = open(filePath, O_RDONLY);
+    if (fd < 0) {
+        LOGE("Unable to open %s", filePath);
+        return false;
+    }
+    uint8_t tagHeader[10];
+    const unsigned int tagSize = pread(fd, tagHeader, sizeof(tagHeader), 0) == sizeof(tagHeader)
+                                 ? getId3TagSize(tagHeader) : 0;
+    close(fd);
+    if (!_file.open(filePath, tagSize)) {
+        return false;
+    }
+
+    // padding for the bit reader at the end of the side info of the last frame
+    uint8_t *input = (uint8_t *) calloc(MP3_INPUT_BUFFER_SIZE + MP3_MAIN_DATA_PADDING, 1);
+    short *samples = (short *) malloc(MP3_FRAME_SAMPLES * 2 * sizeof(short));
+
+    unsigned int size = 0;
+    unsigned int offset = 0;
+    bool isEndOfFile = false;
+    bool isFirstFrame = true;
+    bool stoppedByCallback = false;
+
+    while (!*cancelled) {
+        if (size - offset < MP3_MAX_FRAME_SIZE + 4 && !isEndOfFile) {
+            memmove(input, input + offset, size - offset);
+            size -= offset;
+            offset = 0;
+            const unsigned int numberRead = _file.read(input + size, MP3_INPUT_BUFFER_SIZE - size);
+            if (numberRead == 0) {
+                isEndOfFile = true;
+            } else {
+                size += numberRead;
+            }
+            continue;
+        }
+        if (size - offset < 4) {
+            break;
+        }
+
+        Mp3FrameHeader header;
+        if (!parseHeader(input + offset, &header)
+            || (!isFirstFrame && (header.sampleRateIndex != _sampleRateIndex
+                                  || header.numberChannels != _numberChannels))) {
+            offset++;
+            continue;
+        }
+        if (offset + header.frameSize > size) {
+            // truncated last frame
+            if (isEndOfFile) {
+                break;
+            }
+            offset++;
+            continue;
+        }
+
+        if (isFirstFrame) {
+            // a sync word can be found in garbage, the first frame must be followed by another one
+            Mp3FrameHeader nextHeader;
+            if (offset + header.frameSize + 4 <= size
+                && (!parseHeader(input + offset + header.frameSize, &nextHeader)
+                    || nextHeader.sampleRateIndex != header.sampleRateIndex)) {
+                offset++;
+                continue;
+            }
+            isFirstFrame = false;
+            _sampleRateIndex = header.sampleRateIndex;
+            _fileSampleRate = header.sampleRate;
+            _numberChannels = header.numberChannels;
+
+            // the Xing or Info frame written by encoders only contains the length of the file
+            const uint8_t *sideInfo = input + offset + 4 + (header.hasCrc ? 2 : 0);
+            const uint8_t *tag = sideInfo + (header.numberChannels == 1 ? 17 : 32);
+            if (memcmp(tag, "Xing", 4) == 0 || memcmp(tag, "Info", 4) == 0) {
+                offset += header.frameSize;
+                continue;
+            }
+        }
+
+        decodeFrame(input + offset, header, samples);
+        offset += header.frameSize;
+        _numberDecodedFrames++;
+
+        if (!callback(samples, MP3_FRAME_SAMPLES * (unsigned int) _numberChannels, context)) {
+            stoppedByCallback = true;
+            break;
+        }
+    }
+
+    _file.close();
+    free(samples);
+    free(input);
+
+    _stats.decodeMs = now_ms() - startTime;
+    _stats.ioWaitMs = _file.getIoWaitMs();
+    _stats.numberBytesRead = _file.getNumberBytesRead();
+
+    if (_numberCorruptedGranules > 0) {
+        LOGW("%u corrupted granules in %s", _numberCorruptedGranules, filePath);
+    }
+    return !*cancelled && (stoppedByCallback || _numberDecodedFrames > 0);
+}
+
+bool Mp3Decoder::decodeFrame(const uint8_t *frame, const Mp3FrameHeader &header,
+                             short *samples) {
+    const uint8_t *sideInfo = frame + 4 + (header.hasCrc ? 2 : 0);
+    readSideInfo(sideInfo, header);
+
+    const uint8_t *mainData = sideInfo + (header.numberChannels == 1 ? 17 : 32);
+    const int mainDataSize = header.frameSize - (int) (mainData - frame);
+
+    // only the bytes which can be referenced by the next frames are kept
+    if (_mainDataSize > MP3_MAX_MAIN_DATA_BEGIN) {
+        memmove(_mainData, _mainData + _mainDataSize - MP3_MAX_MAIN_DATA_BEGIN,
+                MP3_MAX_MAIN_DATA_BEGIN);
+        _mainDataSize = MP3_MAX_MAIN_DATA_BEGIN;
+    }
+    memcpy(_mainData + _mainDataSize, mainData, (size_t) mainDataSize);
+    const int begin = _mainDataSize - _mainDataBegin;
+    _mainDataSize += mainDataSize;
+    memset(_mainData + _mainDataSize, 0, MP3_MAIN_DATA_PADDING);
+
+    if (begin < 0) {
+        memset(samples, 0, MP3_FRAME_SAMPLES * header.numberChannels * sizeof(short));
+        return false;
+    }
+
+    const uint8_t *data = _mainData + begin;
+    const unsigned int numberBits = (unsigned int) (_mainDataSize - begin) * 8;
+    unsigned int position = 0;
+
+    for (int gr = 0; gr < 2; gr++) {
+        for (int ch = 0; ch < header.numberChannels; ch++) {
+            const unsigned int end = position + _granules[gr][ch].part23Length;
+            bool isValid = end <= numberBits;
+            if (isValid) {
+                readScalefactors(data, &position, gr, ch);
+                isValid = position <= end && readSpectrum(data, position, end, gr, ch);
+            }
+            if (!isValid) {
+                _numberCorruptedGranules++;
+                memset(_spectrum[ch], 0, sizeof(_spectrum[ch]));
+                _nonZeroEnd[ch] = 0;
+            }
+            position = end;
+        }
+
+        if (header.mode == MP3_MODE_JOINT_STEREO && header.modeExtension != 0) {
+            processStereo(gr, header);
+        }
+
+        for (int ch = 0; ch < header.numberChannels; ch++) {
+            if (_granules[gr][ch].blockType == MP3_BLOCK_SHORT) {
+                reorder(gr, ch);
+            }
+            reduceAliases(gr, ch);
+            synthesize(gr, ch, header.numberChannels, samples);
+        }
+    }
+    return true;
+}
+
+void Mp3Decoder::readSideInfo(const uint8_t *data, const Mp3FrameHeader &header) {
+    unsigned int position = 0;
+    _mainDataBegin = readBits(data, &position, 9);
+    position += header.numberChannels == 1 ? 5 : 3;
+
+    for (int ch = 0; ch < header.numberChannels; ch++) {
+        for (int band = 0; band < 4; band++) {
+            _scfsi[ch][band] = readBits(data, &position, 1);
+        }
+    }
+
+    const uint16_t *longBands = mp3LongBands[header.sampleRateIndex];
+    for (int gr = 0; gr < 2; gr++) {
+        for (int ch = 0; ch < header.numberChannels; ch++) {
+            Mp3Granule &granule = _granules[gr][ch];
+            granule.part23Length = readBits(data, &position, 12);
+            granule.bigValues = readBits(data, &position, 9);
+            if (granule.bigValues > 288) {
+                granule.bigValues = 288;
+            }
+            granule.globalGain = readBits(data, &position, 8);
+            granule.scalefacCompress = readBits(data, &position, 4);
+
+            if (readBits(data, &position, 1)) {
+                granule.blockType = readBits(data, &position, 2);
+                granule.mixedBlock = readBits(data, &position, 1) != 0;
+                granule.tableSelect[0] = readBits(data, &position, 5);
+                granule.tableSelect[1] = readBits(data, &position, 5);
+                granule.tableSelect[2] = 0;
+                for (int w = 0; w < 3; w++) {
+                    granule.subblockGain[w] = readBits(data, &position, 3);
+                }
+                // 8 long bands or 3 short bands, 36 samples at every sample rate
+                granule.region1Start = longBands[8];
+                granule.region2Start = 576;
+            } else {
+                granule.blockType = 0;
+                granule.mixedBlock = false;
+                for (int i = 0; i < 3; i++) {
+                    granule.tableSelect[i] = readBits(data, &position, 5);
+                }
+                memset(granule.subblockGain, 0, sizeof(granule.subblockGain));
+                const int region0Count = readBits(data, &position, 4);
+                const int region1Count = readBits(data, &position, 3);
+                granule.region1Start = longBands[region0Count + 1];
+                const int region2Band = region0Count + region1Count + 2;
+                granule.region2Start = longBands[region2Band < 22 ? region2Band : 22];
+            }
+
+            granule.preflag = readBits(data, &position, 1) != 0;
+            granule.scalefacScale = readBits(data, &position, 1);
+            granule.count1Table = readBits(data, &position, 1);
+        }
+    }
+}
+
+void Mp3Decoder::readScalefactors(const uint8_t *data, unsigned int *position, int granule,
+                                  int channel) {
+    const Mp3Granule &g = _granules[granule][channel];
+    const int slen1 = mp3ScalefactorLengths[g.scalefacCompress][0];
+    const int slen2 = mp3ScalefactorLengths[g.scalefacCompress][1];
+    int *longScalefactors = _longScalefactors[channel];
+    int (*shortScalefactors)[3] = _shortScalefactors[channel];
+
+    if (g.blockType == MP3_BLOCK_SHORT) {
+        int firstShortBand = 0;
+        if (g.mixedBlock) {
+            for (int sfb = 0; sfb < 8; sfb++) {
+                longScalefactors[sfb] = readBits(data, position, slen1);
+            }
+            firstShortBand = 3;
+        }
+        for (int sfb = firstShortBand; sfb < 12; sfb++) {
+            for (int w = 0; w < 3; w++) {
+                shortScalefactors[sfb][w] = readBits(data, position, sfb < 6 ? slen1 : slen2);
+            }
+        }
+        for (int w = 0; w < 3; w++) {
+            shortScalefactors[12][w] = 0;
+        }
+        return;
+    }
+
+    // the second granule reuses the scalefactors of the first one for the bands selected by scfsi
+    static const int scfsiBands[5] = {0, 6, 11, 16, 21};
+    for (int band = 0; band < 4; band++) {
+        if (granule == 1 && _scfsi[channel][band]) {
+            continue;
+        }
+        for (int sfb = scfsiBands[band]; sfb < scfsiBands[band + 1]; sfb++) {
+            longScalefactors[sfb] = readBits(data, position, band < 2 ? slen1 : slen2);
+        }
+    }
+    longScalefactors[21] = 0;
+}
+
+bool Mp3Decoder::readSpectrum(const uint8_t *data, unsigned int position, unsigned int end,
+                              int granule, int channel) {
+    const Mp3Granule &g = _granules[granule][channel];
+    const uint16_t *longBands = mp3LongBands[_sampleRateIndex];
+    const uint16_t *shortBands = mp3ShortBands[_sampleRateIndex];
+    const int *longScalefactors = _longScalefactors[channel];
+    int (*shortScalefactors)[3] = _shortScalefactors[channel];
+
+    // gain of each band in the order of the bitstream, in quarters of power of 2
+    unsigned int bandEnds[40];
+    float bandGains[40];
+    int numberBands = 0;
+    const int globalExponent = g.globalGain - 210;
+    const int scalefactorShift = g.scalefacScale ? 4 : 2;
+
+    const bool isShort = g.blockType == MP3_BLOCK_SHORT;
+    const int numberLongBands = isShort ? (g.mixedBlock ? 8 : 0) : 22;
+    for (int sfb = 0; sfb < numberLongBands; sfb++) {
+        const int scalefactor = longScalefactors[sfb] + (g.preflag ? mp3Pretab[sfb] : 0);
+        const int exponent = globalExponent - scalefactorShift * scalefactor;
+        bandEnds[numberBands] = longBands[sfb + 1];
+        bandGains[numberBands] = ldexpf(quarterPowers[exponent & 3], exponent >> 2);
+        numberBands++;
+    }
+    if (isShort) {
+        unsigned int bandEnd = g.mixedBlock ? longBands[8] : 0;
+        for (int sfb = g.mixedBlock ? 3 : 0; sfb < 13; sfb++) {
+            const int width = shortBands[sfb + 1] - shortBands[sfb];
+            for (int w = 0; w < 3; w++) {
+                const int exponent = globalExponent - 8 * g.subblockGain[w]
+                                     - scalefactorShift * shortScalefactors[sfb][w];
+                bandEnd += width;
+                bandEnds[numberBands] = bandEnd;
+                bandGains[numberBands] = ldexpf(quarterPowers[exponent & 3], exponent >> 2);
+                numberBands++;
+            }
+        }
+    }
+
+    float *xr = _spectrum[channel];
+    unsigned int i = 0;
+    unsigned int nonZeroEnd = 0;
+    int band = 0;
+
+    // big values, pairs of values in 3 regions using their own table
+    const unsigned int bigValuesEnd = g.bigValues * 2;
+    for (int region = 0; region < 3 && position <= end; region++) {
+        unsigned int regionEnd = region == 0 ? g.region1Start
+                                             : region == 1 ? g.region2Start : 576;
+        if (regionEnd > bigValuesEnd) {
+            regionEnd = bigValuesEnd;
+        }
+
+        const int tableIndex = g.tableSelect[region];
+        const uint32_t *lookup = huffmanLookups[tableIndex];
+        if (lookup == nullptr) {
+            // table 0 codes zeros without bits
+            for (; i < regionEnd; i++) {
+                xr[i] = 0.f;
+            }
+            continue;
+        }
+
+        const int linbits = mp3HuffmanTables[tableIndex].linbits;
+        while (i < regionEnd && position <= end) {
+            while (i >= bandEnds[band]) {
+                band++;
+            }
+            const unsigned int symbol = decodeSymbol(lookup, data, &position);
+            const float x = readValue(data, &position, symbol >> 4, linbits);
+            const float y = readValue(data, &position, symbol & 0xF, linbits);
+            xr[i] = x * bandGains[band];
+            xr[i + 1] = y * bandGains[band];
+            if (symbol != 0) {
+                nonZeroEnd = i + 2;
+            }
+            i += 2;
+        }
+    }
+    if (position > end) {
+        return false;
+    }
+
+    // quadruples of values -1, 0 or 1 until the end of the part 3
+    const uint32_t *count1Lookup = huffmanLookups[MP3_COUNT1_TABLE_A + g.count1Table];
+    while (i + 4 <= 576 && position < end) {
+        const unsigned int symbol = decodeSymbol(count1Lookup, data, &position);
+        float values[4];
+        for (int j = 0; j < 4; j++) {
+            values[j] = readValue(data, &position, (symbol >> (3 - j)) & 1, 0);
+        }
+        // the last quadruple can be cut by the end of the part 3, it is ignored
+        if (position > end) {
+            break;
+        }
+        for (int j = 0; j < 4; j++, i++) {
+            while (i >= bandEnds[band]) {
+                band++;
+            }
+            xr[i] = values[j] * bandGains[band];
+        }
+        if (symbol != 0) {
+            nonZeroEnd = i;
+        }
+    }
+
+    for (; i < 576; i++) {
+        xr[i] = 0.f;
+    }
+    _nonZeroEnd[channel] = nonZeroEnd;
+
+    // the decoding of a valid granule ends exactly at the end of its part 3
+    return position == end || i == 576;
+}
+
+void Mp3Decoder::processStereo(int granule, const Mp3FrameHeader &header) {
+    const bool isMidSide = (header.modeExtension & 2) != 0;
+    const bool isIntensity = (header.modeExtension & 1) != 0;
+    unsigned int end = _nonZeroEnd[0] > _nonZeroEnd[1] ? _nonZeroEnd[0] : _nonZeroEnd[1];
+
+    if (isIntensity) {
+        processIntensityStereo(granule, isMidSide);
+    } else if (isMidSide) {
+        float *left = _spectrum[0];
+        float *right = _spectrum[1];
+        const float scale = (float) M_SQRT1_2;
+        for (unsigned int i = 0; i < end; i++) {
+            const float mid = left[i];
+            const float side = right[i];
+            left[i] = (mid + side) * scale;
+            right[i] = (mid - side) * scale;
+        }
+    }
+
+    _nonZeroEnd[0] = end;
+    _nonZeroEnd[1] = end;
+}
+
+void Mp3Decoder::processIntensityStereo(int granule, bool isMidSide) {
+    const Mp3Granule &g = _granules[granule][1];
+    const uint16_t *longBands = mp3LongBands[_sampleRateIndex];
+    const uint16_t *shortBands = mp3ShortBands[_sampleRateIndex];
+    float *left = _spectrum[0];
+    float *right = _spectrum[1];
+    const float scale = (float) M_SQRT1_2;
+
+    // bands of the right channel in the order of the bitstream, window -1 for long bands
+    unsigned int bandStarts[40];
+    unsigned int bandEnds[40];
+    int bandScalefactors[40];
+    int bandWindows[40];
+    int bandIndexes[40];
+    int numberBands = 0;
+
+    const bool isShort = g.blockType == MP3_BLOCK_SHORT;
+    const int numberLongBands = isShort ? (g.mixedBlock ? 8 : 0) : 22;
+    for (int sfb = 0; sfb < numberLongBands; sfb++) {
+        bandStarts[numberBands] = longBands[sfb];
+        bandEnds[numberBands] = longBands[sfb + 1];
+        // the last band has no scalefactor and uses the position of the previous one
+        bandScalefactors[numberBands] = _longScalefactors[1][sfb < 21 ? sfb : 20];
+        bandWindows[numberBands] = -1;
+        bandIndexes[numberBands] = sfb;
+        numberBands++;
+    }
+    if (isShort) {
+        unsigned int bandStart = g.mixedBlock ? longBands[8] : 0;
+        for (int sfb = g.mixedBlock ? 3 : 0; sfb < 13; sfb++) {
+            const unsigned int width = shortBands[sfb + 1] - shortBands[sfb];
+            for (int w = 0; w < 3; w++) {
+                bandStarts[numberBands] = bandStart;
+                bandEnds[numberBands] = bandStart + width;
+                bandScalefactors[numberBands] = _shortScalefactors[1][sfb < 12 ? sfb : 11][w];
+                bandWindows[numberBands] = w;
+                bandIndexes[numberBands] = sfb;
+                numberBands++;
+                bandStart += width;
+            }
+        }
+    }
+
+    // last band with a non zero value of the right channel, for the long bands and each window
+    int lastNonZeroBands[4] = {-1, -1, -1, -1};
+    for (int b = 0; b < numberBands; b++) {
+        for (unsigned int i = bandStarts[b]; i < bandEnds[b]; i++) {
+            if (right[i] != 0.f) {
+                lastNonZeroBands[bandWindows[b] + 1] = bandIndexes[b];
+                break;
+            }
+        }
+    }
+    // long bands of a mixed block only use intensity when all the short windows do
+    if (lastNonZeroBands[1] >= 0 || lastNonZeroBands[2] >= 0 || lastNonZeroBands[3] >= 0) {
+        lastNonZeroBands[0] = 22;
+    }
+
+    // bands above the last non zero value of the right channel are coded by intensity
+    for (int b = 0; b < numberBands; b++) {
+        const int position = bandScalefactors[b];
+        if (bandIndexes[b] <= lastNonZeroBands[bandWindows[b] + 1] || position == 7) {
+            if (isMidSide) {
+                for (unsigned int i = bandStarts[b]; i < bandEnds[b]; i++) {
+                    const float mid = left[i];
+                    const float side = right[i];
+                    left[i] = (mid + side) * scale;
+                    right[i] = (mid - side) * scale;
+                }
+            }
+            continue;
+        }
+        for (unsigned int i = bandStarts[b]; i < bandEnds[b]; i++) {
+            const float value = left[i];
+            left[i] = value * intensityLeft[position];
+            right[i] = value * intensityRight[position];
+        }
+    }
+}
+
+void Mp3Decoder::reorder(int granule, int channel) {
+    const Mp3Granule &g = _granules[granule][channel];
+    const uint16_t *shortBands = mp3ShortBands[_sampleRateIndex];
+    float *xr = _spectrum[channel];
+    float reordered[576];
+
+    // windows of a band are consecutive in the bitstream and interleaved for the IMDCT
+    int sfb = g.mixedBlock ? 3 : 0;
+    for (; sfb < 13; sfb++) {
+        const unsigned int start = 3u * shortBands[sfb];
+        if (start >= _nonZeroEnd[channel]) {
+            break;
+        }
+        const int width = shortBands[sfb + 1] - shortBands[sfb];
+        for (int w = 0; w < 3; w++) {
+            for (int i = 0; i < width; i++) {
+                reordered[3 * i + w] = xr[start + w * width + i];
+            }
+        }
+        memcpy(xr + start, reordered, 3 * width * sizeof(float));
+    }
+    _nonZeroEnd[channel] = 3u * shortBands[sfb];
+}
+
+void Mp3Decoder::reduceAliases(int granule, int channel) {
+    const Mp3Granule &g = _granules[granule][channel];
+    if (g.blockType == MP3_BLOCK_SHORT && !g.mixedBlock) {
+        return;
+    }
+    float *xr = _spectrum[channel];
+
+    // butterflies between the last samples of a subband and the first ones of the next subband
+    int numberSubbands = (int) (_nonZeroEnd[channel] + 17) / 18;
+    if (numberSubbands == 0) {
+        return;
+    }
+    int lastBoundary = g.mixedBlock ? 1 : (numberSubbands < 31 ? numberSubbands : 31);
+    for (int sb = 1; sb <= lastBoundary; sb++) {
+        float *lower = xr + 18 * sb - 1;
+        float *upper = xr + 18 * sb;
+        for (int i = 0; i < 8; i++) {
+            const float bu = lower[-i];
+            const float bd = upper[i];
+            lower[-i] = bu * aliasCs[i] - bd * aliasCa[i];
+            upper[i] = bd * aliasCs[i] + bu * aliasCa[i];
+        }
+    }
+    const unsigned int aliasEnd = 18u * lastBoundary + 8;
+    if (aliasEnd > _nonZeroEnd[channel]) {
+        _nonZeroEnd[channel] = aliasEnd;
+    }
+}
+
+void Mp3Decoder::synthesize(int granule, int channel, int numberChannels, short *samples) {
+    const Mp3Granule &g = _granules[granule][channel];
+    const float *xr = _spectrum[channel];
+    const int numberSubbands = (int) (_nonZeroEnd[channel] + 17) / 18;
+
+    // IMDCT of each subband, then overlap with the previous granule
+    float subbandSamples[18][32];
+    for (int sb = 0; sb < 32; sb++) {
+        float *overlap = _overlap[channel] + 18 * sb;
+        float output[18];
+
+        if (sb >= numberSubbands) {
+            for (int t = 0; t < 18; t++) {
+                output[t] = overlap[t];
+                overlap[t] = 0.f;
+            }
+        } else {
+            const float *input = xr + 18 * sb;
+            const int blockType = g.mixedBlock && sb < 2 ? 0 : g.blockType;
+            const float *window = imdctWindows[blockType];
+            float buffer[36];
+
+            if (blockType == MP3_BLOCK_SHORT) {
+                memset(buffer, 0, sizeof(buffer));
+                for (int w = 0; w < 3; w++) {
+                    for (int i = 0; i < 12; i++) {
+                        float sum = 0.f;
+                        for (int k = 0; k < 6; k++) {
+                            sum += input[3 * k + w] * imdct12[i][k];
+                        }
+                        buffer[6 + 6 * w + i] += window[i] * sum;
+                    }
+                }
+            } else {
+                for (int i = 0; i < 36; i++) {
+                    float sum = 0.f;
+                    for (int k = 0; k < 18; k++) {
+                        sum += input[k] * imdct36[i][k];
+                    }
+                    buffer[i] = window[i] * sum;
+                }
+            }
+
+            for (int t = 0; t < 18; t++) {
+                output[t] = buffer[t] + overlap[t];
+                overlap[t] = buffer[18 + t];
+            }
+        }
+
+        // frequency inversion of the odd subbands
+        for (int t = 0; t < 18; t++) {
+            subbandSamples[t][sb] = (sb & t & 1) ? -output[t] : output[t];
+        }
+    }
+
+    // polyphase synthesis of 32 samples from each time slot
+    float *v = _synthesisBuffer[channel];
+    short *out = samples + granule * 576 * numberChannels + channel;
+    for (int t = 0; t < 18; t++) {
+        const int offset = (_synthesisOffset[channel] - 64) & 1023;
+        _synthesisOffset[channel] = offset;
+
+        // V[i] = sum cos((16 + i) (2k + 1) pi / 64) S[k], folded on a DCT of 32 values
+        float a[33];
+        for (int j = 0; j < 32; j++) {
+            float sum = 0.f;
+            for (int k = 0; k < 32; k++) {
+                sum += subbandSamples[t][k] * dct32[j][k];
+            }
+            a[j] = sum;
+        }
+        a[32] = 0.f;
+        for (int i = 0; i < 17; i++) {
+            v[(offset + i) & 1023] = a[16 + i];
+        }
+        for (int i = 17; i < 48; i++) {
+            v[(offset + i) & 1023] = -a[48 - i];
+        }
+        for (int i = 48; i < 64; i++) {
+            v[(offset + i) & 1023] = -a[i - 48];
+        }
+
+        for (int j = 0; j < 32; j++) {
+            float sum = 0.f;
+            for (int i = 0; i < 8; i++) {
+                sum += v[(offset + 128 * i + j) & 1023] * synthesisWindow[64 * i + j];
+                sum += v[(offset + 128 * i + 96 + j) & 1023] * synthesisWindow[64 * i + 32 + j];
+            }
+            int sample = (int) lrintf(sum * 32768.f);
+            if (sample > SHRT_MAX) {
+                sample = SHRT_MAX;
+            } else if (sample < SHRT_MIN) {
+                sample = SHRT_MIN;
+            }
+            out[(32 * t + j) * numberChannels] = (short) sample;
+        }
+    }
+}
+
+static bool benchmarkCallback(const short *, unsigned int, void *) {
+    return true;
+}
+
+double Mp3Decoder::benchmark(const char *filePath, int numberRuns) {
+    Mp3Decoder decoder;
+    volatile bool cancelled = false;
+
+    double ioWaitMs = 0;
+    const double startTime = now_ms();
+    for (int run = 0; run < numberRuns; run++) {
+        if (!decoder.decode(filePath, benchmarkCallback, nullptr, &cancelled)) {
+            LOGE("Unable to decode %s", filePath);
+            return 0;
+        }
+        ioWaitMs += decoder._stats.ioWaitMs;
+    }
+    const double durationMs = now_ms() - startTime;
+
+    const double audioMs = 1000.0 * numberRuns * decoder.getNumberDecodedFrames()
+                           * MP3_FRAME_SAMPLES / decoder.getFileSampleRate();
+    const double realTimeFactor = audioMs / durationMs;
+    // the file is in the page cache after the first run
+    LOGI("Mp3 decoding of %u frames : %f ms per run including %f ms of I/O wait, %fx real time",
+         decoder.getNumberDecodedFrames(), durationMs / numberRuns, ioWaitMs / numberRuns,
+         realTimeFactor);
+    return realTimeFactor;
+}
@@ -0,0 +1,171 @@
+//
+// Created by Frederic on 04/06/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_MP3DECODER_H
+#define MINI_SOUND_SYSTEM_MP3DECODER_H
+
+#include <stdint.h>
+
+#include "audio/AudioDecoder.h"
+#include "audio/ReadAheadFile.h"
+
+// samples per channel of a layer III frame
+#define MP3_FRAME_SAMPLES 1152
+
+// largest frame : 320 kbits/s at 32000 Hz with padding
+#define MP3_MAX_FRAME_SIZE 1441
+
+// main data of a frame starts at most 511 bytes before the frame
+#define MP3_MAX_MAIN_DATA_BEGIN 511
+
+// zeros after the main data, read by the bit reader past the end of a corrupted granule
+#define MP3_MAIN_DATA_PADDING 16
+
+typedef struct {
+    int sampleRateIndex;
+    int sampleRate;
+    int numberChannels;
+    bool hasCrc;
+    // 0 stereo, 1 joint stereo, 2 dual channel, 3 mono
+    int mode;
+    int modeExtension;
+    int frameSize;
+} Mp3FrameHeader;
+
+typedef struct {
+    unsigned int part23Length;
+    unsigned int bigValues;
+    int globalGain;
+    int scalefacCompress;
+    // 0 normal, 1 start, 2 short, 3 stop
+    int blockType;
+    bool mixedBlock;
+    int tableSelect[3];
+    int subblockGain[3];
+    // first sample of the regions 1 and 2 of big values
+    unsigned int region1Start;
+    unsigned int region2Start;
+    bool preflag;
+    int scalefacScale;
+    int count1Table;
+} Mp3Granule;
+
+/**
+ * Software decoder of MPEG-1 layer III files, 32000, 44100 or 48000 Hz.
+ *
+ * Only depends on the C library, so the same decoding runs on Android and on a desktop. The file
+ * is read ahead by a ReadAheadFile and decoded frames are given to the callback as 16 bits samples,
+ * mono or stereo like the file.
+ */
+class Mp3Decoder : public AudioDecoder {
+public:
+    Mp3Decoder();
+    Mp3Decoder& operator=(const Mp3Decoder& ) = delete;
+    Mp3Decoder(Mp3Decoder&) = delete;
+    ~Mp3Decoder();
+
+    /**
+     * Check the first bytes of a file, after an ID3v2 tag.
+     * @return true if they are a MPEG-1 layer III frame header.
+     */
+    static bool isMp3File(const char *filePath);
+
+    bool decode(const char *filePath, DecodedBlockCallback callback, void *context,
+                volatile bool *cancelled) override;
+
+    int getNumberChannels() override {
+        return _numberChannels;
+    }
+
+    int getFileSampleRate() override {
+        return _fileSampleRate;
+    }
+
+    void getDecodeStats(DecodeStats *stats) override {
+        *stats = _stats;
+    }
+
+    inline unsigned int getNumberDecodedFrames(){
+        return _numberDecodedFrames;
+    }
+
+    /**
+     * Decode a file numberRuns times without callback work.
+     * @return number of seconds of audio decoded per second, 0 if the file can not be decoded.
+     */
+    static double benchmark(const char *filePath, int numberRuns);
+
+private:
+
+    /**
+     * @return false if data does not start with a supported frame header.
+     */
+    static bool parseHeader(const uint8_t *data, Mp3FrameHeader *header);
+
+    void reset();
+
+    /**
+     * Decode a frame to MP3_FRAME_SAMPLES interleaved frames.
+     * @return false if the main data of the frame is in frames which have not been read, after a
+     * resynchronisation for example. Samples are silent but the frame keeps the bit reservoir.
+     */
+    bool decodeFrame(const uint8_t *frame, const Mp3FrameHeader &header, short *samples);
+
+    void readSideInfo(const uint8_t *data, const Mp3FrameHeader &header);
+
+    void readScalefactors(const uint8_t *data, unsigned int *position, int granule, int channel);
+
+    /**
+     * Huffman decoding and requantization of the part 3 of a granule.
+     * @return false if the Huffman data do not end at the end of the part 3.
+     */
+    bool readSpectrum(const uint8_t *data, unsigned int position, unsigned int end,
+                      int granule, int channel);
+
+    void processStereo(int granule, const Mp3FrameHeader &header);
+
+    void processIntensityStereo(int granule, bool isMidSide);
+
+    void reorder(int granule, int channel);
+
+    void reduceAliases(int granule, int channel);
+
+    void synthesize(int granule, int channel, int numberChannels, short *samples);
+
+    ReadAheadFile _file;
+    DecodeStats _stats;
+
+    int _numberChannels;
+    int _fileSampleRate;
+    unsigned int _numberDecodedFrames;
+    unsigned int _numberCorruptedGranules;
+
+    int _sampleRateIndex;
+    int _mainDataBegin;
+    int _scfsi[2][4];
+    Mp3Granule _granules[2][2];
+
+    // scalefactors of the current granule, long bands then the 3 windows of short bands
+    int _longScalefactors[2][22];
+    int _shortScalefactors[2][13][3];
+
+    // requantized spectrum of the current granule
+    float _spectrum[2][576];
+
+    // first sample after the last non zero sample of the spectrum
+    unsigned int _nonZeroEnd[2];
+
+    // end of the previous frames and main data of the current frame
+    uint8_t _mainData[MP3_MAX_MAIN_DATA_BEGIN + MP3_MAX_FRAME_SIZE + MP3_MAIN_DATA_PADDING];
+    int _mainDataSize;
+
+    // second half of the IMDCT of each subband, added to the next granule
+    float _overlap[2][576];
+
+    // circular buffer of the 16 last vectors V of the polyphase synthesis
+    float _synthesisBuffer[2][1024];
+    int _synthesisOffset[2];
+};
+
+#endif //MINI_SOUND_SYSTEM_MP3DECODER_H
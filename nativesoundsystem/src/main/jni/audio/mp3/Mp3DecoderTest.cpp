@@ -0,0 +1,103 @@
+// Host test of the software mp3 decoder, run by nativesoundsystem/run_host_tests.sh.
+// host test sources : audio/mp3/Mp3Decoder.cpp audio/mp3/Mp3Tables.cpp audio/ReadAheadFile.cpp utils/ThreadPolicy.cpp utils/Tracer.cpp
+
+#include "Mp3Decoder.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// paths from the root of the repository
+#define TEST_MP3_PATH "app/src/main/assets/sound.mp3"
+// decoded by ffmpeg 7.0 : 16 bits interleaved stereo, encoder delay and padding removed
+#define TEST_REFERENCE_PATH "nativesoundsystem/src/test/data/sound_mp3_reference.s16le"
+
+#define TEST_SAMPLE_RATE 48000
+#define TEST_NUMBER_CHANNELS 2
+
+// a wrong requantization table costs 40 dB or more, rounding differences a few dB
+#define TEST_MIN_SNR_DB 70.
+
+typedef struct {
+    short *samples;
+    unsigned int numberSamples;
+    unsigned int capacity;
+} DecodedSamples;
+
+static bool decodedBlockCallback(const short *samples, unsigned int numberSamples, void *context) {
+    DecodedSamples *decoded = (DecodedSamples *) context;
+    if (decoded->numberSamples + numberSamples > decoded->capacity) {
+        decoded->capacity = (decoded->numberSamples + numberSamples) * 2;
+        decoded->samples = (short *) realloc(decoded->samples, decoded->capacity * sizeof(short));
+        if (decoded->samples == nullptr) {
+            return false;
+        }
+    }
+    memcpy(decoded->samples + decoded->numberSamples, samples, numberSamples * sizeof(short));
+    decoded->numberSamples += numberSamples;
+    return true;
+}
+
+static short *readReference(const char *path, unsigned int *numberSamples) {
+    FILE *file = fopen(path, "rb");
+    if (file == nullptr) {
+        return nullptr;
+    }
+    fseek(file, 0, SEEK_END);
+    const long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    short *samples = (short *) malloc((size_t) size);
+    *numberSamples = samples != nullptr ? (unsigned int) (fread(samples, 1, (size_t) size, file)
+                                                          / sizeof(short)) : 0;
+    fclose(file);
+    return samples;
+}
+
+int main() {
+    Mp3Decoder decoder;
+    DecodedSamples decoded;
+    memset(&decoded, 0, sizeof(decoded));
+    volatile bool cancelled = false;
+    if (!decoder.decode(TEST_MP3_PATH, decodedBlockCallback, &decoded, &cancelled)) {
+        fprintf(stderr, "Can't decode %s\n", TEST_MP3_PATH);
+        return 1;
+    }
+    if (decoder.getFileSampleRate() != TEST_SAMPLE_RATE
+        || decoder.getNumberChannels() != TEST_NUMBER_CHANNELS) {
+        fprintf(stderr, "Decoded %d channels at %d Hz\n", decoder.getNumberChannels(),
+                decoder.getFileSampleRate());
+        return 1;
+    }
+
+    unsigned int numberReferenceSamples = 0;
+    short *reference = readReference(TEST_REFERENCE_PATH, &numberReferenceSamples);
+    if (reference == nullptr) {
+        fprintf(stderr, "Can't read %s\n", TEST_REFERENCE_PATH);
+        return 1;
+    }
+    if (decoded.numberSamples != numberReferenceSamples) {
+        fprintf(stderr, "Decoded %u samples, %u in the reference\n", decoded.numberSamples,
+                numberReferenceSamples);
+        return 1;
+    }
+
+    double signal = 0;
+    double noise = 0;
+    for (unsigned int i = 0; i < numberReferenceSamples; i++) {
+        const double difference = (double) decoded.samples[i] - reference[i];
+        signal += (double) reference[i] * reference[i];
+        noise += difference * difference;
+    }
+    const double snrDb = 10. * log10(signal / (noise > 0 ? noise : 1e-9));
+    printf("Mp3 decoder : %u samples, %.1f dB SNR against the reference\n",
+           decoded.numberSamples, snrDb);
+
+    free(reference);
+    free(decoded.samples);
+    if (snrDb < TEST_MIN_SNR_DB) {
+        fprintf(stderr, "SNR under %.0f dB\n", TEST_MIN_SNR_DB);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,41 @@
+//
+// Created by Frederic on 04/06/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_MP3TABLES_H
+#define MINI_SOUND_SYSTEM_MP3TABLES_H
+
+#include <stdint.h>
+
+// big values tables 0 to 31, then count1 tables A and B
+#define MP3_NUMBER_HUFFMAN_TABLES 34
+#define MP3_COUNT1_TABLE_A 32
+
+typedef struct {
+    // nullptr for the tables which are not used by the standard
+    const uint16_t *codes;
+    const uint8_t *lengths;
+    // values of x and y are lower than size, 4 for count1 tables
+    uint8_t size;
+    uint8_t linbits;
+} Mp3HuffmanTable;
+
+extern const Mp3HuffmanTable mp3HuffmanTables[MP3_NUMBER_HUFFMAN_TABLES];
+
+// first sample of each scalefactor band, for long blocks and for one window of short blocks
+extern const uint16_t mp3LongBands[3][23];
+extern const uint16_t mp3ShortBands[3][14];
+
+extern const uint8_t mp3Pretab[22];
+
+// slen1 and slen2 for each value of scalefac_compress
+extern const uint8_t mp3ScalefactorLengths[16][2];
+
+// kbits/s for each bitrate index of layer III
+extern const uint16_t mp3Bitrates[15];
+
+extern const int mp3SampleRates[3];
+
+extern const int32_t mp3SynthesisWindow[257];
+
+#endif //MINI_SOUND_SYSTEM_MP3TABLES_H
@@ -1,122 +1,229 @@
 #include "SoundsystemEntrypoint.h"
 
-void Java_fr_bowserf_soundsystem_SoundSystem_native_1init_1soundsystem(JNIEnv *env,
-                                                               jclass jclass1,
-                                                               jint sample_rate,
-                                                               jint frames_per_buf) {
-    _soundSystemCallback = new SoundSystemCallback(env, jclass1);
+jlong Java_fr_bowserf_soundsystem_SoundSystem_native_1init_1soundsystem(JNIEnv *env,
+                                                                jclass jclass1,
+                                                                jint sample_rate,
+                                                                jint frames_per_buf) {
+    SoundSystemInstance *instance = new SoundSystemInstance();
+    instance->soundSystemCallback = new SoundSystemCallback(env, jclass1);
+
+    // the workers and the decoded tracks are shared by all instances
+    pthread_mutex_lock(&_instancesMutex);
+    if (_numberInstances == 0) {
+        _decodeThreadPool = new ThreadPool(
+                ThreadPool::getDefaultNumberWorkers(ANALYSIS_MAX_WORKERS), kThreadRoleDecoder,
+                DECODE_RESERVED_WORKERS, kThreadRoleRender);
+        _trackCache = new TrackCache(TRACK_CACHE_DEFAULT_BUDGET_BYTES);
+    }
+    _numberInstances++;
+    pthread_mutex_unlock(&_instancesMutex);
 
-    _soundSystem = new SoundSystem(_soundSystemCallback, sample_rate, frames_per_buf);
+    instance->soundSystem = new SoundSystem(instance->soundSystemCallback, sample_rate,
+                                            frames_per_buf, _trackCache);
 
 #ifdef MEDIACODEC_EXTRACTOR
-    _extractorNougat = new ExtractorNougat(_soundSystem, sample_rate);
+    instance->extractorNougat = new ExtractorNougat(instance->soundSystem, _decodeThreadPool,
+                                                    sample_rate);
 #endif
+
+    instance->libraryScanner = new LibraryScanner(instance->soundSystemCallback,
+                                                  _decodeThreadPool,
+                                                  instance->soundSystem->getEngine(),
+                                                  sample_rate, frames_per_buf);
+
+    instance->duplicateFinder = new DuplicateFinder(instance->soundSystemCallback,
+                                                    _decodeThreadPool,
+                                                    instance->soundSystem->getEngine(),
+                                                    sample_rate, frames_per_buf);
+
+    // computed while tracks are extracted
+    instance->spectrogram = new Spectrogram(instance->soundSystem, _decodeThreadPool,
+                                            SPECTROGRAM_DEFAULT_BUDGET_BYTES);
+
+    // analyzers share a single pass over the frames of the loaded track
+    instance->analysisPipeline = new AnalysisPipeline(instance->soundSystem,
+                                                      instance->soundSystemCallback,
+                                                      _decodeThreadPool);
+    instance->analysisPipeline->addAnalyzer(new PeakAnalyzer());
+    instance->analysisPipeline->addAnalyzer(new RmsAnalyzer());
+    instance->analysisPipeline->addAnalyzer(new SilenceAnalyzer(sample_rate));
+    instance->analysisPipeline->addAnalyzer(new LoudnessAnalyzer(sample_rate));
+    instance->analysisPipeline->addAnalyzer(new OnsetAnalyzer());
+    instance->analysisPipeline->addAnalyzer(new KeyAnalyzer(sample_rate, _decodeThreadPool));
+
+    // blocks of the size of the player buffers
+    instance->audioRecorder = new AudioRecorder(instance->soundSystem->getEngine(), sample_rate,
+                                                frames_per_buf / 2);
+    return (jlong) (intptr_t) instance;
 }
 
 jboolean Java_fr_bowserf_soundsystem_SoundSystem_native_1is_1soundsystem_1init(JNIEnv *env,
-                                                                       jclass jclass1) {
-    return (jboolean)isSoundSystemInit();
+                                                                       jclass jclass1,
+                                                                       jlong handle) {
+    return (jboolean)isSoundSystemInit(handle);
 }
 
 void Java_fr_bowserf_soundsystem_SoundSystem_native_1load_1file(JNIEnv *env,
                                                                jclass jclass1,
+                                                               jlong handle,
                                                                jstring filePath) {
-    if(!isSoundSystemInit()){
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
         return;
     }
+
+    const char *utf8FilePath = env->GetStringUTFChars(filePath, NULL);
+#ifdef MEDIACODEC_EXTRACTOR
+    // extracted data of the previous track are released by the sound system
+    instance->extractorNougat->stop();
+#endif
+
+    // uncompressed files are played from a mapping and recent tracks from the cache, without
+    // extraction
+    SoundSystem *soundSystem = instance->soundSystem;
+    bool isLoaded = (PcmFile::isPcmFile(utf8FilePath) && soundSystem->loadPcmFile(utf8FilePath))
+                    || soundSystem->loadCachedTrack(utf8FilePath);
+    if (!isLoaded) {
+        soundSystem->prepareExtraction(utf8FilePath);
 #ifdef MEDIACODEC_EXTRACTOR
-    const char *urf8FileURLString = env->GetStringUTFChars(filePath, NULL);
-    _extractorNougat->extract(urf8FileURLString);
+        instance->extractorNougat->extract(utf8FilePath);
 #else
-    _soundSystem->extractMusic(dataLocatorFromURLString(env, filePath));
+        soundSystem->extractMusic(dataLocatorFromURLString(env, filePath));
 #endif
-    _soundSystem->initAudioPlayer();
+    }
+    env->ReleaseStringUTFChars(filePath, utf8FilePath);
+    soundSystem->initAudioPlayer();
 }
 
-void Java_fr_bowserf_soundsystem_SoundSystem_native_1play(JNIEnv *env, jclass jclass1, jboolean play){
-    if(!isSoundSystemInit()){
+void Java_fr_bowserf_soundsystem_SoundSystem_native_1play(JNIEnv *env, jclass jclass1, jlong handle, jboolean play){
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
         return;
     }
-    _soundSystem->play(play);
+    instance->soundSystem->play(play);
 }
 
-jboolean Java_fr_bowserf_soundsystem_SoundSystem_native_1is_1playing(JNIEnv *env, jclass jclass1){
-    if(!isSoundSystemInit()){
+jboolean Java_fr_bowserf_soundsystem_SoundSystem_native_1is_1playing(JNIEnv *env, jclass jclass1, jlong handle){
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
         return JNI_FALSE;
     }
-    return (jboolean)_soundSystem->isPlaying();
+    return (jboolean)instance->soundSystem->isPlaying();
 }
 
-jboolean Java_fr_bowserf_soundsystem_SoundSystem_native_1is_1loaded(JNIEnv *env, jclass jclass1){
-    if(!isSoundSystemInit()){
+jboolean Java_fr_bowserf_soundsystem_SoundSystem_native_1is_1loaded(JNIEnv *env, jclass jclass1, jlong handle){
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
         return JNI_FALSE;
     }
-    return (jboolean)_soundSystem->isLoaded();
+    return (jboolean)instance->soundSystem->isLoaded();
+}
+
+jint Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1playing_1position(JNIEnv *env, jclass jclass1, jlong handle){
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return 0;
+    }
+    PlayerState state;
+    instance->soundSystem->getState(&state);
+    return (jint)state.positionFrames;
 }
 
-void Java_fr_bowserf_soundsystem_SoundSystem_native_1stop(JNIEnv *env, jclass jclass1) {
-    if(!isSoundSystemInit()){
+void Java_fr_bowserf_soundsystem_SoundSystem_native_1stop(JNIEnv *env, jclass jclass1, jlong handle) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
         return;
     }
-    _soundSystem->stop();
+    instance->soundSystem->stop();
 }
 
-void Java_fr_bowserf_soundsystem_SoundSystem_native_1extract_1and_1play(JNIEnv *env, jobject obj, jstring filePath){
-    if(!isSoundSystemInit()){
+void Java_fr_bowserf_soundsystem_SoundSystem_native_1extract_1and_1play(JNIEnv *env, jobject obj, jlong handle, jstring filePath){
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
         return;
     }
-    _soundSystem->extractAndPlayDirectly(dataLocatorFromURLString(env, filePath));
+    instance->soundSystem->extractAndPlayDirectly(dataLocatorFromURLString(env, filePath));
 }
 
-void Java_fr_bowserf_soundsystem_SoundSystem_native_1extract_1from_1assets_1and_1play(JNIEnv *env, jobject obj, jobject assetManager, jstring filename){
-    if(!isSoundSystemInit()){
+void Java_fr_bowserf_soundsystem_SoundSystem_native_1extract_1from_1assets_1and_1play(JNIEnv *env, jobject obj, jlong handle, jobject assetManager, jstring filename){
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
         return;
     }
     SLDataLocator_AndroidFD locator = getTrackFromAsset(env, assetManager, filename);
-    _soundSystem->extractAndPlayDirectly(&locator);
+    instance->soundSystem->extractAndPlayDirectly(&locator);
 }
 
-void Java_fr_bowserf_soundsystem_SoundSystem_native_1release_1soundsystem(JNIEnv *env, jclass jclass1) {
-    if (_soundSystem != nullptr) {
-        delete _soundSystem;
-        _soundSystem = nullptr;
+void Java_fr_bowserf_soundsystem_SoundSystem_native_1release_1soundsystem(JNIEnv *env, jclass jclass1, jlong handle) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return;
     }
+    // background analysis decodes with the OpenSL engine of the sound system
+    delete instance->libraryScanner;
+    delete instance->duplicateFinder;
+    // the recorder is created with the OpenSL engine of the sound system
+    delete instance->audioRecorder;
 #ifdef MEDIACODEC_EXTRACTOR
-    if(_extractorNougat!= nullptr){
-        delete _extractorNougat;
-        _extractorNougat = nullptr;
-    }
+    // the extractor writes to the extracted data of the sound system
+    delete instance->extractorNougat;
 #endif
+    // extraction by OpenSL ES sends frames to the analysis until its player is destroyed
+    instance->soundSystem->release();
+    delete instance->analysisPipeline;
+    delete instance->spectrogram;
+    delete instance->soundSystem;
+    delete instance->soundSystemCallback;
+    delete instance;
+
+    pthread_mutex_lock(&_instancesMutex);
+    _numberInstances--;
+    if (_numberInstances == 0) {
+        delete _decodeThreadPool;
+        _decodeThreadPool = nullptr;
+        delete _trackCache;
+        _trackCache = nullptr;
+    }
+    pthread_mutex_unlock(&_instancesMutex);
 }
 
-jshortArray Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1extracted_1data(JNIEnv *env, jclass jclass1) {
-    if(!isSoundSystemInit()){
+jshortArray Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1extracted_1data(JNIEnv *env, jclass jclass1, jlong handle) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
         return nullptr;
     }
-    unsigned int length = _soundSystem->getTotalNumberFrames();
-    AUDIO_HARDWARE_SAMPLE_TYPE* tmpExtractedData = _soundSystem->getExtractedData();
+    PcmPages* pages = instance->soundSystem->getExtractedData();
+    if (pages == nullptr) {
+        return nullptr;
+    }
+    unsigned int length = instance->soundSystem->getTotalNumberFrames();
+    AUDIO_HARDWARE_SAMPLE_TYPE* tmpExtractedData = (AUDIO_HARDWARE_SAMPLE_TYPE*) calloc(
+            length + 1, sizeof(AUDIO_HARDWARE_SAMPLE_TYPE));
+    pages->read(0, tmpExtractedData, (length + 1) / 2);
 
 #ifdef FLOAT_PLAYER
     short* extractedData = (short*)calloc(length, sizeof(short));
     convertFloatDataToShort(tmpExtractedData, length, extractedData);
+    free(tmpExtractedData);
 #else
     short* extractedData = tmpExtractedData;
 #endif
 
     jshortArray jExtractedData = env->NewShortArray(length);
-    if (jExtractedData == nullptr) {
-        return nullptr;
+    if (jExtractedData != nullptr) {
+        env->SetShortArrayRegion(jExtractedData, 0, length, extractedData);
     }
-    env->SetShortArrayRegion(jExtractedData, 0, length, extractedData);
+    free(extractedData);
     return jExtractedData;
 }
 
-jshortArray Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1extracted_1data_1mono(JNIEnv *env, jclass jclass1) {
-    if(!isSoundSystemInit()){
+jshortArray Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1extracted_1data_1mono(JNIEnv *env, jclass jclass1, jlong handle) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
         return nullptr;
     }
-    AUDIO_HARDWARE_SAMPLE_TYPE* tmpExtractedData = _soundSystem->getExtractedDataMono();
-    unsigned int length = _soundSystem->getTotalNumberFrames()/2;
+    AUDIO_HARDWARE_SAMPLE_TYPE* tmpExtractedData = instance->soundSystem->getExtractedDataMono();
+    unsigned int length = instance->soundSystem->getTotalNumberFrames()/2;
 
 #ifdef FLOAT_PLAYER
     short* extractedData = (short*)calloc(length, sizeof(short));
@@ -133,6 +240,776 @@ jshortArray Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1extracted_1data
     return jExtractedData;
 }
 
+jboolean Java_fr_bowserf_soundsystem_SoundSystem_native_1scan_1library(JNIEnv *env, jclass jclass1, jlong handle, jobjectArray filePaths, jstring indexPath) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return JNI_FALSE;
+    }
+    int numberFiles;
+    char** utf8FilePaths = copyJavaStringArray(env, filePaths, &numberFiles);
+    const char *utf8IndexPath = env->GetStringUTFChars(indexPath, NULL);
+
+    bool started = instance->libraryScanner->scan(utf8FilePaths, numberFiles, utf8IndexPath);
+
+    env->ReleaseStringUTFChars(indexPath, utf8IndexPath);
+    freeStringArray(utf8FilePaths, numberFiles);
+    return (jboolean)started;
+}
+
+void Java_fr_bowserf_soundsystem_SoundSystem_native_1cancel_1library_1scan(JNIEnv *env, jclass jclass1, jlong handle) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return;
+    }
+    instance->libraryScanner->cancel();
+}
+
+jfloatArray Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1scanned_1track_1features(JNIEnv *env, jclass jclass1, jstring indexPath, jstring filePath) {
+    const char *utf8IndexPath = env->GetStringUTFChars(indexPath, NULL);
+    const char *utf8FilePath = env->GetStringUTFChars(filePath, NULL);
+
+    FeatureIndex index;
+    const FeatureRecord* record = nullptr;
+    if (index.openForRead(utf8IndexPath)) {
+        record = index.find(utf8FilePath);
+    }
+
+    env->ReleaseStringUTFChars(filePath, utf8FilePath);
+    env->ReleaseStringUTFChars(indexPath, utf8IndexPath);
+
+    if (record == nullptr || record->status != kFeatureStatusOk) {
+        return nullptr;
+    }
+
+    // layout described in SSTrackFeatures
+    const int length = SCANNED_FEATURES_HEADER_SIZE + FEATURE_OVERVIEW_SIZE;
+    float features[length];
+    features[0] = record->durationMs;
+    features[1] = record->sampleRate;
+    features[2] = record->numberChannels;
+    features[3] = record->peak;
+    features[4] = record->rms;
+    features[5] = record->loudness;
+    for (int i = 0; i < FEATURE_OVERVIEW_SIZE; i++) {
+        features[SCANNED_FEATURES_HEADER_SIZE + i] = record->overview[i] / 255.0f;
+    }
+
+    jfloatArray jFeatures = env->NewFloatArray(length);
+    if (jFeatures == nullptr) {
+        return nullptr;
+    }
+    env->SetFloatArrayRegion(jFeatures, 0, length, features);
+    return jFeatures;
+}
+
+jboolean Java_fr_bowserf_soundsystem_SoundSystem_native_1fingerprint_1tracks(JNIEnv *env, jclass jclass1, jlong handle, jobjectArray filePaths) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return JNI_FALSE;
+    }
+    int numberFiles;
+    char** utf8FilePaths = copyJavaStringArray(env, filePaths, &numberFiles);
+    bool started = instance->duplicateFinder->fingerprintTracks(utf8FilePaths, numberFiles);
+    freeStringArray(utf8FilePaths, numberFiles);
+    return (jboolean)started;
+}
+
+void Java_fr_bowserf_soundsystem_SoundSystem_native_1cancel_1fingerprinting(JNIEnv *env, jclass jclass1, jlong handle) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return;
+    }
+    instance->duplicateFinder->cancel();
+}
+
+jobjectArray Java_fr_bowserf_soundsystem_SoundSystem_native_1find_1duplicates(JNIEnv *env, jclass jclass1, jlong handle, jstring filePath) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return nullptr;
+    }
+    const char *utf8FilePath = env->GetStringUTFChars(filePath, NULL);
+    char* duplicatePaths[MAX_DUPLICATES];
+    int numberDuplicates = instance->duplicateFinder->findDuplicates(utf8FilePath, duplicatePaths,
+                                                                     MAX_DUPLICATES);
+    env->ReleaseStringUTFChars(filePath, utf8FilePath);
+    return toJavaStringArray(env, duplicatePaths, numberDuplicates);
+}
+
+jobjectArray Java_fr_bowserf_soundsystem_SoundSystem_native_1find_1loaded_1track_1duplicates(JNIEnv *env, jclass jclass1, jlong handle) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr || instance->soundSystem->getExtractedData() == nullptr){
+        return nullptr;
+    }
+    SoundSystem *soundSystem = instance->soundSystem;
+    // only the start of the track is fingerprinted
+    unsigned int numberFrames = (unsigned int) (FINGERPRINT_DEFAULT_DURATION_S * soundSystem->getSampleRate());
+    if (numberFrames > soundSystem->getTotalNumberFrames()) {
+        numberFrames = soundSystem->getTotalNumberFrames();
+    }
+    AUDIO_HARDWARE_SAMPLE_TYPE* samples = (AUDIO_HARDWARE_SAMPLE_TYPE*) malloc(
+            numberFrames * 2 * sizeof(AUDIO_HARDWARE_SAMPLE_TYPE));
+    if (samples == nullptr) {
+        return nullptr;
+    }
+    soundSystem->getExtractedData()->read(0, samples, numberFrames);
+
+    char* duplicatePaths[MAX_DUPLICATES];
+    int numberDuplicates = instance->duplicateFinder->findDuplicates(samples, numberFrames * 2,
+                                                                     soundSystem->getSampleRate(), 2,
+                                                                     duplicatePaths, MAX_DUPLICATES);
+    free(samples);
+    return toJavaStringArray(env, duplicatePaths, numberDuplicates);
+}
+
+void Java_fr_bowserf_soundsystem_SoundSystem_native_1clear_1fingerprints(JNIEnv *env, jclass jclass1, jlong handle) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return;
+    }
+    instance->duplicateFinder->clear();
+}
+
+void Java_fr_bowserf_soundsystem_SoundSystem_native_1set_1equalizer_1section(JNIEnv *env, jclass jclass1, jlong handle, jint index, jint type, jfloat frequency, jfloat gainDb, jfloat q) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return;
+    }
+    instance->soundSystem->setEqualizerSection(index, type, frequency, gainDb, q);
+}
+
+void Java_fr_bowserf_soundsystem_SoundSystem_native_1set_1three_1band_1gains(JNIEnv *env, jclass jclass1, jlong handle, jfloat lowGainDb, jfloat midGainDb, jfloat highGainDb) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return;
+    }
+    instance->soundSystem->setThreeBandGains(lowGainDb, midGainDb, highGainDb);
+}
+
+void Java_fr_bowserf_soundsystem_SoundSystem_native_1reset_1equalizer(JNIEnv *env, jclass jclass1, jlong handle) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return;
+    }
+    instance->soundSystem->resetEqualizer();
+}
+
+jfloatArray Java_fr_bowserf_soundsystem_SoundSystem_native_1benchmark_1equalizer(JNIEnv *env, jclass jclass1, jlong handle) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return nullptr;
+    }
+    // usual buffer sizes of android devices
+    const int bufferSizes[] = {64, 128, 192, 240, 256, 480, 512, 1024};
+    const int numberBufferSizes = sizeof(bufferSizes) / sizeof(bufferSizes[0]);
+
+    jfloat results[numberBufferSizes];
+    for (int i = 0; i < numberBufferSizes; i++) {
+        results[i] = (jfloat) Equalizer::benchmark(instance->soundSystem->getSampleRate(),
+                                                   bufferSizes[i], EQUALIZER_BENCHMARK_BLOCKS);
+        LOGI("Equalizer %d frames : %f ns per band per block", bufferSizes[i], results[i]);
+    }
+
+    jfloatArray jResults = env->NewFloatArray(numberBufferSizes);
+    if (jResults == nullptr) {
+        return nullptr;
+    }
+    env->SetFloatArrayRegion(jResults, 0, numberBufferSizes, results);
+    return jResults;
+}
+
+void Java_fr_bowserf_soundsystem_SoundSystem_native_1set_1playback_1rate(JNIEnv *env, jclass jclass1, jlong handle, jfloat rate, jint rampMs) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return;
+    }
+    instance->soundSystem->setPlaybackRate(rate, rampMs);
+}
+
+jfloatArray Java_fr_bowserf_soundsystem_SoundSystem_native_1benchmark_1read_1head(JNIEnv *env, jclass jclass1, jlong handle) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return nullptr;
+    }
+    const float rates[] = {-READ_HEAD_MAX_RATE, -1.f, 0.5f, 1.f, 2.f, READ_HEAD_MAX_RATE};
+    const int numberRates = sizeof(rates) / sizeof(rates[0]);
+
+    // blocks of the player, which must be rendered before the previous one is played
+    const int numberFrames = instance->soundSystem->getBufferSize() / 2;
+    const double bufferDurationNs = numberFrames * 1e9 / instance->soundSystem->getSampleRate();
+
+    jfloat results[numberRates];
+    for (int i = 0; i < numberRates; i++) {
+        double blockNs = ReadHead::benchmark(rates[i], numberFrames, READ_HEAD_BENCHMARK_BLOCKS);
+        results[i] = (jfloat) (100. * blockNs / bufferDurationNs);
+        LOGI("Read head at rate %f : %f ns per block of %d frames, %f %% of the buffer duration",
+             rates[i], blockNs, numberFrames, results[i]);
+    }
+
+    jfloatArray jResults = env->NewFloatArray(numberRates);
+    if (jResults == nullptr) {
+        return nullptr;
+    }
+    env->SetFloatArrayRegion(jResults, 0, numberRates, results);
+    return jResults;
+}
+
+jfloatArray Java_fr_bowserf_soundsystem_SoundSystem_native_1benchmark_1channel_1mapping(JNIEnv *env, jclass jclass1, jlong handle) {
+    if(!isSoundSystemInit(handle)){
+        return nullptr;
+    }
+    // mono, stereo, 5.1 and 7.1
+    const int layouts[] = {1, 2, 6, 8};
+    const int numberLayouts = sizeof(layouts) / sizeof(layouts[0]);
+
+    // kernel of the layout then generic mapping, for each layout
+    jfloat results[numberLayouts * 2];
+    for (int i = 0; i < numberLayouts; i++) {
+        results[i * 2] = (jfloat) ChannelMapper::benchmark(layouts[i], false,
+                                                           CHANNEL_MAPPER_BENCHMARK_FRAMES,
+                                                           CHANNEL_MAPPER_BENCHMARK_BLOCKS);
+        results[i * 2 + 1] = (jfloat) ChannelMapper::benchmark(layouts[i], true,
+                                                               CHANNEL_MAPPER_BENCHMARK_FRAMES,
+                                                               CHANNEL_MAPPER_BENCHMARK_BLOCKS);
+        LOGI("Channel mapping of %d channels : %f ns per frame, %f ns generic", layouts[i],
+             results[i * 2], results[i * 2 + 1]);
+    }
+
+    jfloatArray jResults = env->NewFloatArray(numberLayouts * 2);
+    if (jResults == nullptr) {
+        return nullptr;
+    }
+    env->SetFloatArrayRegion(jResults, 0, numberLayouts * 2, results);
+    return jResults;
+}
+
+jfloat Java_fr_bowserf_soundsystem_SoundSystem_native_1render_1to_1wav(JNIEnv *env, jclass jclass1, jlong handle, jstring wavPath) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return -1;
+    }
+    const char *utf8WavPath = env->GetStringUTFChars(wavPath, NULL);
+    OfflineRenderStats stats;
+    bool success = instance->soundSystem->renderToWav(utf8WavPath, &stats);
+    env->ReleaseStringUTFChars(wavPath, utf8WavPath);
+    return success ? (jfloat) stats.realTimeFactor : -1;
+}
+
+jfloat Java_fr_bowserf_soundsystem_SoundSystem_native_1benchmark_1mp3_1decoder(JNIEnv *env, jclass jclass1, jlong handle, jstring filePath) {
+    if(!isSoundSystemInit(handle)){
+        return 0;
+    }
+    const char *utf8FilePath = env->GetStringUTFChars(filePath, NULL);
+    double realTimeFactor = Mp3Decoder::benchmark(utf8FilePath, MP3_BENCHMARK_RUNS);
+    env->ReleaseStringUTFChars(filePath, utf8FilePath);
+    return (jfloat) realTimeFactor;
+}
+
+void Java_fr_bowserf_soundsystem_SoundSystem_native_1set_1thread_1policy(JNIEnv *env, jclass jclass1, jlong handle, jint role, jint fifoPriority, jint niceLevel, jint cpuMask) {
+    if(!isSoundSystemInit(handle)){
+        return;
+    }
+    ThreadPolicy policy;
+    policy.fifoPriority = fifoPriority;
+    policy.niceLevel = niceLevel;
+    policy.cpuMask = (uint32_t) cpuMask;
+    setThreadPolicy(role, policy);
+}
+
+jintArray Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1thread_1policy_1reports(JNIEnv *env, jclass jclass1, jlong handle) {
+    if(!isSoundSystemInit(handle)){
+        return nullptr;
+    }
+    ThreadPolicyReport reports[THREAD_POLICY_MAX_REPORTS];
+    const int numberReports = getThreadPolicyReports(reports, THREAD_POLICY_MAX_REPORTS);
+
+    // layout described in SSThreadPolicyReport
+    const int length = numberReports * THREAD_POLICY_REPORT_SIZE;
+    jint values[THREAD_POLICY_MAX_REPORTS * THREAD_POLICY_REPORT_SIZE];
+    for (int i = 0; i < numberReports; i++) {
+        jint *value = values + i * THREAD_POLICY_REPORT_SIZE;
+        value[0] = reports[i].role;
+        value[1] = reports[i].tid;
+        value[2] = reports[i].schedulingPolicy;
+        value[3] = reports[i].priority;
+        value[4] = reports[i].niceLevel;
+        value[5] = (jint) reports[i].cpuMask;
+    }
+
+    jintArray jValues = env->NewIntArray(length);
+    if (jValues == nullptr) {
+        return nullptr;
+    }
+    env->SetIntArrayRegion(jValues, 0, length, values);
+    return jValues;
+}
+
+jint Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1big_1cores_1mask(JNIEnv *env, jclass jclass1) {
+    return (jint) getBigCoresMask();
+}
+
+void Java_fr_bowserf_soundsystem_SoundSystem_native_1set_1track_1cache_1budget(JNIEnv *env, jclass jclass1, jlong handle, jlong budgetBytes) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return;
+    }
+    instance->soundSystem->getTrackCache()->setBudget(budgetBytes > 0 ? (size_t) budgetBytes : 0);
+}
+
+void Java_fr_bowserf_soundsystem_SoundSystem_native_1clear_1track_1cache(JNIEnv *env, jclass jclass1, jlong handle) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return;
+    }
+    instance->soundSystem->getTrackCache()->clear();
+}
+
+jlongArray Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1track_1cache_1stats(JNIEnv *env, jclass jclass1, jlong handle) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return nullptr;
+    }
+    TrackCacheStats stats;
+    instance->soundSystem->getTrackCache()->getStats(&stats);
+
+    // layout described in SSTrackCacheStats
+    jlong values[TRACK_CACHE_STATS_SIZE];
+    values[0] = stats.hits;
+    values[1] = stats.misses;
+    values[2] = stats.evictions;
+    values[3] = stats.numberTracks;
+    values[4] = (jlong) stats.usedBytes;
+    values[5] = (jlong) stats.budgetBytes;
+
+    jlongArray jValues = env->NewLongArray(TRACK_CACHE_STATS_SIZE);
+    if (jValues == nullptr) {
+        return nullptr;
+    }
+    env->SetLongArrayRegion(jValues, 0, TRACK_CACHE_STATS_SIZE, values);
+    return jValues;
+}
+
+jboolean Java_fr_bowserf_soundsystem_SoundSystem_native_1start_1tracing(JNIEnv *env, jclass jclass1, jlong handle) {
+    if(!isSoundSystemInit(handle)){
+        return JNI_FALSE;
+    }
+    return (jboolean) startTracing();
+}
+
+void Java_fr_bowserf_soundsystem_SoundSystem_native_1stop_1tracing(JNIEnv *env, jclass jclass1, jlong handle) {
+    if(!isSoundSystemInit(handle)){
+        return;
+    }
+    stopTracing();
+}
+
+jint Java_fr_bowserf_soundsystem_SoundSystem_native_1dump_1trace(JNIEnv *env, jclass jclass1, jlong handle, jstring filePath) {
+    if(!isSoundSystemInit(handle)){
+        return -1;
+    }
+    const char *utf8FilePath = env->GetStringUTFChars(filePath, NULL);
+    int numberEvents = dumpTrace(utf8FilePath);
+    env->ReleaseStringUTFChars(filePath, utf8FilePath);
+    return numberEvents;
+}
+
+void Java_fr_bowserf_soundsystem_SoundSystem_native_1set_1silence_1trimming(JNIEnv *env, jclass jclass1, jlong handle, jboolean trim, jfloat thresholdDb, jint minDurationMs) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return;
+    }
+    instance->soundSystem->setSilenceTrimming(trim, thresholdDb, minDurationMs);
+}
+
+jintArray Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1track_1silence(JNIEnv *env, jclass jclass1, jlong handle) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr || !instance->soundSystem->isLoaded()){
+        return nullptr;
+    }
+    const TrackSilence &silence = instance->soundSystem->getTrackSilence();
+
+    // layout described in SSTrackSilence
+    jint values[TRACK_SILENCE_SIZE];
+    values[0] = silence.trimmedFrames;
+    values[1] = silence.firstAudibleFrame;
+    values[2] = silence.lastAudibleFrame;
+
+    jintArray jValues = env->NewIntArray(TRACK_SILENCE_SIZE);
+    if (jValues == nullptr) {
+        return nullptr;
+    }
+    env->SetIntArrayRegion(jValues, 0, TRACK_SILENCE_SIZE, values);
+    return jValues;
+}
+
+jlongArray Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1playback_1clock(JNIEnv *env, jclass jclass1, jlong handle) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return nullptr;
+    }
+    PlayerState state;
+    instance->soundSystem->getState(&state);
+
+    // layout described in SSPlaybackClock
+    jint rateBits;
+    memcpy(&rateBits, &state.rate, sizeof(rateBits));
+    jlong values[PLAYBACK_CLOCK_SIZE];
+    values[0] = state.isPlaying ? 1 : 0;
+    values[1] = state.presentedFrame;
+    values[2] = state.presentationTimeNs;
+    values[3] = rateBits;
+    values[4] = instance->soundSystem->getSampleRate();
+    values[5] = (jlong) state.outputFrame;
+
+    jlongArray jValues = env->NewLongArray(PLAYBACK_CLOCK_SIZE);
+    if (jValues == nullptr) {
+        return nullptr;
+    }
+    env->SetLongArrayRegion(jValues, 0, PLAYBACK_CLOCK_SIZE, values);
+    return jValues;
+}
+
+void Java_fr_bowserf_soundsystem_SoundSystem_native_1set_1output_1latency(JNIEnv *env, jclass jclass1, jlong handle, jint latencyMs) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return;
+    }
+    instance->soundSystem->setOutputLatency(latencyMs);
+}
+
+jobject Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1status_1buffer(JNIEnv *env, jclass jclass1, jlong handle) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return nullptr;
+    }
+    // Java must not read the buffer anymore once the sound system is released
+    EngineStatus *status = instance->soundSystem->getStatus();
+    return env->NewDirectByteBuffer(status->getBuffer(), status->getSize());
+}
+
+jlongArray Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1decode_1stats(JNIEnv *env, jclass jclass1, jlong handle) {
+    if(!isSoundSystemInit(handle)){
+        return nullptr;
+    }
+    ThreadPoolStats stats;
+    _decodeThreadPool->getStats(&stats);
+
+    // layout described in SSDecodeStats
+    jlong values[DECODE_STATS_SIZE];
+    for (int i = 0; i < kTaskPriorityCount; i++) {
+        jlong *value = values + i * DECODE_STATS_PRIORITY_SIZE;
+        value[0] = stats.runTasks[i];
+        value[1] = (jlong) stats.runMs[i];
+        value[2] = stats.droppedTasks[i];
+        value[3] = stats.cancelledJobs[i];
+        value[4] = (jlong) stats.cancelledWorkMs[i];
+    }
+    values[DECODE_STATS_SIZE - 1] = stats.maxQueuedTasks;
+
+    jlongArray jValues = env->NewLongArray(DECODE_STATS_SIZE);
+    if (jValues == nullptr) {
+        return nullptr;
+    }
+    env->SetLongArrayRegion(jValues, 0, DECODE_STATS_SIZE, values);
+    return jValues;
+}
+
+jint Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1spectrogram_1tile(JNIEnv *env, jclass jclass1, jlong handle, jint level, jint index, jbyteArray columns) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr || index < 0 || env->GetArrayLength(columns) < SPECTROGRAM_TILE_SIZE){
+        return kSpectrogramTileMissing;
+    }
+    uint8_t tile[SPECTROGRAM_TILE_SIZE];
+    const int state = instance->spectrogram->getTile(level, (unsigned int) index, tile);
+    if (state != kSpectrogramTileMissing) {
+        env->SetByteArrayRegion(columns, 0, SPECTROGRAM_TILE_SIZE, (const jbyte *) tile);
+    }
+    return state;
+}
+
+jint Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1spectrogram_1number_1columns(JNIEnv *env, jclass jclass1, jlong handle) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return 0;
+    }
+    return (jint) instance->spectrogram->getNumberColumns();
+}
+
+void Java_fr_bowserf_soundsystem_SoundSystem_native_1set_1spectrogram_1budget(JNIEnv *env, jclass jclass1, jlong handle, jlong budgetBytes) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return;
+    }
+    instance->spectrogram->setBudget(budgetBytes > 0 ? (size_t) budgetBytes : 0);
+}
+
+jlongArray Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1spectrogram_1stats(JNIEnv *env, jclass jclass1, jlong handle) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return nullptr;
+    }
+    SpectrogramStats stats;
+    instance->spectrogram->getStats(&stats);
+
+    // layout described in SSSpectrogramStats
+    jlong values[SPECTROGRAM_STATS_SIZE];
+    values[0] = stats.computedChunks;
+    values[1] = (jlong) stats.computeMs;
+    values[2] = stats.hits;
+    values[3] = stats.misses;
+    values[4] = stats.evictions;
+    values[5] = stats.numberTiles;
+    values[6] = (jlong) stats.usedBytes;
+    values[7] = (jlong) stats.budgetBytes;
+
+    jlongArray jValues = env->NewLongArray(SPECTROGRAM_STATS_SIZE);
+    if (jValues == nullptr) {
+        return nullptr;
+    }
+    env->SetLongArrayRegion(jValues, 0, SPECTROGRAM_STATS_SIZE, values);
+    return jValues;
+}
+
+jdoubleArray Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1track_1analysis(JNIEnv *env, jclass jclass1, jlong handle) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return nullptr;
+    }
+    TrackAnalysis analysis;
+    instance->analysisPipeline->getAnalysis(&analysis);
+
+    // layout described in SSTrackAnalysis
+    jdouble values[TRACK_ANALYSIS_SIZE];
+    values[0] = analysis.isComplete ? 1 : 0;
+    values[1] = analysis.numberFrames;
+    values[2] = analysis.peak;
+    values[3] = analysis.rms;
+    values[4] = analysis.firstAudibleFrame;
+    values[5] = analysis.lastAudibleFrame;
+    values[6] = analysis.loudness;
+    values[7] = analysis.numberOnsets;
+    values[8] = analysis.totalMs;
+    values[9] = analysis.numberTasks;
+    values[10] = analysis.key;
+    values[11] = analysis.keyStrength;
+    for (int type = 0; type < kAnalyzerCount; type++) {
+        values[TRACK_ANALYSIS_RESULTS_SIZE + type] = analysis.analyzerMs[type];
+    }
+
+    jdoubleArray jValues = env->NewDoubleArray(TRACK_ANALYSIS_SIZE);
+    if (jValues == nullptr) {
+        return nullptr;
+    }
+    env->SetDoubleArrayRegion(jValues, 0, TRACK_ANALYSIS_SIZE, values);
+    return jValues;
+}
+
+jint Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1track_1analysis_1curve(JNIEnv *env, jclass jclass1, jlong handle, jint analyzer, jfloatArray values) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return 0;
+    }
+    const jsize maxValues = env->GetArrayLength(values);
+    float *curve = (float *) malloc((maxValues > 0 ? maxValues : 1) * sizeof(float));
+    if (curve == nullptr) {
+        return 0;
+    }
+    const unsigned int numberValues = instance->analysisPipeline->getCurve(analyzer, curve,
+                                                                          (unsigned int) maxValues);
+    env->SetFloatArrayRegion(values, 0, numberValues, curve);
+    free(curve);
+    return (jint) numberValues;
+}
+
+jfloat Java_fr_bowserf_soundsystem_SoundSystem_native_1benchmark_1key_1detection(JNIEnv *env, jclass jclass1, jlong handle) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return 0;
+    }
+    int key;
+    double elapsedMs = KeyAnalyzer::benchmark(_decodeThreadPool,
+                                              instance->soundSystem->getSampleRate(), &key);
+    LOGI("Key detection of %d s : %.1f ms, key %d", ANALYSIS_KEY_BENCHMARK_SECONDS, elapsedMs, key);
+    return (jfloat) elapsedMs;
+}
+
+jboolean Java_fr_bowserf_soundsystem_SoundSystem_native_1start_1capture(JNIEnv *env, jclass jclass1, jlong handle, jstring wavPath, jint source, jint numberChannels) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return JNI_FALSE;
+    }
+    const char *utf8WavPath = env->GetStringUTFChars(wavPath, NULL);
+    bool success = instance->audioRecorder->start(utf8WavPath, source, numberChannels);
+    env->ReleaseStringUTFChars(wavPath, utf8WavPath);
+    return (jboolean) success;
+}
+
+jboolean Java_fr_bowserf_soundsystem_SoundSystem_native_1stop_1capture(JNIEnv *env, jclass jclass1, jlong handle) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return JNI_FALSE;
+    }
+    return (jboolean) instance->audioRecorder->stop();
+}
+
+jdoubleArray Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1capture_1stats(JNIEnv *env, jclass jclass1, jlong handle) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return nullptr;
+    }
+    CaptureStats stats;
+    instance->audioRecorder->getStats(&stats);
+
+    // layout described in SSCaptureStats
+    jdouble values[CAPTURE_STATS_SIZE];
+    values[0] = stats.isCapturing ? 1 : 0;
+    values[1] = stats.hasError ? 1 : 0;
+    values[2] = stats.capturedBlocks;
+    values[3] = stats.droppedBlocks;
+    values[4] = stats.lateBlocks;
+    values[5] = stats.maxQueuedBlocks;
+    values[6] = stats.numberRingBlocks;
+    values[7] = (jdouble) stats.writtenBytes;
+    values[8] = stats.numberWrites;
+    values[9] = stats.startLatencyMs;
+    values[10] = stats.lastLatencyMs;
+    values[11] = stats.meanLatencyMs;
+    values[12] = stats.maxLatencyMs;
+
+    jdoubleArray jValues = env->NewDoubleArray(CAPTURE_STATS_SIZE);
+    if (jValues == nullptr) {
+        return nullptr;
+    }
+    env->SetDoubleArrayRegion(jValues, 0, CAPTURE_STATS_SIZE, values);
+    return jValues;
+}
+
+jint Java_fr_bowserf_soundsystem_SoundSystem_native_1load_1sample(JNIEnv *env, jclass jclass1, jlong handle, jstring filePath) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return -1;
+    }
+    SoundSystem *soundSystem = instance->soundSystem;
+    const char *utf8FilePath = env->GetStringUTFChars(filePath, NULL);
+    int sample = soundSystem->getSampler()->loadSample(utf8FilePath, soundSystem->getEngine(),
+                                                        soundSystem->getBufferSize());
+    env->ReleaseStringUTFChars(filePath, utf8FilePath);
+    return sample;
+}
+
+jboolean Java_fr_bowserf_soundsystem_SoundSystem_native_1trigger_1sample(JNIEnv *env, jclass jclass1, jlong handle, jint sample, jfloat gain, jint offsetFrames) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr || offsetFrames < 0){
+        return JNI_FALSE;
+    }
+    return (jboolean) instance->soundSystem->getSampler()->trigger(sample, gain,
+                                                                   (unsigned int) offsetFrames);
+}
+
+void Java_fr_bowserf_soundsystem_SoundSystem_native_1stop_1samples(JNIEnv *env, jclass jclass1, jlong handle) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return;
+    }
+    instance->soundSystem->getSampler()->stopAll();
+}
+
+void Java_fr_bowserf_soundsystem_SoundSystem_native_1start_1output(JNIEnv *env, jclass jclass1, jlong handle) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return;
+    }
+    instance->soundSystem->startOutput();
+}
+
+jint Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1number_1active_1voices(JNIEnv *env, jclass jclass1, jlong handle) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return 0;
+    }
+    return instance->soundSystem->getSampler()->getNumberActiveVoices();
+}
+
+jint Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1number_1stolen_1voices(JNIEnv *env, jclass jclass1, jlong handle) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return 0;
+    }
+    return (jint) instance->soundSystem->getSampler()->getNumberStolenVoices();
+}
+
+jfloatArray Java_fr_bowserf_soundsystem_SoundSystem_native_1benchmark_1sampler(JNIEnv *env, jclass jclass1, jlong handle) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return nullptr;
+    }
+    const int voices[] = {32, 64, 128};
+    const int numberVoices = sizeof(voices) / sizeof(voices[0]);
+
+    // blocks of the player, in which the voices are mixed
+    const int sampleRate = instance->soundSystem->getSampleRate();
+    const int numberFrames = instance->soundSystem->getBufferSize() / 2;
+    const double bufferDurationNs = numberFrames * 1e9 / sampleRate;
+
+    jfloat results[numberVoices];
+    for (int i = 0; i < numberVoices; i++) {
+        double blockNs = Sampler::benchmark(sampleRate, numberFrames, voices[i],
+                                            SAMPLER_BENCHMARK_BLOCKS);
+        results[i] = (jfloat) (100. * blockNs / bufferDurationNs);
+        LOGI("Sampler with %d voices : %f ns per block of %d frames, %f %% of the buffer duration",
+             voices[i], blockNs, numberFrames, results[i]);
+    }
+
+    jfloatArray jResults = env->NewFloatArray(numberVoices);
+    if (jResults == nullptr) {
+        return nullptr;
+    }
+    env->SetFloatArrayRegion(jResults, 0, numberVoices, results);
+    return jResults;
+}
+
+jboolean Java_fr_bowserf_soundsystem_SoundSystem_native_1schedule_1event(JNIEnv *env, jclass jclass1, jlong handle, jint type, jlong frame, jlong position, jfloat gain, jint rampMs) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr || frame < 0 || position < 0 || position > UINT_MAX){
+        return JNI_FALSE;
+    }
+    return (jboolean) instance->soundSystem->scheduleEvent(type, (uint64_t) frame,
+                                                           (unsigned int) position, gain, rampMs);
+}
+
+void Java_fr_bowserf_soundsystem_SoundSystem_native_1cancel_1scheduled_1events(JNIEnv *env, jclass jclass1, jlong handle) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return;
+    }
+    instance->soundSystem->getEventScheduler()->cancelAll();
+}
+
+jlongArray Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1scheduler_1stats(JNIEnv *env, jclass jclass1, jlong handle) {
+    SoundSystemInstance *instance = toInstance(handle);
+    if(instance == nullptr){
+        return nullptr;
+    }
+    SchedulerStats stats;
+    instance->soundSystem->getEventScheduler()->getStats(&stats);
+
+    // layout described in SSSchedulerStats
+    jlong values[SCHEDULER_STATS_SIZE];
+    values[0] = stats.scheduledEvents;
+    values[1] = stats.appliedEvents;
+    values[2] = stats.lateEvents;
+    values[3] = stats.maxLateFrames;
+    values[4] = stats.cancelledEvents;
+    values[5] = stats.rejectedEvents;
+    values[6] = stats.pendingEvents;
+
+    jlongArray jValues = env->NewLongArray(SCHEDULER_STATS_SIZE);
+    if (jValues == nullptr) {
+        return nullptr;
+    }
+    env->SetLongArrayRegion(jValues, 0, SCHEDULER_STATS_SIZE, values);
+    return jValues;
+}
+
 SLDataLocator_AndroidFD getTrackFromAsset(JNIEnv *env, jobject assetManager, jstring filename){
     // convert Java string to UTF-8
     const char *utf8 = env->GetStringUTFChars(filename, NULL);
@@ -157,12 +1034,16 @@ SLDataLocator_AndroidFD getTrackFromAsset(JNIEnv *env, jobject assetManager, jst
     return loc_fd;
 }
 
-bool isSoundSystemInit(){
-    if(_soundSystem == NULL){
-        LOGE("_soundSystem is not initialize");
-        return false;
+SoundSystemInstance *toInstance(jlong handle){
+    if(handle == 0){
+        LOGE("sound system is not initialized");
+        return nullptr;
     }
-    return true;
+    return (SoundSystemInstance *) (intptr_t) handle;
+}
+
+bool isSoundSystemInit(jlong handle){
+    return toInstance(handle) != nullptr;
 }
 
 // Convert Java string to UTF-8
@@ -186,3 +1067,37 @@ void convertFloatDataToShort(float* src, unsigned int length, short* dst){
         dst[i] = tmp * SHRT_MAX;
     }
 }
+
+char** copyJavaStringArray(JNIEnv *env, jobjectArray jStrings, int* numberStrings){
+    *numberStrings = env->GetArrayLength(jStrings);
+    char** strings = (char**) calloc(*numberStrings > 0 ? *numberStrings : 1, sizeof(char*));
+    for (int i = 0; i < *numberStrings; i++) {
+        jstring jString = (jstring) env->GetObjectArrayElement(jStrings, i);
+        const char *utf8 = env->GetStringUTFChars(jString, NULL);
+        strings[i] = strdup(utf8);
+        env->ReleaseStringUTFChars(jString, utf8);
+        env->DeleteLocalRef(jString);
+    }
+    return strings;
+}
+
+void freeStringArray(char** strings, int numberStrings){
+    for (int i = 0; i < numberStrings; i++) {
+        free(strings[i]);
+    }
+    free(strings);
+}
+
+jobjectArray toJavaStringArray(JNIEnv *env, char** strings, int numberStrings){
+    jobjectArray jStrings = env->NewObjectArray(numberStrings, env->FindClass("java/lang/String"),
+                                                nullptr);
+    for (int i = 0; i < numberStrings; i++) {
+        if (jStrings != nullptr) {
+            jstring jString = env->NewStringUTF(strings[i]);
+            env->SetObjectArrayElement(jStrings, i, jString);
+            env->DeleteLocalRef(jString);
+        }
+        free(strings[i]);
+    }
+    return jStrings;
+}
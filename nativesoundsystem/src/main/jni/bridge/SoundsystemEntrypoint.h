@@ -15,56 +15,264 @@
 #include <assert.h>
 #include <audio/extractornougat/ExtractorNougat.h>
 
+#include "audio/AudioRecorder.h"
 #include "audio/SoundSystem.h"
+#include "audio/mp3/Mp3Decoder.h"
+#include "analysis/AnalysisPipeline.h"
+#include "analysis/DuplicateFinder.h"
+#include "analysis/FeatureIndex.h"
+#include "analysis/Fingerprinter.h"
+#include "analysis/LibraryScanner.h"
+#include "analysis/Spectrogram.h"
+#include "analysis/TrackAnalyzers.h"
+#include "utils/ThreadPolicy.h"
+#include "utils/ThreadPool.h"
+#include "utils/Tracer.h"
 
 #include "listener/SoundSystemCallback.h"
 
-static SoundSystem* _soundSystem;
+/**
+ * Objects of one SoundSystem of Java, which holds a pointer to it as handle. Each instance plays and
+ * extracts its own track, so that several tracks are extracted at the same time.
+ */
+typedef struct {
+    SoundSystemCallback* soundSystemCallback;
+    SoundSystem* soundSystem;
+#ifdef MEDIACODEC_EXTRACTOR
+    ExtractorNougat* extractorNougat;
+#endif
+    LibraryScanner* libraryScanner;
+    DuplicateFinder* duplicateFinder;
+    Spectrogram* spectrogram;
+    AnalysisPipeline* analysisPipeline;
+    AudioRecorder* audioRecorder;
+} SoundSystemInstance;
+
+// guards the creation and release of the objects shared by all instances
+static pthread_mutex_t _instancesMutex = PTHREAD_MUTEX_INITIALIZER;
+static int _numberInstances = 0;
+
+// workers shared by the extraction of tracks and the background analysis of all instances
+static ThreadPool* _decodeThreadPool;
+
+// decoded tracks of all instances, within a single budget
+static TrackCache* _trackCache;
 
-static SoundSystemCallback* _soundSystemCallback;
+// maximum number of tracks decoded at the same time by background analysis
+#define ANALYSIS_MAX_WORKERS 4
 
 #ifdef MEDIACODEC_EXTRACTOR
-static ExtractorNougat* _extractorNougat;
+// workers which only extract tracks, one per deck extracted at the same time
+#define DECODE_RESERVED_WORKERS 2
+#else
+// tracks are extracted by the threads of OpenSL ES
+#define DECODE_RESERVED_WORKERS 0
 #endif
 
+// maximum number of duplicates returned for one track
+#define MAX_DUPLICATES 16
+
+// number of blocks processed for each buffer size by the equalizer benchmark
+#define EQUALIZER_BENCHMARK_BLOCKS 2000
+
+// frames and blocks mapped for each layout by the channel mapping benchmark
+#define CHANNEL_MAPPER_BENCHMARK_FRAMES 1024
+#define CHANNEL_MAPPER_BENCHMARK_BLOCKS 2000
+
+// blocks read at each rate by the read head benchmark
+#define READ_HEAD_BENCHMARK_BLOCKS 2000
+
+// blocks mixed for each number of voices by the sampler benchmark
+#define SAMPLER_BENCHMARK_BLOCKS 2000
+
+// number of decodings of the file by the software decoder benchmark
+#define MP3_BENCHMARK_RUNS 20
+
+// number of values before the overview in the array of scanned track features
+#define SCANNED_FEATURES_HEADER_SIZE 6
+
+// number of values of each report in the array of thread policy reports
+#define THREAD_POLICY_REPORT_SIZE 6
+
+// number of values in the array of track cache stats
+#define TRACK_CACHE_STATS_SIZE 6
+
+// number of values in the array of track silence
+#define TRACK_SILENCE_SIZE 3
+
+// number of values in the array of the playback clock
+#define PLAYBACK_CLOCK_SIZE 6
+
+// number of values for each priority, then the maximum queue length, in the array of decode stats
+#define DECODE_STATS_PRIORITY_SIZE 5
+#define DECODE_STATS_SIZE (kTaskPriorityCount * DECODE_STATS_PRIORITY_SIZE + 1)
+
+// number of values in the array of spectrogram stats
+#define SPECTROGRAM_STATS_SIZE 8
+
+// number of values in the array of the track analysis, then the time of each analyzer
+#define TRACK_ANALYSIS_RESULTS_SIZE 12
+#define TRACK_ANALYSIS_SIZE (TRACK_ANALYSIS_RESULTS_SIZE + kAnalyzerCount)
+
+// number of values in the array of capture stats
+#define CAPTURE_STATS_SIZE 13
+
+// number of values in the array of scheduler stats
+#define SCHEDULER_STATS_SIZE 7
+
 extern "C" {
 
-    void Java_fr_bowserf_soundsystem_SoundSystem_native_1init_1soundsystem(JNIEnv *env,
-                                                                           jclass jclass1,
-                                                                           jint sample_rate,
-                                                                           jint frames_per_buf);
+    jlong Java_fr_bowserf_soundsystem_SoundSystem_native_1init_1soundsystem(JNIEnv *env,
+                                                                            jclass jclass1,
+                                                                            jint sample_rate,
+                                                                            jint frames_per_buf);
 
     void Java_fr_bowserf_soundsystem_SoundSystem_native_1load_1file(JNIEnv *env,
                                                             jclass jclass1,
+                                                            jlong handle,
                                                             jstring filePath);
 
-    void Java_fr_bowserf_soundsystem_SoundSystem_native_1play(JNIEnv *env, jclass jclass1, jboolean play);
+    void Java_fr_bowserf_soundsystem_SoundSystem_native_1play(JNIEnv *env, jclass jclass1, jlong handle, jboolean play);
+
+    jboolean Java_fr_bowserf_soundsystem_SoundSystem_native_1is_1playing(JNIEnv *env, jclass jclass1, jlong handle);
+
+    jboolean Java_fr_bowserf_soundsystem_SoundSystem_native_1is_1loaded(JNIEnv *env, jclass jclass1, jlong handle);
+
+    jint Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1playing_1position(JNIEnv *env, jclass jclass1, jlong handle);
+
+    jboolean Java_fr_bowserf_soundsystem_SoundSystem_native_1is_1soundsystem_1init(JNIEnv *env, jclass jclass1, jlong handle);
+
+    void Java_fr_bowserf_soundsystem_SoundSystem_native_1stop(JNIEnv *env, jclass jclass1, jlong handle);
+
+    void Java_fr_bowserf_soundsystem_SoundSystem_native_1extract_1and_1play(JNIEnv *env, jobject obj, jlong handle, jstring filePath);
+
+    void Java_fr_bowserf_soundsystem_SoundSystem_native_1release_1soundsystem(JNIEnv *env, jclass jclass1, jlong handle);
+
+    void Java_fr_bowserf_soundsystem_SoundSystem_native_1extract_1from_1assets_1and_1play(JNIEnv *env, jobject obj, jlong handle, jobject assetManager, jstring filename);
+
+    jshortArray Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1extracted_1data(JNIEnv *env, jclass jclass1, jlong handle);
+
+    jshortArray Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1extracted_1data_1mono(JNIEnv *env, jclass jclass1, jlong handle);
+
+    jboolean Java_fr_bowserf_soundsystem_SoundSystem_native_1scan_1library(JNIEnv *env, jclass jclass1, jlong handle, jobjectArray filePaths, jstring indexPath);
+
+    void Java_fr_bowserf_soundsystem_SoundSystem_native_1cancel_1library_1scan(JNIEnv *env, jclass jclass1, jlong handle);
+
+    jfloatArray Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1scanned_1track_1features(JNIEnv *env, jclass jclass1, jstring indexPath, jstring filePath);
+
+    jboolean Java_fr_bowserf_soundsystem_SoundSystem_native_1fingerprint_1tracks(JNIEnv *env, jclass jclass1, jlong handle, jobjectArray filePaths);
+
+    void Java_fr_bowserf_soundsystem_SoundSystem_native_1cancel_1fingerprinting(JNIEnv *env, jclass jclass1, jlong handle);
+
+    jobjectArray Java_fr_bowserf_soundsystem_SoundSystem_native_1find_1duplicates(JNIEnv *env, jclass jclass1, jlong handle, jstring filePath);
+
+    jobjectArray Java_fr_bowserf_soundsystem_SoundSystem_native_1find_1loaded_1track_1duplicates(JNIEnv *env, jclass jclass1, jlong handle);
+
+    void Java_fr_bowserf_soundsystem_SoundSystem_native_1clear_1fingerprints(JNIEnv *env, jclass jclass1, jlong handle);
 
-    jboolean Java_fr_bowserf_soundsystem_SoundSystem_native_1is_1playing(JNIEnv *env, jclass jclass1);
+    void Java_fr_bowserf_soundsystem_SoundSystem_native_1set_1equalizer_1section(JNIEnv *env, jclass jclass1, jlong handle, jint index, jint type, jfloat frequency, jfloat gainDb, jfloat q);
 
-    jboolean Java_fr_bowserf_soundsystem_SoundSystem_native_1is_1loaded(JNIEnv *env, jclass jclass1);
+    void Java_fr_bowserf_soundsystem_SoundSystem_native_1set_1three_1band_1gains(JNIEnv *env, jclass jclass1, jlong handle, jfloat lowGainDb, jfloat midGainDb, jfloat highGainDb);
 
-    jboolean Java_fr_bowserf_soundsystem_SoundSystem_native_1is_1soundsystem_1init(JNIEnv *env, jclass jclass1);
+    void Java_fr_bowserf_soundsystem_SoundSystem_native_1reset_1equalizer(JNIEnv *env, jclass jclass1, jlong handle);
 
-    void Java_fr_bowserf_soundsystem_SoundSystem_native_1stop(JNIEnv *env, jclass jclass1);
+    jfloatArray Java_fr_bowserf_soundsystem_SoundSystem_native_1benchmark_1equalizer(JNIEnv *env, jclass jclass1, jlong handle);
 
-    void Java_fr_bowserf_soundsystem_SoundSystem_native_1extract_1and_1play(JNIEnv *env, jobject obj, jstring filePath);
+    void Java_fr_bowserf_soundsystem_SoundSystem_native_1set_1playback_1rate(JNIEnv *env, jclass jclass1, jlong handle, jfloat rate, jint rampMs);
 
-    void Java_fr_bowserf_soundsystem_SoundSystem_native_1release_1soundsystem(JNIEnv *env, jclass jclass1);
+    jfloatArray Java_fr_bowserf_soundsystem_SoundSystem_native_1benchmark_1read_1head(JNIEnv *env, jclass jclass1, jlong handle);
 
-    void Java_fr_bowserf_soundsystem_SoundSystem_native_1extract_1from_1assets_1and_1play(JNIEnv *env, jobject obj, jobject assetManager, jstring filename);
+    jfloatArray Java_fr_bowserf_soundsystem_SoundSystem_native_1benchmark_1channel_1mapping(JNIEnv *env, jclass jclass1, jlong handle);
 
-    jshortArray Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1extracted_1data(JNIEnv *env, jclass jclass1);
+    jfloat Java_fr_bowserf_soundsystem_SoundSystem_native_1render_1to_1wav(JNIEnv *env, jclass jclass1, jlong handle, jstring wavPath);
 
-    jshortArray Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1extracted_1data_1mono(JNIEnv *env, jclass jclass1);
+    jfloat Java_fr_bowserf_soundsystem_SoundSystem_native_1benchmark_1mp3_1decoder(JNIEnv *env, jclass jclass1, jlong handle, jstring filePath);
+
+    void Java_fr_bowserf_soundsystem_SoundSystem_native_1set_1thread_1policy(JNIEnv *env, jclass jclass1, jlong handle, jint role, jint fifoPriority, jint niceLevel, jint cpuMask);
+
+    jintArray Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1thread_1policy_1reports(JNIEnv *env, jclass jclass1, jlong handle);
+
+    jint Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1big_1cores_1mask(JNIEnv *env, jclass jclass1);
+
+    void Java_fr_bowserf_soundsystem_SoundSystem_native_1set_1track_1cache_1budget(JNIEnv *env, jclass jclass1, jlong handle, jlong budgetBytes);
+
+    void Java_fr_bowserf_soundsystem_SoundSystem_native_1clear_1track_1cache(JNIEnv *env, jclass jclass1, jlong handle);
+
+    jlongArray Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1track_1cache_1stats(JNIEnv *env, jclass jclass1, jlong handle);
+
+    jboolean Java_fr_bowserf_soundsystem_SoundSystem_native_1start_1tracing(JNIEnv *env, jclass jclass1, jlong handle);
+
+    void Java_fr_bowserf_soundsystem_SoundSystem_native_1stop_1tracing(JNIEnv *env, jclass jclass1, jlong handle);
+
+    jint Java_fr_bowserf_soundsystem_SoundSystem_native_1dump_1trace(JNIEnv *env, jclass jclass1, jlong handle, jstring filePath);
+
+    void Java_fr_bowserf_soundsystem_SoundSystem_native_1set_1silence_1trimming(JNIEnv *env, jclass jclass1, jlong handle, jboolean trim, jfloat thresholdDb, jint minDurationMs);
+
+    jintArray Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1track_1silence(JNIEnv *env, jclass jclass1, jlong handle);
+
+    jlongArray Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1playback_1clock(JNIEnv *env, jclass jclass1, jlong handle);
+
+    void Java_fr_bowserf_soundsystem_SoundSystem_native_1set_1output_1latency(JNIEnv *env, jclass jclass1, jlong handle, jint latencyMs);
+
+    jobject Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1status_1buffer(JNIEnv *env, jclass jclass1, jlong handle);
+
+    jlongArray Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1decode_1stats(JNIEnv *env, jclass jclass1, jlong handle);
+
+    jint Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1spectrogram_1tile(JNIEnv *env, jclass jclass1, jlong handle, jint level, jint index, jbyteArray columns);
+
+    jint Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1spectrogram_1number_1columns(JNIEnv *env, jclass jclass1, jlong handle);
+
+    void Java_fr_bowserf_soundsystem_SoundSystem_native_1set_1spectrogram_1budget(JNIEnv *env, jclass jclass1, jlong handle, jlong budgetBytes);
+
+    jlongArray Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1spectrogram_1stats(JNIEnv *env, jclass jclass1, jlong handle);
+
+    jdoubleArray Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1track_1analysis(JNIEnv *env, jclass jclass1, jlong handle);
+
+    jint Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1track_1analysis_1curve(JNIEnv *env, jclass jclass1, jlong handle, jint analyzer, jfloatArray values);
+
+    jfloat Java_fr_bowserf_soundsystem_SoundSystem_native_1benchmark_1key_1detection(JNIEnv *env, jclass jclass1, jlong handle);
+
+    jboolean Java_fr_bowserf_soundsystem_SoundSystem_native_1start_1capture(JNIEnv *env, jclass jclass1, jlong handle, jstring wavPath, jint source, jint numberChannels);
+
+    jboolean Java_fr_bowserf_soundsystem_SoundSystem_native_1stop_1capture(JNIEnv *env, jclass jclass1, jlong handle);
+
+    jdoubleArray Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1capture_1stats(JNIEnv *env, jclass jclass1, jlong handle);
+
+    jint Java_fr_bowserf_soundsystem_SoundSystem_native_1load_1sample(JNIEnv *env, jclass jclass1, jlong handle, jstring filePath);
+
+    jboolean Java_fr_bowserf_soundsystem_SoundSystem_native_1trigger_1sample(JNIEnv *env, jclass jclass1, jlong handle, jint sample, jfloat gain, jint offsetFrames);
+
+    void Java_fr_bowserf_soundsystem_SoundSystem_native_1stop_1samples(JNIEnv *env, jclass jclass1, jlong handle);
+
+    void Java_fr_bowserf_soundsystem_SoundSystem_native_1start_1output(JNIEnv *env, jclass jclass1, jlong handle);
+
+    jint Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1number_1active_1voices(JNIEnv *env, jclass jclass1, jlong handle);
+
+    jint Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1number_1stolen_1voices(JNIEnv *env, jclass jclass1, jlong handle);
+
+    jfloatArray Java_fr_bowserf_soundsystem_SoundSystem_native_1benchmark_1sampler(JNIEnv *env, jclass jclass1, jlong handle);
+
+    jboolean Java_fr_bowserf_soundsystem_SoundSystem_native_1schedule_1event(JNIEnv *env, jclass jclass1, jlong handle, jint type, jlong frame, jlong position, jfloat gain, jint rampMs);
+
+    void Java_fr_bowserf_soundsystem_SoundSystem_native_1cancel_1scheduled_1events(JNIEnv *env, jclass jclass1, jlong handle);
+
+    jlongArray Java_fr_bowserf_soundsystem_SoundSystem_native_1get_1scheduler_1stats(JNIEnv *env, jclass jclass1, jlong handle);
 }
 
-bool isSoundSystemInit();
+SoundSystemInstance *toInstance(jlong handle);
+
+bool isSoundSystemInit(jlong handle);
 
 SLDataLocator_URI *dataLocatorFromURLString(JNIEnv *env, jstring fileURLString);
 
 void convertFloatDataToShort(float* data, unsigned int length, short* dst);
 
+char** copyJavaStringArray(JNIEnv *env, jobjectArray jStrings, int* numberStrings);
+
+void freeStringArray(char** strings, int numberStrings);
+
+jobjectArray toJavaStringArray(JNIEnv *env, char** strings, int numberStrings);
+
 SLDataLocator_AndroidFD getTrackFromAsset(JNIEnv *env, jobject assetManager, jstring filename);
 
 #endif //TEST_SOUNDSYSTEM_SOUNDSYSTEM_ENTRYPOINT_H
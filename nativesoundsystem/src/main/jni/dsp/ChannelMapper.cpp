@@ -0,0 +1,334 @@
+#include "ChannelMapper.h"
+
+#include <climits>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef FLOAT_PLAYER
+// same conversion as the rest of the extraction
+#define SAMPLE_SCALE (1.0f / ((float) SHRT_MAX))
+#else
+#define SAMPLE_SCALE 1.0f
+#endif
+
+// frames mixed at once by the kernels
+#define VECTOR_FRAMES 4
+
+typedef float float4 __attribute__((vector_size(16)));
+typedef int32_t int4 __attribute__((vector_size(16)));
+
+enum ChannelPosition {
+    kFrontLeft,
+    kFrontRight,
+    kFrontCenter,
+    kLowFrequency,
+    kBackLeft,
+    kBackRight,
+    kBackCenter,
+    kSideLeft,
+    kSideRight,
+};
+
+// default channel masks of android.media.AudioFormat for each number of channels
+static const int layoutPositions[CHANNEL_MAPPER_MAX_CHANNELS + 1][CHANNEL_MAPPER_MAX_CHANNELS] = {
+        {},
+        {kFrontCenter},
+        {kFrontLeft, kFrontRight},
+        {kFrontLeft, kFrontRight, kFrontCenter},
+        {kFrontLeft, kFrontRight, kBackLeft, kBackRight},
+        {kFrontLeft, kFrontRight, kFrontCenter, kBackLeft, kBackRight},
+        {kFrontLeft, kFrontRight, kFrontCenter, kLowFrequency, kBackLeft, kBackRight},
+        {kFrontLeft, kFrontRight, kFrontCenter, kLowFrequency, kBackLeft, kBackRight, kBackCenter},
+        {kFrontLeft, kFrontRight, kFrontCenter, kLowFrequency, kBackLeft, kBackRight, kSideLeft,
+                kSideRight},
+};
+
+static inline float4 blend(int4 mask, float4 ifTrue, float4 ifFalse) {
+    return (float4) (((int4) ifTrue & mask) | ((int4) ifFalse & ~mask));
+}
+
+static inline AUDIO_HARDWARE_SAMPLE_TYPE toPlayerSample(float sample) {
+#ifdef FLOAT_PLAYER
+    return sample;
+#else
+    sample += sample < 0.f ? -0.5f : 0.5f;
+    return (short) (sample > 32767.f ? 32767.f : (sample < -32768.f ? -32768.f : sample));
+#endif
+}
+
+// interleave VECTOR_FRAMES frames
+static inline void storeFrames(float4 left, float4 right, AUDIO_HARDWARE_SAMPLE_TYPE *frames) {
+#ifndef FLOAT_PLAYER
+    const float4 zero = {0.f, 0.f, 0.f, 0.f};
+    const float4 half = {0.5f, 0.5f, 0.5f, 0.5f};
+    const float4 highest = {32767.f, 32767.f, 32767.f, 32767.f};
+    const float4 lowest = {-32768.f, -32768.f, -32768.f, -32768.f};
+    left += blend(left < zero, -half, half);
+    right += blend(right < zero, -half, half);
+    left = blend(left > highest, highest, blend(left < lowest, lowest, left));
+    right = blend(right > highest, highest, blend(right < lowest, lowest, right));
+#endif
+    for (int i = 0; i < VECTOR_FRAMES; i++) {
+        frames[i * 2] = (AUDIO_HARDWARE_SAMPLE_TYPE) left[i];
+        frames[i * 2 + 1] = (AUDIO_HARDWARE_SAMPLE_TYPE) right[i];
+    }
+}
+
+ChannelMapper::ChannelMapper() :
+        _numberChannels(0),
+        _partialFrame(nullptr),
+        _numberPartialSamples(0) {
+    setNumberChannels(2);
+}
+
+ChannelMapper::~ChannelMapper() {
+    free(_partialFrame);
+}
+
+bool ChannelMapper::setNumberChannels(int numberChannels) {
+    if (numberChannels <= 0) {
+        return false;
+    }
+    if (numberChannels > _numberChannels) {
+        short *partialFrame = (short *) realloc(_partialFrame,
+                                                (size_t) numberChannels * sizeof(short));
+        if (partialFrame == nullptr) {
+            return false;
+        }
+        _partialFrame = partialFrame;
+    }
+    _numberChannels = numberChannels;
+    _numberPartialSamples = 0;
+
+    memset(_leftGains, 0, sizeof(_leftGains));
+    memset(_rightGains, 0, sizeof(_rightGains));
+    if (numberChannels > CHANNEL_MAPPER_MAX_CHANNELS) {
+        _leftGains[0] = SAMPLE_SCALE;
+        _rightGains[1] = SAMPLE_SCALE;
+        _kernel = mapGenericKernel;
+        return true;
+    }
+
+    for (int i = 0; i < numberChannels; i++) {
+        float left = 0.f;
+        float right = 0.f;
+        switch (layoutPositions[numberChannels][i]) {
+            case kFrontLeft:
+                left = 1.f;
+                break;
+            case kFrontRight:
+                right = 1.f;
+                break;
+            case kFrontCenter:
+                // a mono track is played at its level on both channels
+                left = numberChannels == 1 ? 1.f : CHANNEL_MAPPER_FOLD_GAIN;
+                right = left;
+                break;
+            case kBackLeft:
+            case kSideLeft:
+                left = CHANNEL_MAPPER_FOLD_GAIN;
+                break;
+            case kBackRight:
+            case kSideRight:
+                right = CHANNEL_MAPPER_FOLD_GAIN;
+                break;
+            case kBackCenter:
+                left = CHANNEL_MAPPER_FOLD_GAIN * CHANNEL_MAPPER_FOLD_GAIN;
+                right = left;
+                break;
+            default:
+                break;
+        }
+        _leftGains[i] = left * SAMPLE_SCALE;
+        _rightGains[i] = right * SAMPLE_SCALE;
+    }
+
+    switch (numberChannels) {
+        case 1:
+            _kernel = mapMono;
+            break;
+        case 2:
+            _kernel = mapStereo;
+            break;
+        case 3:
+            _kernel = downmix<3>;
+            break;
+        case 4:
+            _kernel = downmix<4>;
+            break;
+        case 5:
+            _kernel = downmix<5>;
+            break;
+        case 6:
+            _kernel = downmix<6>;
+            break;
+        case 7:
+            _kernel = downmix<7>;
+            break;
+        default:
+            _kernel = downmix<8>;
+            break;
+    }
+    return true;
+}
+
+void ChannelMapper::map(const short *samples, AUDIO_HARDWARE_SAMPLE_TYPE *frames,
+                        unsigned int numberFrames) const {
+    _kernel(this, samples, frames, numberFrames);
+}
+
+const short* ChannelMapper::completePartialFrame(const short **samples,
+                                                unsigned int *numberSamples) {
+    if (_numberPartialSamples == 0) {
+        return nullptr;
+    }
+    unsigned int count = _numberChannels - _numberPartialSamples;
+    if (count > *numberSamples) {
+        count = *numberSamples;
+    }
+    memcpy(_partialFrame + _numberPartialSamples, *samples, count * sizeof(short));
+    _numberPartialSamples += count;
+    *samples += count;
+    *numberSamples -= count;
+    if (_numberPartialSamples < (unsigned int) _numberChannels) {
+        return nullptr;
+    }
+    _numberPartialSamples = 0;
+    return _partialFrame;
+}
+
+void ChannelMapper::keepPartialFrame(const short *samples, unsigned int numberSamples) {
+    memcpy(_partialFrame + _numberPartialSamples, samples, numberSamples * sizeof(short));
+    _numberPartialSamples += numberSamples;
+}
+
+void ChannelMapper::mapGeneric(const short *samples, AUDIO_HARDWARE_SAMPLE_TYPE *frames,
+                               unsigned int numberFrames) const {
+    const int numberChannels = _numberChannels;
+    const int numberMixedChannels = numberChannels < CHANNEL_MAPPER_MAX_CHANNELS
+                                    ? numberChannels : CHANNEL_MAPPER_MAX_CHANNELS;
+    for (unsigned int i = 0; i < numberFrames; i++) {
+        const short *frame = samples + (size_t) i * numberChannels;
+        float left = 0.f;
+        float right = 0.f;
+        for (int channel = 0; channel < numberMixedChannels; channel++) {
+            left += frame[channel] * _leftGains[channel];
+            right += frame[channel] * _rightGains[channel];
+        }
+        frames[i * 2] = toPlayerSample(left);
+        frames[i * 2 + 1] = toPlayerSample(right);
+    }
+}
+
+void ChannelMapper::mapGenericKernel(const ChannelMapper *mapper, const short *samples,
+                                     AUDIO_HARDWARE_SAMPLE_TYPE *frames,
+                                     unsigned int numberFrames) {
+    mapper->mapGeneric(samples, frames, numberFrames);
+}
+
+template<int NUMBER_CHANNELS>
+void ChannelMapper::downmix(const ChannelMapper *mapper, const short *samples,
+                            AUDIO_HARDWARE_SAMPLE_TYPE *frames, unsigned int numberFrames) {
+    float4 leftGains[NUMBER_CHANNELS];
+    float4 rightGains[NUMBER_CHANNELS];
+    for (int channel = 0; channel < NUMBER_CHANNELS; channel++) {
+        const float left = mapper->_leftGains[channel];
+        const float right = mapper->_rightGains[channel];
+        leftGains[channel] = (float4) {left, left, left, left};
+        rightGains[channel] = (float4) {right, right, right, right};
+    }
+
+    unsigned int i = 0;
+    for (; i + VECTOR_FRAMES <= numberFrames; i += VECTOR_FRAMES) {
+        const short *block = samples + (size_t) i * NUMBER_CHANNELS;
+        float4 left = {0.f, 0.f, 0.f, 0.f};
+        float4 right = {0.f, 0.f, 0.f, 0.f};
+        // one lane per frame, the loop is unrolled for each layout
+        for (int channel = 0; channel < NUMBER_CHANNELS; channel++) {
+            const float4 channelSamples = {(float) block[channel],
+                                           (float) block[NUMBER_CHANNELS + channel],
+                                           (float) block[2 * NUMBER_CHANNELS + channel],
+                                           (float) block[3 * NUMBER_CHANNELS + channel]};
+            left += channelSamples * leftGains[channel];
+            right += channelSamples * rightGains[channel];
+        }
+        storeFrames(left, right, frames + i * 2);
+    }
+    mapper->mapGeneric(samples + (size_t) i * NUMBER_CHANNELS, frames + i * 2, numberFrames - i);
+}
+
+void ChannelMapper::mapMono(const ChannelMapper *, const short *samples,
+                            AUDIO_HARDWARE_SAMPLE_TYPE *frames, unsigned int numberFrames) {
+#ifdef FLOAT_PLAYER
+    const float4 scale = {SAMPLE_SCALE, SAMPLE_SCALE, SAMPLE_SCALE, SAMPLE_SCALE};
+    unsigned int i = 0;
+    for (; i + VECTOR_FRAMES <= numberFrames; i += VECTOR_FRAMES) {
+        const float4 block = (float4) {(float) samples[i], (float) samples[i + 1],
+                                       (float) samples[i + 2], (float) samples[i + 3]} * scale;
+        storeFrames(block, block, frames + i * 2);
+    }
+    for (; i < numberFrames; i++) {
+        frames[i * 2] = samples[i] * SAMPLE_SCALE;
+        frames[i * 2 + 1] = frames[i * 2];
+    }
+#else
+    // both samples of a frame are written at once
+    for (unsigned int i = 0; i < numberFrames; i++) {
+        const uint32_t sample = (uint16_t) samples[i];
+        const uint32_t frame = sample | (sample << 16);
+        memcpy(frames + i * 2, &frame, sizeof(frame));
+    }
+#endif
+}
+
+void ChannelMapper::mapStereo(const ChannelMapper *, const short *samples,
+                              AUDIO_HARDWARE_SAMPLE_TYPE *frames, unsigned int numberFrames) {
+#ifdef FLOAT_PLAYER
+    const float4 scale = {SAMPLE_SCALE, SAMPLE_SCALE, SAMPLE_SCALE, SAMPLE_SCALE};
+    const unsigned int numberSamples = numberFrames * 2;
+    unsigned int i = 0;
+    for (; i + VECTOR_FRAMES <= numberSamples; i += VECTOR_FRAMES) {
+        const float4 block = (float4) {(float) samples[i], (float) samples[i + 1],
+                                       (float) samples[i + 2], (float) samples[i + 3]} * scale;
+        memcpy(frames + i, &block, sizeof(block));
+    }
+    for (; i < numberSamples; i++) {
+        frames[i] = samples[i] * SAMPLE_SCALE;
+    }
+#else
+    memcpy(frames, samples, numberFrames * 2 * sizeof(short));
+#endif
+}
+
+double ChannelMapper::benchmark(int numberChannels, bool isGeneric, int numberFrames,
+                                int numberBlocks) {
+    ChannelMapper mapper;
+    if (!mapper.setNumberChannels(numberChannels)) {
+        return 0;
+    }
+
+    short *samples = (short *) malloc((size_t) numberFrames * numberChannels * sizeof(short));
+    AUDIO_HARDWARE_SAMPLE_TYPE *frames = (AUDIO_HARDWARE_SAMPLE_TYPE *) malloc(
+            (size_t) numberFrames * 2 * sizeof(AUDIO_HARDWARE_SAMPLE_TYPE));
+    for (int i = 0; i < numberFrames * numberChannels; i++) {
+        samples[i] = (short) (rand() % 20000 - 10000);
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < numberBlocks; i++) {
+        if (isGeneric) {
+            mapper.mapGeneric(samples, frames, (unsigned int) numberFrames);
+        } else {
+            mapper.map(samples, frames, (unsigned int) numberFrames);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    free(samples);
+    free(frames);
+
+    double elapsedNs = (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+    return elapsedNs / numberBlocks / numberFrames;
+}
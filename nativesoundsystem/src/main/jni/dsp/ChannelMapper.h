@@ -0,0 +1,113 @@
+//
+// Created by Frederic on 11/06/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_CHANNELMAPPER_H
+#define MINI_SOUND_SYSTEM_CHANNELMAPPER_H
+
+#include "audio/SampleType.h"
+
+// layouts with more channels only keep their front left and front right channels
+#define CHANNEL_MAPPER_MAX_CHANNELS 8
+
+// -3 dB, gain of the center and surround channels folded into the front channels
+#define CHANNEL_MAPPER_FOLD_GAIN 0.70710678f
+
+/**
+ * Map interleaved 16 bits frames decoded with any number of channels to the interleaved stereo
+ * frames of the player, converted to the sample type of the player.
+ *
+ * Channels are in the order of Android layouts : mono is played on both channels, stereo is copied
+ * and other layouts are downmixed with ITU-R BS.775 coefficients, the LFE channel being dropped.
+ * Coefficients are not normalized, so that the front channels keep their level : downmixed 16 bits
+ * samples are clamped.
+ *
+ * Each layout has its own kernel, mixing 4 frames at once with vectors of 16 bytes.
+ */
+class ChannelMapper {
+public:
+    ChannelMapper();
+    ChannelMapper& operator=(const ChannelMapper& ) = delete;
+    ChannelMapper(ChannelMapper&) = delete;
+    ~ChannelMapper();
+
+    /**
+     * Also drop the partial frame kept from the previous buffer.
+     * @return false if numberChannels is not valid, the layout is then unchanged.
+     */
+    bool setNumberChannels(int numberChannels);
+
+    inline int getNumberChannels() const {
+        return _numberChannels;
+    }
+
+    /**
+     * @param samples numberFrames * getNumberChannels() samples.
+     * @param frames numberFrames stereo frames written, can't overlap samples.
+     */
+    void map(const short *samples, AUDIO_HARDWARE_SAMPLE_TYPE *frames,
+             unsigned int numberFrames) const;
+
+    /**
+     * Frames can be split between the buffers of a decoder. Complete the partial frame kept by
+     * keepPartialFrame with the first samples of the next buffer.
+     * @param samples       moved after the samples used to complete the frame.
+     * @param numberSamples decremented by the samples used to complete the frame.
+     * @return the completed frame, to map before the frames of the buffer, or nullptr if there is
+     * no partial frame or if the buffer doesn't complete it.
+     */
+    const short* completePartialFrame(const short **samples, unsigned int *numberSamples);
+
+    /**
+     * Keep the samples following the whole frames of a buffer, they start the next buffer.
+     * @param numberSamples less than getNumberChannels().
+     */
+    void keepPartialFrame(const short *samples, unsigned int numberSamples);
+
+    /**
+     * Same result as map, frame by frame with the whole matrix of coefficients. Used as the
+     * reference of the kernels.
+     */
+    void mapGeneric(const short *samples, AUDIO_HARDWARE_SAMPLE_TYPE *frames,
+                    unsigned int numberFrames) const;
+
+    /**
+     * Measure the cost of the mapping of a layout.
+     * @param isGeneric true to measure mapGeneric instead of the kernel of the layout.
+     * @return nanoseconds per frame.
+     */
+    static double benchmark(int numberChannels, bool isGeneric, int numberFrames,
+                            int numberBlocks);
+
+private:
+
+    typedef void (*MapKernel)(const ChannelMapper *mapper, const short *samples,
+                              AUDIO_HARDWARE_SAMPLE_TYPE *frames, unsigned int numberFrames);
+
+    template<int NUMBER_CHANNELS>
+    static void downmix(const ChannelMapper *mapper, const short *samples,
+                        AUDIO_HARDWARE_SAMPLE_TYPE *frames, unsigned int numberFrames);
+
+    static void mapMono(const ChannelMapper *mapper, const short *samples,
+                        AUDIO_HARDWARE_SAMPLE_TYPE *frames, unsigned int numberFrames);
+
+    static void mapStereo(const ChannelMapper *mapper, const short *samples,
+                          AUDIO_HARDWARE_SAMPLE_TYPE *frames, unsigned int numberFrames);
+
+    static void mapGenericKernel(const ChannelMapper *mapper, const short *samples,
+                                 AUDIO_HARDWARE_SAMPLE_TYPE *frames, unsigned int numberFrames);
+
+    int _numberChannels;
+    MapKernel _kernel;
+
+    // gain of each decoded channel in the left and right channels of the player, including the
+    // conversion to the sample type of the player
+    float _leftGains[CHANNEL_MAPPER_MAX_CHANNELS];
+    float _rightGains[CHANNEL_MAPPER_MAX_CHANNELS];
+
+    // start of a frame split between two buffers, getNumberChannels() samples
+    short *_partialFrame;
+    unsigned int _numberPartialSamples;
+};
+
+#endif //MINI_SOUND_SYSTEM_CHANNELMAPPER_H
@@ -0,0 +1,149 @@
+// Host test of the channel mapping kernels, run by nativesoundsystem/run_host_tests.sh.
+// host test sources : dsp/ChannelMapper.cpp
+
+#include "ChannelMapper.h"
+
+#include <climits>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// frame counts around the VECTOR_FRAMES frames of the kernels, with and without a tail
+static const unsigned int testNumberFrames[] = {0, 1, 2, 3, 4, 5, 7, 8, 13, 1027};
+
+#ifdef FLOAT_PLAYER
+// kernels and mapGeneric may round their products differently
+#define TEST_TOLERANCE 1e-6f
+#else
+#define TEST_TOLERANCE 1.f
+#endif
+
+static short randomSample(int index) {
+    // full scale samples check the clamping of the downmix
+    switch (index % 16) {
+        case 0:
+            return SHRT_MAX;
+        case 1:
+            return SHRT_MIN;
+        case 2:
+            return 0;
+        default:
+            return (short) (rand() % 65536 - 32768);
+    }
+}
+
+static bool checkMapping(int numberChannels, unsigned int numberFrames) {
+    ChannelMapper mapper;
+    if (!mapper.setNumberChannels(numberChannels)) {
+        fprintf(stderr, "%d channels rejected\n", numberChannels);
+        return false;
+    }
+
+    const unsigned int numberSamples = numberFrames * numberChannels;
+    short *samples = (short *) malloc((numberSamples + 1) * sizeof(short));
+    // one more frame written after the block checks the kernels stop at numberFrames
+    const size_t framesSize = (numberFrames + 1) * 2 * sizeof(AUDIO_HARDWARE_SAMPLE_TYPE);
+    AUDIO_HARDWARE_SAMPLE_TYPE *frames = (AUDIO_HARDWARE_SAMPLE_TYPE *) malloc(framesSize);
+    AUDIO_HARDWARE_SAMPLE_TYPE *expectedFrames = (AUDIO_HARDWARE_SAMPLE_TYPE *) malloc(framesSize);
+    for (unsigned int i = 0; i < numberSamples; i++) {
+        samples[i] = randomSample((int) i);
+    }
+    memset(frames, 0x5a, framesSize);
+    memset(expectedFrames, 0x5a, framesSize);
+
+    mapper.map(samples, frames, numberFrames);
+    mapper.mapGeneric(samples, expectedFrames, numberFrames);
+
+    bool isValid = true;
+    for (unsigned int i = 0; i < numberFrames * 2 && isValid; i++) {
+        const float difference = fabsf((float) frames[i] - (float) expectedFrames[i]);
+        if (difference > TEST_TOLERANCE) {
+            fprintf(stderr, "%d channels, %u frames : sample %u is %f instead of %f\n",
+                    numberChannels, numberFrames, i, (float) frames[i], (float) expectedFrames[i]);
+            isValid = false;
+        }
+    }
+    if (isValid && memcmp(frames + numberFrames * 2, expectedFrames + numberFrames * 2,
+                          2 * sizeof(AUDIO_HARDWARE_SAMPLE_TYPE)) != 0) {
+        fprintf(stderr, "%d channels, %u frames : written after the block\n", numberChannels,
+                numberFrames);
+        isValid = false;
+    }
+
+    free(samples);
+    free(frames);
+    free(expectedFrames);
+    return isValid;
+}
+
+// layout with more channels than the mapper mixes, decoded in buffers which are not whole frames
+#define TEST_SPLIT_CHANNELS 10
+#define TEST_SPLIT_FRAMES 1000
+#define TEST_NUMBER_BUFFER_SIZES 7
+
+static bool checkSplitFrames() {
+    // buffer sizes of a decoder, none of them a multiple of the number of channels
+    static const unsigned int bufferSizes[TEST_NUMBER_BUFFER_SIZES] = {1, 7, 13, 256, 1021, 9, 3};
+
+    ChannelMapper mapper;
+    mapper.setNumberChannels(TEST_SPLIT_CHANNELS);
+    const unsigned int numberSamples = TEST_SPLIT_FRAMES * TEST_SPLIT_CHANNELS;
+    short *samples = (short *) malloc(numberSamples * sizeof(short));
+    const size_t framesSize = TEST_SPLIT_FRAMES * 2 * sizeof(AUDIO_HARDWARE_SAMPLE_TYPE);
+    AUDIO_HARDWARE_SAMPLE_TYPE *frames = (AUDIO_HARDWARE_SAMPLE_TYPE *) malloc(framesSize);
+    AUDIO_HARDWARE_SAMPLE_TYPE *expectedFrames = (AUDIO_HARDWARE_SAMPLE_TYPE *) malloc(framesSize);
+    for (unsigned int i = 0; i < numberSamples; i++) {
+        samples[i] = randomSample((int) i);
+    }
+    mapper.mapGeneric(samples, expectedFrames, TEST_SPLIT_FRAMES);
+
+    unsigned int numberFrames = 0;
+    unsigned int position = 0;
+    for (int i = 0; position < numberSamples; i++) {
+        const unsigned int bufferSize = bufferSizes[i % TEST_NUMBER_BUFFER_SIZES];
+        const short *buffer = samples + position;
+        unsigned int bufferSamples = numberSamples - position < bufferSize
+                                     ? numberSamples - position : bufferSize;
+        position += bufferSamples;
+
+        const short *partialFrame = mapper.completePartialFrame(&buffer, &bufferSamples);
+        if (partialFrame != nullptr) {
+            mapper.map(partialFrame, frames + numberFrames * 2, 1);
+            numberFrames++;
+        }
+        const unsigned int bufferFrames = bufferSamples / TEST_SPLIT_CHANNELS;
+        mapper.map(buffer, frames + numberFrames * 2, bufferFrames);
+        numberFrames += bufferFrames;
+        mapper.keepPartialFrame(buffer + bufferFrames * TEST_SPLIT_CHANNELS,
+                                bufferSamples - bufferFrames * TEST_SPLIT_CHANNELS);
+    }
+
+    const bool isValid = numberFrames == TEST_SPLIT_FRAMES
+                         && memcmp(frames, expectedFrames, framesSize) == 0;
+    if (!isValid) {
+        fprintf(stderr, "%d channels in split buffers : %u frames mapped, not the expected ones\n",
+                TEST_SPLIT_CHANNELS, numberFrames);
+    }
+    free(samples);
+    free(frames);
+    free(expectedFrames);
+    return isValid;
+}
+
+int main() {
+    srand(1);
+    int numberFailures = 0;
+    for (int numberChannels = 1; numberChannels <= CHANNEL_MAPPER_MAX_CHANNELS; numberChannels++) {
+        for (unsigned int i = 0; i < sizeof(testNumberFrames) / sizeof(testNumberFrames[0]); i++) {
+            if (!checkMapping(numberChannels, testNumberFrames[i])) {
+                numberFailures++;
+            }
+        }
+    }
+    if (!checkSplitFrames()) {
+        numberFailures++;
+    }
+    printf("Channel mapper : %d failures\n", numberFailures);
+    return numberFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,373 @@
+#include "Equalizer.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// ratio of the remaining distance to the target parameters covered at each block
+#define EQUALIZER_SMOOTHING 0.25f
+
+// under these differences, parameters jump to their target
+#define EQUALIZER_GAIN_EPSILON 0.01f
+#define EQUALIZER_FREQUENCY_EPSILON 0.001f
+#define EQUALIZER_Q_EPSILON 0.001f
+
+// state values under this threshold are flushed to avoid denormals
+#define EQUALIZER_DENORMAL_THRESHOLD 1e-15f
+
+// frequencies of the DJ equalizer bands
+#define THREE_BAND_LOW_FREQUENCY 250.f
+#define THREE_BAND_MID_FREQUENCY 1000.f
+#define THREE_BAND_MID_Q 0.7f
+#define THREE_BAND_HIGH_FREQUENCY 4000.f
+
+static const BiquadCoefficients IDENTITY_COEFFICIENTS = {1.f, 0.f, 0.f, 0.f, 0.f};
+
+static inline float4 blend(int4 mask, float4 ifTrue, float4 ifFalse) {
+    return (float4) (((int4) ifTrue & mask) | ((int4) ifFalse & ~mask));
+}
+
+static inline float smoothValue(float current, float target, float epsilon) {
+    float next = current + (target - current) * EQUALIZER_SMOOTHING;
+    return fabsf(target - next) < epsilon ? target : next;
+}
+
+Equalizer::Equalizer(int sampleRate, int maxFrames) :
+        _sampleRate(sampleRate),
+        _maxFrames(maxFrames),
+        _isSmoothing(false),
+        _numberActiveSections(0) {
+    for (int i = 0; i < EQUALIZER_MAX_SECTIONS; i++) {
+        _targetParameters[i].type = kSectionBypass;
+        _targetParameters[i].frequency = 1000.f;
+        _targetParameters[i].gainDb = 0.f;
+        _targetParameters[i].q = 0.707f;
+        _parameters[i] = _targetParameters[i];
+        _coefficients[i] = IDENTITY_COEFFICIENTS;
+        _nextCoefficients[i] = IDENTITY_COEFFICIENTS;
+    }
+    for (int i = 0; i < EQUALIZER_MAX_SECTIONS / 2; i++) {
+        _isPairActive[i] = false;
+    }
+    memset(_z1, 0, sizeof(_z1));
+    memset(_z2, 0, sizeof(_z2));
+    _floatFrames = (float *) calloc((size_t) _maxFrames * 2, sizeof(float));
+}
+
+Equalizer::~Equalizer() {
+    free(_floatFrames);
+}
+
+void Equalizer::setSection(int index, int type, float frequency, float gainDb, float q) {
+    if (index < 0 || index >= EQUALIZER_MAX_SECTIONS) {
+        return;
+    }
+    // keep the filter stable and under nyquist
+    const float maxFrequency = _sampleRate * 0.49f;
+    _targetParameters[index].frequency = frequency < 10.f ? 10.f :
+                                         (frequency > maxFrequency ? maxFrequency : frequency);
+    _targetParameters[index].gainDb = gainDb;
+    _targetParameters[index].q = q < 0.1f ? 0.1f : q;
+    _targetParameters[index].type = type;
+
+    if (type != _parameters[index].type) {
+        // a new filter type can't be smoothed, gains start from a flat response
+        _parameters[index] = _targetParameters[index];
+        if (type == kSectionPeaking || type == kSectionLowShelf || type == kSectionHighShelf) {
+            _parameters[index].gainDb = 0.f;
+        }
+    }
+    _isSmoothing = true;
+}
+
+void Equalizer::setThreeBandGains(float lowGainDb, float midGainDb, float highGainDb) {
+    setSection(0, kSectionLowShelf, THREE_BAND_LOW_FREQUENCY,
+               lowGainDb < EQUALIZER_KILL_GAIN_DB ? EQUALIZER_KILL_GAIN_DB : lowGainDb, 0.707f);
+    setSection(1, kSectionPeaking, THREE_BAND_MID_FREQUENCY,
+               midGainDb < EQUALIZER_KILL_GAIN_DB ? EQUALIZER_KILL_GAIN_DB : midGainDb,
+               THREE_BAND_MID_Q);
+    setSection(2, kSectionHighShelf, THREE_BAND_HIGH_FREQUENCY,
+               highGainDb < EQUALIZER_KILL_GAIN_DB ? EQUALIZER_KILL_GAIN_DB : highGainDb, 0.707f);
+}
+
+void Equalizer::reset() {
+    for (int i = 0; i < EQUALIZER_MAX_SECTIONS; i++) {
+        _targetParameters[i].type = kSectionBypass;
+        _targetParameters[i].gainDb = 0.f;
+        _parameters[i].type = kSectionBypass;
+    }
+    _isSmoothing = true;
+}
+
+void Equalizer::copySettings(const Equalizer &equalizer) {
+    memcpy(_targetParameters, equalizer._targetParameters, sizeof(_targetParameters));
+    memcpy(_parameters, equalizer._targetParameters, sizeof(_parameters));
+    _isSmoothing = true;
+
+    // coefficients are not ramped from the previous settings
+    updateParameters();
+    memcpy(_coefficients, _nextCoefficients, sizeof(_coefficients));
+}
+
+void Equalizer::updateParameters() {
+    if (!_isSmoothing) {
+        return;
+    }
+
+    _isSmoothing = false;
+    _numberActiveSections = 0;
+    for (int i = 0; i < EQUALIZER_MAX_SECTIONS; i++) {
+        EqualizerSectionParameters *current = &_parameters[i];
+        const EqualizerSectionParameters *target = &_targetParameters[i];
+
+        current->gainDb = smoothValue(current->gainDb, target->gainDb, EQUALIZER_GAIN_EPSILON);
+        current->q = smoothValue(current->q, target->q, EQUALIZER_Q_EPSILON);
+        // frequencies are smoothed on a logarithmic scale
+        float logFrequency = smoothValue(logf(current->frequency), logf(target->frequency),
+                                         EQUALIZER_FREQUENCY_EPSILON);
+        current->frequency = logFrequency == logf(target->frequency) ? target->frequency
+                                                                    : expf(logFrequency);
+
+        if (current->gainDb != target->gainDb || current->q != target->q
+            || current->frequency != target->frequency) {
+            _isSmoothing = true;
+        }
+
+        computeCoefficients(i, &_nextCoefficients[i]);
+        if (memcmp(&_nextCoefficients[i], &IDENTITY_COEFFICIENTS, sizeof(BiquadCoefficients)) != 0) {
+            _numberActiveSections++;
+        }
+    }
+}
+
+void Equalizer::computeCoefficients(int section, BiquadCoefficients *coefficients) {
+    const EqualizerSectionParameters *parameters = &_parameters[section];
+    const bool hasGain = parameters->type == kSectionPeaking
+                         || parameters->type == kSectionLowShelf
+                         || parameters->type == kSectionHighShelf;
+    if (parameters->type == kSectionBypass || (hasGain && parameters->gainDb == 0.f)) {
+        *coefficients = IDENTITY_COEFFICIENTS;
+        return;
+    }
+
+    // Robert Bristow-Johnson's audio EQ cookbook
+    const double A = pow(10.0, parameters->gainDb / 40.0);
+    const double w0 = 2.0 * M_PI * parameters->frequency / _sampleRate;
+    const double cosW0 = cos(w0);
+    const double alpha = sin(w0) / (2.0 * parameters->q);
+    const double sqrtA2Alpha = 2.0 * sqrt(A) * alpha;
+
+    double b0, b1, b2, a0, a1, a2;
+    switch (parameters->type) {
+        case kSectionPeaking:
+            b0 = 1.0 + alpha * A;
+            b1 = -2.0 * cosW0;
+            b2 = 1.0 - alpha * A;
+            a0 = 1.0 + alpha / A;
+            a1 = -2.0 * cosW0;
+            a2 = 1.0 - alpha / A;
+            break;
+        case kSectionLowShelf:
+            b0 = A * ((A + 1.0) - (A - 1.0) * cosW0 + sqrtA2Alpha);
+            b1 = 2.0 * A * ((A - 1.0) - (A + 1.0) * cosW0);
+            b2 = A * ((A + 1.0) - (A - 1.0) * cosW0 - sqrtA2Alpha);
+            a0 = (A + 1.0) + (A - 1.0) * cosW0 + sqrtA2Alpha;
+            a1 = -2.0 * ((A - 1.0) + (A + 1.0) * cosW0);
+            a2 = (A + 1.0) + (A - 1.0) * cosW0 - sqrtA2Alpha;
+            break;
+        case kSectionHighShelf:
+            b0 = A * ((A + 1.0) + (A - 1.0) * cosW0 + sqrtA2Alpha);
+            b1 = -2.0 * A * ((A - 1.0) + (A + 1.0) * cosW0);
+            b2 = A * ((A + 1.0) + (A - 1.0) * cosW0 - sqrtA2Alpha);
+            a0 = (A + 1.0) - (A - 1.0) * cosW0 + sqrtA2Alpha;
+            a1 = 2.0 * ((A - 1.0) - (A + 1.0) * cosW0);
+            a2 = (A + 1.0) - (A - 1.0) * cosW0 - sqrtA2Alpha;
+            break;
+        case kSectionLowPass:
+            b0 = (1.0 - cosW0) / 2.0;
+            b1 = 1.0 - cosW0;
+            b2 = (1.0 - cosW0) / 2.0;
+            a0 = 1.0 + alpha;
+            a1 = -2.0 * cosW0;
+            a2 = 1.0 - alpha;
+            break;
+        case kSectionHighPass:
+        default:
+            b0 = (1.0 + cosW0) / 2.0;
+            b1 = -(1.0 + cosW0);
+            b2 = (1.0 + cosW0) / 2.0;
+            a0 = 1.0 + alpha;
+            a1 = -2.0 * cosW0;
+            a2 = 1.0 - alpha;
+            break;
+    }
+
+    coefficients->b0 = (float) (b0 / a0);
+    coefficients->b1 = (float) (b1 / a0);
+    coefficients->b2 = (float) (b2 / a0);
+    coefficients->a1 = (float) (a1 / a0);
+    coefficients->a2 = (float) (a2 / a0);
+}
+
+void Equalizer::process(float *frames, int numberFrames) {
+    updateParameters();
+    processBlock(frames, numberFrames);
+}
+
+void Equalizer::processBlock(float *frames, int numberFrames) {
+    if (numberFrames > 0) {
+        for (int pair = 0; pair < EQUALIZER_MAX_SECTIONS / 2; pair++) {
+            const bool ramp = memcmp(&_coefficients[2 * pair], &_nextCoefficients[2 * pair],
+                                     2 * sizeof(BiquadCoefficients)) != 0;
+            const bool isActive = ramp
+                                  || memcmp(&_nextCoefficients[2 * pair], &IDENTITY_COEFFICIENTS,
+                                            sizeof(BiquadCoefficients)) != 0
+                                  || memcmp(&_nextCoefficients[2 * pair + 1], &IDENTITY_COEFFICIENTS,
+                                            sizeof(BiquadCoefficients)) != 0;
+            if (isActive) {
+                processPair(pair, frames, numberFrames, ramp);
+            } else if (_isPairActive[pair]) {
+                // pair just became transparent, its state is meaningless now
+                memset(_z1[pair], 0, sizeof(_z1[pair]));
+                memset(_z2[pair], 0, sizeof(_z2[pair]));
+            }
+            _isPairActive[pair] = isActive;
+        }
+    }
+
+    memcpy(_coefficients, _nextCoefficients, sizeof(_coefficients));
+}
+
+void Equalizer::process(short *frames, int numberFrames) {
+    if (numberFrames > _maxFrames) {
+        numberFrames = _maxFrames;
+    }
+
+    updateParameters();
+    if (_numberActiveSections == 0
+        && memcmp(_coefficients, _nextCoefficients, sizeof(_coefficients)) == 0) {
+        // nothing to do, avoid conversions
+        return;
+    }
+
+    const int numberSamples = numberFrames * 2;
+    for (int i = 0; i < numberSamples; i++) {
+        _floatFrames[i] = frames[i] * (1.f / 32768.f);
+    }
+    processBlock(_floatFrames, numberFrames);
+    for (int i = 0; i < numberSamples; i++) {
+        float sample = _floatFrames[i] * 32768.f;
+        frames[i] = (short) (sample > 32767.f ? 32767 : (sample < -32768.f ? -32768 : lrintf(sample)));
+    }
+}
+
+void Equalizer::processPair(int pair, float *frames, int numberFrames, bool ramp) {
+    const BiquadCoefficients *startA = &_coefficients[2 * pair];
+    const BiquadCoefficients *startB = &_coefficients[2 * pair + 1];
+    const BiquadCoefficients *endA = &_nextCoefficients[2 * pair];
+    const BiquadCoefficients *endB = &_nextCoefficients[2 * pair + 1];
+
+    float4 b0 = {startA->b0, startA->b0, startB->b0, startB->b0};
+    float4 b1 = {startA->b1, startA->b1, startB->b1, startB->b1};
+    float4 b2 = {startA->b2, startA->b2, startB->b2, startB->b2};
+    float4 a1 = {startA->a1, startA->a1, startB->a1, startB->a1};
+    float4 a2 = {startA->a2, startA->a2, startB->a2, startB->a2};
+
+    float4 db0 = {0.f, 0.f, 0.f, 0.f};
+    float4 db1 = db0, db2 = db0, da1 = db0, da2 = db0;
+    if (ramp) {
+        const float4 step = {1.f / numberFrames, 1.f / numberFrames, 1.f / numberFrames,
+                             1.f / numberFrames};
+        const float4 endB0 = {endA->b0, endA->b0, endB->b0, endB->b0};
+        const float4 endB1 = {endA->b1, endA->b1, endB->b1, endB->b1};
+        const float4 endB2 = {endA->b2, endA->b2, endB->b2, endB->b2};
+        const float4 endA1 = {endA->a1, endA->a1, endB->a1, endB->a1};
+        const float4 endA2 = {endA->a2, endA->a2, endB->a2, endB->a2};
+        db0 = (endB0 - b0) * step;
+        db1 = (endB1 - b1) * step;
+        db2 = (endB2 - b2) * step;
+        da1 = (endA1 - a1) * step;
+        da2 = (endA2 - a2) * step;
+    }
+
+    const int4 maskA = {-1, -1, 0, 0};
+    const int4 maskB = ~maskA;
+    float4 z1;
+    float4 z2;
+    memcpy(&z1, _z1[pair], sizeof(z1));
+    memcpy(&z2, _z2[pair], sizeof(z2));
+
+    // first frame : only the first section has an input
+    float4 x = {frames[0], frames[1], 0.f, 0.f};
+    float4 y = b0 * x + z1;
+    z1 = blend(maskA, b1 * x - a1 * y + z2, z1);
+    z2 = blend(maskA, b2 * x - a2 * y, z2);
+    float outputA0 = y[0];
+    float outputA1 = y[1];
+
+    for (int n = 1; n < numberFrames; n++) {
+        b0 += db0;
+        b1 += db1;
+        b2 += db2;
+        a1 += da1;
+        a2 += da2;
+
+        float4 input = {frames[2 * n], frames[2 * n + 1], outputA0, outputA1};
+        y = b0 * input + z1;
+        z1 = b1 * input - a1 * y + z2;
+        z2 = b2 * input - a2 * y;
+
+        frames[2 * n - 2] = y[2];
+        frames[2 * n - 1] = y[3];
+        outputA0 = y[0];
+        outputA1 = y[1];
+    }
+
+    // last frame : only the second section has an input
+    float4 lastInput = {0.f, 0.f, outputA0, outputA1};
+    y = b0 * lastInput + z1;
+    z1 = blend(maskB, b1 * lastInput - a1 * y + z2, z1);
+    z2 = blend(maskB, b2 * lastInput - a2 * y, z2);
+    frames[2 * numberFrames - 2] = y[2];
+    frames[2 * numberFrames - 1] = y[3];
+
+    for (int lane = 0; lane < 4; lane++) {
+        if (fabsf(z1[lane]) < EQUALIZER_DENORMAL_THRESHOLD) {
+            z1[lane] = 0.f;
+        }
+        if (fabsf(z2[lane]) < EQUALIZER_DENORMAL_THRESHOLD) {
+            z2[lane] = 0.f;
+        }
+    }
+    memcpy(_z1[pair], &z1, sizeof(z1));
+    memcpy(_z2[pair], &z2, sizeof(z2));
+}
+
+double Equalizer::benchmark(int sampleRate, int numberFrames, int numberBlocks) {
+    Equalizer equalizer(sampleRate, numberFrames);
+    for (int i = 0; i < EQUALIZER_MAX_SECTIONS; i++) {
+        equalizer.setSection(i, kSectionPeaking, 100.f * (i + 1), 3.f, 1.f);
+    }
+
+    float *frames = (float *) malloc((size_t) numberFrames * 2 * sizeof(float));
+    for (int i = 0; i < numberFrames * 2; i++) {
+        frames[i] = (float) (rand() % 2000 - 1000) / 1000.f;
+    }
+
+    // let parameters reach their target before measuring
+    for (int i = 0; i < 100; i++) {
+        equalizer.process(frames, numberFrames);
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < numberBlocks; i++) {
+        equalizer.process(frames, numberFrames);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    free(frames);
+
+    double elapsedNs = (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+    return elapsedNs / numberBlocks / EQUALIZER_MAX_SECTIONS;
+}
@@ -0,0 +1,141 @@
+//
+// Created by Frederic on 16/05/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_EQUALIZER_H
+#define MINI_SOUND_SYSTEM_EQUALIZER_H
+
+#include <stdint.h>
+
+// number of biquad sections of the chain, must be even
+#define EQUALIZER_MAX_SECTIONS 8
+
+// gain of a killed band of the DJ equalizer
+#define EQUALIZER_KILL_GAIN_DB -60.f
+
+// 4 float lanes : left and right channels of two consecutive sections
+typedef float float4 __attribute__((vector_size(16)));
+typedef int32_t int4 __attribute__((vector_size(16)));
+
+enum EqualizerSectionType {
+    kSectionBypass = 0,
+    kSectionPeaking,
+    kSectionLowShelf,
+    kSectionHighShelf,
+    kSectionLowPass,
+    kSectionHighPass,
+};
+
+typedef struct {
+    int type;
+    float frequency;
+    float gainDb;
+    float q;
+} EqualizerSectionParameters;
+
+typedef struct {
+    float b0;
+    float b1;
+    float b2;
+    float a1;
+    float a2;
+} BiquadCoefficients;
+
+/**
+ * Chain of biquad filters applied in place on interleaved stereo blocks.
+ *
+ * Sections are processed by pairs with 4 float lanes : while the first section of a pair filters
+ * frame n, the second one filters the output of the first section for frame n - 1. So both channels
+ * of two sections are computed by each vector operation.
+ *
+ * Parameters are changed from the thread calling process. They are smoothed block after block and
+ * coefficients are ramped inside a block, nothing is allocated in process.
+ */
+class Equalizer {
+public:
+    /**
+     * @param maxFrames maximum number of frames of a processed block.
+     */
+    Equalizer(int sampleRate, int maxFrames);
+    Equalizer& operator=(const Equalizer& ) = delete;
+    Equalizer(Equalizer&) = delete;
+    ~Equalizer();
+
+    /**
+     * Configure a section of the chain.
+     * @param type      one of EqualizerSectionType.
+     * @param frequency center or cutoff frequency in Hz.
+     * @param gainDb    gain of peaking and shelving filters.
+     * @param q         quality factor, 0.707 for a butterworth response.
+     */
+    void setSection(int index, int type, float frequency, float gainDb, float q);
+
+    /**
+     * Configure the three first sections as a DJ equalizer : low shelf, mid peak and high shelf.
+     * A gain of EQUALIZER_KILL_GAIN_DB or less kills the band.
+     */
+    void setThreeBandGains(float lowGainDb, float midGainDb, float highGainDb);
+
+    /**
+     * Remove all sections.
+     */
+    void reset();
+
+    /**
+     * Use the sections of another equalizer, without smoothing.
+     */
+    void copySettings(const Equalizer &equalizer);
+
+    /**
+     * Filter interleaved stereo frames in place. Called from the audio thread.
+     */
+    void process(float *frames, int numberFrames);
+
+    void process(short *frames, int numberFrames);
+
+    inline int getNumberActiveSections(){
+        return _numberActiveSections;
+    }
+
+    /**
+     * Measure the cost of the chain with all sections active.
+     * @return nanoseconds per section per block of numberFrames.
+     */
+    static double benchmark(int sampleRate, int numberFrames, int numberBlocks);
+
+private:
+
+    // one smoothing step of the parameters, exactly once per processed block
+    void updateParameters();
+
+    // filter the block with the current coefficients, ramped to the next ones
+    void processBlock(float *frames, int numberFrames);
+
+    void computeCoefficients(int section, BiquadCoefficients *coefficients);
+
+    void processPair(int pair, float *frames, int numberFrames, bool ramp);
+
+    int _sampleRate;
+    int _maxFrames;
+
+    // parameters set by the user and smoothed parameters used by the current block
+    EqualizerSectionParameters _targetParameters[EQUALIZER_MAX_SECTIONS];
+    EqualizerSectionParameters _parameters[EQUALIZER_MAX_SECTIONS];
+    bool _isSmoothing;
+    int _numberActiveSections;
+    bool _isPairActive[EQUALIZER_MAX_SECTIONS / 2];
+
+    // coefficients at the start and at the end of the current block
+    BiquadCoefficients _coefficients[EQUALIZER_MAX_SECTIONS];
+    BiquadCoefficients _nextCoefficients[EQUALIZER_MAX_SECTIONS];
+
+    // transposed direct form II state of each pair, in the lane order of float4.
+    // not stored as float4 because heap blocks are only 8 bytes aligned on 32 bits devices.
+    float _z1[EQUALIZER_MAX_SECTIONS / 2][4];
+    float _z2[EQUALIZER_MAX_SECTIONS / 2][4];
+
+    // conversion buffer of 16 bits samples
+    float *_floatFrames;
+};
+
+#endif //MINI_SOUND_SYSTEM_EQUALIZER_H
@@ -0,0 +1,158 @@
+#include "FFT.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// butterflies computed at once
+#define VECTOR_LANES 4
+
+typedef float float4 __attribute__((vector_size(16)));
+
+static int* createBitReverse(int size) {
+    int numberBits = 0;
+    while ((1 << numberBits) < size) {
+        numberBits++;
+    }
+
+    int *bitReverse = (int *) malloc(size * sizeof(int));
+    for (int i = 0; i < size; i++) {
+        int reversed = 0;
+        for (int bit = 0; bit < numberBits; bit++) {
+            reversed |= ((i >> bit) & 1) << (numberBits - 1 - bit);
+        }
+        bitReverse[i] = reversed;
+    }
+    return bitReverse;
+}
+
+FFT::FFT(int size) :
+        _size(size) {
+    _bitReverse = createBitReverse(_size);
+    _halfBitReverse = createBitReverse(_size / 2);
+
+    _cos = (float *) malloc(_size / 2 * sizeof(float));
+    _sin = (float *) malloc(_size / 2 * sizeof(float));
+    for (int i = 0; i < _size / 2; i++) {
+        _cos[i] = (float) cos(2.0 * M_PI * i / _size);
+        _sin[i] = (float) -sin(2.0 * M_PI * i / _size);
+    }
+
+    // a stage of half length h uses exp(-2 pi i k / 2h) for k < h
+    _stageCos = (float *) malloc(_size * sizeof(float));
+    _stageSin = (float *) malloc(_size * sizeof(float));
+    for (int halfLength = 1; halfLength < _size; halfLength <<= 1) {
+        const int twiddleStep = _size / (halfLength * 2);
+        for (int k = 0; k < halfLength; k++) {
+            _stageCos[halfLength - 1 + k] = _cos[k * twiddleStep];
+            _stageSin[halfLength - 1 + k] = _sin[k * twiddleStep];
+        }
+    }
+
+    _window = (float *) malloc(_size * sizeof(float));
+    for (int i = 0; i < _size; i++) {
+        _window[i] = (float) (0.5 - 0.5 * cos(2.0 * M_PI * i / (_size - 1)));
+    }
+
+    _real = (float *) malloc(_size * sizeof(float));
+    _imag = (float *) malloc(_size * sizeof(float));
+}
+
+FFT::~FFT() {
+    free(_bitReverse);
+    free(_halfBitReverse);
+    free(_cos);
+    free(_sin);
+    free(_stageCos);
+    free(_stageSin);
+    free(_window);
+    free(_real);
+    free(_imag);
+}
+
+void FFT::forward(float *real, float *imag) {
+    transform(real, imag, _size, _bitReverse);
+}
+
+void FFT::transform(float *real, float *imag, int numberValues, const int *bitReverse) {
+    for (int i = 0; i < numberValues; i++) {
+        int j = bitReverse[i];
+        if (j > i) {
+            float tmp = real[i];
+            real[i] = real[j];
+            real[j] = tmp;
+            tmp = imag[i];
+            imag[i] = imag[j];
+            imag[j] = tmp;
+        }
+    }
+
+    for (int halfLength = 1; halfLength < numberValues; halfLength <<= 1) {
+        const float *stageCos = _stageCos + halfLength - 1;
+        const float *stageSin = _stageSin + halfLength - 1;
+        for (int start = 0; start < numberValues; start += halfLength * 2) {
+            float *evenReal = real + start;
+            float *evenImag = imag + start;
+            float *oddReal = evenReal + halfLength;
+            float *oddImag = evenImag + halfLength;
+
+            // buffers are not aligned on 16 bytes, vectors are copied
+            int k = 0;
+            for (; k + VECTOR_LANES <= halfLength; k += VECTOR_LANES) {
+                float4 wr, wi, er, ei, or_, oi;
+                memcpy(&wr, stageCos + k, sizeof(wr));
+                memcpy(&wi, stageSin + k, sizeof(wi));
+                memcpy(&er, evenReal + k, sizeof(er));
+                memcpy(&ei, evenImag + k, sizeof(ei));
+                memcpy(&or_, oddReal + k, sizeof(or_));
+                memcpy(&oi, oddImag + k, sizeof(oi));
+                const float4 tr = or_ * wr - oi * wi;
+                const float4 ti = or_ * wi + oi * wr;
+                const float4 newOddReal = er - tr;
+                const float4 newOddImag = ei - ti;
+                const float4 newEvenReal = er + tr;
+                const float4 newEvenImag = ei + ti;
+                memcpy(oddReal + k, &newOddReal, sizeof(newOddReal));
+                memcpy(oddImag + k, &newOddImag, sizeof(newOddImag));
+                memcpy(evenReal + k, &newEvenReal, sizeof(newEvenReal));
+                memcpy(evenImag + k, &newEvenImag, sizeof(newEvenImag));
+            }
+
+            // first two stages
+            for (; k < halfLength; k++) {
+                float wr = stageCos[k];
+                float wi = stageSin[k];
+                float tr = oddReal[k] * wr - oddImag[k] * wi;
+                float ti = oddReal[k] * wi + oddImag[k] * wr;
+                oddReal[k] = evenReal[k] - tr;
+                oddImag[k] = evenImag[k] - ti;
+                evenReal[k] += tr;
+                evenImag[k] += ti;
+            }
+        }
+    }
+}
+
+void FFT::powerSpectrum(const float *input, float *power) {
+    const int halfSize = _size / 2;
+    for (int i = 0; i < halfSize; i++) {
+        _real[i] = input[2 * i] * _window[2 * i];
+        _imag[i] = input[2 * i + 1] * _window[2 * i + 1];
+    }
+    transform(_real, _imag, halfSize, _halfBitReverse);
+
+    // bins 0 and size / 2 of a real signal are real
+    power[0] = (_real[0] + _imag[0]) * (_real[0] + _imag[0]);
+    power[halfSize] = (_real[0] - _imag[0]) * (_real[0] - _imag[0]);
+    for (int k = 1; k < halfSize; k++) {
+        // spectra of the even samples and of the odd samples
+        const float evenReal = (_real[k] + _real[halfSize - k]) * 0.5f;
+        const float evenImag = (_imag[k] - _imag[halfSize - k]) * 0.5f;
+        const float oddReal = (_imag[k] + _imag[halfSize - k]) * 0.5f;
+        const float oddImag = (_real[halfSize - k] - _real[k]) * 0.5f;
+        const float real = evenReal + _cos[k] * oddReal - _sin[k] * oddImag;
+        const float imag = evenImag + _cos[k] * oddImag + _sin[k] * oddReal;
+        power[k] = real * real + imag * imag;
+    }
+}
@@ -0,0 +1,61 @@
+//
+// Created by Frederic on 09/05/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_FFT_H
+#define MINI_SOUND_SYSTEM_FFT_H
+
+/**
+ * Radix-2 complex FFT of a fixed power of two size. Twiddles and bit reversal are computed once in
+ * the constructor so transforms don't allocate.
+ *
+ * Butterflies are computed on 4 lanes with the vector extensions of the compiler, with the twiddles
+ * of each stage stored contiguously. A real signal is transformed as half as many complex values.
+ */
+class FFT {
+public:
+    FFT(int size);
+    FFT& operator=(const FFT& ) = delete;
+    FFT(FFT&) = delete;
+    ~FFT();
+
+    /**
+     * In place forward transform.
+     */
+    void forward(float *real, float *imag);
+
+    /**
+     * Power spectrum of a real signal, windowed with a Hann window. Even samples are transformed as
+     * the real part and odd samples as the imaginary part of size / 2 values, the spectrum is then
+     * separated.
+     * @param input size samples, size of at least 4.
+     * @param power size / 2 + 1 bins.
+     */
+    void powerSpectrum(const float *input, float *power);
+
+    inline int getSize(){
+        return _size;
+    }
+
+private:
+
+    // in place transform of numberValues values, size or size / 2
+    void transform(float *real, float *imag, int numberValues, const int *bitReverse);
+
+    int _size;
+    int *_bitReverse;
+    int *_halfBitReverse;
+    // exp(-2 pi i k / size) for k < size / 2
+    float *_cos;
+    float *_sin;
+    // twiddles of the stage of butterflies of half length h from index h - 1
+    float *_stageCos;
+    float *_stageSin;
+    float *_window;
+
+    // work buffers of powerSpectrum
+    float *_real;
+    float *_imag;
+};
+
+#endif //MINI_SOUND_SYSTEM_FFT_H
@@ -0,0 +1,163 @@
+#include "SilenceDetector.h"
+
+#include <climits>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+// 16 bytes of samples
+#ifdef FLOAT_PLAYER
+typedef float sampleVector __attribute__((vector_size(16)));
+typedef int32_t maskVector __attribute__((vector_size(16)));
+#define FULL_SCALE 1.f
+#else
+typedef short sampleVector __attribute__((vector_size(16)));
+typedef short maskVector __attribute__((vector_size(16)));
+#define FULL_SCALE ((float) SHRT_MAX)
+#endif
+
+#define VECTOR_LANES (sizeof(sampleVector) / sizeof(AUDIO_HARDWARE_SAMPLE_TYPE))
+
+static inline sampleVector select(maskVector mask, sampleVector ifTrue, sampleVector ifFalse) {
+    return (sampleVector) (((maskVector) ifTrue & mask) | ((maskVector) ifFalse & ~mask));
+}
+
+static inline float absoluteSample(AUDIO_HARDWARE_SAMPLE_TYPE sample) {
+    return sample < 0 ? -(float) sample : (float) sample;
+}
+
+SilenceDetector::SilenceDetector(int sampleRate) :
+        _sampleRate(sampleRate) {
+    setParameters(SILENCE_DEFAULT_THRESHOLD_DB, SILENCE_DEFAULT_MIN_DURATION_MS);
+    reset();
+}
+
+void SilenceDetector::setParameters(float thresholdDb, int minDurationMs) {
+    _threshold = FULL_SCALE * powf(10.f, thresholdDb / 20.f);
+    _minDurationFrames = minDurationMs > 0 ? (unsigned int) ((long) minDurationMs * _sampleRate / 1000)
+                                           : 0;
+}
+
+void SilenceDetector::reset() {
+    _numberFrames = 0;
+    _hasAudibleFrames = false;
+    _firstAudibleFrame = 0;
+    _lastAudibleFrame = 0;
+}
+
+void SilenceDetector::process(const AUDIO_HARDWARE_SAMPLE_TYPE *frames,
+                              unsigned int numberFrames) {
+    unsigned int numberFramesProcessed = 0;
+    while (numberFramesProcessed < numberFrames) {
+        unsigned int remainingFrames = numberFrames - numberFramesProcessed;
+        unsigned int blockFrames = remainingFrames < SILENCE_BLOCK_FRAMES ? remainingFrames
+                                                                          : SILENCE_BLOCK_FRAMES;
+        processBlock(frames + numberFramesProcessed * 2, blockFrames);
+        numberFramesProcessed += blockFrames;
+    }
+}
+
+void SilenceDetector::processTrack(const AUDIO_HARDWARE_SAMPLE_TYPE *frames,
+                                   unsigned int numberFrames) {
+    reset();
+
+    // forward until the first audible block
+    while (_numberFrames < numberFrames && !_hasAudibleFrames) {
+        unsigned int remainingFrames = numberFrames - _numberFrames;
+        processBlock(frames + _numberFrames * 2, remainingFrames < SILENCE_BLOCK_FRAMES
+                                                 ? remainingFrames : SILENCE_BLOCK_FRAMES);
+    }
+    if (!_hasAudibleFrames) {
+        return;
+    }
+
+    // backward until the last audible block
+    const unsigned int audibleEnd = _numberFrames;
+    unsigned int end = numberFrames;
+    bool isLastFound = false;
+    while (end > audibleEnd && !isLastFound) {
+        unsigned int blockStart = end - audibleEnd < SILENCE_BLOCK_FRAMES ? audibleEnd
+                                                                          : end - SILENCE_BLOCK_FRAMES;
+        _numberFrames = blockStart;
+        processBlock(frames + blockStart * 2, end - blockStart);
+        isLastFound = _lastAudibleFrame >= blockStart;
+        end = blockStart;
+    }
+    _numberFrames = numberFrames;
+}
+
+void SilenceDetector::processBlock(const AUDIO_HARDWARE_SAMPLE_TYPE *frames,
+                                   unsigned int numberFrames) {
+    if (computePeak(frames, numberFrames * 2) > _threshold) {
+        if (!_hasAudibleFrames) {
+            unsigned int i = 0;
+            while (absoluteSample(frames[i * 2]) <= _threshold
+                   && absoluteSample(frames[i * 2 + 1]) <= _threshold) {
+                i++;
+            }
+            _hasAudibleFrames = true;
+            _firstAudibleFrame = _numberFrames + i;
+        }
+
+        // sound usually goes on until the end of the block
+        unsigned int i = numberFrames - 1;
+        while (absoluteSample(frames[i * 2]) <= _threshold
+               && absoluteSample(frames[i * 2 + 1]) <= _threshold) {
+            i--;
+        }
+        _lastAudibleFrame = _numberFrames + i;
+    }
+    _numberFrames += numberFrames;
+}
+
+unsigned int SilenceDetector::getFirstAudibleFrame() {
+    if (!_hasAudibleFrames || _firstAudibleFrame < _minDurationFrames) {
+        return 0;
+    }
+    return _firstAudibleFrame;
+}
+
+unsigned int SilenceDetector::getLastAudibleFrame() {
+    if (_numberFrames == 0) {
+        return 0;
+    }
+    if (!_hasAudibleFrames || _numberFrames - 1 - _lastAudibleFrame < _minDurationFrames) {
+        return _numberFrames - 1;
+    }
+    return _lastAudibleFrame;
+}
+
+float SilenceDetector::computePeak(const AUDIO_HARDWARE_SAMPLE_TYPE *samples,
+                                   unsigned int numberSamples) {
+    // highest and lowest samples, so that no absolute value is needed in the loop
+    float peak = 0.f;
+    unsigned int i = 0;
+    if (numberSamples >= VECTOR_LANES) {
+        sampleVector highest;
+        memcpy(&highest, samples, sizeof(sampleVector));
+        sampleVector lowest = highest;
+        for (i = VECTOR_LANES; i + VECTOR_LANES <= numberSamples; i += VECTOR_LANES) {
+            sampleVector x;
+            memcpy(&x, samples + i, sizeof(sampleVector));
+            highest = select(x > highest, x, highest);
+            lowest = select(x < lowest, x, lowest);
+        }
+        for (unsigned int lane = 0; lane < VECTOR_LANES; lane++) {
+            const float high = absoluteSample(highest[lane]);
+            const float low = absoluteSample(lowest[lane]);
+            if (high > peak) {
+                peak = high;
+            }
+            if (low > peak) {
+                peak = low;
+            }
+        }
+    }
+    for (; i < numberSamples; i++) {
+        const float sample = absoluteSample(samples[i]);
+        if (sample > peak) {
+            peak = sample;
+        }
+    }
+    return peak;
+}
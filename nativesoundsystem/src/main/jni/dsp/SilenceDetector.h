@@ -0,0 +1,102 @@
+//
+// Created by Frederic on 10/06/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_SILENCEDETECTOR_H
+#define MINI_SOUND_SYSTEM_SILENCEDETECTOR_H
+
+#include "audio/SampleType.h"
+
+// level under which a frame is silent
+#define SILENCE_DEFAULT_THRESHOLD_DB -60.f
+
+// leading or trailing silence shorter than this is kept
+#define SILENCE_DEFAULT_MIN_DURATION_MS 500
+
+// frames whose peak is computed at once, a block with a louder peak is searched frame by frame
+#define SILENCE_BLOCK_FRAMES 1024
+
+typedef struct {
+    // leading frames which have not been stored
+    unsigned int trimmedFrames;
+    // in stored frames
+    unsigned int firstAudibleFrame;
+    unsigned int lastAudibleFrame;
+    // parameters the silence was detected with
+    float thresholdDb;
+    int minDurationMs;
+} TrackSilence;
+
+/**
+ * Find the first and the last audible frames of interleaved stereo frames given block after block,
+ * for example while a track is extracted.
+ *
+ * The peak of each block is computed with vectors of samples. Only blocks louder than the threshold
+ * are searched frame by frame, to find where the sound starts or ends.
+ */
+class SilenceDetector {
+public:
+    SilenceDetector(int sampleRate);
+    SilenceDetector& operator=(const SilenceDetector& ) = delete;
+    SilenceDetector(SilenceDetector&) = delete;
+
+    void setParameters(float thresholdDb, int minDurationMs);
+
+    // forget frames processed, parameters are kept
+    void reset();
+
+    void process(const AUDIO_HARDWARE_SAMPLE_TYPE *frames, unsigned int numberFrames);
+
+    /**
+     * Same result as process on a whole track, but only the silence at the start and at the end of
+     * the track is read, so that a file mapping is not read entirely.
+     */
+    void processTrack(const AUDIO_HARDWARE_SAMPLE_TYPE *frames, unsigned int numberFrames);
+
+    inline bool hasAudibleFrames() {
+        return _hasAudibleFrames;
+    }
+
+    inline unsigned int getNumberFrames() {
+        return _numberFrames;
+    }
+
+    inline unsigned int getMinDurationFrames() {
+        return _minDurationFrames;
+    }
+
+    /**
+     * @return first audible frame, 0 if the leading silence is shorter than the minimum duration or
+     * if no frame is audible yet.
+     */
+    unsigned int getFirstAudibleFrame();
+
+    /**
+     * @return last audible frame, the last frame processed if the trailing silence is shorter than
+     * the minimum duration.
+     */
+    unsigned int getLastAudibleFrame();
+
+    /**
+     * Highest absolute sample, computed with vectors of 16 bytes of samples.
+     * @return peak in the unit of samples.
+     */
+    static float computePeak(const AUDIO_HARDWARE_SAMPLE_TYPE *samples, unsigned int numberSamples);
+
+private:
+
+    void processBlock(const AUDIO_HARDWARE_SAMPLE_TYPE *frames, unsigned int numberFrames);
+
+    int _sampleRate;
+    unsigned int _minDurationFrames;
+
+    // in the unit of samples
+    float _threshold;
+
+    unsigned int _numberFrames;
+    bool _hasAudibleFrames;
+    unsigned int _firstAudibleFrame;
+    unsigned int _lastAudibleFrame;
+};
+
+#endif //MINI_SOUND_SYSTEM_SILENCEDETECTOR_H
@@ -1,5 +1,7 @@
 #include "SoundSystemCallback.h"
 
+#include <utils/Tracer.h>
+
 JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM *jvm, void *reserved) {
     _JVM = jvm;
     return JNI_VERSION_1_6;
@@ -14,6 +16,10 @@ SoundSystemCallback::SoundSystemCallback(JNIEnv *env, jclass jclass1) {
     _extractionCompleteMethodId = getMethodId(env, test, "notifyExtractionCompleted", "()V");
     _extractionStartedMethodId = getMethodId(env, test, "notifyExtractionStarted", "()V");
     _stopTrackMethodId = getMethodId(env, test, "notifyStopTrack", "()V");
+    _scanProgressMethodId = getMethodId(env, test, "notifyScanProgress", "(II)V");
+    _scanCompletedMethodId = getMethodId(env, test, "notifyScanCompleted", "(Z)V");
+    _fingerprintCompletedMethodId = getMethodId(env, test, "notifyFingerprintCompleted", "(IZ)V");
+    _trackAnalysisCompletedMethodId = getMethodId(env, test, "notifyTrackAnalysisCompleted", "()V");
 }
 
 jmethodID SoundSystemCallback::getMethodId(JNIEnv *env, jclass jclass1, char *methodName, char *sign){
@@ -33,6 +39,7 @@ SoundSystemCallback::~SoundSystemCallback() {
 }
 
 void SoundSystemCallback::notifyPlayPause(bool play) {
+    TRACE_SCOPE("notifyPlayPause");
     jint detachedStatus;
     JNIEnv *env = getEventCallbackEnvironnement(_JVM, &detachedStatus);
 
@@ -46,6 +53,7 @@ void SoundSystemCallback::notifyPlayPause(bool play) {
 }
 
 void SoundSystemCallback::notifyEndOfTrack() {
+    TRACE_SCOPE("notifyEndOfTrack");
     jint detachedStatus;
     JNIEnv *env = getEventCallbackEnvironnement(_JVM, &detachedStatus);
 
@@ -57,6 +65,7 @@ void SoundSystemCallback::notifyEndOfTrack() {
 }
 
 void SoundSystemCallback::notifyExtractionCompleted() {
+    TRACE_SCOPE("notifyExtractionCompleted");
     jint detachedStatus;
     JNIEnv *env = getEventCallbackEnvironnement(_JVM, &detachedStatus);
 
@@ -68,6 +77,7 @@ void SoundSystemCallback::notifyExtractionCompleted() {
 }
 
 void SoundSystemCallback::notifyExtractionStarted() {
+    TRACE_SCOPE("notifyExtractionStarted");
     jint detachedStatus;
     JNIEnv *env = getEventCallbackEnvironnement(_JVM, &detachedStatus);
 
@@ -79,6 +89,7 @@ void SoundSystemCallback::notifyExtractionStarted() {
 }
 
 void SoundSystemCallback::notifyStopTrack() {
+    TRACE_SCOPE("notifyStopTrack");
     jint detachedStatus;
     JNIEnv *env = getEventCallbackEnvironnement(_JVM, &detachedStatus);
 
@@ -89,6 +100,58 @@ void SoundSystemCallback::notifyStopTrack() {
     }
 }
 
+void SoundSystemCallback::notifyScanProgress(int numberFilesScanned, int numberFilesTotal) {
+    TRACE_SCOPE("notifyScanProgress");
+    jint detachedStatus;
+    JNIEnv *env = getEventCallbackEnvironnement(_JVM, &detachedStatus);
+
+    env->CallVoidMethod(_soundSystemInstance, _scanProgressMethodId,
+                        (jint) numberFilesScanned, (jint) numberFilesTotal);
+
+    if (detachedStatus == JNI_EDETACHED) {
+        _JVM->DetachCurrentThread();
+    }
+}
+
+void SoundSystemCallback::notifyScanCompleted(bool cancelled) {
+    TRACE_SCOPE("notifyScanCompleted");
+    jint detachedStatus;
+    JNIEnv *env = getEventCallbackEnvironnement(_JVM, &detachedStatus);
+
+    jvalue value;
+    value.z = (jboolean)cancelled;
+    env->CallVoidMethodA(_soundSystemInstance, _scanCompletedMethodId, &value);
+
+    if (detachedStatus == JNI_EDETACHED) {
+        _JVM->DetachCurrentThread();
+    }
+}
+
+void SoundSystemCallback::notifyFingerprintCompleted(int numberTracks, bool cancelled) {
+    TRACE_SCOPE("notifyFingerprintCompleted");
+    jint detachedStatus;
+    JNIEnv *env = getEventCallbackEnvironnement(_JVM, &detachedStatus);
+
+    env->CallVoidMethod(_soundSystemInstance, _fingerprintCompletedMethodId,
+                        (jint) numberTracks, (jboolean) cancelled);
+
+    if (detachedStatus == JNI_EDETACHED) {
+        _JVM->DetachCurrentThread();
+    }
+}
+
+void SoundSystemCallback::notifyTrackAnalysisCompleted() {
+    TRACE_SCOPE("notifyTrackAnalysisCompleted");
+    jint detachedStatus;
+    JNIEnv *env = getEventCallbackEnvironnement(_JVM, &detachedStatus);
+
+    env->CallVoidMethod(_soundSystemInstance, _trackAnalysisCompletedMethodId);
+
+    if (detachedStatus == JNI_EDETACHED) {
+        _JVM->DetachCurrentThread();
+    }
+}
+
 JNIEnv *SoundSystemCallback::getEventCallbackEnvironnement(JavaVM *JVM, jint *detachedStatus) {
     JNIEnv *env;
     jint status = JVM->GetEnv((void **) &env, JNI_VERSION_1_6);
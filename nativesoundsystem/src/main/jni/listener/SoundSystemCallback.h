@@ -17,6 +17,10 @@ public:
     void notifyEndOfTrack();
     void notifyStopTrack();
     void notifyPlayPause(bool play);
+    void notifyScanProgress(int numberFilesScanned, int numberFilesTotal);
+    void notifyScanCompleted(bool cancelled);
+    void notifyFingerprintCompleted(int numberTracks, bool cancelled);
+    void notifyTrackAnalysisCompleted();
     JNIEnv* getEventCallbackEnvironnement(JavaVM* JVM, jint* detachedStatus);
 
 private:
@@ -28,6 +32,10 @@ private:
     jmethodID _extractionCompleteMethodId;
     jmethodID _extractionStartedMethodId;
     jmethodID _stopTrackMethodId;
+    jmethodID _scanProgressMethodId;
+    jmethodID _scanCompletedMethodId;
+    jmethodID _fingerprintCompletedMethodId;
+    jmethodID _trackAnalysisCompletedMethodId;
 };
 
 
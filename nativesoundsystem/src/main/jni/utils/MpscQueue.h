@@ -0,0 +1,97 @@
+//
+// Created by Frederic on 16/06/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_MPSCQUEUE_H
+#define MINI_SOUND_SYSTEM_MPSCQUEUE_H
+
+#include <stdint.h>
+
+/**
+ * Bounded lock-free queue with any number of producer threads and a single consumer thread.
+ * Producers claim a cell with a compare and swap on the tail, then publish it with the sequence of
+ * the cell. Neither push nor pop block or allocate, so the consumer can be the audio thread.
+ *
+ * An item pushed by a producer interrupted between its claim and its publication hides the items
+ * pushed after it until it is published : pop then returns false, it never waits.
+ *
+ * @tparam T        copyable type of items.
+ * @tparam Capacity maximum number of items in the queue, must be a power of two.
+ */
+template<typename T, uint32_t Capacity>
+class MpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                  "Capacity must be a power of two");
+
+public:
+    MpscQueue() : _head(0), _tail(0) {
+        for (uint32_t i = 0; i < Capacity; i++) {
+            _cells[i].sequence = i;
+        }
+    }
+
+    MpscQueue& operator=(const MpscQueue& ) = delete;
+    MpscQueue(MpscQueue&) = delete;
+
+    /**
+     * Called from any producer thread.
+     * @return false if the queue is full, the item is not added.
+     */
+    bool push(const T &item) {
+        uint32_t tail = __atomic_load_n(&_tail, __ATOMIC_RELAXED);
+        for (;;) {
+            Cell *cell = &_cells[tail & (Capacity - 1)];
+            const uint32_t sequence = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+            const int32_t difference = (int32_t) (sequence - tail);
+            if (difference == 0) {
+                // on failure tail is updated with the current tail
+                if (__atomic_compare_exchange_n(&_tail, &tail, tail + 1, true, __ATOMIC_RELAXED,
+                                                __ATOMIC_RELAXED)) {
+                    cell->item = item;
+                    __atomic_store_n(&cell->sequence, tail + 1, __ATOMIC_RELEASE);
+                    return true;
+                }
+            } else if (difference < 0) {
+                // the cell still holds the item pushed Capacity items before
+                return false;
+            } else {
+                tail = __atomic_load_n(&_tail, __ATOMIC_RELAXED);
+            }
+        }
+    }
+
+    /**
+     * Called from the consumer thread.
+     * @return false if the queue is empty.
+     */
+    bool pop(T *item) {
+        const uint32_t head = _head;
+        Cell *cell = &_cells[head & (Capacity - 1)];
+        if (__atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE) != head + 1) {
+            return false;
+        }
+        *item = cell->item;
+        // the cell is free for the push Capacity items later
+        __atomic_store_n(&cell->sequence, head + Capacity, __ATOMIC_RELEASE);
+        _head = head + 1;
+        return true;
+    }
+
+private:
+
+    typedef struct {
+        // index of the push which can write the cell, plus one once it is written
+        uint32_t sequence;
+        T item;
+    } Cell;
+
+    Cell _cells[Capacity];
+
+    // indexes only grow and wrap around. _head is only used by the consumer.
+    // padding keeps them on different cache lines to avoid false sharing.
+    uint32_t _head;
+    char _padding[64 - sizeof(uint32_t)];
+    uint32_t _tail;
+};
+
+#endif //MINI_SOUND_SYSTEM_MPSCQUEUE_H
@@ -0,0 +1,68 @@
+//
+// Created by Frederic on 23/05/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_SPSCQUEUE_H
+#define MINI_SOUND_SYSTEM_SPSCQUEUE_H
+
+#include <stdint.h>
+
+/**
+ * Bounded lock-free queue with a single producer thread and a single consumer thread.
+ * Neither push nor pop block or allocate, so the consumer can be the audio thread.
+ *
+ * @tparam T        copyable type of items.
+ * @tparam Capacity maximum number of items in the queue, must be a power of two.
+ */
+template<typename T, uint32_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                  "Capacity must be a power of two");
+
+public:
+    SpscQueue() : _head(0), _tail(0) {
+    }
+
+    SpscQueue& operator=(const SpscQueue& ) = delete;
+    SpscQueue(SpscQueue&) = delete;
+
+    /**
+     * Called from the producer thread.
+     * @return false if the queue is full, the item is not added.
+     */
+    bool push(const T &item) {
+        const uint32_t tail = _tail;
+        if (tail - __atomic_load_n(&_head, __ATOMIC_ACQUIRE) == Capacity) {
+            return false;
+        }
+        _items[tail & (Capacity - 1)] = item;
+        __atomic_store_n(&_tail, tail + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    /**
+     * Called from the consumer thread.
+     * @return false if the queue is empty.
+     */
+    bool pop(T *item) {
+        const uint32_t head = _head;
+        if (head == __atomic_load_n(&_tail, __ATOMIC_ACQUIRE)) {
+            return false;
+        }
+        *item = _items[head & (Capacity - 1)];
+        __atomic_store_n(&_head, head + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+private:
+
+    T _items[Capacity];
+
+    // indexes only grow and wrap around, each one is written by a single thread.
+    // padding keeps them on different cache lines to avoid false sharing.
+    uint32_t _head;
+    char _padding[64 - sizeof(uint32_t)];
+    uint32_t _tail;
+};
+
+#endif //MINI_SOUND_SYSTEM_SPSCQUEUE_H
@@ -0,0 +1,242 @@
+#include "ThreadPolicy.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <utils/android_debug.h>
+
+// CPUs described by a 32 bits mask
+#define THREAD_POLICY_MAX_CPUS 32
+
+static const char *roleNames[kThreadRoleCount] = {"render", "decoder", "io"};
+
+static pthread_mutex_t policyMutex = PTHREAD_MUTEX_INITIALIZER;
+static bool isPolicyInitialized = false;
+static ThreadPolicy policies[kThreadRoleCount];
+
+// incremented by each change of a policy, read without the mutex by refreshThreadPolicy
+static uint32_t policyGeneration = 1;
+
+static ThreadPolicyReport reports[THREAD_POLICY_MAX_REPORTS];
+static int numberReports = 0;
+static int nextReport = 0;
+
+static void initDefaultPolicies() {
+    if (isPolicyInitialized) {
+        return;
+    }
+    isPolicyInitialized = true;
+
+    // SCHED_FIFO is not requested by default : the extraction runs as fast as possible and
+    // would starve the UI of its core
+    policies[kThreadRoleRender].fifoPriority = 0;
+    policies[kThreadRoleRender].niceLevel = THREAD_NICE_AUDIO;
+    policies[kThreadRoleRender].cpuMask = 0;
+
+    // decoding must not compete with the UI, but should not be stuck on little cores either
+    policies[kThreadRoleDecoder].fifoPriority = 0;
+    policies[kThreadRoleDecoder].niceLevel = THREAD_NICE_BACKGROUND;
+    policies[kThreadRoleDecoder].cpuMask = getBigCoresMask();
+
+    policies[kThreadRoleIo].fifoPriority = 0;
+    policies[kThreadRoleIo].niceLevel = THREAD_NICE_BACKGROUND;
+    policies[kThreadRoleIo].cpuMask = 0;
+}
+
+static uint32_t getConfiguredCpusMask() {
+    long numberCpus = sysconf(_SC_NPROCESSORS_CONF);
+    if (numberCpus < 1) {
+        numberCpus = 1;
+    }
+    if (numberCpus >= THREAD_POLICY_MAX_CPUS) {
+        return 0xFFFFFFFFu;
+    }
+    return (1u << numberCpus) - 1;
+}
+
+void setThreadPolicy(int role, const ThreadPolicy &policy) {
+    if (role < 0 || role >= kThreadRoleCount) {
+        return;
+    }
+    pthread_mutex_lock(&policyMutex);
+    initDefaultPolicies();
+    policies[role] = policy;
+    __atomic_add_fetch(&policyGeneration, 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&policyMutex);
+}
+
+void getThreadPolicy(int role, ThreadPolicy *policy) {
+    if (role < 0 || role >= kThreadRoleCount) {
+        return;
+    }
+    pthread_mutex_lock(&policyMutex);
+    initDefaultPolicies();
+    *policy = policies[role];
+    pthread_mutex_unlock(&policyMutex);
+}
+
+static void applyThreadPolicy(int role, const ThreadPolicy &policy, int tid) {
+    struct sched_param param;
+    memset(&param, 0, sizeof(param));
+
+    bool isFifo = false;
+    if (policy.fifoPriority > 0) {
+        param.sched_priority = policy.fifoPriority;
+        if (sched_setscheduler(0, SCHED_FIFO, &param) == 0) {
+            isFifo = true;
+        } else {
+            LOGW("SCHED_FIFO refused to the %s thread %d : %s", roleNames[role], tid,
+                 strerror(errno));
+        }
+    }
+    if (!isFifo) {
+        // back to the time sharing class if a previous policy was SCHED_FIFO
+        if (sched_getscheduler(0) != SCHED_OTHER) {
+            param.sched_priority = 0;
+            sched_setscheduler(0, SCHED_OTHER, &param);
+        }
+        // nice level is per thread on Linux
+        if (setpriority(PRIO_PROCESS, (id_t) tid, policy.niceLevel) != 0) {
+            LOGW("Nice level %d refused to the %s thread %d : %s", policy.niceLevel,
+                 roleNames[role], tid, strerror(errno));
+        }
+    }
+
+    const uint32_t cpuMask = policy.cpuMask != 0 ? policy.cpuMask : getConfiguredCpusMask();
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    for (int cpu = 0; cpu < THREAD_POLICY_MAX_CPUS; cpu++) {
+        if (cpuMask & (1u << cpu)) {
+            CPU_SET(cpu, &cpuSet);
+        }
+    }
+    if (sched_setaffinity(0, sizeof(cpuSet), &cpuSet) != 0) {
+        LOGW("Affinity 0x%x refused to the %s thread %d : %s", cpuMask, roleNames[role], tid,
+             strerror(errno));
+    }
+}
+
+static void readGrantedPolicy(int role, int tid, ThreadPolicyReport *report) {
+    report->role = role;
+    report->tid = tid;
+    report->schedulingPolicy = sched_getscheduler(0);
+
+    struct sched_param param;
+    report->priority = sched_getparam(0, &param) == 0 ? param.sched_priority : 0;
+
+    // -1 is a valid nice level
+    errno = 0;
+    const int niceLevel = getpriority(PRIO_PROCESS, (id_t) tid);
+    report->niceLevel = errno == 0 ? niceLevel : 0;
+
+    report->cpuMask = 0;
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    if (sched_getaffinity(0, sizeof(cpuSet), &cpuSet) == 0) {
+        for (int cpu = 0; cpu < THREAD_POLICY_MAX_CPUS; cpu++) {
+            if (CPU_ISSET(cpu, &cpuSet)) {
+                report->cpuMask |= 1u << cpu;
+            }
+        }
+    }
+}
+
+void refreshThreadPolicy(int role, uint32_t *appliedGeneration) {
+    if (role < 0 || role >= kThreadRoleCount
+        || __atomic_load_n(&policyGeneration, __ATOMIC_ACQUIRE) == *appliedGeneration) {
+        return;
+    }
+
+    pthread_mutex_lock(&policyMutex);
+    initDefaultPolicies();
+    const ThreadPolicy policy = policies[role];
+    *appliedGeneration = policyGeneration;
+    pthread_mutex_unlock(&policyMutex);
+
+    const int tid = (int) syscall(__NR_gettid);
+    applyThreadPolicy(role, policy, tid);
+
+    ThreadPolicyReport report;
+    readGrantedPolicy(role, tid, &report);
+    LOGI("%s thread %d : policy %d, priority %d, nice %d, cpus 0x%x", roleNames[role], tid,
+         report.schedulingPolicy, report.priority, report.niceLevel, report.cpuMask);
+
+    // a thread refreshing its policy replaces its previous report
+    pthread_mutex_lock(&policyMutex);
+    int index = -1;
+    for (int i = 0; i < numberReports && index < 0; i++) {
+        if (reports[i].tid == tid) {
+            index = i;
+        }
+    }
+    if (index < 0) {
+        index = nextReport;
+        nextReport = (nextReport + 1) % THREAD_POLICY_MAX_REPORTS;
+        if (numberReports < THREAD_POLICY_MAX_REPORTS) {
+            numberReports++;
+        }
+    }
+    reports[index] = report;
+    pthread_mutex_unlock(&policyMutex);
+}
+
+int getThreadPolicyReports(ThreadPolicyReport *dst, int maxReports) {
+    pthread_mutex_lock(&policyMutex);
+    int count = numberReports < maxReports ? numberReports : maxReports;
+    for (int i = 0; i < count; i++) {
+        int index = (nextReport - 1 - i + THREAD_POLICY_MAX_REPORTS) % THREAD_POLICY_MAX_REPORTS;
+        dst[i] = reports[index];
+    }
+    pthread_mutex_unlock(&policyMutex);
+    return count;
+}
+
+uint32_t getBigCoresMask() {
+    long numberCpus = sysconf(_SC_NPROCESSORS_CONF);
+    if (numberCpus > THREAD_POLICY_MAX_CPUS) {
+        numberCpus = THREAD_POLICY_MAX_CPUS;
+    }
+
+    long maxFrequencies[THREAD_POLICY_MAX_CPUS];
+    long highestFrequency = 0;
+    long lowestFrequency = 0;
+    for (int cpu = 0; cpu < numberCpus; cpu++) {
+        char path[96];
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpufreq/cpuinfo_max_freq",
+                 cpu);
+        maxFrequencies[cpu] = 0;
+        FILE *file = fopen(path, "r");
+        if (file == nullptr) {
+            return 0;
+        }
+        if (fscanf(file, "%ld", &maxFrequencies[cpu]) != 1) {
+            maxFrequencies[cpu] = 0;
+        }
+        fclose(file);
+
+        if (maxFrequencies[cpu] > highestFrequency) {
+            highestFrequency = maxFrequencies[cpu];
+        }
+        if (cpu == 0 || maxFrequencies[cpu] < lowestFrequency) {
+            lowestFrequency = maxFrequencies[cpu];
+        }
+    }
+
+    if (highestFrequency == 0 || highestFrequency == lowestFrequency) {
+        return 0;
+    }
+    // every cluster but the little one : on a SoC with a prime core, the prime and the big cores
+    uint32_t mask = 0;
+    for (int cpu = 0; cpu < numberCpus; cpu++) {
+        if (maxFrequencies[cpu] > lowestFrequency) {
+            mask |= 1u << cpu;
+        }
+    }
+    return mask;
+}
@@ -0,0 +1,75 @@
+//
+// Created by Frederic on 06/06/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_THREADPOLICY_H
+#define MINI_SOUND_SYSTEM_THREADPOLICY_H
+
+#include <stdint.h>
+
+// number of threads whose granted policy is remembered
+#define THREAD_POLICY_MAX_REPORTS 16
+
+// nice levels of android.os.Process
+#define THREAD_NICE_AUDIO -16
+#define THREAD_NICE_BACKGROUND 10
+
+enum ThreadRole {
+    // threads the player waits for, like the extraction of the track being played
+    kThreadRoleRender = 0,
+    // background decoding and analysis
+    kThreadRoleDecoder,
+    // file writing
+    kThreadRoleIo,
+    kThreadRoleCount,
+};
+
+typedef struct {
+    // SCHED_FIFO priority, 0 to stay in SCHED_OTHER
+    int fifoPriority;
+    // used when the thread is not SCHED_FIFO
+    int niceLevel;
+    // bit i allows CPU i, 0 allows every CPU
+    uint32_t cpuMask;
+} ThreadPolicy;
+
+// what the OS granted to a thread, read back after the policy has been applied
+typedef struct {
+    int role;
+    int tid;
+    // SCHED_OTHER, SCHED_FIFO...
+    int schedulingPolicy;
+    int priority;
+    int niceLevel;
+    uint32_t cpuMask;
+} ThreadPolicyReport;
+
+/**
+ * Policy used by the threads of a role from their next refreshThreadPolicy. Threads spawned by the
+ * engine apply it when they start and between their tasks.
+ */
+void setThreadPolicy(int role, const ThreadPolicy &policy);
+
+void getThreadPolicy(int role, ThreadPolicy *policy);
+
+/**
+ * Apply the policy of the role to the calling thread if it has changed since appliedGeneration.
+ * Each step is optional : a refused SCHED_FIFO falls back to the nice level, a refused nice level
+ * or affinity keeps the current one. What has been granted is recorded in the reports.
+ * @param appliedGeneration owned by the thread, 0 before the first call.
+ */
+void refreshThreadPolicy(int role, uint32_t *appliedGeneration);
+
+/**
+ * @return number of reports written, at most maxReports, the newest threads first.
+ */
+int getThreadPolicyReports(ThreadPolicyReport *reports, int maxReports);
+
+/**
+ * CPUs faster than the little cores : every CPU above the lowest maximum frequency, read from
+ * cpufreq.
+ * @return 0 if all CPUs are the same or if frequencies are not readable.
+ */
+uint32_t getBigCoresMask();
+
+#endif //MINI_SOUND_SYSTEM_THREADPOLICY_H
@@ -0,0 +1,269 @@
+#include "ThreadPool.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ThreadPolicy.h"
+#include "Tracer.h"
+
+struct ThreadPoolWorker {
+    ThreadPool *pool;
+    pthread_t thread;
+    // reserved workers only run tasks of the tracks
+    bool isReserved;
+    // owner of the running task, null when the worker waits for a task
+    void *runningOwner;
+};
+
+static double now_ms(void) {
+    struct timespec res;
+    clock_gettime(CLOCK_MONOTONIC, &res);
+    return 1000.0 * res.tv_sec + (double) res.tv_nsec / 1e6;
+}
+
+void* ThreadPool::trampoline(void* p) {
+    ThreadPoolWorker* worker = (ThreadPoolWorker*) p;
+    worker->pool->loop(worker);
+    return NULL;
+}
+
+ThreadPool::ThreadPool(int numberWorkers, int threadRole, int numberReservedWorkers,
+                       int reservedThreadRole) :
+        _threadRole(threadRole),
+        _numberReservedWorkers(numberReservedWorkers > 0 ? numberReservedWorkers : 0),
+        _reservedThreadRole(reservedThreadRole),
+        _pendingTasks(0),
+        _queuedTasks(0),
+        _quit(false) {
+    pthread_mutex_init(&_mutex, NULL);
+    pthread_cond_init(&_taskAvailable, NULL);
+    pthread_cond_init(&_idle, NULL);
+    for (int i = 0; i < kTaskPriorityCount; i++) {
+        _heads[i] = NULL;
+        _tails[i] = NULL;
+    }
+    memset(&_stats, 0, sizeof(_stats));
+
+    _numberWorkers = (numberWorkers > 0 ? numberWorkers : 1) + _numberReservedWorkers;
+    _workers = (ThreadPoolWorker*) calloc(_numberWorkers, sizeof(ThreadPoolWorker));
+    for (int i = 0; i < _numberWorkers; i++) {
+        _workers[i].pool = this;
+        _workers[i].isReserved = i < _numberReservedWorkers;
+        _workers[i].runningOwner = NULL;
+        pthread_create(&_workers[i].thread, NULL, trampoline, &_workers[i]);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    pthread_mutex_lock(&_mutex);
+    _quit = true;
+    pthread_cond_broadcast(&_taskAvailable);
+    pthread_mutex_unlock(&_mutex);
+
+    for (int i = 0; i < _numberWorkers; i++) {
+        pthread_join(_workers[i].thread, NULL);
+    }
+    free(_workers);
+
+    // tasks never run are cancelled
+    for (int i = 0; i < kTaskPriorityCount; i++) {
+        while (_heads[i] != NULL) {
+            ThreadPoolTask* next = _heads[i]->next;
+            if (_heads[i]->cancelFunction != NULL) {
+                _heads[i]->cancelFunction(_heads[i]->data);
+            }
+            delete _heads[i];
+            _heads[i] = next;
+        }
+    }
+
+    pthread_cond_destroy(&_idle);
+    pthread_cond_destroy(&_taskAvailable);
+    pthread_mutex_destroy(&_mutex);
+}
+
+void ThreadPool::post(ThreadPoolTaskFunction function, void *data, int priority, void *owner,
+                      ThreadPoolTaskFunction cancelFunction) {
+    if (priority < 0 || priority >= kTaskPriorityCount) {
+        priority = kTaskPriorityBackground;
+    }
+    ThreadPoolTask* task = new ThreadPoolTask();
+    task->function = function;
+    task->data = data;
+    task->owner = owner;
+    task->cancelFunction = cancelFunction;
+    task->next = NULL;
+
+    pthread_mutex_lock(&_mutex);
+    if (_tails[priority] != NULL) {
+        _tails[priority]->next = task;
+    } else {
+        _heads[priority] = task;
+    }
+    _tails[priority] = task;
+    _pendingTasks++;
+    _queuedTasks++;
+    if ((uint32_t) _queuedTasks > _stats.maxQueuedTasks) {
+        _stats.maxQueuedTasks = (uint32_t) _queuedTasks;
+    }
+    // a reserved worker may not be allowed to run the task
+    pthread_cond_broadcast(&_taskAvailable);
+    pthread_mutex_unlock(&_mutex);
+}
+
+int ThreadPool::cancel(void *owner) {
+    ThreadPoolTask* cancelledHead = NULL;
+    int numberCancelled = 0;
+
+    pthread_mutex_lock(&_mutex);
+    for (int i = 0; i < kTaskPriorityCount; i++) {
+        ThreadPoolTask* previous = NULL;
+        ThreadPoolTask* task = _heads[i];
+        while (task != NULL) {
+            ThreadPoolTask* next = task->next;
+            if (task->owner == owner) {
+                if (previous != NULL) {
+                    previous->next = next;
+                } else {
+                    _heads[i] = next;
+                }
+                if (_tails[i] == task) {
+                    _tails[i] = previous;
+                }
+                task->next = cancelledHead;
+                cancelledHead = task;
+                _stats.droppedTasks[i]++;
+                numberCancelled++;
+            } else {
+                previous = task;
+            }
+            task = next;
+        }
+    }
+    _pendingTasks -= numberCancelled;
+    _queuedTasks -= numberCancelled;
+    if (numberCancelled > 0) {
+        pthread_cond_broadcast(&_idle);
+    }
+    pthread_mutex_unlock(&_mutex);
+
+    // cancel functions may post or cancel tasks
+    while (cancelledHead != NULL) {
+        ThreadPoolTask* next = cancelledHead->next;
+        if (cancelledHead->cancelFunction != NULL) {
+            cancelledHead->cancelFunction(cancelledHead->data);
+        }
+        delete cancelledHead;
+        cancelledHead = next;
+    }
+    return numberCancelled;
+}
+
+bool ThreadPool::hasTasks(void *owner) {
+    if (owner == NULL) {
+        return _pendingTasks > 0;
+    }
+    for (int i = 0; i < _numberWorkers; i++) {
+        if (_workers[i].runningOwner == owner) {
+            return true;
+        }
+    }
+    for (int i = 0; i < kTaskPriorityCount; i++) {
+        for (ThreadPoolTask* task = _heads[i]; task != NULL; task = task->next) {
+            if (task->owner == owner) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void ThreadPool::waitIdle(void *owner) {
+    pthread_mutex_lock(&_mutex);
+    while (hasTasks(owner)) {
+        pthread_cond_wait(&_idle, &_mutex);
+    }
+    pthread_mutex_unlock(&_mutex);
+}
+
+void ThreadPool::reportCancelledJob(int priority, double workMs) {
+    if (priority < 0 || priority >= kTaskPriorityCount) {
+        return;
+    }
+    pthread_mutex_lock(&_mutex);
+    _stats.cancelledJobs[priority]++;
+    _stats.cancelledWorkMs[priority] += workMs;
+    pthread_mutex_unlock(&_mutex);
+}
+
+void ThreadPool::getStats(ThreadPoolStats *stats) {
+    pthread_mutex_lock(&_mutex);
+    *stats = _stats;
+    pthread_mutex_unlock(&_mutex);
+}
+
+ThreadPoolTask* ThreadPool::popTask(int lowestPriority, int *priority) {
+    for (int i = 0; i <= lowestPriority; i++) {
+        ThreadPoolTask* task = _heads[i];
+        if (task != NULL) {
+            _heads[i] = task->next;
+            if (_heads[i] == NULL) {
+                _tails[i] = NULL;
+            }
+            _queuedTasks--;
+            *priority = i;
+            return task;
+        }
+    }
+    return NULL;
+}
+
+void ThreadPool::loop(ThreadPoolWorker *worker) {
+    const int role = worker->isReserved ? _reservedThreadRole : _threadRole;
+    const int lowestPriority = worker->isReserved ? kTaskPriorityBackground - 1
+                                                  : kTaskPriorityCount - 1;
+    uint32_t policyGeneration = 0;
+    while (true) {
+        refreshThreadPolicy(role, &policyGeneration);
+
+        pthread_mutex_lock(&_mutex);
+        ThreadPoolTask* task = NULL;
+        int priority = 0;
+        while (!_quit && (task = popTask(lowestPriority, &priority)) == NULL) {
+            pthread_cond_wait(&_taskAvailable, &_mutex);
+        }
+        if (_quit) {
+            pthread_mutex_unlock(&_mutex);
+            return;
+        }
+        worker->runningOwner = task->owner;
+        pthread_mutex_unlock(&_mutex);
+
+        const double startTime = now_ms();
+        {
+            TRACE_SCOPE("ThreadPool::task");
+            task->function(task->data);
+        }
+        const double runMs = now_ms() - startTime;
+        delete task;
+
+        pthread_mutex_lock(&_mutex);
+        worker->runningOwner = NULL;
+        _stats.runTasks[priority]++;
+        _stats.runMs[priority] += runMs;
+        _pendingTasks--;
+        // waiters of an owner are woken up by the end of any task
+        pthread_cond_broadcast(&_idle);
+        pthread_mutex_unlock(&_mutex);
+    }
+}
+
+int ThreadPool::getDefaultNumberWorkers(int maxWorkers) {
+    long numberCores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (numberCores < 1) {
+        numberCores = 1;
+    }
+    return numberCores < maxWorkers ? (int) numberCores : maxWorkers;
+}
@@ -0,0 +1,120 @@
+//
+// Created by Frederic on 02/05/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_THREADPOOL_H
+#define MINI_SOUND_SYSTEM_THREADPOOL_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+typedef void (*ThreadPoolTaskFunction)(void *data);
+
+// tasks of a lower priority are run first
+enum TaskPriority {
+    // extraction of a track being played
+    kTaskPriorityPlaying = 0,
+    // extraction of a loaded track not played yet
+    kTaskPriorityCued,
+    // analysis of the library
+    kTaskPriorityBackground,
+    kTaskPriorityCount,
+};
+
+typedef struct ThreadPoolTask {
+    ThreadPoolTaskFunction function;
+    void *data;
+    // tasks of an owner are cancelled and waited for together, may be null
+    void *owner;
+    // called instead of function when the task is cancelled before it runs, may be null
+    ThreadPoolTaskFunction cancelFunction;
+    ThreadPoolTask *next;
+} ThreadPoolTask;
+
+typedef struct {
+    // tasks run and time spent running them, summed over the workers
+    uint32_t runTasks[kTaskPriorityCount];
+    double runMs[kTaskPriorityCount];
+    // tasks removed from the queue by cancel before they run
+    uint32_t droppedTasks[kTaskPriorityCount];
+    // jobs stopped while running and the work they had done, reported by the owners
+    uint32_t cancelledJobs[kTaskPriorityCount];
+    double cancelledWorkMs[kTaskPriorityCount];
+    // highest number of tasks waiting for a worker at the same time
+    uint32_t maxQueuedTasks;
+} ThreadPoolStats;
+
+struct ThreadPoolWorker;
+
+/**
+ * Fixed number of worker threads consuming queues of tasks, one per priority.
+ * Tasks are run by priority then in the order they have been posted, by the first available worker.
+ * Reserved workers never run background tasks, so that the extraction of a track doesn't wait for
+ * the analysis of the library.
+ * Workers follow the ThreadPolicy of their role, refreshed before each task.
+ */
+class ThreadPool {
+public:
+    ThreadPool(int numberWorkers, int threadRole, int numberReservedWorkers,
+               int reservedThreadRole);
+    ThreadPool& operator=(const ThreadPool& ) = delete;
+    ThreadPool(ThreadPool&) = delete;
+    ~ThreadPool();
+
+    void post(ThreadPoolTaskFunction function, void *data,
+              int priority = kTaskPriorityBackground, void *owner = nullptr,
+              ThreadPoolTaskFunction cancelFunction = nullptr);
+
+    /**
+     * Remove the tasks of owner which are not running yet, their cancel function is called on the
+     * calling thread. Running tasks are not interrupted.
+     * @return number of tasks removed.
+     */
+    int cancel(void *owner);
+
+    // block until no task of owner is queued or running, every task when owner is null
+    void waitIdle(void *owner);
+
+    // account for a job of the priority stopped while running, after workMs of work
+    void reportCancelledJob(int priority, double workMs);
+
+    void getStats(ThreadPoolStats *stats);
+
+    inline int getNumberWorkers(){
+        return _numberWorkers;
+    }
+
+    // number of workers matching the number of online cores, bounded by maxWorkers
+    static int getDefaultNumberWorkers(int maxWorkers);
+
+private:
+    static void* trampoline(void* p);
+    void loop(ThreadPoolWorker *worker);
+
+    // first task of the highest priority up to lowestPriority, called with the mutex locked
+    ThreadPoolTask* popTask(int lowestPriority, int *priority);
+
+    bool hasTasks(void *owner);
+
+    ThreadPoolWorker* _workers;
+    int _numberWorkers;
+    int _threadRole;
+    int _numberReservedWorkers;
+    int _reservedThreadRole;
+
+    pthread_mutex_t _mutex;
+    pthread_cond_t _taskAvailable;
+    pthread_cond_t _idle;
+
+    ThreadPoolTask* _heads[kTaskPriorityCount];
+    ThreadPoolTask* _tails[kTaskPriorityCount];
+
+    // tasks posted and not finished yet, queued or running
+    int _pendingTasks;
+    int _queuedTasks;
+    bool _quit;
+
+    ThreadPoolStats _stats;
+};
+
+#endif //MINI_SOUND_SYSTEM_THREADPOOL_H
@@ -0,0 +1,174 @@
+#include "Tracer.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <utils/android_debug.h>
+
+typedef struct {
+    uint64_t timestampNs;
+    const char *name;
+    int32_t value;
+    char phase;
+} TraceEvent;
+
+typedef struct {
+    TraceEvent *events;
+    // events written since the thread claimed the buffer, only written by this thread
+    uint32_t numberEvents;
+    int tid;
+    char threadName[16];
+} TraceBuffer;
+
+uint32_t traceEnabled = 0;
+
+static TraceBuffer traceBuffers[TRACE_MAX_THREADS];
+static bool areBuffersAllocated = false;
+
+// buffers claimed by threads during the current session
+static uint32_t numberClaimedBuffers = 0;
+static uint32_t session = 0;
+static uint32_t droppedEvents = 0;
+
+static pthread_key_t bufferKey;
+static pthread_once_t bufferKeyOnce = PTHREAD_ONCE_INIT;
+
+static void createBufferKey() {
+    pthread_key_create(&bufferKey, nullptr);
+}
+
+static uint64_t now_ns() {
+    struct timespec res;
+    clock_gettime(CLOCK_MONOTONIC, &res);
+    return 1000000000ull * res.tv_sec + res.tv_nsec;
+}
+
+// the thread specific value is the session in the high bits and the buffer index + 1, 0 if none
+static TraceBuffer* getThreadBuffer() {
+    const uint32_t currentSession = __atomic_load_n(&session, __ATOMIC_ACQUIRE);
+    uintptr_t value = (uintptr_t) pthread_getspecific(bufferKey);
+    if ((uint32_t) (value >> 8) != (currentSession & 0xFFFFFF)) {
+        const uint32_t index = __atomic_fetch_add(&numberClaimedBuffers, 1, __ATOMIC_RELAXED);
+        value = (uintptr_t) (currentSession & 0xFFFFFF) << 8;
+        if (index < TRACE_MAX_THREADS) {
+            TraceBuffer *buffer = &traceBuffers[index];
+            buffer->tid = (int) syscall(__NR_gettid);
+            memset(buffer->threadName, 0, sizeof(buffer->threadName));
+            prctl(PR_GET_NAME, buffer->threadName, 0, 0, 0);
+            // written as is in the JSON
+            for (int i = 0; buffer->threadName[i] != 0; i++) {
+                if (buffer->threadName[i] == '"' || buffer->threadName[i] == '\\') {
+                    buffer->threadName[i] = '_';
+                }
+            }
+            __atomic_store_n(&buffer->numberEvents, 0, __ATOMIC_RELEASE);
+            value |= index + 1;
+        }
+        pthread_setspecific(bufferKey, (void *) value);
+    }
+
+    const uint32_t index = (uint32_t) (value & 0xFF);
+    return index != 0 ? &traceBuffers[index - 1] : nullptr;
+}
+
+void traceEvent(const char *name, char phase, int32_t value) {
+    TraceBuffer *buffer = getThreadBuffer();
+    if (buffer == nullptr) {
+        __atomic_add_fetch(&droppedEvents, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    const uint32_t index = buffer->numberEvents;
+    TraceEvent *event = &buffer->events[index & (TRACE_BUFFER_EVENTS - 1)];
+    event->timestampNs = now_ns();
+    event->name = name;
+    event->value = value;
+    event->phase = phase;
+    __atomic_store_n(&buffer->numberEvents, index + 1, __ATOMIC_RELEASE);
+}
+
+bool startTracing() {
+    pthread_once(&bufferKeyOnce, createBufferKey);
+
+    // events are never freed, a thread may still be writing after the end of a session
+    if (!areBuffersAllocated) {
+        for (int i = 0; i < TRACE_MAX_THREADS; i++) {
+            traceBuffers[i].events = (TraceEvent *) calloc(TRACE_BUFFER_EVENTS,
+                                                           sizeof(TraceEvent));
+            if (traceBuffers[i].events == nullptr) {
+                LOGE("No memory for trace buffers");
+                return false;
+            }
+        }
+        areBuffersAllocated = true;
+    }
+
+    __atomic_store_n(&traceEnabled, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&numberClaimedBuffers, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&droppedEvents, 0, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&session, 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&traceEnabled, 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+void stopTracing() {
+    __atomic_store_n(&traceEnabled, 0, __ATOMIC_RELEASE);
+}
+
+int dumpTrace(const char *filePath) {
+    stopTracing();
+
+    FILE *file = fopen(filePath, "w");
+    if (file == nullptr) {
+        LOGE("Can't write trace to %s", filePath);
+        return -1;
+    }
+
+    const int pid = getpid();
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"soundsystem\"}}",
+            pid);
+
+    int numberEvents = 0;
+    uint32_t numberBuffers = __atomic_load_n(&numberClaimedBuffers, __ATOMIC_ACQUIRE);
+    if (!areBuffersAllocated) {
+        numberBuffers = 0;
+    } else if (numberBuffers > TRACE_MAX_THREADS) {
+        numberBuffers = TRACE_MAX_THREADS;
+    }
+    for (uint32_t i = 0; i < numberBuffers; i++) {
+        const TraceBuffer *buffer = &traceBuffers[i];
+        const uint32_t end = __atomic_load_n(&buffer->numberEvents, __ATOMIC_ACQUIRE);
+        const uint32_t start = end > TRACE_BUFFER_EVENTS ? end - TRACE_BUFFER_EVENTS : 0;
+
+        fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+                        "\"args\":{\"name\":\"%s\"}}", pid, buffer->tid, buffer->threadName);
+
+        for (uint32_t j = start; j < end; j++) {
+            const TraceEvent *event = &buffer->events[j & (TRACE_BUFFER_EVENTS - 1)];
+            // timestamps are in microseconds
+            fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%llu.%03u,\"pid\":%d,\"tid\":%d",
+                    event->name, event->phase,
+                    (unsigned long long) (event->timestampNs / 1000),
+                    (unsigned int) (event->timestampNs % 1000), pid, buffer->tid);
+            if (event->phase == 'C') {
+                fprintf(file, ",\"args\":{\"value\":%d}", event->value);
+            }
+            fprintf(file, "}");
+            numberEvents++;
+        }
+    }
+    fprintf(file, "\n]}\n");
+
+    const bool success = fclose(file) == 0;
+    LOGI("Trace of %d events written, %u events dropped", numberEvents,
+         __atomic_load_n(&droppedEvents, __ATOMIC_RELAXED));
+    return success ? numberEvents : -1;
+}
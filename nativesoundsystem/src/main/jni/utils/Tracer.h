@@ -0,0 +1,81 @@
+//
+// Created by Frederic on 09/06/2017.
+//
+
+#ifndef MINI_SOUND_SYSTEM_TRACER_H
+#define MINI_SOUND_SYSTEM_TRACER_H
+
+#include <stdint.h>
+
+// threads traced during a session, events of other threads are dropped
+#define TRACE_MAX_THREADS 32
+
+// events kept per thread, a power of 2 : the oldest are overwritten
+#define TRACE_BUFFER_EVENTS 8192
+
+// non zero while tracing, the only thing read by trace points when tracing is off
+extern uint32_t traceEnabled;
+
+static inline bool isTracing() {
+    return __builtin_expect(__atomic_load_n(&traceEnabled, __ATOMIC_RELAXED) != 0, 0);
+}
+
+/**
+ * Record an event in the buffer of the calling thread. Never allocates nor locks, so it can be
+ * called from the audio thread.
+ * @param name  string literal, only its address is kept.
+ * @param phase 'B' begin of a span, 'E' end of a span or 'C' counter.
+ */
+void traceEvent(const char *name, char phase, int32_t value);
+
+/**
+ * Start a new session : previous events are dropped. Buffers are allocated by the first session
+ * and kept afterwards.
+ * @return false if buffers can't be allocated.
+ */
+bool startTracing();
+
+void stopTracing();
+
+/**
+ * Stop tracing and write the events of the session as Chrome trace JSON, readable by Perfetto or
+ * chrome://tracing.
+ * @return number of events written, -1 if the file can't be written.
+ */
+int dumpTrace(const char *filePath);
+
+// span from the construction to the destruction of the scope
+class TraceScope {
+public:
+    explicit TraceScope(const char *name) : _name(isTracing() ? name : nullptr) {
+        if (_name != nullptr) {
+            traceEvent(_name, 'B', 0);
+        }
+    }
+    TraceScope& operator=(const TraceScope& ) = delete;
+    TraceScope(TraceScope&) = delete;
+
+    ~TraceScope() {
+        if (_name != nullptr) {
+            traceEvent(_name, 'E', 0);
+        }
+    }
+
+private:
+    // null if tracing was off when the scope started
+    const char *_name;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+
+#define TRACE_COUNTER(name, value) \
+    do { \
+        if (isTracing()) { \
+            traceEvent(name, 'C', (int32_t) (value)); \
+        } \
+    } while (0)
+
+#endif //MINI_SOUND_SYSTEM_TRACER_H
@@ -16,11 +16,14 @@
  */
 #ifndef NATIVE_AUDIO_ANDROID_DEBUG_H_H
 #define NATIVE_AUDIO_ANDROID_DEBUG_H_H
-#include <android/log.h>
 
 #if 1
 
 #define MODULE_NAME  "SOUNDSYSTEM"
+
+#ifdef __ANDROID__
+#include <android/log.h>
+
 #define LOGV(...) __android_log_print(ANDROID_LOG_VERBOSE, MODULE_NAME, __VA_ARGS__)
 #define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, MODULE_NAME, __VA_ARGS__)
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, MODULE_NAME, __VA_ARGS__)
@@ -28,6 +31,20 @@
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, MODULE_NAME, __VA_ARGS__)
 #define LOGF(...) __android_log_print(ANDROID_LOG_FATAL, MODULE_NAME, __VA_ARGS__)
 
+#else
+// host build of the modules without android dependency, like offline rendering
+#include <stdio.h>
+
+#define HOST_LOG(level, ...) (fprintf(stderr, "%s %s : ", level, MODULE_NAME), \
+                              fprintf(stderr, __VA_ARGS__), fputc('\n', stderr))
+#define LOGV(...) HOST_LOG("V", __VA_ARGS__)
+#define LOGD(...) HOST_LOG("D", __VA_ARGS__)
+#define LOGI(...) HOST_LOG("I", __VA_ARGS__)
+#define LOGW(...) HOST_LOG("W", __VA_ARGS__)
+#define LOGE(...) HOST_LOG("E", __VA_ARGS__)
+#define LOGF(...) HOST_LOG("F", __VA_ARGS__)
+#endif
+
 #else
 
 #define LOGV(...)
@@ -0,0 +1,127 @@
+package fr.bowserf.soundsystem;
+
+/**
+ * Counters and latency of the capture, see {@link SoundSystem#getCaptureStats()}.
+ */
+public class SSCaptureStats {
+
+    private final boolean mCapturing;
+    private final boolean mError;
+    private final long mCapturedBlocks;
+    private final long mDroppedBlocks;
+    private final long mLateBlocks;
+    private final int mMaxQueuedBlocks;
+    private final int mNumberRingBlocks;
+    private final long mWrittenBytes;
+    private final long mNumberWrites;
+    private final float mStartLatencyMs;
+    private final float mLastLatencyMs;
+    private final float mMeanLatencyMs;
+    private final float mMaxLatencyMs;
+
+    /**
+     * @param stats Array sent by native code : 1 if capturing, 1 after a write error, captured,
+     *              dropped and late blocks, highest number of blocks in the ring, blocks of the
+     *              ring, written bytes, number of writes, start latency, then the last, mean and
+     *              maximum capture to disk latency in ms.
+     */
+    /* package */ SSCaptureStats(final double[] stats) {
+        mCapturing = stats[0] != 0;
+        mError = stats[1] != 0;
+        mCapturedBlocks = (long) stats[2];
+        mDroppedBlocks = (long) stats[3];
+        mLateBlocks = (long) stats[4];
+        mMaxQueuedBlocks = (int) stats[5];
+        mNumberRingBlocks = (int) stats[6];
+        mWrittenBytes = (long) stats[7];
+        mNumberWrites = (long) stats[8];
+        mStartLatencyMs = (float) stats[9];
+        mLastLatencyMs = (float) stats[10];
+        mMeanLatencyMs = (float) stats[11];
+        mMaxLatencyMs = (float) stats[12];
+    }
+
+    public boolean isCapturing() {
+        return mCapturing;
+    }
+
+    /**
+     * @return True if the file couldn't be written, blocks captured since then are lost.
+     */
+    public boolean hasError() {
+        return mError;
+    }
+
+    /**
+     * @return Number of blocks of the size of the player buffers received from the source.
+     */
+    public long getCapturedBlocks() {
+        return mCapturedBlocks;
+    }
+
+    /**
+     * @return Number of blocks received while the ring was full, missing from the file.
+     */
+    public long getDroppedBlocks() {
+        return mDroppedBlocks;
+    }
+
+    /**
+     * @return Number of blocks received more than two blocks after the previous one : the device
+     * may have lost audio before it.
+     */
+    public long getLateBlocks() {
+        return mLateBlocks;
+    }
+
+    /**
+     * @return Highest number of blocks waiting for the writer thread, out of
+     * {@link #getNumberRingBlocks()}.
+     */
+    public int getMaxQueuedBlocks() {
+        return mMaxQueuedBlocks;
+    }
+
+    public int getNumberRingBlocks() {
+        return mNumberRingBlocks;
+    }
+
+    public long getWrittenBytes() {
+        return mWrittenBytes;
+    }
+
+    public long getNumberWrites() {
+        return mNumberWrites;
+    }
+
+    /**
+     * @return Time from the start of the capture to the first block received, in ms.
+     */
+    public float getStartLatencyMs() {
+        return mStartLatencyMs;
+    }
+
+    /**
+     * @return Time from the capture of the first frame of the last block written to the end of its
+     * write, in ms.
+     */
+    public float getLastLatencyMs() {
+        return mLastLatencyMs;
+    }
+
+    /**
+     * @return Mean time from the capture of the first frame of a block to the end of its write,
+     * in ms.
+     */
+    public float getMeanLatencyMs() {
+        return mMeanLatencyMs;
+    }
+
+    /**
+     * @return Maximum time from the capture of the first frame of a block to the end of its write,
+     * in ms.
+     */
+    public float getMaxLatencyMs() {
+        return mMaxLatencyMs;
+    }
+}
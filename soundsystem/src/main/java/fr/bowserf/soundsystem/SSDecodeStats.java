@@ -0,0 +1,75 @@
+package fr.bowserf.soundsystem;
+
+/**
+ * Counters of the workers decoding tracks, shared by all sound systems, see
+ * {@link SoundSystem#getDecodeStats()}. Decoding is split in tasks run by priority : the extraction
+ * of the played track first, then the extraction of loaded tracks not played, then the analysis of
+ * the library.
+ */
+public class SSDecodeStats {
+
+    /**
+     * Priorities of decoding tasks, in the order they are run.
+     */
+    public static final int PRIORITY_PLAYING = 0;
+    public static final int PRIORITY_CUED = 1;
+    public static final int PRIORITY_BACKGROUND = 2;
+    public static final int NUMBER_PRIORITIES = 3;
+
+    private static final int PRIORITY_SIZE = 5;
+
+    private final long[] mStats;
+
+    /**
+     * @param stats Array sent by native code : for each priority the number of tasks run, the time
+     *              spent running them in ms, the number of tasks dropped before running, the number
+     *              of jobs cancelled while running and their work in ms. Then the highest number of
+     *              tasks waiting for a worker.
+     */
+    /* package */ SSDecodeStats(final long[] stats) {
+        mStats = stats;
+    }
+
+    /**
+     * @return Number of tasks of the priority run by the workers.
+     */
+    public long getRunTasks(final int priority) {
+        return mStats[priority * PRIORITY_SIZE];
+    }
+
+    /**
+     * @return Time spent running tasks of the priority in ms, summed over the workers.
+     */
+    public long getRunMs(final int priority) {
+        return mStats[priority * PRIORITY_SIZE + 1];
+    }
+
+    /**
+     * @return Number of tasks of the priority cancelled before they run, for instance the rest of
+     * an extraction when another track is loaded.
+     */
+    public long getDroppedTasks(final int priority) {
+        return mStats[priority * PRIORITY_SIZE + 2];
+    }
+
+    /**
+     * @return Number of extractions or analyses of a track of the priority stopped before their end.
+     */
+    public long getCancelledJobs(final int priority) {
+        return mStats[priority * PRIORITY_SIZE + 3];
+    }
+
+    /**
+     * @return Decoding time in ms wasted by the cancelled jobs of the priority.
+     */
+    public long getCancelledWorkMs(final int priority) {
+        return mStats[priority * PRIORITY_SIZE + 4];
+    }
+
+    /**
+     * @return Highest number of tasks waiting for a worker at the same time.
+     */
+    public long getMaxQueuedTasks() {
+        return mStats[NUMBER_PRIORITIES * PRIORITY_SIZE];
+    }
+}
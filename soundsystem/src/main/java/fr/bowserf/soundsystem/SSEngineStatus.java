@@ -0,0 +1,243 @@
+package fr.bowserf.soundsystem;
+
+import java.nio.ByteBuffer;
+
+/**
+ * Snapshot of the state of the engine, filled by {@link SoundSystem#readEngineStatus(SSEngineStatus)}
+ * from a block of native memory without calling native code. An instance is meant to be reused by
+ * a single thread, for instance at each frame of the UI.
+ */
+public class SSEngineStatus {
+
+    /**
+     * Words of the native block, in the order of EngineStatusWord. Each section starts with a
+     * sequence which is odd while the section is written.
+     */
+    private static final int WORD_PLAYER_SEQUENCE = 0;
+    private static final int WORD_IS_PLAYING = 1;
+    private static final int WORD_POSITION_FRAMES = 2;
+    private static final int WORD_PRESENTED_FRAME = 3;
+    private static final int WORD_PRESENTATION_TIME_HIGH = 4;
+    private static final int WORD_PRESENTATION_TIME_LOW = 5;
+    private static final int WORD_RATE = 6;
+    private static final int WORD_PEAK_LEFT = 7;
+    private static final int WORD_PEAK_RIGHT = 8;
+    private static final int WORD_STARVED_BUFFERS = 9;
+    private static final int WORD_LATE_CALLBACKS = 10;
+    private static final int WORD_OUTPUT_FRAME_HIGH = 11;
+    private static final int WORD_OUTPUT_FRAME_LOW = 12;
+    private static final int WORD_LOAD_SEQUENCE = 13;
+    private static final int WORD_IS_LOADED = 14;
+    private static final int WORD_IS_EXTRACTING = 15;
+    private static final int WORD_EXTRACTED_FRAMES = 16;
+    private static final int WORD_TOTAL_FRAMES = 17;
+    /* package */ static final int NUMBER_WORDS = 18;
+
+    /**
+     * Copies of a section tried while native threads write it, the previous values are kept after.
+     */
+    private static final int MAX_READ_ATTEMPTS = 8;
+
+    private final int[] mWords = new int[NUMBER_WORDS];
+
+    /**
+     * Written and read around the copy of a section : a volatile store followed by a volatile load
+     * is a full barrier, the words of the section are not read before the sequence or after its
+     * check.
+     */
+    private volatile int mBarrier;
+
+    private boolean mIsPlaying;
+    private long mPositionFrames;
+    private long mPresentedFrame;
+    private long mPresentationTimeNs;
+    private float mRate;
+    private float mPeakLeft;
+    private float mPeakRight;
+    private long mStarvedBuffers;
+    private long mLateCallbacks;
+    private long mOutputFrame;
+
+    private boolean mIsLoaded;
+    private boolean mIsExtracting;
+    private long mExtractedFrames;
+    private long mTotalFrames;
+
+    public SSEngineStatus() {
+    }
+
+    /**
+     * @param buffer Direct buffer of the native block, in native byte order.
+     * @return False if a section was written during all attempts, its previous values are kept.
+     */
+    /* package */ boolean read(final ByteBuffer buffer) {
+        boolean isRead = true;
+        if (readSection(buffer, WORD_PLAYER_SEQUENCE, WORD_LOAD_SEQUENCE)) {
+            mIsPlaying = mWords[WORD_IS_PLAYING] != 0;
+            mPositionFrames = mWords[WORD_POSITION_FRAMES] & 0xFFFFFFFFL;
+            mPresentedFrame = mWords[WORD_PRESENTED_FRAME] & 0xFFFFFFFFL;
+            mPresentationTimeNs = ((long) mWords[WORD_PRESENTATION_TIME_HIGH] << 32)
+                    | (mWords[WORD_PRESENTATION_TIME_LOW] & 0xFFFFFFFFL);
+            mRate = Float.intBitsToFloat(mWords[WORD_RATE]);
+            mPeakLeft = Float.intBitsToFloat(mWords[WORD_PEAK_LEFT]);
+            mPeakRight = Float.intBitsToFloat(mWords[WORD_PEAK_RIGHT]);
+            mStarvedBuffers = mWords[WORD_STARVED_BUFFERS] & 0xFFFFFFFFL;
+            mLateCallbacks = mWords[WORD_LATE_CALLBACKS] & 0xFFFFFFFFL;
+            mOutputFrame = ((long) mWords[WORD_OUTPUT_FRAME_HIGH] << 32)
+                    | (mWords[WORD_OUTPUT_FRAME_LOW] & 0xFFFFFFFFL);
+        } else {
+            isRead = false;
+        }
+        if (readSection(buffer, WORD_LOAD_SEQUENCE, NUMBER_WORDS)) {
+            mIsLoaded = mWords[WORD_IS_LOADED] != 0;
+            mIsExtracting = mWords[WORD_IS_EXTRACTING] != 0;
+            mExtractedFrames = mWords[WORD_EXTRACTED_FRAMES] & 0xFFFFFFFFL;
+            mTotalFrames = mWords[WORD_TOTAL_FRAMES] & 0xFFFFFFFFL;
+        } else {
+            isRead = false;
+        }
+        return isRead;
+    }
+
+    /**
+     * Copy the words following the sequence up to endWord.
+     */
+    private boolean readSection(final ByteBuffer buffer, final int sequenceWord, final int endWord) {
+        for (int attempt = 0; attempt < MAX_READ_ATTEMPTS; attempt++) {
+            final int sequence = buffer.getInt(sequenceWord * 4);
+            if ((sequence & 1) != 0) {
+                continue;
+            }
+            barrier();
+            for (int word = sequenceWord + 1; word < endWord; word++) {
+                mWords[word] = buffer.getInt(word * 4);
+            }
+            barrier();
+            if (buffer.getInt(sequenceWord * 4) == sequence) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    private void barrier() {
+        mBarrier = 0;
+        mBarrier++;
+    }
+
+    /**
+     * @return True if a track was playing during the last played buffer.
+     */
+    public boolean isPlaying() {
+        return mIsPlaying;
+    }
+
+    /**
+     * @return Position in frames from the start of the track after the last played buffer.
+     */
+    public long getPositionFrames() {
+        return mPositionFrames;
+    }
+
+    /**
+     * @return Frame of the track heard at {@link #getPresentationTimeNs()}, see
+     * {@link SSPlaybackClock}.
+     */
+    public long getPresentedFrame() {
+        return mPresentedFrame;
+    }
+
+    /**
+     * @return Time at which the presented frame is heard, in the time base of
+     * {@link System#nanoTime()}.
+     */
+    public long getPresentationTimeNs() {
+        return mPresentationTimeNs;
+    }
+
+    /**
+     * @return Frames of the track played per frame of the output, 0 when the position doesn't move.
+     */
+    public float getRate() {
+        return mRate;
+    }
+
+    /**
+     * @return Highest absolute sample of the left channel in the last played buffer, 1 at full
+     * scale.
+     */
+    public float getPeakLeft() {
+        return mPeakLeft;
+    }
+
+    /**
+     * @return Highest absolute sample of the right channel in the last played buffer, 1 at full
+     * scale.
+     */
+    public float getPeakRight() {
+        return mPeakRight;
+    }
+
+    /**
+     * @return Number of played buffers which needed frames not extracted yet, played as silence.
+     */
+    public long getStarvedBuffers() {
+        return mStarvedBuffers;
+    }
+
+    /**
+     * @return Number of player callbacks which came too late to keep the output fed.
+     */
+    public long getLateCallbacks() {
+        return mLateCallbacks;
+    }
+
+    /**
+     * @return Frame of the output clock heard at {@link #getPresentationTimeNs()}, see
+     * {@link SSPlaybackClock#getOutputFrame()}.
+     */
+    public long getOutputFrame() {
+        return mOutputFrame;
+    }
+
+    /**
+     * @return True if the track is completely loaded.
+     */
+    public boolean isLoaded() {
+        return mIsLoaded;
+    }
+
+    /**
+     * @return True while the track is extracted.
+     */
+    public boolean isExtracting() {
+        return mIsExtracting;
+    }
+
+    /**
+     * @return Number of frames of the track extracted so far.
+     */
+    public long getExtractedFrames() {
+        return mExtractedFrames;
+    }
+
+    /**
+     * @return Number of frames of the track, estimated from its duration during the extraction.
+     */
+    public long getTotalFrames() {
+        return mTotalFrames;
+    }
+
+    /**
+     * @return Extraction progress between 0 and 1.
+     */
+    public float getExtractionProgress() {
+        if (mIsLoaded) {
+            return 1f;
+        }
+        if (mTotalFrames == 0) {
+            return 0f;
+        }
+        return Math.min(1f, (float) mExtractedFrames / mTotalFrames);
+    }
+}
@@ -0,0 +1,90 @@
+package fr.bowserf.soundsystem;
+
+/**
+ * Clock of the player published by the audio thread at each played buffer, see
+ * {@link SoundSystem#getPlaybackClock()}.
+ */
+public class SSPlaybackClock {
+
+    private final boolean mIsPlaying;
+    private final long mPresentedFrame;
+    private final long mPresentationTimeNs;
+    private final float mRate;
+    private final int mSampleRate;
+    private final long mOutputFrame;
+
+    /**
+     * @param clock Array sent by native code : playing flag, presented frame, presentation time,
+     *              bits of the rate, sample rate and frame of the output clock.
+     */
+    /* package */ SSPlaybackClock(final long[] clock) {
+        mIsPlaying = clock[0] != 0;
+        mPresentedFrame = clock[1];
+        mPresentationTimeNs = clock[2];
+        mRate = Float.intBitsToFloat((int) clock[3]);
+        mSampleRate = (int) clock[4];
+        mOutputFrame = clock[5];
+    }
+
+    /**
+     * @return True if a track was playing during the last played buffer.
+     */
+    public boolean isPlaying() {
+        return mIsPlaying;
+    }
+
+    /**
+     * @return Frame of the track heard at {@link #getPresentationTimeNs()}.
+     */
+    public long getPresentedFrame() {
+        return mPresentedFrame;
+    }
+
+    /**
+     * @return Time at which the presented frame is heard, in the time base of
+     * {@link System#nanoTime()}. Includes the buffers queued before it and the output latency.
+     */
+    public long getPresentationTimeNs() {
+        return mPresentationTimeNs;
+    }
+
+    /**
+     * @return Frames of the track played per frame of the output, 0 when the position doesn't move.
+     */
+    public float getRate() {
+        return mRate;
+    }
+
+    /**
+     * Extrapolate the position heard at a given time, for progress bars and waveform cursors drawn
+     * at each frame of the UI without asking the native code again.
+     *
+     * @param nanoTime Time in the time base of {@link System#nanoTime()}.
+     * @return Frame of the track heard at nanoTime.
+     */
+    public long getFrameAt(final long nanoTime) {
+        final double elapsedFrames = (nanoTime - mPresentationTimeNs) * 1e-9 * mSampleRate * mRate;
+        return Math.max(0, mPresentedFrame + (long) elapsedFrames);
+    }
+
+    /**
+     * @return Frame of the output clock heard at {@link #getPresentationTimeNs()}. The output clock
+     * counts the frames played by the player, whatever the track and its rate, and stops while the
+     * output is stopped. Events are scheduled against it.
+     */
+    public long getOutputFrame() {
+        return mOutputFrame;
+    }
+
+    /**
+     * Extrapolate the frame of the output clock heard at a given time, to schedule an event at
+     * this time with {@link SoundSystem#scheduleStart(long)} and the other schedule methods.
+     *
+     * @param nanoTime Time in the time base of {@link System#nanoTime()}.
+     * @return Frame of the output clock heard at nanoTime, while the output runs.
+     */
+    public long getOutputFrameAt(final long nanoTime) {
+        final double elapsedFrames = (nanoTime - mPresentationTimeNs) * 1e-9 * mSampleRate;
+        return Math.max(0, mOutputFrame + Math.round(elapsedFrames));
+    }
+}
@@ -0,0 +1,80 @@
+package fr.bowserf.soundsystem;
+
+/**
+ * Counters of the scheduled events, see {@link SoundSystem#getSchedulerStats()}.
+ */
+public class SSSchedulerStats {
+
+    private final long mScheduledEvents;
+    private final long mAppliedEvents;
+    private final long mLateEvents;
+    private final long mMaxLateFrames;
+    private final long mCancelledEvents;
+    private final long mRejectedEvents;
+    private final int mPendingEvents;
+
+    /**
+     * @param stats Array sent by native code : scheduled, applied and late events, highest delay
+     *              of a late event in frames, cancelled and rejected events, then the events
+     *              waiting for their frame.
+     */
+    /* package */ SSSchedulerStats(final long[] stats) {
+        mScheduledEvents = stats[0];
+        mAppliedEvents = stats[1];
+        mLateEvents = stats[2];
+        mMaxLateFrames = stats[3];
+        mCancelledEvents = stats[4];
+        mRejectedEvents = stats[5];
+        mPendingEvents = (int) stats[6];
+    }
+
+    /**
+     * @return Events accepted since the sound system was created.
+     */
+    public long getScheduledEvents() {
+        return mScheduledEvents;
+    }
+
+    /**
+     * @return Events applied by the player, late ones included.
+     */
+    public long getAppliedEvents() {
+        return mAppliedEvents;
+    }
+
+    /**
+     * @return Events whose frame had already been rendered when they reached the player, applied
+     * at the start of the next buffer.
+     */
+    public long getLateEvents() {
+        return mLateEvents;
+    }
+
+    /**
+     * @return Highest delay of a late event, in frames.
+     */
+    public long getMaxLateFrames() {
+        return mMaxLateFrames;
+    }
+
+    /**
+     * @return Events dropped by {@link SoundSystem#cancelScheduledEvents()} before their frame.
+     */
+    public long getCancelledEvents() {
+        return mCancelledEvents;
+    }
+
+    /**
+     * @return Events refused because too many events were waiting for the player.
+     */
+    public long getRejectedEvents() {
+        return mRejectedEvents;
+    }
+
+    /**
+     * @return Events received by the player and waiting for their frame.
+     */
+    public int getPendingEvents() {
+        return mPendingEvents;
+    }
+}
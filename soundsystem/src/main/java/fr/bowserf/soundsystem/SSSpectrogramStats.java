@@ -0,0 +1,79 @@
+package fr.bowserf.soundsystem;
+
+/**
+ * Counters of the spectrogram of the loaded track, see {@link SoundSystem#getSpectrogramStats()}.
+ */
+public class SSSpectrogramStats {
+
+    private final long mComputedChunks;
+    private final long mComputeMs;
+    private final long mHits;
+    private final long mMisses;
+    private final long mEvictions;
+    private final int mNumberTiles;
+    private final long mUsedBytes;
+    private final long mBudgetBytes;
+
+    /**
+     * @param stats Array sent by native code : computed chunks, compute time in ms, hits, misses,
+     *              evictions, number of tiles, used bytes and budget in bytes.
+     */
+    /* package */ SSSpectrogramStats(final long[] stats) {
+        mComputedChunks = stats[0];
+        mComputeMs = stats[1];
+        mHits = stats[2];
+        mMisses = stats[3];
+        mEvictions = stats[4];
+        mNumberTiles = (int) stats[5];
+        mUsedBytes = stats[6];
+        mBudgetBytes = stats[7];
+    }
+
+    /**
+     * @return Number of parts of {@link SoundSystem#SPECTROGRAM_TILE_COLUMNS} columns transformed,
+     * including parts computed again after their tiles have been evicted.
+     */
+    public long getComputedChunks() {
+        return mComputedChunks;
+    }
+
+    /**
+     * @return Time spent by all workers to compute the chunks, in ms.
+     */
+    public long getComputeMs() {
+        return mComputeMs;
+    }
+
+    /**
+     * @return Number of requested tiles found in memory, even partially computed.
+     */
+    public long getHits() {
+        return mHits;
+    }
+
+    /**
+     * @return Number of requested tiles not computed yet or evicted.
+     */
+    public long getMisses() {
+        return mMisses;
+    }
+
+    /**
+     * @return Number of tiles removed from memory to stay under the budget.
+     */
+    public long getEvictions() {
+        return mEvictions;
+    }
+
+    public int getNumberTiles() {
+        return mNumberTiles;
+    }
+
+    public long getUsedBytes() {
+        return mUsedBytes;
+    }
+
+    public long getBudgetBytes() {
+        return mBudgetBytes;
+    }
+}
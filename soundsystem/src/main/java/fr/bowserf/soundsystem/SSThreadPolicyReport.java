@@ -0,0 +1,78 @@
+package fr.bowserf.soundsystem;
+
+/**
+ * Scheduling granted by the OS to a thread of the sound system, read back after its thread policy
+ * has been applied.
+ */
+public class SSThreadPolicyReport {
+
+    /**
+     * Number of values of each report in the array sent by native code.
+     */
+    /* package */ static final int SIZE = 6;
+
+    /**
+     * Linux scheduling policies, see {@link #getSchedulingPolicy()}.
+     */
+    public static final int SCHED_OTHER = 0;
+    public static final int SCHED_FIFO = 1;
+    public static final int SCHED_RR = 2;
+
+    private final int mRole;
+    private final int mTid;
+    private final int mSchedulingPolicy;
+    private final int mPriority;
+    private final int mNiceLevel;
+    private final int mCpuMask;
+
+    /**
+     * @param reports Array sent by native code : role, thread id, scheduling policy, priority,
+     *                nice level and CPU mask of each report.
+     * @param index   Index of the report in the array.
+     */
+    /* package */ SSThreadPolicyReport(final int[] reports, final int index) {
+        final int offset = index * SIZE;
+        mRole = reports[offset];
+        mTid = reports[offset + 1];
+        mSchedulingPolicy = reports[offset + 2];
+        mPriority = reports[offset + 3];
+        mNiceLevel = reports[offset + 4];
+        mCpuMask = reports[offset + 5];
+    }
+
+    /**
+     * @return One of the SoundSystem.THREAD_ROLE_* constants.
+     */
+    public int getRole() {
+        return mRole;
+    }
+
+    public int getTid() {
+        return mTid;
+    }
+
+    /**
+     * @return {@link #SCHED_OTHER}, {@link #SCHED_FIFO}...
+     */
+    public int getSchedulingPolicy() {
+        return mSchedulingPolicy;
+    }
+
+    /**
+     * @return Real time priority, 0 if the thread is not {@link #SCHED_FIFO}.
+     */
+    public int getPriority() {
+        return mPriority;
+    }
+
+    public int getNiceLevel() {
+        return mNiceLevel;
+    }
+
+    /**
+     * @return Bit i is set if the thread can run on CPU i.
+     */
+    public int getCpuMask() {
+        return mCpuMask;
+    }
+}
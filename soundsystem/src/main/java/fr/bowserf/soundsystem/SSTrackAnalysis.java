@@ -0,0 +1,152 @@
+package fr.bowserf.soundsystem;
+
+/**
+ * Results of the analyzers of the loaded track, see {@link SoundSystem#getTrackAnalysis()}.
+ */
+public class SSTrackAnalysis {
+
+    private static final String[] PITCH_CLASS_NAMES =
+            {"C", "C#", "D", "Eb", "E", "F", "F#", "G", "Ab", "A", "Bb", "B"};
+
+    private final boolean mComplete;
+    private final long mNumberFrames;
+    private final float mPeak;
+    private final float mRms;
+    private final long mFirstAudibleFrame;
+    private final long mLastAudibleFrame;
+    private final float mLoudness;
+    private final int mNumberOnsets;
+    private final double mTotalMs;
+    private final int mNumberTasks;
+    private final int mKey;
+    private final float mKeyStrength;
+    private final double[] mAnalyzerMs;
+
+    /**
+     * @param analysis Array sent by native code : 1 if complete, frames analysed, peak, rms, first
+     *                 and last audible frames, loudness, number of onsets, time of the pass in ms,
+     *                 number of tasks, key, key strength, then the time of each analyzer in ms.
+     */
+    /* package */ SSTrackAnalysis(final double[] analysis) {
+        mComplete = analysis[0] != 0;
+        mNumberFrames = (long) analysis[1];
+        mPeak = (float) analysis[2];
+        mRms = (float) analysis[3];
+        mFirstAudibleFrame = (long) analysis[4];
+        mLastAudibleFrame = (long) analysis[5];
+        mLoudness = (float) analysis[6];
+        mNumberOnsets = (int) analysis[7];
+        mTotalMs = analysis[8];
+        mNumberTasks = (int) analysis[9];
+        mKey = (int) analysis[10];
+        mKeyStrength = (float) analysis[11];
+        mAnalyzerMs = new double[SoundSystem.TRACK_ANALYZER_COUNT];
+        System.arraycopy(analysis, 12, mAnalyzerMs, 0, SoundSystem.TRACK_ANALYZER_COUNT);
+    }
+
+    /**
+     * @return True once every stored frame has been analysed. Other results are only valid then.
+     */
+    public boolean isComplete() {
+        return mComplete;
+    }
+
+    /**
+     * @return Number of stored frames analysed so far.
+     */
+    public long getNumberFrames() {
+        return mNumberFrames;
+    }
+
+    /**
+     * @return Highest absolute sample, 1 is full scale.
+     */
+    public float getPeak() {
+        return mPeak;
+    }
+
+    /**
+     * @return Root mean square of the samples of both channels, 1 is full scale.
+     */
+    public float getRms() {
+        return mRms;
+    }
+
+    /**
+     * @return First audible frame in the stored frames, with the default parameters of
+     * {@link SoundSystem#setSilenceTrimming(boolean, float, int)}.
+     */
+    public long getFirstAudibleFrame() {
+        return mFirstAudibleFrame;
+    }
+
+    /**
+     * @return Last audible frame in the stored frames.
+     */
+    public long getLastAudibleFrame() {
+        return mLastAudibleFrame;
+    }
+
+    /**
+     * @return Integrated loudness of ITU-R BS.1770 in LUFS, -70 for a silent track.
+     */
+    public float getLoudness() {
+        return mLoudness;
+    }
+
+    /**
+     * @return Number of onsets found in the onset envelope, see
+     * {@link SoundSystem#getTrackAnalysisCurve(int, float[])}.
+     */
+    public int getNumberOnsets() {
+        return mNumberOnsets;
+    }
+
+    /**
+     * @return 0 to 11 for the major keys from C, 12 to 23 for the minor keys from C, -1 if the
+     * key is unknown.
+     */
+    public int getKey() {
+        return mKey;
+    }
+
+    /**
+     * @return Correlation of the chroma of the track with the profile of its key, from -1 to 1.
+     */
+    public float getKeyStrength() {
+        return mKeyStrength;
+    }
+
+    /**
+     * @return Name of the key, such as "D" or "F#m", null if the key is unknown.
+     */
+    public String getKeyName() {
+        if (mKey < 0) {
+            return null;
+        }
+        final String pitchClass = PITCH_CLASS_NAMES[mKey % 12];
+        return mKey < 12 ? pitchClass : pitchClass + "m";
+    }
+
+    /**
+     * @return Time of the whole pass in ms, including the reading of the frames.
+     */
+    public double getTotalMs() {
+        return mTotalMs;
+    }
+
+    /**
+     * @return Number of tasks run by the workers for the pass.
+     */
+    public int getNumberTasks() {
+        return mNumberTasks;
+    }
+
+    /**
+     * @param analyzer One of the TRACK_ANALYZER_* constants of {@link SoundSystem}.
+     * @return Time spent in the analyzer in ms.
+     */
+    public double getAnalyzerMs(final int analyzer) {
+        return mAnalyzerMs[analyzer];
+    }
+}
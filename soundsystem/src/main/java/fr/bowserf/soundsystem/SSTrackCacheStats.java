@@ -0,0 +1,60 @@
+package fr.bowserf.soundsystem;
+
+/**
+ * Counters of the cache of decoded tracks, see {@link SoundSystem#getTrackCacheStats()}.
+ */
+public class SSTrackCacheStats {
+
+    private final long mHits;
+    private final long mMisses;
+    private final long mEvictions;
+    private final int mNumberTracks;
+    private final long mUsedBytes;
+    private final long mBudgetBytes;
+
+    /**
+     * @param stats Array sent by native code : hits, misses, evictions, number of tracks, used
+     *              bytes and budget in bytes.
+     */
+    /* package */ SSTrackCacheStats(final long[] stats) {
+        mHits = stats[0];
+        mMisses = stats[1];
+        mEvictions = stats[2];
+        mNumberTracks = (int) stats[3];
+        mUsedBytes = stats[4];
+        mBudgetBytes = stats[5];
+    }
+
+    /**
+     * @return Number of loaded tracks found in the cache.
+     */
+    public long getHits() {
+        return mHits;
+    }
+
+    /**
+     * @return Number of loaded tracks which have been extracted.
+     */
+    public long getMisses() {
+        return mMisses;
+    }
+
+    /**
+     * @return Number of tracks removed from the cache to stay under the budget.
+     */
+    public long getEvictions() {
+        return mEvictions;
+    }
+
+    public int getNumberTracks() {
+        return mNumberTracks;
+    }
+
+    public long getUsedBytes() {
+        return mUsedBytes;
+    }
+
+    public long getBudgetBytes() {
+        return mBudgetBytes;
+    }
+}
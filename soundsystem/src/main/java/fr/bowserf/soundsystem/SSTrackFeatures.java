@@ -0,0 +1,75 @@
+package fr.bowserf.soundsystem;
+
+/**
+ * Features of a track computed by a library scan.
+ */
+public class SSTrackFeatures {
+
+    /**
+     * Number of values before the overview in the array sent by native code.
+     */
+    private static final int HEADER_SIZE = 6;
+
+    private final int mDurationMs;
+    private final int mSampleRate;
+    private final int mNumberChannels;
+    private final float mPeak;
+    private final float mRms;
+    private final float mLoudness;
+    private final float[] mOverview;
+
+    /**
+     * @param features Array sent by native code : duration, sample rate, number of channels, peak,
+     *                 rms, loudness and then peaks of the overview.
+     */
+    /* package */ SSTrackFeatures(final float[] features) {
+        mDurationMs = (int) features[0];
+        mSampleRate = (int) features[1];
+        mNumberChannels = (int) features[2];
+        mPeak = features[3];
+        mRms = features[4];
+        mLoudness = features[5];
+        mOverview = new float[features.length - HEADER_SIZE];
+        System.arraycopy(features, HEADER_SIZE, mOverview, 0, mOverview.length);
+    }
+
+    public int getDurationMs() {
+        return mDurationMs;
+    }
+
+    public int getSampleRate() {
+        return mSampleRate;
+    }
+
+    public int getNumberChannels() {
+        return mNumberChannels;
+    }
+
+    /**
+     * @return Highest absolute sample value, between 0 and 1.
+     */
+    public float getPeak() {
+        return mPeak;
+    }
+
+    /**
+     * @return Root mean square of all samples, between 0 and 1.
+     */
+    public float getRms() {
+        return mRms;
+    }
+
+    /**
+     * @return Gated loudness of the track in dB full scale.
+     */
+    public float getLoudness() {
+        return mLoudness;
+    }
+
+    /**
+     * @return Peaks of consecutive parts of the track, between 0 and 1.
+     */
+    public float[] getOverview() {
+        return mOverview;
+    }
+}
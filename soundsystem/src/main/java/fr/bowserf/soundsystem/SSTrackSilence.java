@@ -0,0 +1,44 @@
+package fr.bowserf.soundsystem;
+
+/**
+ * Silence at the start and at the end of the loaded track, see
+ * {@link SoundSystem#getTrackSilence()}.
+ */
+public class SSTrackSilence {
+
+    private final int mTrimmedFrames;
+    private final int mFirstAudibleFrame;
+    private final int mLastAudibleFrame;
+
+    /**
+     * @param silence Array sent by native code : trimmed frames, first and last audible frames.
+     */
+    /* package */ SSTrackSilence(final int[] silence) {
+        mTrimmedFrames = silence[0];
+        mFirstAudibleFrame = silence[1];
+        mLastAudibleFrame = silence[2];
+    }
+
+    /**
+     * @return Number of frames of leading silence which have not been stored.
+     */
+    public int getTrimmedFrames() {
+        return mTrimmedFrames;
+    }
+
+    /**
+     * @return First audible frame in the stored frames, 0 if the leading silence is shorter than
+     * the minimum duration.
+     */
+    public int getFirstAudibleFrame() {
+        return mFirstAudibleFrame;
+    }
+
+    /**
+     * @return Last audible frame in the stored frames, the last frame if the trailing silence is
+     * shorter than the minimum duration.
+     */
+    public int getLastAudibleFrame() {
+        return mLastAudibleFrame;
+    }
+}
@@ -5,10 +5,15 @@ import android.os.Handler;
 import android.os.Looper;
 import android.support.annotation.Keep;
 
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
 import java.util.ArrayList;
 import java.util.List;
 
 import fr.bowserf.soundsystem.listener.SSExtractionObserver;
+import fr.bowserf.soundsystem.listener.SSFingerprintObserver;
+import fr.bowserf.soundsystem.listener.SSTrackAnalysisObserver;
+import fr.bowserf.soundsystem.listener.SSLibraryScanObserver;
 import fr.bowserf.soundsystem.listener.SSPlayingStatusObserver;
 
 /**
@@ -26,6 +31,90 @@ public class SoundSystem {
         System.loadLibrary("soundsystem");
     }
 
+    /**
+     * Types of equalizer sections, see {@link #setEqualizerSection(int, int, float, float, float)}.
+     */
+    public static final int EQUALIZER_SECTION_BYPASS = 0;
+    public static final int EQUALIZER_SECTION_PEAKING = 1;
+    public static final int EQUALIZER_SECTION_LOW_SHELF = 2;
+    public static final int EQUALIZER_SECTION_HIGH_SHELF = 3;
+    public static final int EQUALIZER_SECTION_LOW_PASS = 4;
+    public static final int EQUALIZER_SECTION_HIGH_PASS = 5;
+
+    /**
+     * Number of sections of the equalizer.
+     */
+    public static final int EQUALIZER_NUMBER_SECTIONS = 8;
+
+    /**
+     * Gain in dB under which a band of the three band equalizer is killed.
+     */
+    public static final float EQUALIZER_KILL_GAIN_DB = -60f;
+
+    /**
+     * Roles of native threads, see {@link #setThreadPolicy(int, int, int, int)}.
+     */
+    public static final int THREAD_ROLE_RENDER = 0;
+    public static final int THREAD_ROLE_DECODER = 1;
+    public static final int THREAD_ROLE_IO = 2;
+
+    /**
+     * Layout of the spectrogram tiles, see {@link #getSpectrogramTile(int, int, byte[])}. Column
+     * c of level 0 is the spectrum of SPECTROGRAM_FFT_SIZE frames from frame
+     * c * SPECTROGRAM_HOP_FRAMES, a column of level n the maximum of 2^n columns of level 0.
+     */
+    public static final int SPECTROGRAM_FFT_SIZE = 1024;
+    public static final int SPECTROGRAM_HOP_FRAMES = 512;
+    public static final int SPECTROGRAM_NUMBER_BANDS = 128;
+    public static final int SPECTROGRAM_TILE_COLUMNS = 256;
+    public static final int SPECTROGRAM_NUMBER_LEVELS = 8;
+    public static final int SPECTROGRAM_TILE_SIZE =
+            SPECTROGRAM_TILE_COLUMNS * SPECTROGRAM_NUMBER_BANDS;
+
+    /**
+     * States of a spectrogram tile, see {@link #getSpectrogramTile(int, int, byte[])}.
+     */
+    public static final int SPECTROGRAM_TILE_MISSING = 0;
+    public static final int SPECTROGRAM_TILE_PARTIAL = 1;
+    public static final int SPECTROGRAM_TILE_COMPLETE = 2;
+
+    /**
+     * Analyzers of the loaded track, see {@link SSTrackAnalysis#getAnalyzerMs(int)} and
+     * {@link #getTrackAnalysisCurve(int, float[])}.
+     */
+    public static final int TRACK_ANALYZER_PEAK = 0;
+    public static final int TRACK_ANALYZER_RMS = 1;
+    public static final int TRACK_ANALYZER_SILENCE = 2;
+    public static final int TRACK_ANALYZER_LOUDNESS = 3;
+    public static final int TRACK_ANALYZER_ONSET = 4;
+    public static final int TRACK_ANALYZER_KEY = 5;
+    public static final int TRACK_ANALYZER_COUNT = 6;
+
+    /**
+     * Frames of each value of the onset envelope.
+     */
+    public static final int TRACK_ANALYSIS_ONSET_HOP_FRAMES = 512;
+
+    /**
+     * Duration in seconds of the track generated by {@link #benchmarkKeyDetection()}.
+     */
+    public static final int KEY_DETECTION_BENCHMARK_SECONDS = 300;
+
+    /**
+     * Sources of {@link #startCapture(String, int, int)} : default input of the device, or a tone
+     * generated at the pace of the device.
+     */
+    public static final int CAPTURE_SOURCE_MICROPHONE = 0;
+    public static final int CAPTURE_SOURCE_SYNTHETIC = 1;
+
+    /**
+     * Types of scheduled events, in the order of ScheduledEventType.
+     */
+    private static final int SCHEDULED_EVENT_START = 0;
+    private static final int SCHEDULED_EVENT_STOP = 1;
+    private static final int SCHEDULED_EVENT_SEEK = 2;
+    private static final int SCHEDULED_EVENT_GAIN = 3;
+
     /**
      * Private instance of this class.
      */
@@ -44,6 +133,18 @@ public class SoundSystem {
         return sInstance;
     }
 
+    /**
+     * Create a sound system independent from the one of {@link #getInstance()}, with its own
+     * player, extraction and observers, for instance to preview a track while another one is
+     * played. Tracks of several sound systems are extracted at the same time.
+     *
+     * @return A new instance, to initialize with {@link #initSoundSystem(int, int)} and to release
+     * with {@link #release()}.
+     */
+    public static SoundSystem newInstance() {
+        return new SoundSystem(Looper.getMainLooper());
+    }
+
     /**
      * List of all playing status observer.
      */
@@ -54,11 +155,38 @@ public class SoundSystem {
      */
     private final List<SSExtractionObserver> mExtractionObservers;
 
+    /**
+     * List of all observer listening for the library scan progress.
+     */
+    private final List<SSLibraryScanObserver> mLibraryScanObservers;
+
+    /**
+     * List of all observer listening for the end of fingerprinting.
+     */
+    private final List<SSFingerprintObserver> mFingerprintObservers;
+
+    /**
+     * List of all observer listening for the end of the analysis of the loaded track.
+     */
+    private final List<SSTrackAnalysisObserver> mTrackAnalysisObservers;
+
     /**
      * Handler attach to the main thread.
      */
     private final Handler mMainHandler;
 
+    /**
+     * Native block of the engine status, null when the sound system is not initialized. Guarded by
+     * mStatusLock so that it's never read after the release of native objects.
+     */
+    private ByteBuffer mStatusBuffer;
+    private final Object mStatusLock = new Object();
+
+    /**
+     * Handle of the native objects of this sound system, 0 when it's not initialized.
+     */
+    private long mNativeHandle;
+
     /**
      * Private constructor.
      */
@@ -67,6 +195,9 @@ public class SoundSystem {
 
         mPlayingStatusObservers = new ArrayList<>();
         mExtractionObservers = new ArrayList<>();
+        mLibraryScanObservers = new ArrayList<>();
+        mFingerprintObservers = new ArrayList<>();
+        mTrackAnalysisObservers = new ArrayList<>();
     }
 
     /**
@@ -76,28 +207,46 @@ public class SoundSystem {
      * @param nativeFramesPerBuf    Native value of the number of frames per buffer.
      */
     public void initSoundSystem(final int nativeFrameRate, final int nativeFramesPerBuf) {
-        native_init_soundsystem(nativeFrameRate, nativeFramesPerBuf);
+        if (mNativeHandle != 0) {
+            return;
+        }
+        mNativeHandle = native_init_soundsystem(nativeFrameRate, nativeFramesPerBuf);
+        synchronized (mStatusLock) {
+            final ByteBuffer buffer = native_get_status_buffer(mNativeHandle);
+            // the layout of the block is shared with native code
+            final boolean isValid = buffer != null
+                    && buffer.capacity() == SSEngineStatus.NUMBER_WORDS * 4;
+            mStatusBuffer = isValid ? buffer.order(ByteOrder.nativeOrder()) : null;
+        }
     }
 
     /**
      * Release native objects and this object.
      */
     public void release() {
-        native_release_soundsystem();
-        sInstance = null;
+        synchronized (mStatusLock) {
+            mStatusBuffer = null;
+        }
+        final long handle = mNativeHandle;
+        mNativeHandle = 0;
+        native_release_soundsystem(handle);
+        if (sInstance == this) {
+            sInstance = null;
+        }
     }
 
     public boolean isSoundSystemInit(){
-        return native_is_soundsystem_init();
+        return native_is_soundsystem_init(mNativeHandle);
     }
 
     /**
-     * Load track file into the RAM.
+     * Load track file into the RAM. Recently extracted tracks are loaded instantly from the cache of
+     * decoded tracks, see {@link #setTrackCacheBudget(long)}.
      *
      * @param filePath Path of the file on the hard disk.
      */
     public void loadFile(final String filePath) {
-        native_load_file(filePath);
+        native_load_file(mNativeHandle, filePath);
     }
 
     /**
@@ -106,14 +255,14 @@ public class SoundSystem {
      * @param isPlaying True if music is playing.
      */
     public void playMusic(final boolean isPlaying) {
-        native_play(isPlaying);
+        native_play(mNativeHandle, isPlaying);
     }
 
     /**
      * Stop music.
      */
     public void stopMusic() {
-        native_stop();
+        native_stop(mNativeHandle);
     }
 
     /**
@@ -121,7 +270,54 @@ public class SoundSystem {
      * @return  True if a track is played.
      */
     public boolean isPlaying(){
-        return native_is_playing();
+        return native_is_playing(mNativeHandle);
+    }
+
+    /**
+     * Get the position of the player. Updated by the audio thread after each played buffer.
+     * @return Position in frames from the start of the track.
+     */
+    public int getPlayingPosition(){
+        return native_get_playing_position(mNativeHandle);
+    }
+
+    /**
+     * Read the state of the engine published by native threads : transport, position, levels,
+     * underruns and extraction progress. No native code is called, so that it can be polled at
+     * each frame of the UI. Native threads never wait for the read.
+     *
+     * @param status Filled with the state, reused between calls.
+     * @return False if the sound system is not initialized, or if the state changed during the
+     * whole read : the status then keeps some previous values.
+     */
+    public boolean readEngineStatus(final SSEngineStatus status) {
+        synchronized (mStatusLock) {
+            return mStatusBuffer != null && status.read(mStatusBuffer);
+        }
+    }
+
+    /**
+     * Get the clock of the player, published by the audio thread at each played buffer without
+     * locking it. The position heard at any time is extrapolated from it with
+     * {@link SSPlaybackClock#getFrameAt(long)}, it only needs to be read again when the transport
+     * or the rate changes, or to correct the drift.
+     *
+     * @return Clock of the player, or null if the sound system is not initialized.
+     */
+    public SSPlaybackClock getPlaybackClock() {
+        final long[] clock = native_get_playback_clock(mNativeHandle);
+        return clock == null ? null : new SSPlaybackClock(clock);
+    }
+
+    /**
+     * Set the latency of the output after the buffers of the player, included in the presentation
+     * time of the playback clock. The latency reported by the device is used by default.
+     *
+     * @param latencyMs Latency measured by the application, a negative value to use the latency
+     *                  reported by the device again.
+     */
+    public void setOutputLatency(final int latencyMs) {
+        native_set_output_latency(mNativeHandle, latencyMs);
     }
 
     /**
@@ -129,7 +325,7 @@ public class SoundSystem {
      * @return True if a track is loaded.
      */
     public boolean isLoaded(){
-        return native_is_loaded();
+        return native_is_loaded(mNativeHandle);
     }
 
     /**
@@ -138,7 +334,7 @@ public class SoundSystem {
      * @return A short array containing all extracted data from audio file.
      */
     public short[] getExtractedData(){
-        return native_get_extracted_data();
+        return native_get_extracted_data(mNativeHandle);
     }
 
     /**
@@ -146,7 +342,7 @@ public class SoundSystem {
      * @return A shorrt array containing mono data of extracted audio file.
      */
     public short[] getExtractedDataMono(){
-        return native_get_extracted_data_mono();
+        return native_get_extracted_data_mono(mNativeHandle);
     }
 
     /**
@@ -155,7 +351,7 @@ public class SoundSystem {
      * @param fileName      Name of the file to play which is inside Asset folder.
      */
     public void playSong(final AssetManager assetManager, final String fileName){
-        native_extract_from_assets_and_play(assetManager, fileName);
+        native_extract_from_assets_and_play(mNativeHandle, assetManager, fileName);
     }
 
     /**
@@ -163,7 +359,580 @@ public class SoundSystem {
      * @param audioFilePath Local path of the audio file on device.
      */
     public void extractAndPlay(final String audioFilePath){
-        native_extract_and_play(audioFilePath);
+        native_extract_and_play(mNativeHandle, audioFilePath);
+    }
+
+    /**
+     * Decode and analyse audio files in background and store their features in an index file.
+     * Files already in the index are skipped, so calling it again with the same params resumes an
+     * interrupted scan.
+     *
+     * @param filePaths     Local paths of audio files on device.
+     * @param indexFilePath Path of the index file, created if it doesn't exist.
+     * @return False if a scan is already running.
+     */
+    public boolean scanLibrary(final String[] filePaths, final String indexFilePath) {
+        return native_scan_library(mNativeHandle, filePaths, indexFilePath);
+    }
+
+    /**
+     * Stop the running library scan. Tracks already scanned are kept in the index.
+     */
+    public void cancelLibraryScan() {
+        native_cancel_library_scan(mNativeHandle);
+    }
+
+    /**
+     * Get features of a track from an index built by {@link #scanLibrary(String[], String)}.
+     *
+     * @param indexFilePath Path of the index file.
+     * @param filePath      Local path of the audio file on device.
+     * @return Features of the track or null if it has not been scanned successfully.
+     */
+    public SSTrackFeatures getScannedTrackFeatures(final String indexFilePath, final String filePath) {
+        final float[] features = native_get_scanned_track_features(indexFilePath, filePath);
+        return features == null ? null : new SSTrackFeatures(features);
+    }
+
+    /**
+     * Compute in background acoustic fingerprints of the start of audio files, to find tracks
+     * with the same audio content whatever their encoding. Fingerprints are kept in RAM until
+     * {@link #clearFingerprints()} is called.
+     *
+     * @param filePaths Local paths of audio files on device.
+     * @return False if fingerprinting is already running.
+     */
+    public boolean fingerprintTracks(final String[] filePaths) {
+        return native_fingerprint_tracks(mNativeHandle, filePaths);
+    }
+
+    /**
+     * Stop the running fingerprinting. Tracks already fingerprinted are kept.
+     */
+    public void cancelFingerprinting() {
+        native_cancel_fingerprinting(mNativeHandle);
+    }
+
+    /**
+     * Find tracks with the same audio content as a fingerprinted file.
+     *
+     * @param filePath Local path of a file given to {@link #fingerprintTracks(String[])}.
+     * @return Paths of duplicates, best match first.
+     */
+    public String[] findDuplicates(final String filePath) {
+        return native_find_duplicates(mNativeHandle, filePath);
+    }
+
+    /**
+     * Find fingerprinted tracks with the same audio content as the loaded track.
+     *
+     * @return Paths of duplicates, best match first.
+     */
+    public String[] findLoadedTrackDuplicates() {
+        return native_find_loaded_track_duplicates(mNativeHandle);
+    }
+
+    /**
+     * Remove all fingerprints from RAM.
+     */
+    public void clearFingerprints() {
+        native_clear_fingerprints(mNativeHandle);
+    }
+
+    /**
+     * Configure a section of the equalizer applied on the played track. Changes are smoothed to
+     * avoid clicks.
+     *
+     * @param index     Index of the section, lower than {@link #EQUALIZER_NUMBER_SECTIONS}.
+     * @param type      One of the EQUALIZER_SECTION_* values.
+     * @param frequency Center or cutoff frequency in Hz.
+     * @param gainDb    Gain in dB of peaking and shelving sections.
+     * @param q         Quality factor, 0.707 for a flat response.
+     */
+    public void setEqualizerSection(final int index, final int type, final float frequency,
+                                    final float gainDb, final float q) {
+        native_set_equalizer_section(mNativeHandle, index, type, frequency, gainDb, q);
+    }
+
+    /**
+     * Use the three first sections of the equalizer as a DJ equalizer.
+     * A gain of {@link #EQUALIZER_KILL_GAIN_DB} or lower kills the band.
+     *
+     * @param lowGainDb  Gain in dB of the low shelf.
+     * @param midGainDb  Gain in dB of the mid peak.
+     * @param highGainDb Gain in dB of the high shelf.
+     */
+    public void setThreeBandGains(final float lowGainDb, final float midGainDb,
+                                  final float highGainDb) {
+        native_set_three_band_gains(mNativeHandle, lowGainDb, midGainDb, highGainDb);
+    }
+
+    /**
+     * Bypass all sections of the equalizer.
+     */
+    public void resetEqualizer() {
+        native_reset_equalizer(mNativeHandle);
+    }
+
+    /**
+     * Measure the cost of the equalizer for usual buffer sizes (64, 128, 192, 240, 256, 480, 512
+     * and 1024 frames). Results are also written in logcat. Blocking, don't call it from the main
+     * thread.
+     *
+     * @return Nanoseconds per band per block for each buffer size.
+     */
+    public float[] benchmarkEqualizer() {
+        return native_benchmark_equalizer(mNativeHandle);
+    }
+
+    /**
+     * Change the speed of the play position, for scratches, reverse playback or vinyl brakes. The
+     * rate moves linearly from its current value to the new one, frames are interpolated when it's
+     * not 1.
+     *
+     * @param rate   1 for normal playback, negative to play backward, between -4 and 4.
+     * @param rampMs Duration to reach the rate, 0 to change it immediately. A vinyl brake is a
+     *               rate of 0 reached in about a second.
+     */
+    public void setPlaybackRate(final float rate, final int rampMs) {
+        native_set_playback_rate(mNativeHandle, rate, rampMs);
+    }
+
+    /**
+     * Measure the cost of reading the track at rates -4, -1, 0.5, 1, 2 and 4, for the buffer size
+     * of the player. Results are also written in logcat. Blocking, don't call it from the main
+     * thread.
+     *
+     * @return Percentage of the duration of a buffer spent reading it, for each rate.
+     */
+    public float[] benchmarkReadHead() {
+        return native_benchmark_read_head(mNativeHandle);
+    }
+
+    /**
+     * Measure the cost of mapping decoded frames to the stereo frames of the player, for mono,
+     * stereo, 5.1 and 7.1 files. Results are also written in logcat. Blocking, don't call it from
+     * the main thread.
+     *
+     * @return Nanoseconds per frame of each layout, with its optimized kernel then with the generic
+     * mapping.
+     */
+    public float[] benchmarkChannelMapping() {
+        return native_benchmark_channel_mapping(mNativeHandle);
+    }
+
+    /**
+     * Render the loaded track with the current equalizer settings to a WAV file, as fast as
+     * possible. Output is the same as what the player plays. Blocking, don't call it from the main
+     * thread.
+     *
+     * @param wavFilePath Path of the WAV file to create.
+     * @return Real time factor of the rendering (duration of the track divided by the rendering
+     * time), negative if no track is loaded, while a track is extracted or if the file can't be
+     * written.
+     */
+    public float renderToWav(final String wavFilePath) {
+        return native_render_to_wav(mNativeHandle, wavFilePath);
+    }
+
+    /**
+     * Measure the speed of the software MP3 decoder used by library scans and duplicate search on
+     * MPEG-1 layer III files. The result is also written in logcat. Blocking, don't call it from
+     * the main thread.
+     *
+     * @param mp3FilePath Path of a MP3 file.
+     * @return Real time factor of the decoding, 0 if the file can't be decoded.
+     */
+    public float benchmarkMp3Decoder(final String mp3FilePath) {
+        return native_benchmark_mp3_decoder(mNativeHandle, mp3FilePath);
+    }
+
+    /**
+     * Measure the time of the key detection of {@link #KEY_DETECTION_BENCHMARK_SECONDS} of
+     * generated chords, from the first frame to the key, with the workers of the decoding. The
+     * result is also written in logcat. Blocking, don't call it from the main thread.
+     *
+     * @return Time of the detection in ms.
+     */
+    public float benchmarkKeyDetection() {
+        return native_benchmark_key_detection(mNativeHandle);
+    }
+
+    /**
+     * Capture audio to a WAV file of 16 bits samples at the sample rate of the sound system.
+     * Blocks of the size of the player buffers are copied by the capture callback to a ring, and
+     * written by a dedicated thread with large sequential writes : the callback never waits for
+     * the storage, blocks which don't fit in the ring are dropped and counted.
+     * {@link #CAPTURE_SOURCE_MICROPHONE} needs the RECORD_AUDIO permission.
+     *
+     * @param wavFilePath    Path of the WAV file to create.
+     * @param source         One of the CAPTURE_SOURCE_* constants.
+     * @param numberChannels 1 or 2.
+     * @return False if a capture is running, or if the file or the source can't be created.
+     */
+    public boolean startCapture(final String wavFilePath, final int source,
+                                final int numberChannels) {
+        return native_start_capture(mNativeHandle, wavFilePath, source, numberChannels);
+    }
+
+    /**
+     * Stop the capture, write the captured audio left and complete the file. Blocking, don't call
+     * it from the main thread.
+     *
+     * @return False if no capture was running or if the file couldn't be written.
+     */
+    public boolean stopCapture() {
+        return native_stop_capture(mNativeHandle);
+    }
+
+    /**
+     * @return Counters and latency of the current capture, or of the last one once stopped. Null
+     * if the sound system is not initialized.
+     */
+    public SSCaptureStats getCaptureStats() {
+        final double[] stats = native_get_capture_stats(mNativeHandle);
+        return stats == null ? null : new SSCaptureStats(stats);
+    }
+
+    /**
+     * Decode a short audio file into the bank of samples, mixed over the track by the player.
+     * Files longer than 30 seconds are truncated. Blocking, don't call it from the main thread.
+     *
+     * @param filePath Path of the file.
+     * @return Index of the sample for {@link #triggerSample(int, float, int)}, -1 if the bank of
+     * 64 samples is full or if the file can't be decoded.
+     */
+    public int loadSample(final String filePath) {
+        return native_load_sample(mNativeHandle, filePath);
+    }
+
+    /**
+     * Play a sample once, in the next buffer of the player : it is heard one buffer after the
+     * call. Up to 128 voices are mixed, the oldest one is stolen beyond. The output must have been
+     * started by {@link #playMusic(boolean)} or {@link #startOutput()}.
+     *
+     * @param sample       Index returned by {@link #loadSample(String)}.
+     * @param gain         Linear gain of the voice.
+     * @param offsetFrames Delay of the voice from the start of the next buffer, in frames.
+     * @return False if the sample doesn't exist or too many triggers are waiting.
+     */
+    public boolean triggerSample(final int sample, final float gain, final int offsetFrames) {
+        return native_trigger_sample(mNativeHandle, sample, gain, offsetFrames);
+    }
+
+    /**
+     * Fade out every voice of the samples at the start of the next buffer.
+     */
+    public void stopSamples() {
+        native_stop_samples(mNativeHandle);
+    }
+
+    /**
+     * Start the output without loading a track, so that samples can be played. Loading a track
+     * stops the output until {@link #playMusic(boolean)} is called.
+     */
+    public void startOutput() {
+        native_start_output(mNativeHandle);
+    }
+
+    /**
+     * @return Voices of the samples still playing after the last buffer of the player.
+     */
+    public int getNumberActiveVoices() {
+        return native_get_number_active_voices(mNativeHandle);
+    }
+
+    /**
+     * @return Voices stolen because every voice was playing, since the sound system was created.
+     */
+    public int getNumberStolenVoices() {
+        return native_get_number_stolen_voices(mNativeHandle);
+    }
+
+    /**
+     * Measure the cost of mixing 32, 64 and 128 voices of samples, for the buffer size of the
+     * player. Results are also written in logcat. Blocking, don't call it from the main thread.
+     *
+     * @return Percentage of the duration of a buffer spent mixing it, for each number of voices.
+     */
+    public float[] benchmarkSampler() {
+        return native_benchmark_sampler(mNativeHandle);
+    }
+
+    /**
+     * Start playing the track at a frame of the output clock, to the frame. The frame for a time is
+     * given by {@link SSPlaybackClock#getOutputFrameAt(long)}. Scheduled events are sent without
+     * locking and applied while the output runs : a frame already played when the event reaches
+     * the player is applied at the start of the next buffer, and counted as late.
+     *
+     * @param outputFrame Frame of the output clock.
+     * @return False if too many events are waiting.
+     */
+    public boolean scheduleStart(final long outputFrame) {
+        return native_schedule_event(mNativeHandle, SCHEDULED_EVENT_START, outputFrame, 0, 0f, 0);
+    }
+
+    /**
+     * Stop the track and move back to its start at a frame of the output clock, see
+     * {@link #scheduleStart(long)}.
+     *
+     * @param outputFrame Frame of the output clock.
+     * @return False if too many events are waiting.
+     */
+    public boolean scheduleStop(final long outputFrame) {
+        return native_schedule_event(mNativeHandle, SCHEDULED_EVENT_STOP, outputFrame, 0, 0f, 0);
+    }
+
+    /**
+     * Move the play position at a frame of the output clock, see {@link #scheduleStart(long)}.
+     *
+     * @param outputFrame    Frame of the output clock.
+     * @param positionFrames Frame of the track played from outputFrame.
+     * @return False if too many events are waiting.
+     */
+    public boolean scheduleSeek(final long outputFrame, final long positionFrames) {
+        return native_schedule_event(mNativeHandle, SCHEDULED_EVENT_SEEK, outputFrame,
+                positionFrames, 0f, 0);
+    }
+
+    /**
+     * Change the gain of the track at a frame of the output clock, see
+     * {@link #scheduleStart(long)}. The gain is applied after the equalizer.
+     *
+     * @param outputFrame Frame of the output clock at which the change starts.
+     * @param gain        Linear gain, 1 by default.
+     * @param rampMs      Duration to reach the gain, 0 to change it at once.
+     * @return False if too many events are waiting.
+     */
+    public boolean scheduleGain(final long outputFrame, final float gain, final int rampMs) {
+        return native_schedule_event(mNativeHandle, SCHEDULED_EVENT_GAIN, outputFrame, 0, gain,
+                rampMs);
+    }
+
+    /**
+     * Drop the scheduled events which have not been applied yet.
+     */
+    public void cancelScheduledEvents() {
+        native_cancel_scheduled_events(mNativeHandle);
+    }
+
+    /**
+     * @return Counters of the scheduled events, or null if the sound system is not initialized.
+     */
+    public SSSchedulerStats getSchedulerStats() {
+        final long[] stats = native_get_scheduler_stats(mNativeHandle);
+        return stats == null ? null : new SSSchedulerStats(stats);
+    }
+
+    /**
+     * Change the scheduling of the native threads of a role. Threads apply it before their next
+     * task. Steps refused by the OS are skipped : without permission SCHED_FIFO falls back to the
+     * nice level, a negative nice level or an affinity can also be refused. Use
+     * {@link #getThreadPolicyReports()} to check what has been granted.
+     * By default render threads have nice level -16, decoder threads nice level 10 on the big cores
+     * and io threads nice level 10.
+     *
+     * @param role         {@link #THREAD_ROLE_RENDER} for the extraction of the played track,
+     *                     {@link #THREAD_ROLE_DECODER} for scans and duplicate search or
+     *                     {@link #THREAD_ROLE_IO} for wav rendering.
+     * @param fifoPriority SCHED_FIFO priority between 1 and 99, 0 to not request SCHED_FIFO.
+     * @param niceLevel    Nice level between -20 and 19, used when the thread is not SCHED_FIFO.
+     * @param cpuMask      Bit i allows CPU i, 0 allows every CPU. See {@link #getBigCoresMask()}.
+     */
+    public void setThreadPolicy(final int role, final int fifoPriority, final int niceLevel,
+                                final int cpuMask) {
+        native_set_thread_policy(mNativeHandle, role, fifoPriority, niceLevel, cpuMask);
+    }
+
+    /**
+     * @return Scheduling granted to the native threads which have applied a thread policy, the
+     * newest threads first, or null if the sound system is not initialized.
+     */
+    public SSThreadPolicyReport[] getThreadPolicyReports() {
+        final int[] values = native_get_thread_policy_reports(mNativeHandle);
+        if (values == null) {
+            return null;
+        }
+        final SSThreadPolicyReport[] reports =
+                new SSThreadPolicyReport[values.length / SSThreadPolicyReport.SIZE];
+        for (int i = 0; i < reports.length; i++) {
+            reports[i] = new SSThreadPolicyReport(values, i);
+        }
+        return reports;
+    }
+
+    /**
+     * @return Mask of the CPUs faster than the little cores, every CPU above the lowest maximum
+     * frequency, 0 if all CPUs are the same or if their frequency can't be read.
+     */
+    public int getBigCoresMask() {
+        return native_get_big_cores_mask();
+    }
+
+    /**
+     * Set the memory used to keep extracted tracks in RAM, 256 MB by default. The cache and its
+     * budget are shared by every sound system of the process. Least recently loaded tracks are
+     * removed first when it is exceeded, loaded tracks are never removed. A track whose file has
+     * been modified since its extraction is extracted again.
+     *
+     * @param budgetBytes Maximum size of the cached tracks in bytes, 0 to only keep the loaded track.
+     */
+    public void setTrackCacheBudget(final long budgetBytes) {
+        native_set_track_cache_budget(mNativeHandle, budgetBytes);
+    }
+
+    /**
+     * Remove from RAM every extracted track except the loaded ones, for every sound system.
+     */
+    public void clearTrackCache() {
+        native_clear_track_cache(mNativeHandle);
+    }
+
+    /**
+     * @return Counters of the cache of extracted tracks, or null if the sound system is not
+     * initialized.
+     */
+    public SSTrackCacheStats getTrackCacheStats() {
+        final long[] stats = native_get_track_cache_stats(mNativeHandle);
+        return stats == null ? null : new SSTrackCacheStats(stats);
+    }
+
+    /**
+     * Tracks are extracted and analysed by workers shared by all sound systems. Loading a track
+     * stops the extraction of the previous one of this sound system and releases its decoder, so
+     * that skipping tracks doesn't pile up work.
+     *
+     * @return Counters of the workers, including the work wasted by cancelled extractions and
+     * analyses, or null if the sound system is not initialized.
+     */
+    public SSDecodeStats getDecodeStats() {
+        final long[] stats = native_get_decode_stats(mNativeHandle);
+        return stats == null ? null : new SSDecodeStats(stats);
+    }
+
+    /**
+     * Copy a tile of the spectrogram of the loaded track. The spectrogram is computed in background
+     * while the track is extracted, tiles which are missing or evicted are computed when they are
+     * requested : call it again at the next frame of the UI until the tile is complete.
+     *
+     * @param level   Zoom level, 0 for the most detailed one, up to
+     *                {@link #SPECTROGRAM_NUMBER_LEVELS} excluded.
+     * @param index   Tile of the level, covering columns of level 0 from
+     *                index * {@link #SPECTROGRAM_TILE_COLUMNS} * 2^level.
+     * @param columns Array of at least {@link #SPECTROGRAM_TILE_SIZE} bytes, filled with
+     *                {@link #SPECTROGRAM_TILE_COLUMNS} columns of {@link #SPECTROGRAM_NUMBER_BANDS}
+     *                unsigned levels, lowest frequency first. 255 is a full scale sine and 0 is
+     *                96 dB below, bands are spaced logarithmically from 30 Hz.
+     * @return {@link #SPECTROGRAM_TILE_MISSING} if nothing has been copied,
+     * {@link #SPECTROGRAM_TILE_PARTIAL} if columns not computed yet are 0, or
+     * {@link #SPECTROGRAM_TILE_COMPLETE}.
+     */
+    public int getSpectrogramTile(final int level, final int index, final byte[] columns) {
+        return native_get_spectrogram_tile(mNativeHandle, level, index, columns);
+    }
+
+    /**
+     * @return Number of columns of level 0 of the spectrogram of the loaded track, growing while
+     * the track is extracted.
+     */
+    public int getSpectrogramNumberColumns() {
+        return native_get_spectrogram_number_columns(mNativeHandle);
+    }
+
+    /**
+     * Set the memory used by the tiles of the spectrogram, 16 MB by default. Least recently
+     * requested tiles are removed first when it is exceeded, and computed again when they are
+     * requested.
+     *
+     * @param budgetBytes Maximum size of the tiles in bytes.
+     */
+    public void setSpectrogramBudget(final long budgetBytes) {
+        native_set_spectrogram_budget(mNativeHandle, budgetBytes);
+    }
+
+    /**
+     * @return Counters of the spectrogram, or null if the sound system is not initialized.
+     */
+    public SSSpectrogramStats getSpectrogramStats() {
+        final long[] stats = native_get_spectrogram_stats(mNativeHandle);
+        return stats == null ? null : new SSSpectrogramStats(stats);
+    }
+
+    /**
+     * Copy the results of the analysis of the loaded track. Peak, rms, silence, loudness, onset and
+     * key analyzers process the frames in background while the track is extracted, in a single pass
+     * over the frames. {@link SSTrackAnalysisObserver#onTrackAnalysisCompleted()} is called once
+     * the whole track has been analysed.
+     *
+     * @return Results of the analysis, or null if the sound system is not initialized.
+     */
+    public SSTrackAnalysis getTrackAnalysis() {
+        final double[] analysis = native_get_track_analysis(mNativeHandle);
+        return analysis == null ? null : new SSTrackAnalysis(analysis);
+    }
+
+    /**
+     * Copy the values computed along the loaded track by an analyzer, once the analysis is
+     * complete. The onset envelope has a value per {@link #TRACK_ANALYSIS_ONSET_HOP_FRAMES} frames,
+     * the rise of energy from the previous ones in dB.
+     *
+     * @param analyzer {@link #TRACK_ANALYZER_ONSET}, the other analyzers have no curve.
+     * @param values   Array filled with the values, which are truncated to its length.
+     * @return Number of values copied.
+     */
+    public int getTrackAnalysisCurve(final int analyzer, final float[] values) {
+        return native_get_track_analysis_curve(mNativeHandle, analyzer, values);
+    }
+
+    /**
+     * Skip the silence at the start and at the end of the next tracks loaded. The leading silence of
+     * extracted tracks is not stored in RAM, uncompressed files are played from their first audible
+     * frame. Silence is detected while tracks are extracted, at almost no cost.
+     *
+     * @param trim          True to trim silence, false to play tracks entirely.
+     * @param thresholdDb   Level under which a frame is silent, -60 dB by default.
+     * @param minDurationMs Silence shorter than this is kept, 500 ms by default.
+     */
+    public void setSilenceTrimming(final boolean trim, final float thresholdDb,
+                                   final int minDurationMs) {
+        native_set_silence_trimming(mNativeHandle, trim, thresholdDb, minDurationMs);
+    }
+
+    /**
+     * @return Silence of the loaded track, or null if no track is completely loaded.
+     */
+    public SSTrackSilence getTrackSilence() {
+        final int[] silence = native_get_track_silence(mNativeHandle);
+        return silence == null ? null : new SSTrackSilence(silence);
+    }
+
+    /**
+     * Start recording what native threads do : extraction, player callbacks, message handling and
+     * notifications. Events of a previous session are dropped. Tracing costs nothing when it's not
+     * started.
+     *
+     * @return False if trace buffers can't be allocated.
+     */
+    public boolean startTracing() {
+        return native_start_tracing(mNativeHandle);
+    }
+
+    /**
+     * Stop recording events, they are kept until the next {@link #startTracing()}.
+     */
+    public void stopTracing() {
+        native_stop_tracing(mNativeHandle);
+    }
+
+    /**
+     * Stop tracing and write recorded events to a Chrome trace JSON file, to open with
+     * https://ui.perfetto.dev or chrome://tracing.
+     *
+     * @param jsonFilePath Path of the file to write.
+     * @return Number of events written, -1 if the file can't be written.
+     */
+    public int dumpTrace(final String jsonFilePath) {
+        return native_dump_trace(mNativeHandle, jsonFilePath);
     }
 
     //---------------
@@ -297,31 +1066,261 @@ public class SoundSystem {
         });
     }
 
+    public boolean addLibraryScanObserver(final SSLibraryScanObserver observer) {
+        synchronized (mLibraryScanObservers) {
+            //noinspection SimplifiableIfStatement
+            if (observer == null || mLibraryScanObservers.contains(observer)) {
+                return false;
+            }
+            return mLibraryScanObservers.add(observer);
+        }
+    }
+
+    public boolean removeLibraryScanObserver(final SSLibraryScanObserver observer) {
+        synchronized (mLibraryScanObservers) {
+            return mLibraryScanObservers.remove(observer);
+        }
+    }
+
+    /**
+     * Notify that a track of the library has been scanned.
+     * Called from native code.
+     */
+    @SuppressWarnings("unused")
+    @Keep
+    public void notifyScanProgress(final int numberFilesScanned, final int numberFilesTotal) {
+        mMainHandler.post(new Runnable() {
+            @Override
+            public void run() {
+                synchronized (mLibraryScanObservers) {
+                    for (final SSLibraryScanObserver observer : mLibraryScanObservers) {
+                        observer.onScanProgress(numberFilesScanned, numberFilesTotal);
+                    }
+                }
+            }
+        });
+    }
+
+    /**
+     * Notify that the library scan has finished.
+     * Called from native code.
+     */
+    @SuppressWarnings("unused")
+    @Keep
+    public void notifyScanCompleted(final boolean cancelled) {
+        mMainHandler.post(new Runnable() {
+            @Override
+            public void run() {
+                synchronized (mLibraryScanObservers) {
+                    for (final SSLibraryScanObserver observer : mLibraryScanObservers) {
+                        observer.onScanCompleted(cancelled);
+                    }
+                }
+            }
+        });
+    }
+
+    public boolean addFingerprintObserver(final SSFingerprintObserver observer) {
+        synchronized (mFingerprintObservers) {
+            //noinspection SimplifiableIfStatement
+            if (observer == null || mFingerprintObservers.contains(observer)) {
+                return false;
+            }
+            return mFingerprintObservers.add(observer);
+        }
+    }
+
+    public boolean removeFingerprintObserver(final SSFingerprintObserver observer) {
+        synchronized (mFingerprintObservers) {
+            return mFingerprintObservers.remove(observer);
+        }
+    }
+
+    /**
+     * Notify that fingerprinting has finished.
+     * Called from native code.
+     */
+    @SuppressWarnings("unused")
+    @Keep
+    public void notifyFingerprintCompleted(final int numberTracks, final boolean cancelled) {
+        mMainHandler.post(new Runnable() {
+            @Override
+            public void run() {
+                synchronized (mFingerprintObservers) {
+                    for (final SSFingerprintObserver observer : mFingerprintObservers) {
+                        observer.onFingerprintCompleted(numberTracks, cancelled);
+                    }
+                }
+            }
+        });
+    }
+
+    public boolean addTrackAnalysisObserver(final SSTrackAnalysisObserver observer) {
+        synchronized (mTrackAnalysisObservers) {
+            //noinspection SimplifiableIfStatement
+            if (observer == null || mTrackAnalysisObservers.contains(observer)) {
+                return false;
+            }
+            return mTrackAnalysisObservers.add(observer);
+        }
+    }
+
+    public boolean removeTrackAnalysisObserver(final SSTrackAnalysisObserver observer) {
+        synchronized (mTrackAnalysisObservers) {
+            return mTrackAnalysisObservers.remove(observer);
+        }
+    }
+
+    /**
+     * Notify that the loaded track has been analysed.
+     * Called from native code.
+     */
+    @SuppressWarnings("unused")
+    @Keep
+    public void notifyTrackAnalysisCompleted() {
+        mMainHandler.post(new Runnable() {
+            @Override
+            public void run() {
+                synchronized (mTrackAnalysisObservers) {
+                    for (final SSTrackAnalysisObserver observer : mTrackAnalysisObservers) {
+                        observer.onTrackAnalysisCompleted();
+                    }
+                }
+            }
+        });
+    }
+
     //--------------------
     // - Native methods -
     //--------------------
 
-    private native void native_init_soundsystem(int nativeFrameRate, int nativeFramesPerBuf);
+    private native long native_init_soundsystem(int nativeFrameRate, int nativeFramesPerBuf);
+
+    private native boolean native_is_soundsystem_init(long handle);
+
+    private native void native_load_file(long handle, String filePath);
+
+    private native void native_release_soundsystem(long handle);
+
+    private native void native_play(long handle, boolean play);
+
+    private native boolean native_is_playing(long handle);
+
+    private native boolean native_is_loaded(long handle);
+
+    private native int native_get_playing_position(long handle);
+
+    private native void native_stop(long handle);
+
+    private native void native_extract_and_play(long handle, String filePath);
+
+    private native void native_extract_from_assets_and_play(long handle, AssetManager assetManager, String filename);
+
+    private native short[] native_get_extracted_data(long handle);
+
+    private native short[] native_get_extracted_data_mono(long handle);
+
+    private native boolean native_scan_library(long handle, String[] filePaths, String indexFilePath);
+
+    private native void native_cancel_library_scan(long handle);
+
+    private native float[] native_get_scanned_track_features(String indexFilePath, String filePath);
+
+    private native boolean native_fingerprint_tracks(long handle, String[] filePaths);
+
+    private native void native_cancel_fingerprinting(long handle);
+
+    private native String[] native_find_duplicates(long handle, String filePath);
+
+    private native String[] native_find_loaded_track_duplicates(long handle);
+
+    private native void native_clear_fingerprints(long handle);
+
+    private native void native_set_equalizer_section(long handle, int index, int type, float frequency, float gainDb, float q);
+
+    private native void native_set_three_band_gains(long handle, float lowGainDb, float midGainDb, float highGainDb);
+
+    private native void native_reset_equalizer(long handle);
+
+    private native float[] native_benchmark_equalizer(long handle);
+
+    private native void native_set_playback_rate(long handle, float rate, int rampMs);
+
+    private native float[] native_benchmark_read_head(long handle);
+
+    private native float[] native_benchmark_channel_mapping(long handle);
+
+    private native float native_render_to_wav(long handle, String wavFilePath);
+
+    private native float native_benchmark_mp3_decoder(long handle, String mp3FilePath);
+
+    private native void native_set_thread_policy(long handle, int role, int fifoPriority, int niceLevel, int cpuMask);
+
+    private native int[] native_get_thread_policy_reports(long handle);
+
+    private native int native_get_big_cores_mask();
+
+    private native void native_set_track_cache_budget(long handle, long budgetBytes);
+
+    private native void native_clear_track_cache(long handle);
+
+    private native long[] native_get_track_cache_stats(long handle);
+
+    private native boolean native_start_tracing(long handle);
+
+    private native void native_stop_tracing(long handle);
+
+    private native int native_dump_trace(long handle, String jsonFilePath);
+
+    private native void native_set_silence_trimming(long handle, boolean trim, float thresholdDb, int minDurationMs);
+
+    private native int[] native_get_track_silence(long handle);
+
+    private native long[] native_get_playback_clock(long handle);
+
+    private native void native_set_output_latency(long handle, int latencyMs);
+
+    private native ByteBuffer native_get_status_buffer(long handle);
+
+    private native long[] native_get_decode_stats(long handle);
+
+    private native int native_get_spectrogram_tile(long handle, int level, int index, byte[] columns);
+
+    private native int native_get_spectrogram_number_columns(long handle);
+
+    private native void native_set_spectrogram_budget(long handle, long budgetBytes);
+
+    private native long[] native_get_spectrogram_stats(long handle);
+
+    private native double[] native_get_track_analysis(long handle);
+
+    private native int native_get_track_analysis_curve(long handle, int analyzer, float[] values);
+
+    private native float native_benchmark_key_detection(long handle);
+
+    private native boolean native_start_capture(long handle, String wavFilePath, int source, int numberChannels);
+
+    private native boolean native_stop_capture(long handle);
 
-    private native boolean native_is_soundsystem_init();
+    private native double[] native_get_capture_stats(long handle);
 
-    private native void native_load_file(String filePath);
+    private native int native_load_sample(long handle, String filePath);
 
-    private native void native_release_soundsystem();
+    private native boolean native_trigger_sample(long handle, int sample, float gain, int offsetFrames);
 
-    private native void native_play(boolean play);
+    private native void native_stop_samples(long handle);
 
-    private native boolean native_is_playing();
+    private native void native_start_output(long handle);
 
-    private native boolean native_is_loaded();
+    private native int native_get_number_active_voices(long handle);
 
-    private native void native_stop();
+    private native int native_get_number_stolen_voices(long handle);
 
-    private native void native_extract_and_play(String filePath);
+    private native float[] native_benchmark_sampler(long handle);
 
-    private native void native_extract_from_assets_and_play(AssetManager assetManager, String filename);
+    private native boolean native_schedule_event(long handle, int type, long frame, long position, float gain, int rampMs);
 
-    private native short[] native_get_extracted_data();
+    private native void native_cancel_scheduled_events(long handle);
 
-    private native short[] native_get_extracted_data_mono();
+    private native long[] native_get_scheduler_stats(long handle);
 }
@@ -0,0 +1,17 @@
+package fr.bowserf.soundsystem.listener;
+
+import android.support.annotation.MainThread;
+
+/**
+ * Listener for the fingerprinting of audio files.
+ */
+public interface SSFingerprintObserver {
+
+    /**
+     * Callback to notify that all files have been fingerprinted.
+     * @param numberTracks Number of tracks in the fingerprint index.
+     * @param cancelled    True if fingerprinting has been cancelled before the end.
+     */
+    @MainThread
+    void onFingerprintCompleted(int numberTracks, boolean cancelled);
+}
@@ -0,0 +1,26 @@
+package fr.bowserf.soundsystem.listener;
+
+import android.support.annotation.MainThread;
+
+/**
+ * Listener for the progress of a library scan.
+ */
+public interface SSLibraryScanObserver {
+
+    /**
+     * Callback to notify that a track has been scanned.
+     * @param numberFilesScanned Number of tracks already in the index, including the ones scanned
+     *                           by a previous scan.
+     * @param numberFilesTotal   Number of tracks to scan.
+     */
+    @MainThread
+    void onScanProgress(int numberFilesScanned, int numberFilesTotal);
+
+    /**
+     * Callback to notify the end of the scan.
+     * @param cancelled True if the scan has been cancelled before the end. Scanning again the same
+     *                  files with the same index will resume it.
+     */
+    @MainThread
+    void onScanCompleted(boolean cancelled);
+}
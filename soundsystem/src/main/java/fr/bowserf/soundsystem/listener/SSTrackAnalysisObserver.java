@@ -0,0 +1,16 @@
+package fr.bowserf.soundsystem.listener;
+
+import android.support.annotation.MainThread;
+
+/**
+ * Listener for the analysis of the loaded track.
+ */
+public interface SSTrackAnalysisObserver {
+
+    /**
+     * Callback to notify that every analyzer has processed the whole loaded track. Results are
+     * read with {@link fr.bowserf.soundsystem.SoundSystem#getTrackAnalysis()}.
+     */
+    @MainThread
+    void onTrackAnalysisCompleted();
+}